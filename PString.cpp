@@ -22,10 +22,40 @@
 void PString::begin()
 {
   _cur = _buf;
+  _overflow = false;
   if (_size > 0)
     _buf[0] = '\0';
 }
 
+void PString::truncate(size_t length)
+{
+  if (length < (size_t)(_cur - _buf))
+  {
+    _cur = _buf + length;
+    *_cur = '\0';
+  }
+  _overflow = false;
+}
+
+size_t PString::append(const char *str, size_t len)
+{
+  size_t room = _size > 0 ? _size - 1 - (_cur - _buf) : 0;
+
+  if (len > room)
+  {
+    len = room;
+    _overflow = true;
+  }
+
+  if (_size > 0)
+  {
+    memcpy(_cur, str, len);
+    _cur += len;
+    *_cur = '\0';
+  }
+  return len;
+}
+
 #if defined(ARDUINO) && ARDUINO >= 100
 size_t PString::write(uint8_t b)
 #else
@@ -41,18 +71,83 @@ void PString::write(uint8_t b)
 #endif
   }
 
+  _overflow = true;
 #if defined(ARDUINO) && ARDUINO >= 100
   return 0;
 #endif
 }
 
+#if defined(ARDUINO) && ARDUINO >= 100
+size_t PString::write(const uint8_t *buffer, size_t size)
+{
+  return append((const char *)buffer, size);
+}
+#endif
+
 int PString::format(char *str, ...) 
 { 
   va_list argptr;  
   va_start(argptr, str); 
   int ret = vsnprintf(_cur, _size - (_cur - _buf), str, argptr);
+  va_end(argptr);
+  if (ret < 0 || (size_t)ret >= _size - (_cur - _buf))
+    _overflow = true;
   if (_size)
      while (*_cur) 
         ++_cur;
   return ret;
 }
+
+PString &PString::appendUInt(uint32_t value)
+{
+  char buf[10];
+  uint8_t i = sizeof(buf);
+
+  do
+  {
+    buf[--i] = '0' + value % 10;
+    value /= 10;
+  } while (value);
+
+  append(buf + i, sizeof(buf) - i);
+  return *this;
+}
+
+PString &PString::appendInt(int32_t value)
+{
+  if (value < 0)
+  {
+    append("-", 1);
+    return appendUInt(-(uint32_t)value);
+  }
+  return appendUInt(value);
+}
+
+PString &PString::appendFixed(int32_t value, uint8_t decimals)
+{
+  uint32_t v = value < 0 ? -(uint32_t)value : value;
+  uint32_t div = 1;
+  char buf[10];
+
+  if (decimals > sizeof(buf) - 1)
+    decimals = sizeof(buf) - 1;
+  for (uint8_t i = 0; i < decimals; i++)
+    div *= 10;
+
+  if (value < 0)
+    append("-", 1);
+  appendUInt(v / div);
+
+  if (decimals)
+  {
+    v %= div;
+    buf[0] = '.';
+    for (uint8_t i = decimals; i > 0; i--)
+    {
+      buf[i] = '0' + v % 10;
+      v /= 10;
+    }
+    append(buf, decimals + 1);
+  }
+  return *this;
+}
@@ -33,9 +33,12 @@ class PString : public Print
 private:
   char *_buf, *_cur;
   size_t _size;
+  bool _overflow;
+  size_t append(const char *str, size_t len);
 public:
 #if defined(ARDUINO) && ARDUINO >= 100
   virtual size_t write(uint8_t);
+  virtual size_t write(const uint8_t *buffer, size_t size);
 #else
   virtual void write(uint8_t);
 #endif
@@ -69,9 +72,16 @@ public:
   bool operator==(const char *str) 
   { return _size > 0 && !strcmp(_buf, str); }
 
+  // true if something has been truncated since begin()
+  inline bool overflow() 
+  { return _overflow; }
+
   // call this to re-use an existing string
   void begin();
 
+  // drop what was added after length, e.g. an item that did not fit
+  void truncate(size_t length);
+
   // This function allows assignment to an arbitrary scalar value like str = myfloat;
   template<class T> inline PString &operator =(T arg) 
   { begin(); print(arg); return *this; }
@@ -82,6 +92,13 @@ public:
 
   // Safe access to sprintf-like formatting, e.g. str.format("Hi, my name is %s and I'm %d years old", name, age);
   int format(char *str, ...);
+
+  // Fast integer formatting, straight into the buffer
+  PString &appendUInt(uint32_t value);
+  PString &appendInt(int32_t value);
+
+  // Fixed point formatting, e.g. str.appendFixed(1234, 2) gives "12.34"
+  PString &appendFixed(int32_t value, uint8_t decimals);
 };
 
 #endif
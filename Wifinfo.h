@@ -31,19 +31,43 @@
 #include <WiFiUdp.h>
 #include <EEPROM.h>
 #include <Ticker.h>
-//#include <WebSocketsServer.h>
 //#include <Hash.h>
 #include <NeoPixelBus.h>
 #include <LibTeleinfo.h>
 #include <FS.h>
+#include <core_version.h>
+
+// Web server needs core 3.x (_parseRequest() returning ClientFuture),
+// 2.x has no ARDUINO_ESP8266_MAJOR
+#if !defined(ARDUINO_ESP8266_MAJOR) || ARDUINO_ESP8266_MAJOR < 3
+#error "WifInfo needs ESP8266 Arduino core 3.0.0 or newer"
+#endif
 
 extern "C" {
 #include "user_interface.h"
 }
 
 #include "webserver.h"
+#include "webconn.h"
 #include "webclient.h"
 #include "config.h"
+#include "capture.h"
+#include "tinfostd.h"
+#include "tinfolabels.h"
+#include "tinfoframe.h"
+#include "httpqueue.h"
+#include "mqtt.h"
+#include "emonbulk.h"
+#include "gzip.h"
+#include "influx.h"
+#include "udpframe.h"
+#include "metrics.h"
+#include "jsonwriter.h"
+#include "jsoncache.h"
+#include "logread.h"
+#include "fileindex.h"
+#include "sse.h"
+#include "sched.h"
 #include "PString.h"
 
 //External function from main CPP
@@ -91,6 +115,11 @@ void floggerflush();
 #define Infoflush()  {}
 #endif
 
+// Teleinfo serial ingestion
+#define TINFO_RX_BUFFER_SIZE 2048 // UART RX ring size (~2s of data at 9600 bps)
+#define TINFO_FEED_CHUNK     64   // bytes read from UART at once
+#define TINFO_FEED_BUDGET_MS 20   // max time feeding tinfo per loop() pass
+
 #define BLINK_LED_MS   50 // 50 ms blink
 #define RGB_LED_PIN    14 
 #define RED_LED_PIN    12
@@ -136,22 +165,29 @@ typedef struct
 
 // Exported variables/object instancied in main sketch
 // ===================================================
-extern ESP8266WebServer server;
 extern WiFiUDP OTA;
 extern TInfo tinfo;
 extern uint8_t rgb_brightness;
 extern unsigned long seconds;
 extern _sysinfo sysinfo;
-extern Ticker Tick_emoncms;
-extern Ticker Tick_jeedom;
-extern Ticker Tick_domoticz;
 extern PString flogger;
+extern unsigned long tinfo_rx_bytes;
+extern uint16_t tinfo_rx_max_pending;
+extern uint32_t tinfo_rx_overruns;
+extern uint32_t tinfo_frames;
+extern uint32_t tinfo_updated_frames;
+extern unsigned long tinfo_last_frame;
 
 // Exported function located in main sketch
 // ===================================================
 void ResetConfig(void);
+void Task_1_Sec();
 void Task_emoncms();
 void Task_jeedom();
 void Task_domoticz();
+void Task_mqtt();
+void Task_influx();
+void tinfoFeed(const char * buf, size_t len);
+size_t handleTeleinfoSerial(unsigned long budget_ms);
 
 #endif
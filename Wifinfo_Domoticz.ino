@@ -20,6 +20,8 @@
 // History : V1.00 2015-06-14 - Charles-Henri HALLARD - First release
 // History : V2.00 2017-08-27 - Sylvain REMY          - Domoticz management, some improvements & bug fixes
 //
+// Needs ESP8266 Arduino core 3.0.0 or newer (3.x), build stops on 2.x
+//
 // All text above must be included in any redistribution.
 //
 // **********************************************************************************
@@ -33,7 +35,6 @@
 #include <ArduinoOTA.h>
 #include <EEPROM.h>
 #include <Ticker.h>
-//#include <WebSocketsServer.h>
 //#include <Hash.h>
 #include <NeoPixelBus.h>
 #include <LibTeleinfo.h>
@@ -48,7 +49,10 @@ char floggerbuffer[255];
 PString flogger(floggerbuffer, sizeof(floggerbuffer));
 
 //WiFiManager wifi(0);
-ESP8266WebServer server(80);
+WebConnServer server(80);
+
+// Request headers web server keeps
+const char * web_headers[] = { "If-None-Match" };
 
 //holds the current upload
 File fsUploadFile;
@@ -72,17 +76,17 @@ uint8_t rgb_brightness = 50;
 Ticker rgb_ticker;
 Ticker blu_ticker;
 Ticker red_ticker;
-Ticker Every_1_Sec;
-Ticker Tick_emoncms;
-Ticker Tick_jeedom;
-Ticker Tick_domoticz;
-
-volatile boolean task_1_sec = false;
-volatile boolean task_emoncms = false;
-volatile boolean task_jeedom = false;
-volatile boolean task_domoticz = false;
+
 unsigned long seconds = 0;
 
+// Teleinfo serial ingestion statistics
+unsigned long tinfo_rx_bytes = 0;
+uint16_t tinfo_rx_max_pending = 0;
+uint32_t tinfo_rx_overruns = 0;
+uint32_t tinfo_frames = 0;
+uint32_t tinfo_updated_frames = 0;
+unsigned long tinfo_last_frame = 0;
+
 // sysinfo data
 _sysinfo sysinfo;
 
@@ -108,51 +112,81 @@ void UpdateSysinfo(boolean first_call, boolean show_debug)
 
 /* ======================================================================
 Function: Task_1_Sec 
-Purpose : update our second ticker
+Purpose : update our second counter and sysinfo
 Input   : -
 Output  : - 
-Comments: -
+Comments: scheduled task, catch up if we have been late so uptime
+          does not drift
 ====================================================================== */
 void Task_1_Sec()
 {
-  task_1_sec = true;
-  seconds++;
+  static unsigned long last_ms = 0;
+
+  while (millis() - last_ms >= 1000) {
+    seconds++;
+    last_ms += 1000;
+  }
+  UpdateSysinfo(false, false);
 }
 
 /* ======================================================================
 Function: Task_emoncms
-Purpose : callback of emoncms ticker
+Purpose : emoncms periodic push
 Input   : 
 Output  : -
-Comments: Like an Interrupt, need to be short, we set flag for main loop
+Comments: scheduled task
 ====================================================================== */
 void Task_emoncms()
 {
-  task_emoncms = true;
+  emoncmsPost();
 }
 
 /* ======================================================================
 Function: Task_jeedom
-Purpose : callback of jeedom ticker
+Purpose : jeedom periodic push
 Input   : 
 Output  : -
-Comments: Like an Interrupt, need to be short, we set flag for main loop
+Comments: scheduled task
 ====================================================================== */
 void Task_jeedom()
 {
-  task_jeedom = true;
+  jeedomPost();
 }
 
 /* ======================================================================
 Function: Task_domoticz
-Purpose : callback of domoticz ticker
+Purpose : domoticz periodic push
 Input   : 
 Output  : -
-Comments: Like an Interrupt, need to be short, we set flag for main loop
+Comments: scheduled task
 ====================================================================== */
 void Task_domoticz()
 {
-  task_domoticz = true;
+  domoticzPost();
+}
+
+/* ======================================================================
+Function: Task_mqtt
+Purpose : MQTT periodic push
+Input   : 
+Output  : -
+Comments: scheduled task
+====================================================================== */
+void Task_mqtt()
+{
+  mqttPost();
+}
+
+/* ======================================================================
+Function: Task_influx
+Purpose : InfluxDB periodic push
+Input   : 
+Output  : -
+Comments: scheduled task
+====================================================================== */
+void Task_influx()
+{
+  influxPost();
 }
 
 /* ======================================================================
@@ -252,6 +286,8 @@ Comments: -
 ====================================================================== */
 void DataCallback(ValueList * me, uint8_t flags)
 {
+  // Keep our label table in sync
+  tinfolabels.set(me->name, me->value);
 
   // This is for simulating ADPS during my tests
   // ===========================================
@@ -297,6 +333,25 @@ void NewFrame(ValueList * me)
 {
   char buff[32];
 
+  tinfo_frames++;
+  tinfo_last_frame = millis();
+  tinfolabels.frameDone();
+
+  // Nothing changed, decode only if we never did
+  if (!tinfoframe.frame)
+    tinfoFrameDecode();
+
+  // emoncms bulk upload and InfluxDB samples
+  emonBulkSample();
+  influxSample();
+
+  // Binary datagram to UDP receivers
+  udpFrameSend(false);
+
+  // JSON bodies for web clients, then pushed to subscribers
+  jsonCacheFrame();
+  sseFrame();
+
   // Light the RGB LED 
   if ( config.config & CFG_RGB_LED) {
     LedRGBON(COLOR_GREEN);
@@ -310,16 +365,35 @@ void NewFrame(ValueList * me)
 }
 
 /* ======================================================================
-Function: NewFrame 
+Function: UpdatedFrame 
 Purpose : callback when we received a complete teleinfo frame
 Input   : linked list pointer on the concerned data
 Output  : - 
-Comments: it's called only if one data in the frame is different than
+Comments: it's called instead of NewFrame and only if one data in the frame is different than
           the previous frame
 ====================================================================== */
 void UpdatedFrame(ValueList * me)
 {
   char buff[32];
+
+  tinfo_frames++;
+  tinfo_updated_frames++;
+  tinfo_last_frame = millis();
+  tinfolabels.frameDone();
+
+  // Decode once for all consumers
+  tinfoFrameDecode();
+
+  // emoncms bulk upload and InfluxDB samples
+  emonBulkSample();
+  influxSample();
+
+  // Binary datagram to UDP receivers
+  udpFrameSend(true);
+
+  // JSON bodies for web clients, then pushed to subscribers
+  jsonCacheFrame();
+  sseFrame();
   
   // Light the RGB LED (purple)
   if ( config.config & CFG_RGB_LED) {
@@ -331,40 +405,79 @@ void UpdatedFrame(ValueList * me)
 
   sprintf_P( buff, PSTR("Updated Frame (%ld Bytes free)"), ESP.getFreeHeap() );
   Debugln(buff);
+}
 
-/*
-  // Got at least one ?
-  if (me) {
-    WiFiUDP myudp;
-    IPAddress ip = WiFi.localIP();
-
-    // start UDP server
-    myudp.begin(1201);
-    ip[3] = 255;
-
-    // transmit broadcast package
-    myudp.beginPacket(ip, 1201);
-
-    // start of frame
-    myudp.write(TINFO_STX);
-
-    // Loop thru the node
-    while (me->next) {
-      me = me->next;
-      // prepare line and write it
-      sprintf_P( buff, PSTR("%s %s %c\n"),me->name, me->value, me->checksum );
-      myudp.write( buff);
-    }
 
-    // End of frame
-    myudp.write(TINFO_ETX);
-    myudp.endPacket();
-    myudp.flush();
+/* ======================================================================
+Function: tinfoFeed
+Purpose : push a block of raw teleinfo bytes to the decoder
+Input   : buffer of received bytes
+          number of bytes in buffer
+Output  : - 
+Comments: -
+====================================================================== */
+void tinfoFeed(const char * buf, size_t len)
+{
+  const char * end = buf + len;
+  unsigned long start = micros();
 
+  if (tinfo_mode == TINFO_MODE_STANDARD) {
+    while (buf < end)
+      tinfostd.process(*buf++);
+  } else {
+    while (buf < end)
+      tinfo.process(*buf++);
   }
-*/
+
+  tinfo_rx_bytes += len;
+  stageAccount(STAGE_FEED, start);
 }
 
+/* ======================================================================
+Function: handleTeleinfoSerial
+Purpose : drain the teleinfo UART and feed all pending bytes to tinfo
+Input   : max time (ms) we're allowed to spend in this pass
+Output  : number of bytes processed
+Comments: bytes are read by chunks into a local buffer and fed in one
+          go, so a whole burst is handled in a single loop() pass 
+          instead of one byte per pass
+====================================================================== */
+size_t handleTeleinfoSerial(unsigned long budget_ms)
+{
+  char buff[TINFO_FEED_CHUNK];
+  unsigned long start = millis();
+  size_t total = 0;
+  int pending = Serial.available();
+
+  // Keep track of the worst case for system page
+  if (pending > tinfo_rx_max_pending)
+    tinfo_rx_max_pending = pending;
+
+  // UART FIFO/ring has overflowed since last call, data lost
+  if (Serial.hasOverrun())
+    tinfo_rx_overruns++;
+
+  while (pending > 0) {
+    size_t len = Serial.readBytes(buff, pending < (int) sizeof(buff) ? pending : sizeof(buff));
+
+    if (!len)
+      break;
+
+    // Record raw stream if asked, live data is ignored while replaying
+    captureWrite(buff, len);
+    if (!replayActive())
+      tinfoFeed(buff, len);
+    total += len;
+
+    // Leave some time to network stuff, remaining will be done next pass
+    if (millis() - start >= budget_ms)
+      break;
+
+    pending = Serial.available();
+  }
+
+  return total;
+}
 
 /* ======================================================================
 Function: ResetConfig
@@ -401,6 +514,21 @@ void ResetConfig(void)
   strcpy_P(config.domoticz.host, CFG_DMCZ_DEFAULT_HOST);
   config.domoticz.port = CFG_DMCZ_DEFAULT_PORT;
   strcpy_P(config.domoticz.url, CFG_DMCZ_DEFAULT_URL);
+
+  // MQTT
+  strcpy_P(config.mqtt.topic, CFG_MQTT_DEFAULT_TOPIC);
+  config.mqtt.port = CFG_MQTT_DEFAULT_PORT;
+  config.mqtt.keepalive = CFG_MQTT_DEFAULT_KA;
+
+  // InfluxDB
+  config.influx.port = CFG_INFX_DEFAULT_PORT;
+  strcpy_P(config.influx.db, CFG_INFX_DEFAULT_DB);
+  strcpy_P(config.influx.measurement, CFG_INFX_DEFAULT_MEAS);
+  config.influx.batch = CFG_INFX_DEFAULT_BATCH;
+  config.influx.freq = CFG_INFX_DEFAULT_FREQ;
+
+  // UDP frame datagrams
+  config.udp.port = CFG_UDP_DEFAULT_PORT;
   
   config.config |= CFG_DEBUG;
 
@@ -600,7 +728,7 @@ void setup()
 
   // Our configuration is stored into EEPROM
   //EEPROM.begin(sizeof(_Config));
-  EEPROM.begin(1024);
+  EEPROM.begin(CFG_EEPROM_SIZE);
 
   DebugF("Config size="); Debug(sizeof(_Config));
   DebugF(" (emoncms=");   Debug(sizeof(_emoncms));
@@ -624,6 +752,9 @@ void setup()
       Debugf("FS File: %s, size: %d\n", fileName.c_str(), fileSize);
     }
     DebuglnF("");
+
+    // Web files served from index
+    fileIndexBuild();
   }
   
   // Read Configuration from EEP
@@ -642,6 +773,27 @@ void setup()
     DebuglnF("Reset to default");
   }
 
+  // Sinks servers and credentials
+  httpSetup();
+
+  // Requests we could not send before restart
+  httpSpoolSetup();
+
+  // MQTT broker session
+  mqttSetup();
+
+  // emoncms bulk upload sampling
+  emonBulkSetup();
+
+  // Jeedom label filter
+  jeedomSetup();
+
+  // InfluxDB lines held
+  influxSetup();
+
+  // UDP frame datagrams
+  udpFrameSetup();
+
   // We'll drive our onboard LED
   // old TXD1, not used anymore, has been swapped
   pinMode(RED_LED_PIN, OUTPUT); 
@@ -698,6 +850,10 @@ void setup()
   server.on("/wifiscan.json", wifiScanJSON);
   server.on("/factory_reset", handleFactoryReset);
   server.on("/reset", handleReset);
+  server.on("/capture", handleCaptureOperation);
+  server.on("/capture.json", captureJSONTable);
+  server.on("/metrics", handleMetrics);
+  server.on("/events", HTTP_GET, handleEvents);
 
   // handler for the hearbeat
   server.on("/hb.htm", HTTP_GET, [&](){
@@ -744,7 +900,10 @@ void setup()
       } else if(upload.status == UPLOAD_FILE_END) {
         if(fsUploadFile)
         {
+          String filename = upload.filename;
+          if(!filename.startsWith("/")) filename = "/"+filename;
           fsUploadFile.close();
+          fileIndexUpdate(filename.c_str());
           InfoF("Uploaded file Size: ");
           Infoln(upload.totalSize);
           Infoflush();
@@ -850,12 +1009,13 @@ void setup()
 
   // All other not known 
   server.onNotFound(handleNotFound);
-  
-  // serves all SPIFFS Web file with 24hr max-age control
+
+  // SPIFFS Web files are served by handleNotFound() from file index,
+  // /font, /js and /css with 24hr max-age control
   // to avoid multiple requests to ESP
-  server.serveStatic("/font", SPIFFS, "/font","max-age=86400"); 
-  server.serveStatic("/js",   SPIFFS, "/js"  ,"max-age=86400"); 
-  server.serveStatic("/css",  SPIFFS, "/css" ,"max-age=86400"); 
+
+  // Request headers we need, for 304 answers
+  server.collectHeaders(web_headers, sizeof(web_headers) / sizeof(web_headers[0]));
   server.begin();
 
   // Display configuration
@@ -868,7 +1028,9 @@ void setup()
   // we swap RXD1/RXD1 to RXD2/TXD2 
   // Note that TXD2 is not used teleinfo is receive only
   #ifdef DEBUG_SERIAL1
-    Serial.begin(1200, SERIAL_7E1);
+    // Enlarge RX ring so a slow web request does not overflow it
+    Serial.setRxBufferSize(TINFO_RX_BUFFER_SIZE);
+    Serial.begin(TINFO_HIST_BAUD, SERIAL_7E1);
     Serial.swap();
   #endif
 
@@ -882,26 +1044,27 @@ void setup()
   tinfo.attachNewFrame(NewFrame);
   tinfo.attachUpdatedFrame(UpdatedFrame);
 
-  //webSocket.begin();
-  //webSocket.onEvent(webSocketEvent);
+  // Linky standard mode decoder share the same frame callbacks
+  tinfostd.attachNewFrame(NewFrame);
+  tinfostd.attachUpdatedFrame(UpdatedFrame);
+  tinfoSetMode(config.tic_mode);
 
   // Light off the RGB LED
   LedRGBOFF();
 
-  // Update sysinfo every second
-  Every_1_Sec.attach(1, Task_1_Sec);
-  
-  // Emoncms Update if needed
-  if (config.emoncms.freq) 
-    Tick_emoncms.attach(config.emoncms.freq, Task_emoncms);
-
-  // Jeedom Update if needed
-  if (config.jeedom.freq) 
-    Tick_jeedom.attach(config.jeedom.freq, Task_jeedom);
-
-  // Domoticz Update if needed
-  if (config.domoticz.freq) 
-    Tick_domoticz.attach(config.domoticz.freq, Task_domoticz);
+  // Periodic tasks, sysinfo every second then sinks if needed
+  schedRegister(TASK_SYSINFO,  "sysinfo",  Task_1_Sec,    STAGE_COUNT,    1000);
+  schedRegister(TASK_EMONCMS,  "emoncms",  Task_emoncms,  STAGE_EMONCMS,  0);
+  schedRegister(TASK_JEEDOM,   "jeedom",   Task_jeedom,   STAGE_JEEDOM,   0);
+  schedRegister(TASK_DOMOTICZ, "domoticz", Task_domoticz, STAGE_DOMOTICZ, 0);
+  schedRegister(TASK_MQTT,     "mqtt",     Task_mqtt,     STAGE_MQTT,     0);
+  schedRegister(TASK_INFLUX,   "influx",   Task_influx,   STAGE_INFLUX,   0);
+  schedSet(TASK_SYSINFO,  1000);
+  schedSet(TASK_EMONCMS,  config.emoncms.freq  * 1000UL);
+  schedSet(TASK_JEEDOM,   config.jeedom.freq   * 1000UL);
+  schedSet(TASK_DOMOTICZ, config.domoticz.freq * 1000UL);
+  schedSet(TASK_MQTT,     config.mqtt.freq     * 1000UL);
+  schedSet(TASK_INFLUX,   config.influx.freq   * 1000UL);
 }
 
 void floggerflush()
@@ -914,6 +1077,7 @@ void floggerflush()
   {
     if (fr.size() >= 10000)
       {
+        logReadRotated(fr.size());
         fr.close();
         if (SPIFFS.exists("/log.1"))
         {
@@ -946,36 +1110,43 @@ Comments: -
 ====================================================================== */
 void loop()
 {
-  char c;
+  // Handle teleinfo serial first, drain all pending bytes
+  handleTeleinfoSerial(TINFO_FEED_BUDGET_MS);
 
   // Do all related network stuff
-  server.handleClient();
+  {
+    unsigned long start = micros();
+    server.handleConnections();
+    stageAccount(STAGE_WEB, start);
+  }
   ArduinoOTA.handle();
-  
-  //webSocket.loop();
-
-  // Only once task per loop, let system do it own task
-  if (task_1_sec) { 
-    UpdateSysinfo(false, false); 
-    task_1_sec = false; 
-  } else if (task_emoncms) { 
-    emoncmsPost(); 
-    task_emoncms=false; 
-  } else if (task_jeedom) { 
-    jeedomPost();  
-    task_jeedom=false;
-  } else if (task_domoticz) { 
-    domoticzPost();  
-    task_domoticz=false;
+
+  // Live frame subscribers
+  if (ssestat.clients)
+    sseHandle();
+
+  // Periodic tasks due, within pass budget
+  schedHandle();
+
+  // Sinks requests, one step at a time, and spooled ones
+  if (httpPending() || httpSpooled()) {
+    unsigned long start = micros();
+    httpHandle();
+    stageAccount(STAGE_HTTP, start);
   }
 
-  // Handle teleinfo serial
-  if ( Serial.available() ) {
-    // Read Serial and process to tinfo
-    c = Serial.read();
-    //Serial1.print(c);
-    tinfo.process(c);
+  // MQTT session, keep alive and acknowledges
+  if (*config.mqtt.host) {
+    unsigned long start = micros();
+    mqttHandle();
+    stageAccount(STAGE_MQTT, start);
   }
 
+  // Replayed stream if any
+  replayHandle(TINFO_FEED_BUDGET_MS);
+
+  // Historic/Standard mode detection
+  tinfoModeHandle(tinfo_last_frame);
+
   //delay(10);
 }
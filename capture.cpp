@@ -0,0 +1,385 @@
+// **********************************************************************************
+// ESP8266 Teleinfo capture/replay of raw teleinfo stream
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use, see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+
+#include "capture.h"
+
+// Pipeline stages statistics
+_stagestat stagestat[STAGE_COUNT];
+
+// Capture state
+static File capture_file;
+static char capture_buf[CAPTURE_BUFFER_SIZE];
+static uint16_t capture_idx = 0;
+static uint32_t capture_size = 0;
+static bool capturing = false;
+
+// Replay state
+static File replay_file;
+static bool replaying = false;
+static bool replay_loop;
+static uint16_t replay_speed;
+static uint32_t replay_baud;
+static unsigned long replay_start;
+static uint64_t replay_bytes;
+static uint32_t replay_frames;
+static uint32_t replay_next_ms[TASK_COUNT];
+
+/* ======================================================================
+Function: replayTaskFreq
+Purpose : return configured period of a sink task
+Input   : task (TASK_xxx from TASK_SINK_FIRST)
+Output  : period in seconds, 0 if sink is off
+Comments: sink tasks are the ones replay drives from its virtual clock
+====================================================================== */
+static uint32_t replayTaskFreq(uint8_t task)
+{
+  switch (task) {
+    case TASK_EMONCMS:  return config.emoncms.freq;
+    case TASK_JEEDOM:   return config.jeedom.freq;
+    case TASK_DOMOTICZ: return config.domoticz.freq;
+    case TASK_MQTT:     return config.mqtt.freq;
+    case TASK_INFLUX:   return config.influx.freq;
+  }
+  return 0;
+}
+
+/* ======================================================================
+Function: stageAccount
+Purpose : account time spent in a pipeline stage
+Input   : stage index (STAGE_xxx)
+          micros() value when stage started
+Output  : -
+Comments: -
+====================================================================== */
+void stageAccount(uint8_t stage, unsigned long start_us)
+{
+  uint32_t elapsed = micros() - start_us;
+  _stagestat * s = &stagestat[stage];
+
+  s->count++;
+  s->total_us += elapsed;
+  if (elapsed > s->max_us)
+    s->max_us = elapsed;
+}
+
+/* ======================================================================
+Function: stageReset
+Purpose : clear all pipeline stages statistics
+Input   : -
+Output  : -
+Comments: -
+====================================================================== */
+void stageReset(void)
+{
+  memset(stagestat, 0, sizeof(stagestat));
+}
+
+/* ======================================================================
+Function: captureFlush
+Purpose : write capture RAM buffer to file
+Input   : -
+Output  : -
+Comments: -
+====================================================================== */
+static void captureFlush(void)
+{
+  if (capture_idx && capture_file) {
+    capture_file.write((uint8_t *) capture_buf, capture_idx);
+    capture_size += capture_idx;
+  }
+  capture_idx = 0;
+}
+
+/* ======================================================================
+Function: captureStart
+Purpose : start recording raw teleinfo stream to a file
+Input   : file name
+Output  : true if file has been created
+Comments: any previous capture with same name is overwritten
+====================================================================== */
+bool captureStart(const char * filename)
+{
+  captureStop();
+
+  capture_file = SPIFFS.open(filename, "w");
+  if (!capture_file)
+    return false;
+
+  capture_idx = 0;
+  capture_size = 0;
+  capturing = true;
+
+  Infof("Capture started to %s\n", filename);
+  return true;
+}
+
+/* ======================================================================
+Function: captureStop
+Purpose : stop recording raw teleinfo stream
+Input   : -
+Output  : -
+Comments: -
+====================================================================== */
+void captureStop(void)
+{
+  if (capturing) {
+    captureFlush();
+    capture_file.close();
+    capturing = false;
+    Infof("Capture stopped, %u bytes\n", capture_size);
+  }
+}
+
+bool captureActive(void)
+{
+  return capturing;
+}
+
+/* ======================================================================
+Function: captureWrite
+Purpose : record received bytes if a capture is running
+Input   : buffer of received bytes
+          number of bytes in buffer
+Output  : -
+Comments: data are buffered in RAM, file is only written when
+          buffer is full to avoid too many SPIFFS writes
+====================================================================== */
+void captureWrite(const char * buf, size_t len)
+{
+  if (!capturing)
+    return;
+
+  while (len) {
+    size_t n = sizeof(capture_buf) - capture_idx;
+    if (n > len)
+      n = len;
+
+    memcpy(capture_buf + capture_idx, buf, n);
+    capture_idx += n;
+    buf += n;
+    len -= n;
+
+    if (capture_idx >= sizeof(capture_buf))
+      captureFlush();
+  }
+
+  // Don't fill all the file system
+  if (capture_size >= CAPTURE_MAX_SIZE)
+    captureStop();
+}
+
+/* ======================================================================
+Function: replayStart
+Purpose : start replaying a captured stream through tinfo and sinks
+Input   : file name
+          line speed of the capture (1200 or 9600)
+          acceleration factor (1 = real time)
+          true to restart from beginning at end of file
+Output  : true if replay started
+Comments: real tickers are detached during replay, sinks are triggered
+          from the virtual clock derived from replayed bytes
+====================================================================== */
+bool replayStart(const char * filename, uint32_t baud, uint16_t speed, bool loop)
+{
+  replayStop();
+
+  replay_file = SPIFFS.open(filename, "r");
+  if (!replay_file)
+    return false;
+
+  replay_baud = baud ? baud : 1200;
+  replay_speed = constrain(speed, 1, REPLAY_MAX_SPEED);
+  replay_loop = loop;
+  replay_bytes = 0;
+  replay_frames = tinfo_frames;
+  replay_start = millis();
+
+  // Virtual clock now drive our sinks
+  for (uint8_t task = TASK_SINK_FIRST; task < TASK_COUNT; task++) {
+    schedSet(task, 0);
+    replay_next_ms[task] = replayTaskFreq(task) * 1000;
+  }
+
+  // Decoder must match replayed stream
+  tinfoSetMode(replay_baud >= TINFO_STD_BAUD ? TINFO_MODE_STANDARD : TINFO_MODE_HISTORIQUE);
+
+  stageReset();
+  schedReset();
+  replaying = true;
+
+  Infof("Replay of %s at %u bps x%u\n", filename, replay_baud, replay_speed);
+  return true;
+}
+
+/* ======================================================================
+Function: replayStop
+Purpose : stop current replay and give back sinks to real tickers
+Input   : -
+Output  : -
+Comments: -
+====================================================================== */
+void replayStop(void)
+{
+  if (!replaying)
+    return;
+
+  replay_file.close();
+  replaying = false;
+
+  // Back to configured mode, auto mode will detect by itself
+  if (config.tic_mode != TINFO_MODE_AUTO)
+    tinfoSetMode(config.tic_mode);
+
+  for (uint8_t task = TASK_SINK_FIRST; task < TASK_COUNT; task++)
+    schedSet(task, replayTaskFreq(task) * 1000UL);
+
+  Infof("Replay stopped, %u frames\n", tinfo_frames - replay_frames);
+}
+
+bool replayActive(void)
+{
+  return replaying;
+}
+
+/* ======================================================================
+Function: replayVirtualMs
+Purpose : return virtual time elapsed since replay start
+Input   : -
+Output  : virtual time in ms
+Comments: one char on the line is 10 bits (start, 7 data, parity, stop)
+====================================================================== */
+static uint32_t replayVirtualMs(void)
+{
+  return (uint32_t) (replay_bytes * 10000ULL / replay_baud);
+}
+
+/* ======================================================================
+Function: replayHandle
+Purpose : feed tinfo with replayed data according to virtual clock
+Input   : max time (ms) we're allowed to spend in this pass
+Output  : -
+Comments: to be called from main loop. A pass stops at next sink
+          deadline, so at high speed each period still gets its own
+          run instead of several being merged in one trigger
+====================================================================== */
+void replayHandle(unsigned long budget_ms)
+{
+  char buff[REPLAY_CHUNK];
+  unsigned long start = millis();
+  uint64_t target;
+
+  if (!replaying)
+    return;
+
+  // Number of bytes the line would have sent at this speed
+  target = (uint64_t) (start - replay_start) * replay_speed * replay_baud / 10000ULL;
+
+  // But not past next sink deadline
+  for (uint8_t task = TASK_SINK_FIRST; task < TASK_COUNT; task++) {
+    if (replayTaskFreq(task)) {
+      uint64_t due = ((uint64_t) replay_next_ms[task] * replay_baud + 9999) / 10000ULL;
+
+      if (due < target)
+        target = due;
+    }
+  }
+
+  while (replay_bytes < target && millis() - start < budget_ms) {
+    size_t len = target - replay_bytes < sizeof(buff) ? target - replay_bytes : sizeof(buff);
+
+    len = replay_file.read((uint8_t *) buff, len);
+    if (!len) {
+      // End of file
+      if (replay_loop && replay_file.size()) {
+        replay_file.seek(0, SeekSet);
+        continue;
+      }
+      replayStop();
+      return;
+    }
+
+    tinfoFeed(buff, len);
+    replay_bytes += len;
+  }
+
+  // Fire sinks tasks on virtual clock
+  uint32_t now = replayVirtualMs();
+  for (uint8_t task = TASK_SINK_FIRST; task < TASK_COUNT; task++) {
+    uint32_t freq = replayTaskFreq(task);
+
+    if (freq && now >= replay_next_ms[task]) {
+      schedTrigger(task);
+      replay_next_ms[task] += freq * 1000;
+      // Period changed meanwhile
+      if (replay_next_ms[task] <= now)
+        replay_next_ms[task] = now + freq * 1000;
+    }
+  }
+}
+
+/* ======================================================================
+Function: getCaptureJSONData
+Purpose : Return JSON string containing capture/replay state and
+          pipeline stages statistics
+Input   : Response String
+Output  : -
+Comments: -
+====================================================================== */
+void getCaptureJSONData(String & r)
+{
+  static const char * const names[STAGE_COUNT] = { "feed", "emoncms", "jeedom", "domoticz", "http", "mqtt", "influx", "web" };
+  unsigned long elapsed = replaying ? millis() - replay_start : 0;
+  uint32_t frames = tinfo_frames - replay_frames;
+
+  r = F("{\"capture\":{\"active\":");
+  r += capturing ? 1 : 0;
+  r += F(",\"size\":");
+  r += capture_size + capture_idx;
+  r += F("},\r\n\"replay\":{\"active\":");
+  r += replaying ? 1 : 0;
+  r += F(",\"baud\":");
+  r += replay_baud;
+  r += F(",\"speed\":");
+  r += replay_speed;
+  r += F(",\"bytes\":");
+  r += (unsigned long) replay_bytes;
+  r += F(",\"virtual_s\":");
+  r += replay_baud ? replayVirtualMs() / 1000 : 0;
+  r += F(",\"frames\":");
+  r += frames;
+  r += F(",\"frames_s\":");
+  r += elapsed ? (float) frames * 1000.0f / elapsed : 0.0f;
+  r += F("},\r\n\"stages\":[");
+
+  for (uint8_t i = 0; i < STAGE_COUNT; i++) {
+    if (i)
+      r += ',';
+    r += F("\r\n{\"na\":\"");
+    r += names[i];
+    r += F("\",\"count\":");
+    r += stagestat[i].count;
+    r += F(",\"total_us\":");
+    r += stagestat[i].total_us;
+    r += F(",\"avg_us\":");
+    r += stagestat[i].count ? stagestat[i].total_us / stagestat[i].count : 0;
+    r += F(",\"max_us\":");
+    r += stagestat[i].max_us;
+    r += '}';
+  }
+  r += F("\r\n]}\r\n");
+}
@@ -0,0 +1,69 @@
+// **********************************************************************************
+// ESP8266 Teleinfo capture/replay Include file
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use , see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+// Include main project include file
+#include "Wifinfo.h"
+
+#define CAPTURE_DEFAULT_FILE  "/capture.tic"
+#define CAPTURE_BUFFER_SIZE   256   // RAM buffer before writing to SPIFFS
+#define CAPTURE_MAX_SIZE      262144 // Stop capture when file reach this size
+#define REPLAY_MAX_SPEED      1000  // Max acceleration factor, a day in 86s of line time
+#define REPLAY_CHUNK          128   // bytes read from file at once
+
+// Pipeline stages we measure
+enum {
+  STAGE_FEED = 0,   // tinfo.process() of received/replayed bytes
+  STAGE_EMONCMS,    // emoncmsPost()
+  STAGE_JEEDOM,     // jeedomPost()
+  STAGE_DOMOTICZ,   // domoticzPost()
+  STAGE_HTTP,       // httpHandle() one step of request engine
+  STAGE_MQTT,       // mqttPost() and mqttHandle()
+  STAGE_INFLUX,     // influxPost()
+  STAGE_WEB,        // server.handleConnections(), requests and files sent
+  STAGE_COUNT
+};
+
+// Time spent in one pipeline stage
+typedef struct
+{
+  uint32_t count;    // number of runs
+  uint32_t total_us; // cumulated run time
+  uint32_t max_us;   // worst run time
+} _stagestat;
+
+// Exported variables/object instancied in main sketch
+// ===================================================
+extern _stagestat stagestat[STAGE_COUNT];
+
+// declared exported function from capture.cpp
+// ===================================================
+void stageAccount(uint8_t stage, unsigned long start_us);
+void stageReset(void);
+bool captureStart(const char * filename);
+void captureStop(void);
+bool captureActive(void);
+void captureWrite(const char * buf, size_t len);
+bool replayStart(const char * filename, uint32_t baud, uint16_t speed, bool loop);
+void replayStop(void);
+bool replayActive(void);
+void replayHandle(unsigned long budget_ms);
+void getCaptureJSONData(String & r);
+
+#endif
@@ -76,6 +76,40 @@ void eepromDump(uint8_t bytesPerRow)
   }
 }
 
+/* ======================================================================
+Function: readLegacyConfig
+Purpose : upgrade config saved by a firmware without MQTT
+Input 	: -
+Output	: true if such a config was found and upgraded
+Comments: fields before MQTT did not move, so only its CRC is checked,
+          MQTT and InfluxDB get defaults and config is saved with new size
+====================================================================== */
+static bool readLegacyConfig(void) 
+{
+	uint16_t crc = ~0;
+
+	for (uint16_t i = 0; i < CFG_LEGACY_SIZE; ++i)
+		crc = crc16Update(crc, EEPROM.read(i));
+
+	if (crc != 0)
+		return false;
+
+  // old filler1 and CRC are now start of MQTT config
+  memset(&config.mqtt, 0, sizeof(_Config) - offsetof(_Config, mqtt));
+  strcpy_P(config.mqtt.topic, PSTR(CFG_MQTT_DEFAULT_TOPIC));
+  config.mqtt.port = CFG_MQTT_DEFAULT_PORT;
+  config.mqtt.keepalive = CFG_MQTT_DEFAULT_KA;
+  config.influx.port = CFG_INFX_DEFAULT_PORT;
+  strcpy_P(config.influx.db, PSTR(CFG_INFX_DEFAULT_DB));
+  strcpy_P(config.influx.measurement, PSTR(CFG_INFX_DEFAULT_MEAS));
+  config.influx.batch = CFG_INFX_DEFAULT_BATCH;
+  config.influx.freq = CFG_INFX_DEFAULT_FREQ;
+  config.udp.port = CFG_UDP_DEFAULT_PORT;
+
+  InfolnF("Upgrading config");
+  return saveConfig();
+}
+
 /* ======================================================================
 Function: readConfig
 Purpose : fill config structure with data located into eeprom
@@ -103,6 +137,10 @@ bool readConfig (bool clear_on_error)
   
 	// CRC Error ?
 	if (crc != 0) {
+    // Config saved before MQTT was added, keep it
+    if (readLegacyConfig())
+      return true;
+
 		// Clear config if wanted
     if (clear_on_error)
 		  memset(&config, 0, sizeof( _Config ));
@@ -168,6 +206,22 @@ bool saveConfig (void)
   return (ret_code);
 }
 
+/* ======================================================================
+Function: showPushConfig
+Purpose : display push on change settings of a sink
+Input 	: sink push settings
+Output	: -
+Comments: -
+====================================================================== */
+static void showPushConfig(_pushcfg * push)
+{
+  DebugF("push     :"); Debugln(push->mode == CFG_PUSH_CHANGE ? F("change") : F("always")); 
+  DebugF("heartbeat:"); Debugln(push->heartbeat); 
+  DebugF("deadband :"); Debug(push->db_power); DebugF("VA "); 
+                        Debug(push->db_current); DebugF("A "); 
+                        Debug(push->db_index); DebuglnF("Wh"); 
+}
+
 /* ======================================================================
 Function: showConfig
 Purpose : display configuration
@@ -185,6 +239,7 @@ void showConfig()
   DebugF("ap_retrycount:"); Debugln(config.ap_retrycount); 
   DebugF("OTA auth :"); Debugln(config.ota_auth); 
   DebugF("OTA port :"); Debugln(config.ota_port); 
+  DebugF("TIC mode :"); Debugln(config.tic_mode); 
   DebugF("Config   :"); 
   if (config.config & CFG_RGB_LED) DebugF(" RGB"); 
   if (config.config & CFG_DEBUG)   DebugF(" DEBUG"); 
@@ -196,6 +251,8 @@ void showConfig()
   DebugF("key      :"); Debugln(config.emoncms.apikey); 
   DebugF("node     :"); Debugln(config.emoncms.node); 
   DebugF("freq     :"); Debugln(config.emoncms.freq); 
+  DebugF("bulk     :"); Debugln(config.emoncms.bulk); 
+  showPushConfig(&config.emoncms.push);
 
   DebuglnF("\r\n===== Jeedom"); 
   DebugF("host     :"); Debugln(config.jeedom.host); 
@@ -204,6 +261,9 @@ void showConfig()
   DebugF("key      :"); Debugln(config.jeedom.apikey); 
   DebugF("compteur :"); Debugln(config.jeedom.adco); 
   DebugF("freq     :"); Debugln(config.jeedom.freq); 
+  DebugF("format   :"); Debugln(config.jeedom.format); 
+  DebugF("filtre   :"); Debug(config.jeedom.filter); DebugF(" "); Debugln(config.jeedom.labels); 
+  showPushConfig(&config.jeedom.push);
 
   DebuglnF("\r\n===== Domoticz"); 
   DebugF("host     :"); Debugln(config.domoticz.host); 
@@ -218,4 +278,42 @@ void showConfig()
   DebugF("idx_kwh :"); Debugln(config.domoticz.idx_kwh); 
   DebugF("idx_pct  :"); Debugln(config.domoticz.idx_pct); 
   DebugF("freq     :"); Debugln(config.domoticz.freq); 
+  showPushConfig(&config.domoticz.push);
+
+  DebuglnF("\r\n===== MQTT"); 
+  DebugF("host     :"); Debugln(config.mqtt.host); 
+  DebugF("port     :"); Debugln(config.mqtt.port); 
+  DebugF("user     :"); Debugln(config.mqtt.usr); 
+  DebugF("password :"); Debugln(config.mqtt.pwd);
+  DebugF("topic    :"); Debugln(config.mqtt.topic); 
+  DebugF("mode     :"); 
+  if (config.mqtt.mode & CFG_MQTT_DOMOTICZ) DebugF(" DOMOTICZ"); 
+  if (config.mqtt.mode & CFG_MQTT_FRAME)    DebugF(" FRAME"); 
+  if (config.mqtt.mode & CFG_MQTT_LWT)      DebugF(" LWT"); 
+  if (config.mqtt.mode & CFG_MQTT_RETAIN)   DebugF(" RETAIN"); 
+  Debugln();
+  DebugF("qos      :"); Debugln(config.mqtt.qos); 
+  DebugF("keepalive:"); Debugln(config.mqtt.keepalive); 
+  DebugF("freq     :"); Debugln(config.mqtt.freq); 
+  showPushConfig(&config.mqtt.push);
+
+  DebuglnF("\r\n===== InfluxDB"); 
+  DebugF("host     :"); Debugln(config.influx.host); 
+  DebugF("port     :"); Debugln(config.influx.port); 
+  DebugF("database :"); Debugln(config.influx.db); 
+  DebugF("user     :"); Debugln(config.influx.usr); 
+  DebugF("password :"); Debugln(config.influx.pwd);
+  DebugF("mesure   :"); Debugln(config.influx.measurement); 
+  DebugF("batch    :"); Debugln(config.influx.batch); 
+  DebugF("gzip     :"); Debugln(config.influx.gzip); 
+  DebugF("freq     :"); Debugln(config.influx.freq); 
+
+  DebuglnF("\r\n===== UDP"); 
+  DebugF("port     :"); Debugln(config.udp.port); 
+  for (uint8_t i = 0; i < CFG_UDP_RECEIVERS; i++) {
+    if (!config.udp.rcv[i].ip)
+      continue;
+    DebugF("receiver :"); Debug(IPAddress(config.udp.rcv[i].ip)); 
+    DebugF(" every "); Debugln(config.udp.rcv[i].every); 
+  }
 }
@@ -41,6 +41,7 @@
 #define CFG_JDOM_APIKEY_SIZE  48
 #define CFG_JDOM_URL_SIZE     64
 #define CFG_JDOM_ADCO_SIZE    12
+#define CFG_JDOM_LABELS_SIZE  64
 #define CFG_JDOM_DEFAULT_PORT 80
 #define CFG_JDOM_DEFAULT_HOST "jeedom.local"
 #define CFG_JDOM_DEFAULT_URL  "/jeedom/plugins/teleinfo/core/php/jeeTeleinfo.php"
@@ -54,11 +55,53 @@
 #define CFG_DMCZ_DEFAULT_HOST "domoticz.local"
 #define CFG_DMCZ_DEFAULT_URL  "/json.htm"
 
+#define CFG_MQTT_HOST_SIZE    32
+#define CFG_MQTT_USR_SIZE     32
+#define CFG_MQTT_PWD_SIZE     32
+#define CFG_MQTT_TOPIC_SIZE   64
+#define CFG_MQTT_DEFAULT_PORT 1883
+#define CFG_MQTT_DEFAULT_TOPIC "wifinfo"
+#define CFG_MQTT_DEFAULT_KA   60
+
+#define CFG_INFX_HOST_SIZE    32
+#define CFG_INFX_DB_SIZE      32
+#define CFG_INFX_USR_SIZE     32
+#define CFG_INFX_PWD_SIZE     32
+#define CFG_INFX_MEAS_SIZE    32
+#define CFG_INFX_DEFAULT_PORT 8086
+#define CFG_INFX_DEFAULT_DB   "teleinfo"
+#define CFG_INFX_DEFAULT_MEAS "teleinfo"
+#define CFG_INFX_DEFAULT_BATCH 10
+#define CFG_INFX_DEFAULT_FREQ 60
+
+#define CFG_UDP_RECEIVERS     4
+#define CFG_UDP_DEFAULT_PORT  1201
+
 // Port pour l'OTA
 #define DEFAULT_OTA_PORT     8266
 #define DEFAULT_OTA_AUTH     "OTA_WifInfo"
 //#define DEFAULT_OTA_AUTH     ""
 
+// Sinks push mode
+#define CFG_PUSH_ALWAYS 0 // Send all values at each update
+#define CFG_PUSH_CHANGE 1 // Send only changed values
+
+// Jeedom request format
+#define CFG_JDOM_GET    0 // Values in URL query string
+#define CFG_JDOM_FORM   1 // Values in form encoded POST body
+#define CFG_JDOM_JSON   2 // Values in JSON POST body
+
+// Jeedom label filter
+#define CFG_JDOM_ALL     0 // Send all labels
+#define CFG_JDOM_INCLUDE 1 // Send only listed labels
+#define CFG_JDOM_EXCLUDE 2 // Send all labels but listed ones
+
+// MQTT publish modes
+#define CFG_MQTT_DOMOTICZ 0x01  // domoticz/in message per configured idx
+#define CFG_MQTT_FRAME    0x02  // one message with whole frame on topic
+#define CFG_MQTT_LWT      0x04  // last will "offline" on topic/status
+#define CFG_MQTT_RETAIN   0x08  // frame message is retained
+
 // Bit definition for different configuration modes
 #define CFG_LCD				  0x0001	// Enable display
 #define CFG_DEBUG			  0x0002	// Enable serial debug
@@ -66,6 +109,11 @@
 #define CFG_INFO        0x0008  // Enable serial & file info
 #define CFG_BAD_CRC     0x8000  // Bad CRC when reading configuration
 
+// Size of config before MQTT was added (including its CRC), 
+// such a config is kept when upgrading
+#define CFG_LEGACY_SIZE 1017
+#define CFG_EEPROM_SIZE 2048
+
 // Web Interface Configuration Form field names
 #define CFG_FORM_SSID      FPSTR("ssid")
 #define CFG_FORM_PSK       FPSTR("psk")
@@ -78,6 +126,7 @@
 #define CFG_FORM_CFG_INFO  FPSTR("cfg_info")
 #define CFG_FORM_CFG_RGB   FPSTR("cfg_rgb")
 #define CFG_FORM_CFG_OLED  FPSTR("cfg_oled")
+#define CFG_FORM_TIC_MODE  FPSTR("tic_mode")
 
 #define CFG_FORM_EMON_HOST  FPSTR("emon_host")
 #define CFG_FORM_EMON_PORT  FPSTR("emon_port")
@@ -85,6 +134,7 @@
 #define CFG_FORM_EMON_KEY   FPSTR("emon_apikey")
 #define CFG_FORM_EMON_NODE  FPSTR("emon_node")
 #define CFG_FORM_EMON_FREQ  FPSTR("emon_freq")
+#define CFG_FORM_EMON_BULK  FPSTR("emon_bulk")
 
 #define CFG_FORM_JDOM_HOST  FPSTR("jdom_host")
 #define CFG_FORM_JDOM_PORT  FPSTR("jdom_port")
@@ -92,6 +142,9 @@
 #define CFG_FORM_JDOM_KEY   FPSTR("jdom_apikey")
 #define CFG_FORM_JDOM_ADCO  FPSTR("jdom_adco")
 #define CFG_FORM_JDOM_FREQ  FPSTR("jdom_freq")
+#define CFG_FORM_JDOM_FMT   FPSTR("jdom_fmt")
+#define CFG_FORM_JDOM_FILTER FPSTR("jdom_filter")
+#define CFG_FORM_JDOM_LABELS FPSTR("jdom_labels")
 
 #define CFG_FORM_DMCZ_HOST      FPSTR("dmcz_host")
 #define CFG_FORM_DMCZ_PORT      FPSTR("dmcz_port")
@@ -106,6 +159,41 @@
 #define CFG_FORM_DMCZ_IDX_PCT   FPSTR("dmcz_idx_pct")
 #define CFG_FORM_DMCZ_FREQ      FPSTR("dmcz_freq")
 
+#define CFG_FORM_MQTT_HOST    FPSTR("mqtt_host")
+#define CFG_FORM_MQTT_PORT    FPSTR("mqtt_port")
+#define CFG_FORM_MQTT_USR     FPSTR("mqtt_usr")
+#define CFG_FORM_MQTT_PWD     FPSTR("mqtt_pwd")
+#define CFG_FORM_MQTT_TOPIC   FPSTR("mqtt_topic")
+#define CFG_FORM_MQTT_QOS     FPSTR("mqtt_qos")
+#define CFG_FORM_MQTT_KA      FPSTR("mqtt_ka")
+#define CFG_FORM_MQTT_FREQ    FPSTR("mqtt_freq")
+#define CFG_FORM_MQTT_DMCZ    FPSTR("mqtt_dz")
+#define CFG_FORM_MQTT_FRAME   FPSTR("mqtt_frame")
+#define CFG_FORM_MQTT_LWT     FPSTR("mqtt_lwt")
+#define CFG_FORM_MQTT_RETAIN  FPSTR("mqtt_retain")
+
+#define CFG_FORM_INFX_HOST    FPSTR("infx_host")
+#define CFG_FORM_INFX_PORT    FPSTR("infx_port")
+#define CFG_FORM_INFX_DB      FPSTR("infx_db")
+#define CFG_FORM_INFX_USR     FPSTR("infx_usr")
+#define CFG_FORM_INFX_PWD     FPSTR("infx_pwd")
+#define CFG_FORM_INFX_MEAS    FPSTR("infx_meas")
+#define CFG_FORM_INFX_BATCH   FPSTR("infx_batch")
+#define CFG_FORM_INFX_FREQ    FPSTR("infx_freq")
+#define CFG_FORM_INFX_GZIP    FPSTR("infx_gzip")
+
+// UDP receivers, suffix is receiver index (udp_ip0, udp_dec0, ...)
+#define CFG_FORM_UDP_PORT     FPSTR("udp_port")
+#define CFG_FORM_UDP_IP       FPSTR("udp_ip")
+#define CFG_FORM_UDP_DEC      FPSTR("udp_dec")
+
+// Push settings, suffix of each sink prefix (emon_, jdom_, dmcz_, mqtt_)
+#define CFG_FORM_PUSH_MODE  FPSTR("_push")
+#define CFG_FORM_PUSH_HB    FPSTR("_hb")
+#define CFG_FORM_PUSH_DBPWR FPSTR("_db_pwr")
+#define CFG_FORM_PUSH_DBCUR FPSTR("_db_cur")
+#define CFG_FORM_PUSH_DBIDX FPSTR("_db_idx")
+
 #define CFG_FORM_IP  FPSTR("wifi_ip");
 #define CFG_FORM_GW  FPSTR("wifi_gw");
 #define CFG_FORM_MSK FPSTR("wifi_msk");
@@ -113,6 +201,17 @@
 #pragma pack(push)  // push current alignment to stack
 #pragma pack(1)     // set alignment to 1 byte boundary
 
+// Push on change settings of a sink
+// 8 Bytes
+typedef struct
+{
+  uint8_t  mode;       // CFG_PUSH_ALWAYS/CFG_PUSH_CHANGE (1 Byte)
+  uint16_t heartbeat;  // max silence in change mode, seconds (2 Bytes)
+  uint16_t db_power;   // PAPP/PMAX deadband in VA (2 Bytes)
+  uint8_t  db_current; // IINST/IMAX deadband in A (1 Byte)
+  uint16_t db_index;   // indexes deadband in Wh (2 Bytes)
+} _pushcfg;
+
 // Config for emoncms
 // 256 Bytes
 typedef struct 
@@ -123,7 +222,9 @@ typedef struct
   uint16_t port;    								    // Protocol port (HTTP/HTTPS) (2 Bytes)
   uint8_t  node;     									  // optional node (8 Bytes)
   uint32_t freq;                        // refresh rate (4 Bytes)
-  uint8_t  filler[143];  							  // in case adding data in config avoiding loosing current conf by bad crc (143 Bytes)
+  _pushcfg push;                        // push on change (8 Bytes)
+  uint8_t  bulk;                        // bulk upload sample period (s), 0 for single value post (1 Byte)
+  uint8_t  filler[134];  							  // in case adding data in config avoiding loosing current conf by bad crc (134 Bytes)
 } _emoncms;
 
 // Config for jeedom
@@ -136,7 +237,11 @@ typedef struct
   char  adco[CFG_JDOM_ADCO_SIZE+1];     // Identifiant compteur (12+1=13 Bytes)
   uint16_t port;                        // Protocol port (HTTP/HTTPS) (2 Bytes)
   uint32_t freq;                        // refresh rate (4 Bytes)
-  uint8_t filler[90];                   // in case adding data in config avoiding loosing current conf by bad crc (90 Bytes)
+  _pushcfg push;                        // push on change (8 Bytes)
+  uint8_t  format;                      // CFG_JDOM_GET/FORM/JSON (1 Byte)
+  uint8_t  filter;                      // CFG_JDOM_ALL/INCLUDE/EXCLUDE (1 Byte)
+  char  labels[CFG_JDOM_LABELS_SIZE+1]; // Comma separated label names (64+1=65 Bytes)
+  uint8_t filler[15];                   // in case adding data in config avoiding loosing current conf by bad crc (15 Bytes)
 } _jeedom;
 
 // Config for domoticz
@@ -155,11 +260,62 @@ typedef struct
   uint16_t idx_elec;                    // Index device domoticz Eletric (2 Byte)
   uint16_t idx_kwh;                     // Index device domoticz Kwh (2 Byte)
   uint16_t idx_pct;                     // Index device domoticz Percentage (2 Byte)
-  uint8_t filler[74];                   // in case adding data in config avoiding loosing current conf by bad crc (74 Bytes)
+  _pushcfg push;                        // push on change (8 Bytes)
+  uint8_t filler[66];                   // in case adding data in config avoiding loosing current conf by bad crc (66 Bytes)
 } _domoticz;
 
+// Config for MQTT broker
+// 256 Bytes
+typedef struct 
+{
+  char  host[CFG_MQTT_HOST_SIZE+1];     // FQDN (32+1=33 Bytes)
+  uint16_t port;                        // Protocol port (2 Bytes)
+  char  usr[CFG_MQTT_USR_SIZE+1];       // User (32+1=33 Bytes)
+  char  pwd[CFG_MQTT_PWD_SIZE+1];       // Password (32+1=33 Bytes)
+  char  topic[CFG_MQTT_TOPIC_SIZE+1];   // Frame topic, status is topic/status (64+1=65 Bytes)
+  uint8_t  mode;                        // CFG_MQTT_xxx bits (1 Byte)
+  uint8_t  qos;                         // Publish QoS 0 or 1 (1 Byte)
+  uint16_t keepalive;                   // Keep alive, seconds (2 Bytes)
+  uint32_t freq;                        // refresh rate (4 Bytes)
+  _pushcfg push;                        // push on change (8 Bytes)
+  uint8_t filler[74];                   // in case adding data in config avoiding loosing current conf by bad crc (74 Bytes)
+} _mqtt;
+
+// Config for InfluxDB
+// 256 Bytes
+typedef struct 
+{
+  char  host[CFG_INFX_HOST_SIZE+1];     // FQDN (32+1=33 Bytes)
+  uint16_t port;                        // Protocol port (2 Bytes)
+  char  db[CFG_INFX_DB_SIZE+1];         // Database (32+1=33 Bytes)
+  char  usr[CFG_INFX_USR_SIZE+1];       // User (32+1=33 Bytes)
+  char  pwd[CFG_INFX_PWD_SIZE+1];       // Password (32+1=33 Bytes)
+  char  measurement[CFG_INFX_MEAS_SIZE+1]; // Measurement name (32+1=33 Bytes)
+  uint8_t  batch;                       // frames per write (1 Byte)
+  uint8_t  gzip;                        // compress write body (1 Byte)
+  uint32_t freq;                        // max time frames are held (4 Bytes)
+  uint8_t filler[83];                   // in case adding data in config avoiding loosing current conf by bad crc (83 Bytes)
+} _influx;
+
+// One receiver of frame datagrams
+// 5 Bytes
+typedef struct 
+{
+  uint32_t ip;                          // IPv4, 255.255.255.255 broadcast, 0 disabled (4 Bytes)
+  uint8_t  every;                       // send one frame out of every (1 Byte)
+} _udprcv;
+
+// Config for binary frame datagrams
+// 64 Bytes
+typedef struct 
+{
+  uint16_t port;                        // Destination port, 0 disabled (2 Bytes)
+  _udprcv  rcv[CFG_UDP_RECEIVERS];      // Receivers (4*5=20 Bytes)
+  uint8_t filler[42];                   // in case adding data in config avoiding loosing current conf by bad crc (42 Bytes)
+} _udp;
+
 // Config saved into eeprom
-// 1024 bytes total including CRC
+// 2048 bytes total including CRC
 typedef struct 
 {
   char  ssid[CFG_SSID_SIZE+1]; 		 // SSID (32+1=33 Bytes)
@@ -170,11 +326,15 @@ typedef struct
   char  ota_auth[CFG_PSK_SIZE+1];  // OTA Authentication password (64+1=65 Bytes)
   uint32_t config;           		   // Bit field register (4 Bytes)
   uint16_t ota_port;         		   // OTA port (2 Bytes)
-  uint8_t  filler[1];      		     // in case adding data in config avoiding loosing current conf by bad crc (1 Bytes)
+  uint8_t  tic_mode;       		     // Teleinfo mode auto/historique/standard (1 Bytes)
   _emoncms emoncms;                // Emoncms configuration (256 Bytes)
   _jeedom  jeedom;                 // jeedom configuration (256 Bytes)
   _domoticz  domoticz;             // domoticz configuration (256 Bytes)
   uint8_t  filler1[1];             // Another filler in case we need more (1 Bytes)
+  _mqtt    mqtt;                   // MQTT configuration (256 Bytes)
+  _influx  influx;                 // InfluxDB configuration (256 Bytes)
+  _udp     udp;                    // UDP frame datagrams configuration (64 Bytes)
+  uint8_t  filler2[455];           // Room for next ones (455 Bytes)
   uint16_t crc;                    // CRC (2 Bytes)
 } _Config;
 
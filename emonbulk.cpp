@@ -0,0 +1,380 @@
+// **********************************************************************************
+// ESP8266 Teleinfo emoncms bulk upload
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use , see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// Frames are sampled every config.emoncms.bulk seconds and kept in RAM as
+// records of varints: time since previous sample, then (label id + 1, zigzag
+// delta from previous value) for each value that changed, then 0.
+// At each emoncms tick, they are uploaded in input/bulk POST requests:
+//   data=[[-58,node,{"PAPP":4630,"IINST":20,...}],[-56,node,{"PAPP":4700}],...]&sentat=AGE
+// first entry of a request has all values, next ones only changed values
+// in push on change mode.
+// Sample times are relative to request creation, and httpqueue adds the
+// request age, so emoncms dates them right even when they were spooled.
+//
+// **********************************************************************************
+#include "emonbulk.h"
+
+static uint8_t  emon_bulk[EMON_BULK_SIZE];
+static uint16_t emon_bulk_len;            // bytes used
+static uint16_t emon_bulk_count;          // samples held
+static uint32_t emon_bulk_start;          // time (s) records are relative to
+static uint32_t emon_bulk_time;           // time (s) of last sample
+static bool     emon_bulk_sampled;        // emon_bulk_time is set
+
+// Encoder values (last sample) and decoder ones (start of buffer)
+static uint32_t emon_bulk_last[LABEL_COUNT];
+static uint32_t emon_bulk_last_seen[(LABEL_COUNT + 31) / 32];
+static uint32_t emon_bulk_base[LABEL_COUNT];
+static uint32_t emon_bulk_base_seen[(LABEL_COUNT + 31) / 32];
+
+_emonbulkstat emonbulkstat;
+
+#define BULK_SEEN(b, id)  ((b)[(id) >> 5] & (1UL << ((id) & 31)))
+#define BULK_SET(b, id)   ((b)[(id) >> 5] |= (1UL << ((id) & 31)))
+
+/* ======================================================================
+Function: bulkPut
+Purpose : write a varint in samples buffer
+Input   : where to write, updated
+          end of room
+          value
+Output  : false if no room
+Comments: -
+====================================================================== */
+static bool bulkPut(uint8_t ** p, const uint8_t * end, uint32_t v)
+{
+  do {
+    if (*p >= end)
+      return false;
+    *(*p)++ = (v & 0x7F) | (v >= 0x80 ? 0x80 : 0);
+    v >>= 7;
+  } while (v);
+  return true;
+}
+
+/* ======================================================================
+Function: bulkGet
+Purpose : read a varint from samples buffer
+Input   : where to read, updated
+Output  : value
+Comments: -
+====================================================================== */
+static uint32_t bulkGet(const uint8_t ** p)
+{
+  uint32_t v = 0;
+  uint8_t shift = 0;
+  uint8_t c;
+
+  do {
+    c = *(*p)++;
+    v |= (uint32_t) (c & 0x7F) << shift;
+    shift += 7;
+  } while (c & 0x80);
+  return v;
+}
+
+/* ======================================================================
+Function: bulkEncode
+Purpose : add current frame as a record
+Input   : -
+Output  : false if it did not fit
+Comments: encoder values are only updated once record is complete
+====================================================================== */
+static bool bulkEncode(void)
+{
+  uint8_t * p = emon_bulk + emon_bulk_len;
+  const uint8_t * end = emon_bulk + EMON_BULK_SIZE;
+  uint32_t number;
+
+  // Time since previous record, or since records start
+  if (!bulkPut(&p, end, seconds - (emon_bulk_count ? emon_bulk_time : emon_bulk_start)))
+    return false;
+
+  for (uint8_t id = 0; id < LABEL_COUNT; id++) {
+    int32_t delta;
+
+    if (!tinfoFrameValue(id, &number) || (BULK_SEEN(emon_bulk_last_seen, id) && number == emon_bulk_last[id]))
+      continue;
+
+    delta = (int32_t) (number - (BULK_SEEN(emon_bulk_last_seen, id) ? emon_bulk_last[id] : 0));
+    if (!bulkPut(&p, end, id + 1) || !bulkPut(&p, end, ((uint32_t) delta << 1) ^ (uint32_t) (delta >> 31)))
+      return false;
+  }
+  if (!bulkPut(&p, end, 0))
+    return false;
+
+  // Record complete, commit encoder state
+  for (uint8_t id = 0; id < LABEL_COUNT; id++) {
+    if (tinfoFrameValue(id, &number)) {
+      emon_bulk_last[id] = number;
+      BULK_SET(emon_bulk_last_seen, id);
+    }
+  }
+  emon_bulk_len = p - emon_bulk;
+  emon_bulk_count++;
+  emon_bulk_time = seconds;
+  emon_bulk_sampled = true;
+  return true;
+}
+
+/* ======================================================================
+Function: bulkUrl
+Purpose : start a bulk request
+Input   : where to render
+Output  : -
+Comments: bulk URL is post URL with last part replaced by EMON_BULK_URL
+====================================================================== */
+static void bulkUrl(PString & req)
+{
+  const char * url = *config.emoncms.url ? config.emoncms.url : "/";
+  const char * slash = strrchr(url, '/');
+
+  req.begin();
+  req.write((const uint8_t *) url, slash ? slash + 1 - url : 0);
+  if (!slash)
+    req += '/';
+  req += F(EMON_BULK_URL "?apikey=");
+  req += config.emoncms.apikey;
+  req += HTTP_BODY_SEP;
+  req += F("data=[");
+}
+
+/* ======================================================================
+Function: bulkItem
+Purpose : render a value of a bulk entry
+Input   : where to render
+          label id (LABEL_xxx)
+          true for first value of entry
+Output  : -
+Comments: values are taken from decoder state, body is form encoded
+          so names are too (NJOURF+1)
+====================================================================== */
+static void bulkItem(PString & req, uint8_t id, bool first)
+{
+  if (!first)
+    req += ',';
+  req += '"';
+  urlEncode_P(req, (PGM_P) TInfoLabels::labelName(id));
+  req += F("\":");
+  req.appendUInt(emon_bulk_base[id]);
+}
+
+/* ======================================================================
+Function: bulkEntry
+Purpose : render a sample as bulk entry
+Input   : where to render
+          sample time relative to request (s)
+          record ids, NULL to render all values
+Output  : -
+Comments: -
+====================================================================== */
+static void bulkEntry(PString & req, int32_t time, const uint8_t * ids)
+{
+  bool first = true;
+
+  req += '[';
+  req.appendInt(time);
+  req += ',';
+  req.appendUInt(config.emoncms.node);
+  req += F(",{");
+
+  if (ids) {
+    for (uint32_t id; (id = bulkGet(&ids)); first = false) {
+      bulkGet(&ids);
+      bulkItem(req, id - 1, first);
+    }
+  } else {
+    for (uint8_t id = 0; id < LABEL_COUNT; id++) {
+      if (BULK_SEEN(emon_bulk_base_seen, id)) {
+        bulkItem(req, id, first);
+        first = false;
+      }
+    }
+  }
+  req += F("}]");
+}
+
+/* ======================================================================
+Function: bulkQueue
+Purpose : queue a rendered bulk request
+Input   : rendered request
+          samples in it
+          buffer bytes of these samples
+Output  : true if queued
+Comments: -
+====================================================================== */
+static bool bulkQueue(PString & req, uint16_t samples, uint16_t encoded)
+{
+  req += F(EMON_BULK_END);
+  emonbulkstat.rendered += req.length() - (strchr(req, HTTP_BODY_SEP) + 1 - (const char *) req);
+  emonbulkstat.encoded += encoded;
+
+  if (!req.overflow() && httpEnqueue(SINK_EMONCMS, req)) {
+    emonbulkstat.requests++;
+    sinkpush[SINK_EMONCMS].sent++;
+    return true;
+  }
+  emonbulkstat.dropped += samples;
+  return false;
+}
+
+/* ======================================================================
+Function: emonBulkPost
+Purpose : upload samples held
+Input   : -
+Output  : true if all requests have been queued
+Comments: as many requests as needed, each one fit in HTTP_URL_SIZE
+          when requests are lost, sample period doubles until one is
+          queued again, so buffer covers a longer time
+====================================================================== */
+boolean emonBulkPost(void)
+{
+  const uint8_t * p = emon_bulk;
+  const uint8_t * end = emon_bulk + emon_bulk_len;
+  const uint8_t * first = p;    // first record of current request
+  uint32_t time = emon_bulk_start;
+  uint16_t limit = HTTP_URL_SIZE - sizeof(EMON_BULK_END);
+  uint16_t samples = 0;
+  bool all = config.emoncms.push.mode != CFG_PUSH_CHANGE;
+  bool ok = true;
+  PString req(http_buffer, HTTP_URL_SIZE);
+
+  while (p < end) {
+    const uint8_t * rec = p;
+    const uint8_t * ids;
+    uint16_t mark = req.length();
+
+    // Apply record to decoder state
+    time += bulkGet(&p);
+    ids = p;
+    for (uint32_t id; (id = bulkGet(&p)); ) {
+      uint32_t z = bulkGet(&p);
+      emon_bulk_base[id - 1] += (z >> 1) ^ -(z & 1);
+      BULK_SET(emon_bulk_base_seen, id - 1);
+    }
+
+    if (samples) {
+      // Nothing changed
+      if (!all && !*ids)
+        continue;
+
+      req += ',';
+      bulkEntry(req, (int32_t) (time - seconds), all ? NULL : ids);
+      if (req.length() <= limit && !req.overflow()) {
+        samples++;
+        continue;
+      }
+
+      // Full, send what we have, this sample starts next request
+      req.truncate(mark);
+      if (!bulkQueue(req, samples, rec - first))
+        ok = false;
+      samples = 0;
+    }
+
+    first = rec;
+    bulkUrl(req);
+    bulkEntry(req, (int32_t) (time - seconds), NULL);
+    if (req.length() > limit || req.overflow()) {
+      // Even alone it does not fit
+      emonbulkstat.dropped++;
+      ok = false;
+      continue;
+    }
+    samples = 1;
+  }
+
+  if (samples && !bulkQueue(req, samples, end - first))
+    ok = false;
+
+  emon_bulk_len = 0;
+  emon_bulk_count = 0;
+  emon_bulk_start = emon_bulk_time;
+
+  // Degrade resolution while we lose samples
+  if (ok)
+    emonbulkstat.step = config.emoncms.bulk;
+  else if (emonbulkstat.step && emonbulkstat.step < EMON_BULK_STEP_MAX)
+    emonbulkstat.step *= 2;
+
+  return ok;
+}
+
+/* ======================================================================
+Function: emonBulkSample
+Purpose : keep current frame for next bulk upload
+Input   : -
+Output  : -
+Comments: called for each frame, when buffer is full samples are
+          uploaded right away
+====================================================================== */
+void emonBulkSample(void)
+{
+  if (!config.emoncms.bulk || !*config.emoncms.host || !tinfoframe.valid)
+    return;
+
+  if (emon_bulk_sampled && seconds - emon_bulk_time < emonbulkstat.step)
+    return;
+
+  if (!bulkEncode()) {
+    emonbulkstat.early++;
+    emonBulkPost();
+    if (!bulkEncode()) {
+      // Even in an empty buffer it does not fit
+      emonbulkstat.dropped++;
+      return;
+    }
+  }
+  emonbulkstat.samples++;
+}
+
+/* ======================================================================
+Function: emonBulkSetup
+Purpose : start bulk sampling from config
+Input   : -
+Output  : -
+Comments: samples held are uploaded first
+====================================================================== */
+void emonBulkSetup(void)
+{
+  if (emon_bulk_count)
+    emonBulkPost();
+  emonbulkstat.step = config.emoncms.bulk;
+}
+
+/* ======================================================================
+Function: emonBulkUsed
+Purpose : get samples buffer usage
+Input   : -
+Output  : bytes used
+Comments: -
+====================================================================== */
+uint16_t emonBulkUsed(void)
+{
+  return emon_bulk_len;
+}
+
+/* ======================================================================
+Function: emonBulkCount
+Purpose : get samples held
+Input   : -
+Output  : sample count
+Comments: -
+====================================================================== */
+uint16_t emonBulkCount(void)
+{
+  return emon_bulk_count;
+}
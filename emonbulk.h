@@ -0,0 +1,53 @@
+// **********************************************************************************
+// ESP8266 Teleinfo emoncms bulk upload Include file
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use , see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#ifndef EMONBULK_H
+#define EMONBULK_H
+
+// Include main project include file
+#include "Wifinfo.h"
+
+#define EMON_BULK_SIZE      2048        // delta compressed samples held between uploads
+#define EMON_BULK_STEP_MAX  64          // sample period cap (s) while uploads are lost
+#define EMON_BULK_URL       "bulk.json" // replaces last part of emoncms post URL
+#define EMON_BULK_END       "]&" HTTP_AGE_PARAM
+
+// Bulk upload statistics
+typedef struct
+{
+  uint32_t samples;       // samples stored
+  uint32_t requests;      // bulk requests queued
+  uint32_t dropped;       // samples lost, request could not be queued
+  uint32_t early;         // uploads forced by full buffer
+  uint32_t encoded;       // RAM bytes of uploaded samples
+  uint32_t rendered;      // request bytes of uploaded samples
+  uint8_t  step;          // current sample period (s)
+} _emonbulkstat;
+
+// Exported variables/object instancied in main sketch
+// ===================================================
+extern _emonbulkstat emonbulkstat;
+
+// declared exported function from emonbulk.cpp
+// ===================================================
+void emonBulkSample(void);
+boolean emonBulkPost(void);
+void emonBulkSetup(void);
+uint16_t emonBulkUsed(void);
+uint16_t emonBulkCount(void);
+
+#endif
@@ -0,0 +1,307 @@
+// **********************************************************************************
+// ESP8266 Teleinfo SPIFFS web files index
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use, see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+
+#include "fileindex.h"
+
+// Index statistics
+_fileindexstat fileindexstat;
+
+static _fileindex fileindex[FILE_INDEX_SIZE];
+
+// Content types by file extension
+typedef struct
+{
+  char ext[7];
+  char type[30];
+} _filetype;
+
+static const _filetype file_types[] PROGMEM = {
+  { ".htm",   "text/html" },
+  { ".html",  "text/html" },
+  { ".css",   "text/css" },
+  { ".json",  "text/json" },
+  { ".js",    "application/javascript" },
+  { ".png",   "image/png" },
+  { ".gif",   "image/gif" },
+  { ".jpg",   "image/jpeg" },
+  { ".ico",   "image/x-icon" },
+  { ".xml",   "text/xml" },
+  { ".pdf",   "application/x-pdf" },
+  { ".zip",   "application/x-zip" },
+  { ".gz",    "application/x-gzip" },
+  { ".otf",   "application/x-font-opentype" },
+  { ".eot",   "application/vnd.ms-fontobject" },
+  { ".svg",   "image/svg+xml" },
+  { ".woff",  "application/x-font-woff" },
+  { ".woff2", "application/x-font-woff2" },
+  { ".ttf",   "application/x-font-ttf" },
+};
+#define FILE_TYPES (sizeof(file_types) / sizeof(file_types[0]))
+
+// Paths browser may keep one day, same as former serveStatic()
+static const char * const file_static[] = { "/font", "/js/", "/css/" };
+
+/* ======================================================================
+Function: fileIndexType
+Purpose : find content type of a file
+Input   : path
+Output  : index in content types table, FILE_INDEX_UNKNOWN if none
+Comments: -
+====================================================================== */
+uint8_t fileIndexType(const char * path)
+{
+  size_t len = strlen(path);
+
+  for (uint8_t i = 0; i < FILE_TYPES; i++) {
+    PGM_P ext = file_types[i].ext;
+    size_t n = strlen_P(ext);
+
+    if (len >= n && !strcmp_P(path + len - n, ext))
+      return i;
+  }
+  return FILE_INDEX_UNKNOWN;
+}
+
+/* ======================================================================
+Function: fileIndexTypeName
+Purpose : content type
+Input   : index in content types table
+Output  : content type
+Comments: text/plain for FILE_INDEX_UNKNOWN
+====================================================================== */
+const __FlashStringHelper * fileIndexTypeName(uint8_t type)
+{
+  if (type >= FILE_TYPES)
+    return F("text/plain");
+  return FPSTR(file_types[type].type);
+}
+
+/* ======================================================================
+Function: fileIndexFind
+Purpose : look for a file in index
+Input   : path as requested
+Output  : entry, NULL if not there
+Comments: -
+====================================================================== */
+static _fileindex * fileIndexFind(const char * path)
+{
+  for (uint8_t i = 0; i < FILE_INDEX_SIZE; i++) {
+    if (*fileindex[i].path && !strcmp(fileindex[i].path, path))
+      return &fileindex[i];
+  }
+  return NULL;
+}
+
+/* ======================================================================
+Function: fileIndexPath
+Purpose : path a file is requested with
+Input   : file name on SPIFFS
+          where to put path
+Output  : FILE_INDEX_GZ if name is the gzip variant of path
+Comments: /js/x.js.gz is /js/x.js, /x.gz is /x.gz
+====================================================================== */
+static uint8_t fileIndexPath(const char * name, char * path)
+{
+  size_t len = strlen(name);
+
+  strncpy(path, name, FILE_INDEX_PATH - 1);
+  path[FILE_INDEX_PATH - 1] = '\0';
+
+  if (len > 3 && len < FILE_INDEX_PATH && !strcmp(name + len - 3, ".gz")) {
+    path[len - 3] = '\0';
+    if (fileIndexType(path) != FILE_INDEX_UNKNOWN)
+      return FILE_INDEX_GZ;
+    path[len - 3] = '.';
+  }
+  return 0;
+}
+
+/* ======================================================================
+Function: fileIndexAdd
+Purpose : add a file to index
+Input   : file name on SPIFFS
+Output  : -
+Comments: content is read once to compute its ETag, a gzip variant
+          wins over the plain file
+====================================================================== */
+static void fileIndexAdd(const char * name)
+{
+  char path[FILE_INDEX_PATH];
+  uint8_t flags = fileIndexPath(name, path);
+  uint8_t type = fileIndexType(path);
+  _fileindex * e;
+  uint8_t buf[FILE_INDEX_BLOCK];
+  uint32_t hash = 2166136261UL;
+  size_t n;
+  File f;
+
+  if (type == FILE_INDEX_UNKNOWN || strlen(name) >= FILE_INDEX_PATH)
+    return;
+
+  if ((e = fileIndexFind(path))) {
+    if ((e->flags & FILE_INDEX_GZ) && !(flags & FILE_INDEX_GZ))
+      return;
+  } else {
+    for (e = fileindex; e < fileindex + FILE_INDEX_SIZE && *e->path; e++)
+      ;
+    if (e == fileindex + FILE_INDEX_SIZE) {
+      fileindexstat.full = true;
+      return;
+    }
+    fileindexstat.files++;
+  }
+
+  if (!(f = SPIFFS.open(name, "r"))) {
+    *e->path = '\0';
+    fileindexstat.files--;
+    return;
+  }
+
+  while ((n = f.read(buf, sizeof(buf))) > 0) {
+    for (size_t i = 0; i < n; i++)
+      hash = (hash ^ buf[i]) * 16777619UL;
+    yield();
+  }
+
+  strcpy(e->path, path);
+  e->type = type;
+  e->flags = flags;
+  e->size = f.size();
+  e->etag = hash;
+  f.close();
+}
+
+/* ======================================================================
+Function: fileIndexBuild
+Purpose : index all web files
+Input   : -
+Output  : -
+Comments: called once SPIFFS is mounted
+====================================================================== */
+void fileIndexBuild(void)
+{
+  Dir dir = SPIFFS.openDir("/");
+
+  memset(fileindex, 0, sizeof(fileindex));
+  fileindexstat.files = 0;
+  fileindexstat.full = false;
+
+  while (dir.next())
+    fileIndexAdd(dir.fileName().c_str());
+}
+
+/* ======================================================================
+Function: fileIndexUpdate
+Purpose : a file has been uploaded or deleted
+Input   : file name on SPIFFS
+Output  : -
+Comments: entry is done again from what is on SPIFFS now, with or
+          without .gz
+====================================================================== */
+void fileIndexUpdate(const char * name)
+{
+  char path[FILE_INDEX_PATH + 3];
+  _fileindex * e;
+
+  fileIndexPath(name, path);
+  if ((e = fileIndexFind(path))) {
+    *e->path = '\0';
+    fileindexstat.files--;
+  }
+
+  if (SPIFFS.exists(path))
+    fileIndexAdd(path);
+  strcat(path, ".gz");
+  if (SPIFFS.exists(path))
+    fileIndexAdd(path);
+}
+
+/* ======================================================================
+Function: fileIndexKnows
+Purpose : tell if index is all we need to know about a path
+Input   : path as requested
+Output  : true if it is a web file and index has them all
+Comments: then a path not in index is not on SPIFFS
+====================================================================== */
+bool fileIndexKnows(const char * path)
+{
+  char name[FILE_INDEX_PATH];
+
+  if (fileindexstat.full)
+    return false;
+  fileIndexPath(path, name);
+  return fileIndexType(name) != FILE_INDEX_UNKNOWN;
+}
+
+/* ======================================================================
+Function: fileIndexSend
+Purpose : send a web file
+Input   : path as requested, / is /index.htm
+Output  : false if not in index
+Comments: one lookup in RAM, nothing read from flash for a 304
+====================================================================== */
+bool fileIndexSend(const char * path)
+{
+  char name[FILE_INDEX_PATH + 12];
+  char etag[12];
+  size_t len = strlen(path);
+  bool cache = false;
+  _fileindex * e;
+  File f;
+
+  if (!len || len >= FILE_INDEX_PATH) {
+    fileindexstat.misses++;
+    return false;
+  }
+  strcpy(name, path);
+  if (name[len - 1] == '/')
+    strcat(name, "index.htm");
+
+  if (!(e = fileIndexFind(name))) {
+    fileindexstat.misses++;
+    return false;
+  }
+
+  sprintf_P(etag, PSTR("\"%08x\""), e->etag);
+  for (uint8_t i = 0; i < sizeof(file_static) / sizeof(file_static[0]); i++) {
+    if (!strncmp(name, file_static[i], strlen(file_static[i])))
+      cache = true;
+  }
+
+  if (server.hasHeader(F("If-None-Match")) && server.header(F("If-None-Match")) == etag) {
+    fileindexstat.notmod++;
+    server.sendHeader(F("ETag"), etag);
+    server.send(304);
+    return true;
+  }
+
+  if (e->flags & FILE_INDEX_GZ)
+    strcat(name, ".gz");
+  if (!(f = SPIFFS.open(name, "r"))) {
+    // Removed behind our back
+    fileIndexUpdate(name);
+    fileindexstat.misses++;
+    return false;
+  }
+
+  fileindexstat.hits++;
+  server.sendHeader(F("ETag"), etag);
+  server.sendHeader(F("Cache-Control"), cache ? F("max-age=86400") : F("no-cache"));
+  server.streamFileAsync(f, fileIndexTypeName(e->type));
+  return true;
+}
@@ -0,0 +1,66 @@
+// **********************************************************************************
+// ESP8266 Teleinfo SPIFFS web files index Include file
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use , see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#ifndef FILEINDEX_H
+#define FILEINDEX_H
+
+// Include main project include file
+#include "Wifinfo.h"
+
+#define FILE_INDEX_SIZE     16    // web files we know
+#define FILE_INDEX_PATH     32    // SPIFFS max name size with ending 0
+#define FILE_INDEX_BLOCK    128   // read by blocks of this size to hash content
+#define FILE_INDEX_UNKNOWN  0xFF  // type of a file not in content types table
+
+// Served from path.gz
+#define FILE_INDEX_GZ       0x01
+
+// One web file, only files with a known content type are indexed,
+// others (logs, spool, captures) change behind our back
+typedef struct
+{
+  char     path[FILE_INDEX_PATH]; // as requested, without .gz
+  uint8_t  type;                  // in content types table
+  uint8_t  flags;                 // FILE_INDEX_xxx
+  uint32_t size;                  // of what we send
+  uint32_t etag;                  // FNV-1a of what we send
+} _fileindex;
+
+// Index statistics
+typedef struct
+{
+  uint32_t hits;          // files sent
+  uint32_t notmod;        // 304 answered
+  uint32_t misses;        // requests not in index
+  uint8_t  files;         // files in index
+  bool     full;          // some web files did not fit, misses go to flash
+} _fileindexstat;
+
+// Exported variables/object instancied in main sketch
+// ===================================================
+extern _fileindexstat fileindexstat;
+
+// declared exported function from fileindex.cpp
+// ===================================================
+uint8_t fileIndexType(const char * path);
+const __FlashStringHelper * fileIndexTypeName(uint8_t type);
+void fileIndexBuild(void);
+void fileIndexUpdate(const char * name);
+bool fileIndexKnows(const char * path);
+bool fileIndexSend(const char * path);
+
+#endif
@@ -0,0 +1,252 @@
+// **********************************************************************************
+// ESP8266 Teleinfo gzip compressor
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use, see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+
+#include "gzip.h"
+
+// Compressor statistics
+_gzipstat gzipstat;
+
+// Last position of each 3 bytes hash, 0 is none (positions are + 1)
+static uint16_t gzip_hash[1 << GZIP_HASH_BITS];
+
+// Output bit stream
+static uint8_t * gzip_out;
+static uint16_t gzip_size;
+static uint16_t gzip_pos;
+static uint32_t gzip_bits;
+static uint8_t gzip_count;
+
+// Deflate length codes 257..285 base and extra bits (RFC 1951 3.2.5)
+static const uint16_t gzip_len_base[] PROGMEM = {
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t gzip_len_extra[] PROGMEM = {
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+
+// Deflate distance codes 0..29 base and extra bits
+static const uint16_t gzip_dist_base[] PROGMEM = {
+  1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+  257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const uint8_t gzip_dist_extra[] PROGMEM = {
+  0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+  7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+// CRC-32 (IEEE) by nibble, small table
+static const uint32_t gzip_crc_table[16] PROGMEM = {
+  0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+  0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c, 0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c };
+
+/* ======================================================================
+Function: gzipCrc
+Purpose : compute CRC-32 of a buffer
+Input   : data, length
+Output  : CRC-32
+Comments: -
+====================================================================== */
+static uint32_t gzipCrc(const uint8_t * data, uint16_t len)
+{
+  uint32_t crc = 0xFFFFFFFF;
+
+  while (len--) {
+    crc ^= *data++;
+    crc = pgm_read_dword(&gzip_crc_table[crc & 0x0F]) ^ (crc >> 4);
+    crc = pgm_read_dword(&gzip_crc_table[crc & 0x0F]) ^ (crc >> 4);
+  }
+  return ~crc;
+}
+
+/* ======================================================================
+Function: gzipHash
+Purpose : hash of 3 bytes for match finder
+Input   : data
+Output  : hash table index
+Comments: -
+====================================================================== */
+static inline uint16_t gzipHash(const uint8_t * p)
+{
+  return ((p[0] << 5) ^ (p[1] << 2) ^ p[2] ^ (p[1] >> 3)) & ((1 << GZIP_HASH_BITS) - 1);
+}
+
+/* ======================================================================
+Function: gzipPutBits
+Purpose : write bits to output, LSB first
+Input   : value, number of bits (max 16)
+Output  : -
+Comments: output overflow is detected by caller from gzip_pos
+====================================================================== */
+static void gzipPutBits(uint16_t value, uint8_t count)
+{
+  gzip_bits |= (uint32_t) value << gzip_count;
+  gzip_count += count;
+  while (gzip_count >= 8) {
+    if (gzip_pos < gzip_size)
+      gzip_out[gzip_pos] = gzip_bits;
+    gzip_pos++;
+    gzip_bits >>= 8;
+    gzip_count -= 8;
+  }
+}
+
+/* ======================================================================
+Function: gzipPutCode
+Purpose : write a Huffman code, MSB first as deflate wants
+Input   : code, number of bits
+Output  : -
+Comments: -
+====================================================================== */
+static void gzipPutCode(uint16_t code, uint8_t count)
+{
+  uint16_t rev = 0;
+
+  for (uint8_t i = 0; i < count; i++, code >>= 1)
+    rev = (rev << 1) | (code & 1);
+  gzipPutBits(rev, count);
+}
+
+/* ======================================================================
+Function: gzipSymbol
+Purpose : write a literal/length symbol with fixed Huffman codes
+Input   : symbol 0..287
+Output  : -
+Comments: RFC 1951 3.2.6
+====================================================================== */
+static void gzipSymbol(uint16_t sym)
+{
+  if (sym < 144)
+    gzipPutCode(0x30 + sym, 8);
+  else if (sym < 256)
+    gzipPutCode(0x190 + sym - 144, 9);
+  else if (sym < 280)
+    gzipPutCode(sym - 256, 7);
+  else
+    gzipPutCode(0xC0 + sym - 280, 8);
+}
+
+/* ======================================================================
+Function: gzipMatch
+Purpose : write a length/distance pair
+Input   : length 3..258, distance 1..32768
+Output  : -
+Comments: -
+====================================================================== */
+static void gzipMatch(uint16_t len, uint16_t dist)
+{
+  uint8_t code = 28;
+  uint8_t extra;
+
+  while (len < pgm_read_word(&gzip_len_base[code]))
+    code--;
+  gzipSymbol(257 + code);
+  extra = pgm_read_byte(&gzip_len_extra[code]);
+  if (extra)
+    gzipPutBits(len - pgm_read_word(&gzip_len_base[code]), extra);
+
+  code = 29;
+  while (dist < pgm_read_word(&gzip_dist_base[code]))
+    code--;
+  gzipPutCode(code, 5);
+  extra = pgm_read_byte(&gzip_dist_extra[code]);
+  if (extra)
+    gzipPutBits(dist - pgm_read_word(&gzip_dist_base[code]), extra);
+}
+
+/* ======================================================================
+Function: gzipCompress
+Purpose : compress a buffer to gzip format
+Input   : plain data and length
+          output buffer and size
+Output  : compressed size, 0 if it does not fit or does not shrink
+Comments: one fixed Huffman block, greedy LZ77 with one candidate per
+          hash, good enough on repetitive text like line protocol
+====================================================================== */
+uint16_t gzipCompress(const uint8_t * in, uint16_t len, uint8_t * out, uint16_t size)
+{
+  static const uint8_t header[10] PROGMEM = { 0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 3 };
+  uint32_t crc;
+  uint16_t i = 0;
+
+  gzipstat.calls++;
+  gzipstat.in += len;
+
+  // Only worth it if smaller
+  if (size > len)
+    size = len;
+  if (size < GZIP_OVERHEAD) {
+    gzipstat.fallback++;
+    return 0;
+  }
+
+  memcpy_P(out, header, sizeof(header));
+  gzip_out = out;
+  gzip_size = size - 8;
+  gzip_pos = sizeof(header);
+  gzip_bits = 0;
+  gzip_count = 0;
+  memset(gzip_hash, 0, sizeof(gzip_hash));
+
+  // Last block, fixed Huffman codes
+  gzipPutBits(1, 1);
+  gzipPutBits(1, 2);
+
+  while (i < len && gzip_pos < gzip_size) {
+    uint16_t best = 0;
+
+    if (i + GZIP_MIN_MATCH <= len) {
+      uint16_t cand = gzip_hash[gzipHash(in + i)];
+
+      gzip_hash[gzipHash(in + i)] = i + 1;
+      if (cand--) {
+        uint16_t max = len - i < GZIP_MAX_MATCH ? len - i : GZIP_MAX_MATCH;
+
+        while (best < max && in[cand + best] == in[i + best])
+          best++;
+        if (best >= GZIP_MIN_MATCH) {
+          gzipMatch(best, i - cand);
+
+          // Positions we skip can still be matched later
+          for (uint16_t end = i + best; ++i < end; ) {
+            if (i + GZIP_MIN_MATCH <= len)
+              gzip_hash[gzipHash(in + i)] = i + 1;
+          }
+          continue;
+        }
+      }
+    }
+    gzipSymbol(in[i++]);
+  }
+
+  // End of block, pad to byte
+  gzipSymbol(256);
+  gzipPutBits(0, 7);
+
+  if (i < len || gzip_pos > gzip_size) {
+    gzipstat.fallback++;
+    return 0;
+  }
+
+  // Trailer, CRC and size little endian
+  crc = gzipCrc(in, len);
+  for (uint8_t b = 0; b < 4; b++)
+    out[gzip_pos++] = crc >> (8 * b);
+  for (uint8_t b = 0; b < 4; b++)
+    out[gzip_pos++] = (uint32_t) len >> (8 * b);
+
+  gzipstat.out += gzip_pos;
+  return gzip_pos;
+}
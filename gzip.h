@@ -0,0 +1,46 @@
+// **********************************************************************************
+// ESP8266 Teleinfo gzip compressor Include file
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use , see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#ifndef GZIP_H
+#define GZIP_H
+
+// Include main project include file
+#include "Wifinfo.h"
+
+#define GZIP_HASH_BITS    8     // match finder hash table of 2^n entries
+#define GZIP_MIN_MATCH    3
+#define GZIP_MAX_MATCH    258
+#define GZIP_OVERHEAD     18    // header and trailer bytes
+
+// Compressor statistics
+typedef struct
+{
+  uint32_t calls;         // bodies compressed
+  uint32_t in;            // plain bytes
+  uint32_t out;           // compressed bytes
+  uint32_t fallback;      // bodies sent plain, no gain or no room
+} _gzipstat;
+
+// Exported variables/object instancied in main sketch
+// ===================================================
+extern _gzipstat gzipstat;
+
+// declared exported function from gzip.cpp
+// ===================================================
+uint16_t gzipCompress(const uint8_t * in, uint16_t len, uint8_t * out, uint16_t size);
+
+#endif
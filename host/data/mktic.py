@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+# **********************************************************************************
+# WifInfo host build, teleinfo recordings generator
+# **********************************************************************************
+# Creative Commons Attrib Share-Alike License
+# You are free to use/extend this library but please abide with the CC-BY-SA license:
+# Attribution-NonCommercial-ShareAlike 4.0 International License
+# http://creativecommons.org/licenses/by-nc-sa/4.0/
+#
+# Writes historique.tic and standard.tic, raw byte streams as the meter
+# sends them (7 bit chars, STX/ETX framed). Meter identifiers are fake,
+# load follows a fixed pseudo random walk so files are reproducible.
+#
+#   python3 mktic.py
+#
+# All text above must be included in any redistribution.
+#
+# **********************************************************************************
+import os
+import random
+
+STX, ETX, LF, CR, HT = '\x02', '\x03', '\n', '\r', '\t'
+
+
+def checksum(data):
+    return chr((sum(data.encode('ascii')) & 0x3F) + 0x20)
+
+
+def historic_group(label, value):
+    # Checksum on label SP value
+    return LF + label + ' ' + value + ' ' + checksum(label + ' ' + value) + CR
+
+
+def standard_group(label, value, horodate=None):
+    # Checksum on everything up to last HT included
+    data = label + HT + (horodate + HT if horodate is not None else '') + value + HT
+    return LF + data + checksum(data) + CR
+
+
+def historic(frames, rnd):
+    hchc, hchp = 1234567, 7654321
+    out = []
+    for n in range(frames):
+        hp = (n // 120) % 2 == 0
+        papp = 300 + rnd.randrange(0, 40) * 50 if n % 7 else 3500
+        iinst = (papp + 115) // 230
+        if hp:
+            hchp += papp // 36
+        else:
+            hchc += papp // 36
+        groups = [
+            ('ADCO', '031428097115'),
+            ('OPTARIF', 'HC..'),
+            ('ISOUSC', '30'),
+            ('HCHC', '%09d' % hchc),
+            ('HCHP', '%09d' % hchp),
+            ('PTEC', 'HP..' if hp else 'HC..'),
+            ('IINST', '%03d' % iinst),
+            ('IMAX', '042'),
+            ('PAPP', '%05d' % papp),
+            ('HHPHC', 'A'),
+            ('MOTDETAT', '000000'),
+        ]
+        out.append(STX + ''.join(historic_group(l, v) for l, v in groups) + ETX)
+    return ''.join(out)
+
+
+def standard(frames, rnd):
+    easf01, easf02 = 9876543, 13580246
+    out = []
+    for n in range(frames):
+        hp = (n // 60) % 2 == 0
+        sinsts = 400 + rnd.randrange(0, 60) * 50 if n % 9 else 6200
+        irms = (sinsts + 115) // 230
+        if hp:
+            easf02 += sinsts // 360
+        else:
+            easf01 += sinsts // 360
+        east = easf01 + easf02
+        date = 'E230615%02d%02d%02d' % (10 + n // 3600, (n // 60) % 60, n % 60)
+        groups = [
+            ('ADSC', '041876543210', None),
+            ('VTIC', '02', None),
+            ('DATE', '', date),
+            ('NGTF', 'H PLEINE/CREUSE ', None),
+            ('LTARF', ' HEURE  PLEINE  ' if hp else ' HEURE  CREUSE  ', None),
+            ('EAST', '%09d' % east, None),
+            ('EASF01', '%09d' % easf01, None),
+            ('EASF02', '%09d' % easf02, None),
+            ('EASF03', '000000000', None),
+            ('EASF04', '000000000', None),
+            ('EASF05', '000000000', None),
+            ('EASF06', '000000000', None),
+            ('EASF07', '000000000', None),
+            ('EASF08', '000000000', None),
+            ('EASF09', '000000000', None),
+            ('EASF10', '000000000', None),
+            ('EASD01', '%09d' % easf02, None),
+            ('EASD02', '%09d' % easf01, None),
+            ('EASD03', '000000000', None),
+            ('EASD04', '000000000', None),
+            ('IRMS1', '%03d' % irms, None),
+            ('URMS1', '%03d' % (229 + rnd.randrange(0, 4)), None),
+            ('PREF', '09', None),
+            ('PCOUP', '09', None),
+            ('SINSTS', '%05d' % sinsts, None),
+            ('SMAXSN', '06200', 'E230615093512'),
+            ('SMAXSN-1', '05830', 'E230614191045'),
+            ('CCASN', '%05d' % (sinsts // 2), 'E230615100000'),
+            ('CCASN-1', '01250', 'E230615093000'),
+            ('UMOY1', '230', 'E230615100000'),
+            ('STGE', '003A0001', None),
+            ('MSG1', 'PAS DE          MESSAGE         ', None),
+            ('PRM', '09876543210123', None),
+            ('RELAIS', '000', None),
+            ('NTARF', '02' if hp else '01', None),
+            ('NJOURF', '00', None),
+            ('NJOURF+1', '00', None),
+            ('PJOURF+1', '00004001 06004002 22004001 NONUTILE NONUTILE NONUTILE '
+                         'NONUTILE NONUTILE NONUTILE NONUTILE NONUTILE', None),
+        ]
+        out.append(STX + ''.join(standard_group(l, v, h) for l, v, h in groups) + ETX)
+    return ''.join(out)
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    # About 3.5 and 2 minutes of line time
+    with open(os.path.join(here, 'historique.tic'), 'wb') as f:
+        f.write(historic(150, random.Random(1)).encode('ascii'))
+    with open(os.path.join(here, 'standard.tic'), 'wb') as f:
+        f.write(standard(120, random.Random(2)).encode('ascii'))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,26 @@
+# Turn the sketch into a C++ file like the Arduino builder does:
+# Arduino.h first, then prototypes of functions defined in the sketch
+# so they can be used before their definition.
+#   cmake -DINO=<sketch.ino> -DOUT=<file.cpp> -P ino2cpp.cmake
+
+file(READ "${INO}" src)
+string(REGEX MATCHALL
+  "\n(static )?(void|int|bool|boolean|uint[0-9]+_t|int[0-9]+_t|size_t|char \\*|const char \\*|String|unsigned long|float) +\\**[A-Za-z_0-9]+ *\\([^;\n]*\\)[ \t\r]*\n"
+  protos "${src}")
+
+set(out "#include <Arduino.h>\n#include \"Wifinfo.h\"\n\n")
+foreach(p ${protos})
+  string(STRIP "${p}" p)
+  # default values are only given once, in definition
+  string(REGEX REPLACE "=[^,)]*" "" p "${p}")
+  string(APPEND out "${p};\n")
+endforeach()
+string(APPEND out "\n#line 1 \"${INO}\"\n#include \"${INO}\"\n")
+
+# Don't touch output if nothing changed, saves a rebuild
+if(EXISTS "${OUT}")
+  file(READ "${OUT}" old)
+endif()
+if(NOT old STREQUAL out)
+  file(WRITE "${OUT}" "${out}")
+endif()
@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+# **********************************************************************************
+# WifInfo host build, teleinfo labels perfect hash generator
+# **********************************************************************************
+# Creative Commons Attrib Share-Alike License
+# You are free to use/extend this library but please abide with the CC-BY-SA license:
+# Attribution-NonCommercial-ShareAlike 4.0 International License
+# http://creativecommons.org/licenses/by-nc-sa/4.0/
+#
+# Reads tinfo_label_names[] of tinfolabels.cpp, looks for the first seed
+# from FNV-1a offset basis giving each label its own slot, then rewrites
+# tinfo_label_slots[] and TINFO_LABEL_SEED. Hash and fold are the ones
+# of tinfolabels.h, the static_assert there checks the result.
+#
+#   python3 mklabels.py
+#
+# All text above must be included in any redistribution.
+#
+# **********************************************************************************
+import os
+import re
+import sys
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..')
+SOURCE = os.path.join(ROOT, 'tinfolabels.cpp')
+HEADER = os.path.join(ROOT, 'tinfolabels.h')
+
+FNV_BASIS = 0x811c9dc5
+FNV_PRIME = 16777619
+
+
+def label_hash(name, seed):
+    h = seed
+    for c in name.encode('ascii'):
+        h = ((h ^ c) * FNV_PRIME) & 0xFFFFFFFF
+    return h
+
+
+def label_slot(name, seed, slots):
+    h = label_hash(name, seed)
+    return (h ^ (h >> 16)) & (slots - 1)
+
+
+def find_seed(names, slots):
+    seed = FNV_BASIS
+    while True:
+        used = set(label_slot(n, seed, slots) for n in names)
+        if len(used) == len(names):
+            return seed
+        seed = (seed + 1) & 0xFFFFFFFF
+        if seed == FNV_BASIS:
+            sys.exit('no collision free seed for %d slots' % slots)
+
+
+def table(names, seed, slots):
+    cells = [0] * slots
+    for i, n in enumerate(names):
+        cells[label_slot(n, seed, slots)] = i + 1
+    lines = []
+    for i in range(0, slots, 16):
+        lines.append('  ' + ', '.join('%3d' % c for c in cells[i:i + 16]))
+    return ',\n'.join(lines) + '\n'
+
+
+def main():
+    with open(SOURCE) as f:
+        source = f.read()
+    with open(HEADER) as f:
+        header = f.read()
+
+    slots = int(re.search(r'#define TINFO_LABEL_SLOTS\s+(\d+)', header).group(1))
+    names = re.search(r'tinfo_label_names\[\]\[TINFO_LABEL_SIZE\] PROGMEM = \{(.*?)\};',
+                      source, re.S).group(1)
+    names = re.findall(r'"([^"]*)"', names)
+    seed = find_seed(names, slots)
+
+    source = re.sub(r'(tinfo_label_slots\[TINFO_LABEL_SLOTS\] PROGMEM = \{\n).*?(\};)',
+                    lambda m: m.group(1) + table(names, seed, slots) + m.group(2),
+                    source, flags=re.S)
+    header = re.sub(r'(#define TINFO_LABEL_SEED\s+)0x[0-9a-fA-F]+UL',
+                    lambda m: m.group(1) + '0x%08xUL' % seed, header)
+
+    with open(SOURCE, 'w') as f:
+        f.write(source)
+    with open(HEADER, 'w') as f:
+        f.write(header)
+    print('%d labels, %d slots, seed 0x%08x' % (len(names), slots, seed))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,334 @@
+// **********************************************************************************
+// WifInfo host build, Arduino core stand-in
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// Only what the sketch uses, with the ESP8266 core 3.x signatures.
+// Time is virtual, see host.h, PROGMEM strings are plain strings.
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <ctype.h>
+#include <stdarg.h>
+#include <functional>
+#include <algorithm>
+
+#define ARDUINO                 10805
+#define ARDUINO_ARCH_ESP8266
+#include "core_version.h"
+
+#define PROGMEM
+#define PSTR(s)                 (s)
+#define PGM_P                   const char *
+class __FlashStringHelper;
+#define F(s)                    (reinterpret_cast<const __FlashStringHelper *>(PSTR(s)))
+#define FPSTR(p)                (reinterpret_cast<const __FlashStringHelper *>(p))
+#define sprintf_P               sprintf
+#define snprintf_P              snprintf
+#define vsnprintf_P             vsnprintf
+#define strcpy_P                strcpy
+#define strncpy_P               strncpy
+#define strcat_P                strcat
+#define strcmp_P                strcmp
+#define strncmp_P               strncmp
+#define strcasecmp_P            strcasecmp
+#define strncasecmp_P           strncasecmp
+#define strstr_P                strstr
+#define strlen_P                strlen
+#define memcpy_P                memcpy
+#define pgm_read_byte(p)        (*(const uint8_t *)(p))
+#define pgm_read_word(p)        (*(const uint16_t *)(p))
+#define pgm_read_dword(p)       (*(const uint32_t *)(p))
+
+// In newlib of the core, glibc only has it since 2.38
+#if defined(__GLIBC__) && !__GLIBC_PREREQ(2, 38)
+inline size_t strlcpy(char * dst, const char * src, size_t size)
+{
+  size_t len = strlen(src);
+
+  if (size) {
+    size_t n = len < size - 1 ? len : size - 1;
+
+    memcpy(dst, src, n);
+    dst[n] = '\0';
+  }
+  return len;
+}
+#endif
+
+typedef bool    boolean;
+typedef uint8_t byte;
+
+#define INPUT   0x00
+#define OUTPUT  0x01
+#define LOW     0
+#define HIGH    1
+#define A0      17
+#define DEC     10
+#define HEX     16
+
+using std::min;
+using std::max;
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield(void);
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+long random(long howbig);
+long random(long howsmall, long howbig);
+
+class String;
+
+class Print
+{
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t) = 0;
+  virtual size_t write(const uint8_t * buffer, size_t size);
+  size_t write(const char * s) { return s ? write((const uint8_t *) s, strlen(s)) : 0; }
+  size_t write(const char * buffer, size_t size) { return write((const uint8_t *) buffer, size); }
+  virtual int availableForWrite() { return 0; }
+  virtual void flush() {}
+
+  size_t print(const __FlashStringHelper *);
+  size_t print(const String &);
+  size_t print(const char[]);
+  size_t print(char);
+  size_t print(unsigned char, int = DEC);
+  size_t print(int, int = DEC);
+  size_t print(unsigned int, int = DEC);
+  size_t print(long, int = DEC);
+  size_t print(unsigned long, int = DEC);
+  size_t print(long long, int = DEC);
+  size_t print(unsigned long long, int = DEC);
+  size_t print(double, int = 2);
+
+  size_t println(const __FlashStringHelper *);
+  size_t println(const String &);
+  size_t println(const char[]);
+  size_t println(char);
+  size_t println(unsigned char, int = DEC);
+  size_t println(int, int = DEC);
+  size_t println(unsigned int, int = DEC);
+  size_t println(long, int = DEC);
+  size_t println(unsigned long, int = DEC);
+  size_t println(long long, int = DEC);
+  size_t println(unsigned long long, int = DEC);
+  size_t println(double, int = 2);
+  size_t println(void);
+
+  size_t printf(const char * format, ...) __attribute__ ((format (printf, 2, 3)));
+  size_t printf_P(PGM_P format, ...) __attribute__ ((format (printf, 2, 3)));
+
+private:
+  size_t printNumber(unsigned long long n, int base);
+};
+
+class Stream : public Print
+{
+public:
+  Stream() : _timeout(1000) {}
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+
+  void setTimeout(unsigned long timeout) { _timeout = timeout; }
+  unsigned long getTimeout(void) const { return _timeout; }
+  virtual size_t readBytes(char * buffer, size_t length);
+  size_t readBytes(uint8_t * buffer, size_t length) { return readBytes((char *) buffer, length); }
+  String readStringUntil(char terminator);
+  String readString();
+
+protected:
+  int timedRead();
+  unsigned long _timeout;
+};
+
+// Heap backed like core 3.x WString (short strings kept inline), so
+// allocations are counted by host heap
+#define STRING_SSO 10
+class String
+{
+public:
+  String(const char * cstr = "");
+  String(const String & str);
+  String(const __FlashStringHelper * str);
+  explicit String(char c);
+  explicit String(unsigned char, unsigned char base = 10);
+  explicit String(int, unsigned char base = 10);
+  explicit String(unsigned int, unsigned char base = 10);
+  explicit String(long, unsigned char base = 10);
+  explicit String(unsigned long, unsigned char base = 10);
+  explicit String(float, unsigned char decimalPlaces = 2);
+  explicit String(double, unsigned char decimalPlaces = 2);
+  ~String();
+
+  String & operator =(const String & rhs);
+  String & operator =(const char * cstr);
+  String & operator =(const __FlashStringHelper * str);
+
+  bool reserve(unsigned int size);
+  unsigned int length(void) const { return _len; }
+  const char * c_str() const { return _buf; }
+  char * begin() { return _buf; }
+  char * end() { return _buf + _len; }
+
+  bool concat(const char * cstr, unsigned int length);
+  String & operator +=(const String & rhs);
+  String & operator +=(const char * cstr);
+  String & operator +=(char c);
+  String & operator +=(unsigned char num);
+  String & operator +=(int num);
+  String & operator +=(unsigned int num);
+  String & operator +=(long num);
+  String & operator +=(unsigned long num);
+  String & operator +=(float num);
+  String & operator +=(double num);
+  String & operator +=(const __FlashStringHelper * str);
+
+  friend String operator +(const String & lhs, const String & rhs);
+  friend String operator +(const String & lhs, const char * cstr);
+  friend String operator +(const String & lhs, char c);
+  friend String operator +(const String & lhs, const __FlashStringHelper * rhs);
+  friend String operator +(const char * lhs, const String & rhs);
+
+  int compareTo(const String & s) const;
+  bool equals(const String & s) const { return compareTo(s) == 0; }
+  bool equals(const char * cstr) const;
+  bool equalsIgnoreCase(const String & s) const;
+  bool operator ==(const String & rhs) const { return equals(rhs); }
+  bool operator ==(const char * cstr) const { return equals(cstr); }
+  bool operator !=(const String & rhs) const { return !equals(rhs); }
+  bool operator !=(const char * cstr) const { return !equals(cstr); }
+  bool operator <(const String & rhs) const { return compareTo(rhs) < 0; }
+  bool startsWith(const String & prefix) const;
+  bool endsWith(const String & suffix) const;
+
+  char charAt(unsigned int index) const { return (*this)[index]; }
+  char operator [](unsigned int index) const;
+  char & operator [](unsigned int index);
+  int indexOf(char ch, unsigned int fromIndex = 0) const;
+  int indexOf(const String & str, unsigned int fromIndex = 0) const;
+  int lastIndexOf(char ch) const;
+  String substring(unsigned int beginIndex) const { return substring(beginIndex, _len); }
+  String substring(unsigned int beginIndex, unsigned int endIndex) const;
+  void remove(unsigned int index);
+  void remove(unsigned int index, unsigned int count);
+  void replace(const String & find, const String & replace);
+  void toLowerCase(void);
+  void toUpperCase(void);
+  void trim(void);
+
+  long toInt(void) const { return atol(c_str()); }
+  float toFloat(void) const { return atof(c_str()); }
+  double toDouble(void) const { return atof(c_str()); }
+
+private:
+  void init(void) { _buf = _sso; _len = 0; _cap = STRING_SSO; _sso[0] = '\0'; }
+  void copy(const char * cstr, unsigned int length);
+  char * _buf;
+  unsigned int _len;
+  unsigned int _cap;
+  char _sso[STRING_SSO + 1];
+};
+
+#define SERIAL_7E1 0x1a
+#define SERIAL_8N1 0x1c
+
+// UART, RX is fed by host at line speed from a TIC file, see host.h
+class HardwareSerial : public Stream
+{
+public:
+  HardwareSerial(int uart) : _uart(uart) {}
+  void begin(unsigned long baud, int config = SERIAL_8N1);
+  void end();
+  void swap();
+  void updateBaudRate(unsigned long baud);
+  int baudRate(void);
+  size_t setRxBufferSize(size_t size);
+  int available(void) override;
+  int peek(void) override;
+  int read(void) override;
+  size_t read(char * buffer, size_t size);
+  size_t readBytes(char * buffer, size_t size) override;
+  size_t readBytes(uint8_t * buffer, size_t size) { return readBytes((char *) buffer, size); }
+  bool hasOverrun(void);
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t * buffer, size_t size) override;
+  using Print::write;
+  int availableForWrite(void) override { return 128; }
+  void flush(void) override {}
+  void setDebugOutput(bool) {}
+  operator bool() const { return true; }
+
+private:
+  int _uart;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+
+class EspClass
+{
+public:
+  uint32_t getFreeHeap(void);
+  uint32_t getMaxFreeBlockSize(void);
+  uint8_t getHeapFragmentation(void);
+  uint32_t getChipId(void);
+  uint32_t getFlashChipRealSize(void);
+  uint32_t getFlashChipSize(void);
+  uint32_t getSketchSize(void);
+  uint32_t getFreeSketchSpace(void);
+  uint32_t getCycleCount(void);
+  uint8_t getCpuFreqMHz(void);
+  String getResetReason(void);
+  void restart(void);
+  void reset(void);
+  void wdtFeed(void) {}
+  bool eraseConfig(void);
+};
+
+extern EspClass ESP;
+
+#define U_FLASH 0
+#define U_FS    100
+
+class UpdaterClass
+{
+public:
+  bool begin(size_t size, int command = U_FLASH);
+  size_t write(uint8_t * data, size_t len);
+  bool end(bool evenIfRemaining = false);
+  bool hasError(void);
+  void printError(Print & out);
+  size_t progress(void) { return _written; }
+
+private:
+  size_t _size = 0;
+  size_t _written = 0;
+  bool _error = false;
+};
+
+extern UpdaterClass Update;
+
+#endif
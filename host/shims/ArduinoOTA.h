@@ -0,0 +1,35 @@
+// WifInfo host build, ArduinoOTA stand-in, never receives an update
+#ifndef HOST_ARDUINOOTA_H
+#define HOST_ARDUINOOTA_H
+
+#include "Arduino.h"
+
+typedef enum { OTA_AUTH_ERROR, OTA_BEGIN_ERROR, OTA_CONNECT_ERROR, OTA_RECEIVE_ERROR, OTA_END_ERROR } ota_error_t;
+
+class ArduinoOTAClass
+{
+public:
+  typedef std::function<void(void)> THandlerFunction;
+  typedef std::function<void(ota_error_t)> THandlerFunction_Error;
+  typedef std::function<void(unsigned int, unsigned int)> THandlerFunction_Progress;
+
+  void setPort(uint16_t) {}
+  void setHostname(const char *) {}
+  void setPassword(const char *) {}
+  void onStart(THandlerFunction fn) { _start = fn; }
+  void onEnd(THandlerFunction fn) { _end = fn; }
+  void onError(THandlerFunction_Error fn) { _error = fn; }
+  void onProgress(THandlerFunction_Progress fn) { _progress = fn; }
+  void begin() {}
+  void handle() {}
+
+private:
+  THandlerFunction          _start;
+  THandlerFunction          _end;
+  THandlerFunction_Error    _error;
+  THandlerFunction_Progress _progress;
+};
+
+extern ArduinoOTAClass ArduinoOTA;
+
+#endif
@@ -0,0 +1,36 @@
+// **********************************************************************************
+// WifInfo host build, EEPROM stand-in
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#ifndef HOST_EEPROM_H
+#define HOST_EEPROM_H
+
+#include "Arduino.h"
+
+#define HOST_EEPROM_SIZE 4096
+
+class EEPROMClass
+{
+public:
+  void begin(size_t size);
+  uint8_t read(int address);
+  void write(int address, uint8_t val);
+  bool commit();
+  void end();
+  uint8_t * getDataPtr();
+  size_t length() { return _size; }
+
+private:
+  size_t _size = 0;
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
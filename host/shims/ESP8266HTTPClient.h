@@ -0,0 +1,57 @@
+// **********************************************************************************
+// WifInfo host build, HTTPClient stand-in
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// Blocking requests over the in process TCP of WiFi.cpp, so they reach
+// stand-in servers of tests. One request per connection, like the
+// core with reuse off.
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#ifndef HOST_ESP8266HTTPCLIENT_H
+#define HOST_ESP8266HTTPCLIENT_H
+
+#include "ESP8266WiFi.h"
+
+#define HTTPC_ERROR_CONNECTION_REFUSED  (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED  (-2)
+#define HTTPC_ERROR_CONNECTION_LOST     (-5)
+#define HTTPC_ERROR_READ_TIMEOUT        (-11)
+
+#define HTTPCLIENT_DEFAULT_TCP_TIMEOUT  5000
+
+class HTTPClient
+{
+public:
+  HTTPClient();
+  ~HTTPClient();
+
+  bool begin(const String & host, uint16_t port, const String & uri);
+  void end(void);
+  void setAuthorization(const char * user, const char * password);
+  void setTimeout(uint16_t timeout) { _timeout = timeout; }
+
+  int GET(void);
+  int POST(const String & payload);
+  String getString(void) { return _body; }
+  int getSize(void) { return _body.length(); }
+
+private:
+  int request(const char * method, const String & payload);
+  bool readLine(String & line);
+
+  WiFiClient _client;
+  String     _host;
+  uint16_t   _port;
+  String     _uri;
+  String     _auth;
+  String     _body;
+  uint16_t   _timeout;
+};
+
+#endif
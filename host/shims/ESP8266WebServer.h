@@ -0,0 +1,187 @@
+// **********************************************************************************
+// WifInfo host build, ESP8266WebServer stand-in
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// Same parser, handler dispatch and response helpers as core 3.x
+// ESP8266WebServer, protected members WebConnServer uses included.
+// Multipart bodies are only parsed for uploads, like the core does.
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#ifndef HOST_ESP8266WEBSERVER_H
+#define HOST_ESP8266WEBSERVER_H
+
+#include "ESP8266WiFi.h"
+#include "FS.h"
+#include <memory>
+#include <vector>
+
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS };
+enum HTTPUploadStatus { UPLOAD_FILE_START, UPLOAD_FILE_WRITE, UPLOAD_FILE_END, UPLOAD_FILE_ABORTED };
+enum HTTPClientStatus { HC_NONE, HC_WAIT_READ, HC_WAIT_CLOSE };
+
+#define HTTP_DOWNLOAD_UNIT_SIZE 1460
+#define HTTP_UPLOAD_BUFLEN      2048
+#define HTTP_MAX_DATA_WAIT      5000 // ms to wait for the client to send the request
+#define HTTP_MAX_POST_WAIT      5000 // ms to wait for POST data to arrive
+#define HTTP_MAX_SEND_WAIT      5000 // ms to wait for data chunk to be ACKed
+#define HTTP_MAX_CLOSE_WAIT     2000 // ms to wait for the client to close the connection
+
+#define CONTENT_LENGTH_UNKNOWN  ((size_t) -1)
+#define CONTENT_LENGTH_NOT_SET  ((size_t) -2)
+
+typedef struct
+{
+  HTTPUploadStatus status;
+  String  filename;
+  String  name;
+  String  type;
+  size_t  totalSize;
+  size_t  currentSize;
+  size_t  contentLength;
+  uint8_t buf[HTTP_UPLOAD_BUFLEN];
+} HTTPUpload;
+
+class ESP8266WebServer
+{
+public:
+  typedef std::function<void(void)> THandlerFunction;
+  enum ClientFuture { CLIENT_REQUEST_CAN_CONTINUE, CLIENT_REQUEST_IS_HANDLED, CLIENT_MUST_STOP, CLIENT_IS_GIVEN };
+
+  ESP8266WebServer(int port = 80);
+  virtual ~ESP8266WebServer() {}
+
+  void begin();
+  void handleClient();
+  void close();
+  void stop() { close(); }
+
+  void on(const String & uri, THandlerFunction handler);
+  void on(const String & uri, HTTPMethod method, THandlerFunction fn);
+  void on(const String & uri, HTTPMethod method, THandlerFunction fn, THandlerFunction ufn);
+  void onNotFound(THandlerFunction fn);
+  void onFileUpload(THandlerFunction fn);
+  void serveStatic(const char * uri, FS & fs, const char * path, const char * cache_header = NULL);
+
+  const String & uri() const { return _currentUri; }
+  HTTPMethod method() const { return _currentMethod; }
+  WiFiClient client() { return _currentClient; }
+  HTTPUpload & upload() { return *_currentUpload; }
+
+  const String & arg(const String & name) const;
+  const String & arg(int i) const;
+  const String & argName(int i) const;
+  int args() const { return _args.size(); }
+  bool hasArg(const String & name) const;
+  void collectHeaders(const char * headerKeys[], const size_t headerKeysCount);
+  const String & header(const String & name) const;
+  const String & header(int i) const;
+  const String & headerName(int i) const;
+  int headers() const { return _headers.size(); }
+  bool hasHeader(const String & name) const;
+  const String & hostHeader() const { return _hostHeader; }
+
+  void send(int code, const char * content_type = NULL, const String & content = String(""));
+  void send(int code, char * content_type, const String & content) { send(code, (const char *) content_type, content); }
+  void send(int code, const String & content_type, const String & content) { send(code, content_type.c_str(), content); }
+  void send(int code, const char * content_type, const char * content) { send(code, content_type, content, strlen(content)); }
+  void send(int code, const char * content_type, const char * content, size_t contentLength);
+  void send_P(int code, PGM_P content_type, PGM_P content) { send(code, content_type, content); }
+  void send_P(int code, PGM_P content_type, PGM_P content, size_t contentLength) { send(code, content_type, content, contentLength); }
+  void setContentLength(const size_t contentLength) { _contentLength = contentLength; }
+  void sendHeader(const String & name, const String & value, bool first = false);
+  void sendContent(const String & content) { sendContent(content.c_str(), content.length()); }
+  void sendContent(const char * content, size_t size);
+  void sendContent_P(PGM_P content) { sendContent(content, strlen(content)); }
+  void sendContent_P(PGM_P content, size_t size) { sendContent(content, size); }
+
+  template<typename T>
+  size_t streamFile(T & file, const String & contentType, HTTPMethod requestMethod = HTTP_GET)
+  {
+    uint8_t buf[HTTP_DOWNLOAD_UNIT_SIZE];
+    size_t sent = 0;
+    size_t len;
+
+    setContentLength(file.size());
+    if (String(file.name()).endsWith(".gz") && contentType != "application/x-gzip" &&
+        contentType != "application/octet-stream")
+      sendHeader("Content-Encoding", "gzip");
+    send(200, contentType, "");
+    if (requestMethod == HTTP_HEAD)
+      return 0;
+    while ((len = file.read(buf, sizeof(buf))) > 0) {
+      if (_currentClient.write(buf, len) != len)
+        break;
+      sent += len;
+    }
+    return sent;
+  }
+
+  void keepAlive(bool keepAlive) { _keepAlive = keepAlive; }
+  bool keepAlive() const { return _keepAlive; }
+
+  static String urlDecode(const String & text);
+  static const char * responseCodeToString(int code);
+
+protected:
+  ClientFuture _parseRequest(WiFiClient & client);
+  void _handleRequest();
+  void _finalizeResponse();
+  void _prepareHeader(String & response, int code, const char * content_type, size_t contentLength);
+  void _parseArguments(const String & data);
+  bool _parseForm(WiFiClient & client, const String & boundary, uint32_t len);
+  void _collectHeader(const String & name, const String & value);
+
+  struct RequestHandler
+  {
+    String           uri;
+    HTTPMethod       method;
+    THandlerFunction fn;
+    THandlerFunction ufn;
+  };
+
+  struct RequestArgument
+  {
+    String key;
+    String value;
+  };
+
+  WiFiServer       _server;
+  WiFiClient       _currentClient;
+  HTTPMethod       _currentMethod;
+  String           _currentUri;
+  uint8_t          _currentVersion;
+  HTTPClientStatus _currentStatus;
+  unsigned long    _statusChange;
+  bool             _keepAlive;
+  bool             _chunked;
+  size_t           _contentLength;
+  String           _responseHeaders;
+  String           _hostHeader;
+  size_t           _clientContentLength;
+
+  // Files under path served for uri, as core StaticRequestHandler
+  struct StaticHandler
+  {
+    String uri;
+    String path;
+    String cache;
+  };
+  bool _handleStatic();
+
+  std::vector<RequestHandler>  _handlers;
+  std::vector<StaticHandler>   _statics;
+  THandlerFunction             _notFoundHandler;
+  THandlerFunction             _fileUploadHandler;
+  std::vector<RequestArgument> _args;
+  std::vector<RequestArgument> _headers;
+  std::unique_ptr<HTTPUpload>  _currentUpload;
+  const RequestHandler *       _currentHandler;
+};
+
+#endif
@@ -0,0 +1,159 @@
+// **********************************************************************************
+// WifInfo host build, ESP8266WiFi stand-in
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// TCP connections are in process, other end is a host endpoint (mock
+// server, simulated browser), see host.h. Station is always connected.
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#ifndef HOST_ESP8266WIFI_H
+#define HOST_ESP8266WIFI_H
+
+#include "Arduino.h"
+#include <memory>
+
+class IPAddress
+{
+public:
+  IPAddress() : _addr(0) {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _addr(a | b << 8 | c << 16 | (uint32_t) d << 24) {}
+  IPAddress(uint32_t addr) : _addr(addr) {}
+  operator uint32_t() const { return _addr; }
+  uint8_t operator [](int i) const { return _addr >> (i * 8); }
+  bool operator ==(const IPAddress & o) const { return _addr == o._addr; }
+  bool operator !=(const IPAddress & o) const { return _addr != o._addr; }
+  bool fromString(const char * str);
+  String toString() const;
+  bool isSet() const { return _addr != 0; }
+
+private:
+  uint32_t _addr;
+};
+
+Print & operator <<(Print & p, const IPAddress & ip);
+size_t printIP(Print & p, const IPAddress & ip);
+
+#define WL_IDLE_STATUS  0
+#define WL_CONNECTED    3
+#define WL_DISCONNECTED 6
+
+#define WIFI_OFF        0
+#define WIFI_STA        1
+#define WIFI_AP         2
+#define WIFI_AP_STA     3
+
+#define WIFI_SCAN_RUNNING (-1)
+#define WIFI_SCAN_FAILED  (-2)
+
+struct HostTcp;
+
+class Client : public Stream
+{
+public:
+  virtual int connect(IPAddress ip, uint16_t port) = 0;
+  virtual int connect(const char * host, uint16_t port) = 0;
+  virtual uint8_t connected() = 0;
+  virtual void stop() = 0;
+  virtual operator bool() = 0;
+};
+
+class WiFiClient : public Client
+{
+public:
+  WiFiClient();
+  WiFiClient(std::shared_ptr<HostTcp> tcp);
+  WiFiClient(const WiFiClient & other);
+  WiFiClient & operator =(const WiFiClient & other);
+  virtual ~WiFiClient();
+
+  int connect(IPAddress ip, uint16_t port) override;
+  int connect(const char * host, uint16_t port) override;
+  int connect(const String & host, uint16_t port);
+  uint8_t connected() override;
+  uint8_t status();
+  void stop() override;
+  bool stop(unsigned int maxWaitMs);
+  operator bool() override;
+
+  int available() override;
+  int read() override;
+  int read(uint8_t * buf, size_t size);
+  int read(char * buf, size_t size) { return read((uint8_t *) buf, size); }
+  int peek() override;
+  size_t peekBytes(uint8_t * buffer, size_t length);
+  size_t peekBytes(char * buffer, size_t length) { return peekBytes((uint8_t *) buffer, length); }
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t * buf, size_t size) override;
+  using Print::write;
+  int availableForWrite() override;
+  void flush() override;
+  bool flush(unsigned int maxWaitMs);
+
+  void setNoDelay(bool nodelay);
+  void setSync(bool sync);
+  bool getSync() const;
+  IPAddress remoteIP();
+  uint16_t remotePort();
+  IPAddress localIP();
+  void keepAlive(uint16_t idle_sec = 7200, uint16_t intv_sec = 75, uint8_t count = 9) {}
+
+private:
+  std::shared_ptr<HostTcp> _tcp;
+  bool _sync;
+};
+
+class WiFiServer
+{
+public:
+  WiFiServer(uint16_t port) : _port(port), _listening(false) {}
+  ~WiFiServer();
+  void begin();
+  void close();
+  WiFiClient available(uint8_t * status = NULL);
+  bool hasClient();
+  void setNoDelay(bool) {}
+
+private:
+  uint16_t _port;
+  bool _listening;
+};
+
+class ESP8266WiFiClass
+{
+public:
+  int status();
+  void printDiag(Print & p);
+  String SSID() const;
+  String SSID(uint8_t network);
+  String psk() const;
+  int begin(const char * ssid, const char * passphrase = NULL);
+  bool mode(int m);
+  int getMode();
+  IPAddress localIP();
+  IPAddress subnetMask();
+  IPAddress gatewayIP();
+  String macAddress();
+  bool disconnect(bool wifioff = false);
+  bool softAP(const char * ssid, const char * passphrase = NULL);
+  IPAddress softAPIP();
+  String softAPmacAddress();
+  int8_t scanNetworks(bool async = false, bool show_hidden = false);
+  int8_t scanComplete();
+  void scanDelete();
+  int32_t RSSI();
+  int32_t RSSI(uint8_t network);
+  uint8_t encryptionType(uint8_t network);
+  int32_t channel(uint8_t network);
+  int hostByName(const char * name, IPAddress & result);
+  int hostByName(const char * name, IPAddress & result, uint32_t timeout_ms);
+};
+
+extern ESP8266WiFiClass WiFi;
+
+#endif
@@ -0,0 +1,17 @@
+// WifInfo host build, mDNS stand-in, nothing is announced
+#ifndef HOST_ESP8266MDNS_H
+#define HOST_ESP8266MDNS_H
+
+#include "ESP8266WiFi.h"
+
+class MDNSResponder
+{
+public:
+  bool begin(const char *) { return true; }
+  void update() {}
+  void addService(const char *, const char *, uint16_t) {}
+};
+
+extern MDNSResponder MDNS;
+
+#endif
@@ -0,0 +1,333 @@
+// **********************************************************************************
+// WifInfo host build, SPIFFS in RAM
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#include "host.h"
+#include "FS.h"
+#include <map>
+#include <string>
+#include <dirent.h>
+
+#define HOST_FS_NAME_LEN  31     // SPIFFS_OBJ_NAME_LEN - 1
+#define HOST_FS_PAGE      256    // per file overhead
+
+typedef std::shared_ptr<std::string> _hostdata;
+
+struct HostFileHandle
+{
+  std::string name;
+  _hostdata   data;
+  size_t      pos;
+  bool        can_read;
+  bool        can_write;
+  bool        append;
+  bool        open;
+};
+
+static std::map<std::string, _hostdata> files;
+static size_t fs_size = 1024 * 1024;
+static HostFsStats fs_stats;
+
+FS SPIFFS;
+
+HostFsStats & hostFsStats(void)
+{
+  return fs_stats;
+}
+
+void hostFsSize(size_t bytes)
+{
+  fs_size = bytes;
+}
+
+static size_t fsUsed(void)
+{
+  size_t used = 0;
+
+  for (std::map<std::string, _hostdata>::iterator it = files.begin(); it != files.end(); ++it)
+    used += it->second->size() + HOST_FS_PAGE;
+  return used;
+}
+
+// Sub directories become part of names, like mkspiffs does
+static bool fsLoad(const std::string & dir, const std::string & prefix)
+{
+  DIR * d = opendir(dir.c_str());
+  struct dirent * e;
+
+  if (!d)
+    return false;
+  while ((e = readdir(d)) != NULL) {
+    std::string path = dir + "/" + e->d_name;
+    FILE * f;
+    char buf[4096];
+    size_t n;
+
+    if (e->d_name[0] == '.')
+      continue;
+    if (e->d_type == DT_DIR) {
+      fsLoad(path, prefix + e->d_name + "/");
+      continue;
+    }
+    f = fopen(path.c_str(), "rb");
+    if (!f)
+      continue;
+    _hostdata data = std::make_shared<std::string>();
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+      data->append(buf, n);
+    fclose(f);
+    files[prefix + e->d_name] = data;
+  }
+  closedir(d);
+  return true;
+}
+
+bool hostFsLoad(const char * dir)
+{
+  return fsLoad(dir, "/");
+}
+
+std::string hostFsRead(const char * path)
+{
+  std::map<std::string, _hostdata>::iterator it = files.find(path);
+
+  return it == files.end() ? std::string() : *it->second;
+}
+
+/* ======================================================================
+FS
+====================================================================== */
+bool FS::begin() { return true; }
+void FS::end() {}
+
+bool FS::format()
+{
+  files.clear();
+  return true;
+}
+
+bool FS::info(FSInfo & info)
+{
+  info.totalBytes = fs_size;
+  info.usedBytes = fsUsed();
+  info.blockSize = 8192;
+  info.pageSize = HOST_FS_PAGE;
+  info.maxOpenFiles = 5;
+  info.maxPathLength = HOST_FS_NAME_LEN + 1;
+  return true;
+}
+
+File FS::open(const char * path, const char * mode)
+{
+  HostHeapCoreScope core;
+  std::map<std::string, _hostdata>::iterator it;
+  std::shared_ptr<HostFileHandle> h;
+  bool plus = strchr(mode, '+') != NULL;
+
+  fs_stats.opens++;
+  if (!path || strlen(path) > HOST_FS_NAME_LEN)
+    return File();
+
+  it = files.find(path);
+  if (mode[0] == 'r') {
+    if (it == files.end())
+      return File();
+  } else if (it == files.end()) {
+    if (fsUsed() + HOST_FS_PAGE > fs_size)
+      return File();
+    it = files.insert(std::make_pair(std::string(path), std::make_shared<std::string>())).first;
+  } else if (mode[0] == 'w')
+    it->second->clear();
+
+  h = std::make_shared<HostFileHandle>();
+  h->name = path;
+  h->data = it->second;
+  h->can_read = mode[0] == 'r' || plus;
+  h->can_write = mode[0] != 'r' || plus;
+  h->append = mode[0] == 'a';
+  h->pos = h->append && !plus ? h->data->size() : 0;
+  h->open = true;
+  return File(h);
+}
+
+bool FS::exists(const char * path)
+{
+  fs_stats.exists++;
+  return files.find(path) != files.end();
+}
+
+Dir FS::openDir(const char * path)
+{
+  return Dir(String(path));
+}
+
+bool FS::remove(const char * path)
+{
+  return files.erase(path) > 0;
+}
+
+bool FS::rename(const char * pathFrom, const char * pathTo)
+{
+  std::map<std::string, _hostdata>::iterator it = files.find(pathFrom);
+
+  if (it == files.end() || strlen(pathTo) > HOST_FS_NAME_LEN || files.count(pathTo))
+    return false;
+  files[pathTo] = it->second;
+  files.erase(it);
+  return true;
+}
+
+/* ======================================================================
+File
+====================================================================== */
+size_t File::write(uint8_t c)
+{
+  return write(&c, 1);
+}
+
+size_t File::write(const uint8_t * buf, size_t size)
+{
+  HostHeapCoreScope core;
+  size_t used;
+
+  if (!_p || !_p->open || !_p->can_write)
+    return 0;
+  fs_stats.writes++;
+
+  // Flash full, short write like SPIFFS
+  used = fsUsed();
+  if (_p->append)
+    _p->pos = _p->data->size();
+  if (_p->pos + size > _p->data->size()) {
+    size_t grow = _p->pos + size - _p->data->size();
+    if (used + grow > fs_size)
+      size -= std::min(size, used + grow - fs_size);
+  }
+  if (_p->pos + size > _p->data->size())
+    _p->data->resize(_p->pos + size);
+  memcpy(&(*_p->data)[_p->pos], buf, size);
+  _p->pos += size;
+  fs_stats.write_bytes += size;
+  return size;
+}
+
+int File::available()
+{
+  if (!_p || !_p->open)
+    return 0;
+  return _p->data->size() > _p->pos ? _p->data->size() - _p->pos : 0;
+}
+
+int File::read()
+{
+  uint8_t c;
+
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+int File::peek()
+{
+  return available() ? (uint8_t) (*_p->data)[_p->pos] : -1;
+}
+
+size_t File::read(uint8_t * buf, size_t size)
+{
+  size_t n;
+
+  if (!_p || !_p->open || !_p->can_read)
+    return 0;
+  fs_stats.reads++;
+  n = std::min(size, (size_t) available());
+  if (n)
+    memcpy(buf, _p->data->data() + _p->pos, n);
+  _p->pos += n;
+  fs_stats.read_bytes += n;
+  return n;
+}
+
+bool File::seek(uint32_t pos, SeekMode mode)
+{
+  size_t p;
+
+  if (!_p || !_p->open)
+    return false;
+  p = mode == SeekSet ? pos : mode == SeekCur ? _p->pos + pos : _p->data->size() + pos;
+  if (p > _p->data->size())
+    return false;
+  _p->pos = p;
+  return true;
+}
+
+size_t File::position() const
+{
+  return _p && _p->open ? _p->pos : 0;
+}
+
+size_t File::size() const
+{
+  return _p && _p->open ? _p->data->size() : 0;
+}
+
+void File::close()
+{
+  if (_p)
+    _p->open = false;
+  _p.reset();
+}
+
+File::operator bool() const
+{
+  return _p && _p->open;
+}
+
+const char * File::name() const
+{
+  return _p ? _p->name.c_str() : "";
+}
+
+/* ======================================================================
+Dir, SPIFFS has no directory, files starting with path are listed
+====================================================================== */
+bool Dir::next()
+{
+  std::map<std::string, _hostdata>::iterator it;
+  int i = 0;
+
+  fs_stats.dir_next++;
+  for (it = files.begin(); it != files.end(); ++it) {
+    if (strncmp(it->first.c_str(), _prefix.c_str(), _prefix.length()))
+      continue;
+    if (i++ > _index) {
+      _index = i - 1;
+      _name = it->first.c_str();
+      return true;
+    }
+  }
+  _index = i;
+  _name = "";
+  return false;
+}
+
+String Dir::fileName()
+{
+  return _name;
+}
+
+size_t Dir::fileSize()
+{
+  std::map<std::string, _hostdata>::iterator it = files.find(_name.c_str());
+
+  return it == files.end() ? 0 : it->second->size();
+}
+
+File Dir::openFile(const char * mode)
+{
+  return SPIFFS.open(_name, mode);
+}
@@ -0,0 +1,105 @@
+// **********************************************************************************
+// WifInfo host build, FS/SPIFFS stand-in
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// Flat in-RAM file system with SPIFFS naming (full path, no directory)
+// and a size limit. Flash accesses are counted, see host.h
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#ifndef HOST_FS_H
+#define HOST_FS_H
+
+#include "Arduino.h"
+#include <memory>
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+struct HostFileHandle;
+
+class File : public Stream
+{
+public:
+  File() {}
+  File(std::shared_ptr<HostFileHandle> p) : _p(p) {}
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t * buf, size_t size) override;
+  using Print::write;
+  int available() override;
+  int read() override;
+  int peek() override;
+  void flush() override {}
+  size_t read(uint8_t * buf, size_t size);
+  size_t readBytes(char * buffer, size_t length) override { return read((uint8_t *) buffer, length); }
+  bool seek(uint32_t pos, SeekMode mode);
+  bool seek(uint32_t pos) { return seek(pos, SeekSet); }
+  size_t position() const;
+  size_t size() const;
+  void close();
+  operator bool() const;
+  const char * name() const;
+  const char * fullName() const { return name(); }
+  bool isFile() const { return (bool) *this; }
+  bool isDirectory() const { return false; }
+
+private:
+  std::shared_ptr<HostFileHandle> _p;
+};
+
+class Dir
+{
+public:
+  Dir() : _index(-1) {}
+  Dir(const String & prefix) : _prefix(prefix), _index(-1) {}
+  File openFile(const char * mode);
+  String fileName();
+  size_t fileSize();
+  bool isFile() const { return true; }
+  bool isDirectory() const { return false; }
+  bool next();
+  bool rewind() { _index = -1; return true; }
+
+private:
+  String _prefix;
+  String _name;
+  int    _index;
+};
+
+struct FSInfo
+{
+  size_t totalBytes;
+  size_t usedBytes;
+  size_t blockSize;
+  size_t pageSize;
+  size_t maxOpenFiles;
+  size_t maxPathLength;
+};
+
+class FS
+{
+public:
+  bool begin();
+  void end();
+  bool format();
+  bool info(FSInfo & info);
+  File open(const char * path, const char * mode);
+  File open(const String & path, const char * mode) { return open(path.c_str(), mode); }
+  bool exists(const char * path);
+  bool exists(const String & path) { return exists(path.c_str()); }
+  Dir openDir(const char * path);
+  Dir openDir(const String & path) { return openDir(path.c_str()); }
+  bool remove(const char * path);
+  bool remove(const String & path) { return remove(path.c_str()); }
+  bool rename(const char * pathFrom, const char * pathTo);
+  bool rename(const String & pathFrom, const String & pathTo) { return rename(pathFrom.c_str(), pathTo.c_str()); }
+};
+
+extern FS SPIFFS;
+
+#endif
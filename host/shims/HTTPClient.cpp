@@ -0,0 +1,141 @@
+// **********************************************************************************
+// WifInfo host build, HTTPClient stand-in
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#include "host.h"
+#include "ESP8266HTTPClient.h"
+#include "base64.h"
+
+HTTPClient::HTTPClient() : _port(80), _timeout(HTTPCLIENT_DEFAULT_TCP_TIMEOUT)
+{
+}
+
+HTTPClient::~HTTPClient()
+{
+  end();
+}
+
+bool HTTPClient::begin(const String & host, uint16_t port, const String & uri)
+{
+  end();
+  _host = host;
+  _port = port;
+  _uri = uri;
+  _auth = "";
+  return true;
+}
+
+void HTTPClient::end(void)
+{
+  _client.stop();
+  _body = "";
+}
+
+void HTTPClient::setAuthorization(const char * user, const char * password)
+{
+  String auth = user;
+
+  if (!user || !password)
+    return;
+  auth += ":";
+  auth += password;
+  _auth = base64::encode(auth, false);
+}
+
+int HTTPClient::GET(void)
+{
+  return request("GET", "");
+}
+
+int HTTPClient::POST(const String & payload)
+{
+  return request("POST", payload);
+}
+
+// Line of response head without CRLF, waits for it until timeout
+bool HTTPClient::readLine(String & line)
+{
+  unsigned long start = millis();
+
+  line = "";
+  while (millis() - start < _timeout) {
+    int c;
+
+    if (!_client.available()) {
+      if (!_client.connected())
+        return false;
+      delay(1);
+      continue;
+    }
+    c = _client.read();
+    if (c == '\n')
+      return true;
+    if (c != '\r')
+      line += (char) c;
+  }
+  return false;
+}
+
+int HTTPClient::request(const char * method, const String & payload)
+{
+  String req;
+  String line;
+  long length = -1;
+  int code;
+  unsigned long start;
+
+  _body = "";
+  _client.setTimeout(_timeout);
+  if (!_client.connect(_host.c_str(), _port))
+    return HTTPC_ERROR_CONNECTION_REFUSED;
+
+  req = String(method) + " " + _uri + " HTTP/1.1\r\nHost: " + _host;
+  if (_port != 80)
+    req += ":" + String(_port);
+  req += "\r\nUser-Agent: ESP8266HTTPClient\r\nConnection: close\r\n";
+  if (_auth.length())
+    req += "Authorization: Basic " + _auth + "\r\n";
+  if (payload.length())
+    req += "Content-Length: " + String(payload.length()) + "\r\n";
+  req += "\r\n";
+  req += payload;
+  if (_client.write((const uint8_t *) req.c_str(), req.length()) != req.length()) {
+    _client.stop();
+    return HTTPC_ERROR_SEND_HEADER_FAILED;
+  }
+
+  // Status line then headers, only length is of use here
+  if (!readLine(line) || line.length() < 12) {
+    _client.stop();
+    return HTTPC_ERROR_READ_TIMEOUT;
+  }
+  code = line.substring(9, 12).toInt();
+  while (readLine(line) && line.length()) {
+    line.toLowerCase();
+    if (line.startsWith("content-length:"))
+      length = line.substring(15).toInt();
+  }
+
+  // Body until length or server closes
+  start = millis();
+  while ((length < 0 || (long) _body.length() < length) && millis() - start < _timeout) {
+    if (_client.available()) {
+      _body += (char) _client.read();
+      continue;
+    }
+    if (!_client.connected())
+      break;
+    delay(1);
+  }
+  _client.stop();
+  if (length >= 0 && (long) _body.length() < length)
+    return HTTPC_ERROR_CONNECTION_LOST;
+  return code;
+}
@@ -0,0 +1,276 @@
+// **********************************************************************************
+// WifInfo host build, LibTeleinfo historic decoder
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// Same processing as LibTeleinfo 1.x (Charles-Henri Hallard)
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#include "LibTeleinfo.h"
+
+TInfo::TInfo()
+{
+  memset(&_valueslist, 0, sizeof(_valueslist));
+  _fn_ADPS = NULL;
+  _fn_data = NULL;
+  _fn_new_frame = NULL;
+  _fn_updated_frame = NULL;
+  _separator = ' ';
+  init();
+}
+
+void TInfo::init()
+{
+  listDelete();
+  clearBuffer();
+  _state = TINFO_INIT;
+  _frame_updated = false;
+}
+
+void TInfo::clearBuffer()
+{
+  memset(_recv_buff, 0, TINFO_BUFSIZE);
+  _recv_idx = 0;
+}
+
+void TInfo::attachADPS(void (*fn_ADPS)(uint8_t phase)) { _fn_ADPS = fn_ADPS; }
+void TInfo::attachData(void (*fn_data)(ValueList * valueslist, uint8_t state)) { _fn_data = fn_data; }
+void TInfo::attachNewFrame(void (*fn_new_frame)(ValueList * valueslist)) { _fn_new_frame = fn_new_frame; }
+void TInfo::attachUpdatedFrame(void (*fn_updated_frame)(ValueList * valueslist)) { _fn_updated_frame = fn_updated_frame; }
+
+ValueList * TInfo::getList(void)
+{
+  return &_valueslist;
+}
+
+ValueList * TInfo::addCustomValue(char * name, char * value, uint8_t * flags)
+{
+  if (name && value && *name && *value)
+    return valueAdd(name, value, calcChecksum(name, value), flags);
+  return NULL;
+}
+
+// Existing label: value replaced if changed, new one malloc'ed at end
+ValueList * TInfo::valueAdd(char * name, char * value, uint8_t checksum, uint8_t * flags)
+{
+  ValueList * me = &_valueslist;
+  size_t lgname = strlen(name);
+  size_t lgvalue = strlen(value);
+
+  while (me->next) {
+    me = me->next;
+    if (strncmp(me->name, name, lgname) == 0 && me->name[lgname] == '\0') {
+      if (strcmp(me->value, value) == 0) {
+        *flags |= TINFO_FLAGS_EXIST;
+        me->flags = *flags;
+        return me;
+      }
+      if (strlen(me->value) != lgvalue) {
+        char * v = (char *) realloc(me->value, lgvalue + 1);
+        if (!v)
+          return NULL;
+        me->value = v;
+      }
+      strcpy(me->value, value);
+      me->checksum = checksum;
+      *flags |= TINFO_FLAGS_UPDATED;
+      me->flags = *flags;
+      return me;
+    }
+  }
+
+  ValueList * newp = (ValueList *) malloc(sizeof(ValueList));
+  if (!newp)
+    return NULL;
+  newp->name = (char *) malloc(lgname + 1);
+  newp->value = (char *) malloc(lgvalue + 1);
+  if (!newp->name || !newp->value) {
+    free(newp->name);
+    free(newp->value);
+    free(newp);
+    return NULL;
+  }
+  strcpy(newp->name, name);
+  strcpy(newp->value, value);
+  newp->checksum = checksum;
+  newp->next = NULL;
+  *flags |= TINFO_FLAGS_ADDED;
+  newp->flags = *flags;
+  me->next = newp;
+  return newp;
+}
+
+// Labels not in last frame are removed
+void TInfo::valueRemoveFlagged(uint8_t flags)
+{
+  ValueList * me = &_valueslist;
+
+  while (me->next) {
+    ValueList * p = me->next;
+    if (p->flags & flags) {
+      me->next = p->next;
+      free(p->name);
+      free(p->value);
+      free(p);
+    } else {
+      p->flags = TINFO_FLAGS_NOTHING;
+      me = p;
+    }
+  }
+}
+
+uint8_t TInfo::valuesDump(void)
+{
+  uint8_t n = 0;
+
+  for (ValueList * me = _valueslist.next; me; me = me->next)
+    n++;
+  return n;
+}
+
+char * TInfo::valueGet(char * name, char * value)
+{
+  for (ValueList * me = _valueslist.next; me; me = me->next)
+    if (strcmp(me->name, name) == 0) {
+      strcpy(value, me->value);
+      return value;
+    }
+  return NULL;
+}
+
+boolean TInfo::listDelete()
+{
+  ValueList * me = _valueslist.next;
+
+  while (me) {
+    ValueList * next = me->next;
+    free(me->name);
+    free(me->value);
+    free(me);
+    me = next;
+  }
+  _valueslist.next = NULL;
+  return true;
+}
+
+unsigned char TInfo::calcChecksum(char * etiquette, char * valeur)
+{
+  uint8_t sum = ' ';
+
+  while (*etiquette)
+    sum += *etiquette++;
+  while (*valeur)
+    sum += *valeur++;
+  return (sum & 0x3F) + ' ';
+}
+
+void TInfo::customLabel(char * plabel, char * pvalue, uint8_t * pflags)
+{
+  int8_t phase = -1;
+
+  if (!_fn_ADPS)
+    return;
+  if (!strcmp(plabel, "ADPS"))
+    phase = 0;
+  else if (!strcmp(plabel, "ADIR1"))
+    phase = 1;
+  else if (!strcmp(plabel, "ADIR2"))
+    phase = 2;
+  else if (!strcmp(plabel, "ADIR3"))
+    phase = 3;
+  if (phase >= 0 && (*pflags & (TINFO_FLAGS_ADDED | TINFO_FLAGS_UPDATED)))
+    _fn_ADPS(phase);
+}
+
+// "label SP value SP checksum", checksum on label SP value
+ValueList * TInfo::checkLine(char * pline)
+{
+  char checksum;
+  char buff[TINFO_BUFSIZE];
+  uint8_t flags = TINFO_FLAGS_NONE;
+  char * ptok;
+  char * pvalue;
+  char * pend;
+  uint8_t len = strlen(pline);
+
+  if (len < 5)
+    return NULL;
+  checksum = pline[len - 1];
+  pline[len - 2] = '\0';
+
+  strncpy(buff, pline, TINFO_BUFSIZE);
+  buff[TINFO_BUFSIZE - 1] = '\0';
+  ptok = buff;
+  pvalue = strchr(ptok, _separator);
+  if (!pvalue)
+    return NULL;
+  *pvalue++ = '\0';
+  pend = strchr(pvalue, _separator);
+  if (pend)
+    *pend = '\0';
+
+  if (calcChecksum(ptok, pvalue) != (uint8_t) checksum)
+    return NULL;
+
+  ValueList * me = valueAdd(ptok, pvalue, checksum, &flags);
+  if (!me)
+    return NULL;
+  if (flags & (TINFO_FLAGS_ADDED | TINFO_FLAGS_UPDATED)) {
+    _frame_updated = true;
+    if (_fn_data)
+      _fn_data(me, flags);
+  }
+  customLabel(ptok, pvalue, &flags);
+  return me;
+}
+
+_State_e TInfo::process(char c)
+{
+  c &= 0x7F;
+
+  switch (c) {
+    case TINFO_STX:
+      clearBuffer();
+      _state = TINFO_WAIT_ETX;
+      _frame_updated = false;
+      break;
+
+    case TINFO_ETX:
+      if (_state == TINFO_WAIT_ETX) {
+        if (_frame_updated) {
+          if (_fn_updated_frame)
+            _fn_updated_frame(&_valueslist);
+        } else if (_fn_new_frame)
+          _fn_new_frame(&_valueslist);
+        // Labels missing in this frame go away
+        valueRemoveFlagged(TINFO_FLAGS_NOTHING);
+      }
+      _state = TINFO_WAIT_STX;
+      break;
+
+    case 0x04:
+      _state = TINFO_WAIT_STX;
+      break;
+
+    case TINFO_SGR:
+      clearBuffer();
+      break;
+
+    case TINFO_EGR:
+      if (_state == TINFO_WAIT_ETX)
+        checkLine(_recv_buff);
+      clearBuffer();
+      break;
+
+    default:
+      if (_state == TINFO_WAIT_ETX && _recv_idx < TINFO_BUFSIZE - 1)
+        _recv_buff[_recv_idx++] = c;
+      break;
+  }
+  return _state;
+}
@@ -0,0 +1,85 @@
+// **********************************************************************************
+// WifInfo host build, LibTeleinfo stand-in
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// Historic mode decoder with the same list, flags and callbacks as
+// LibTeleinfo: each group is checked then stored (malloc) in the list,
+// data callback for new or changed values, frame callback on ETX.
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#ifndef HOST_LIBTELEINFO_H
+#define HOST_LIBTELEINFO_H
+
+#include "Arduino.h"
+
+#define TINFO_FLAGS_NONE     0x00
+#define TINFO_FLAGS_NOTHING  0x01
+#define TINFO_FLAGS_ADDED    0x02
+#define TINFO_FLAGS_EXIST    0x04
+#define TINFO_FLAGS_UPDATED  0x08
+#define TINFO_FLAGS_ALERT    0x80
+
+#define TINFO_STX 0x02
+#define TINFO_ETX 0x03
+#define TINFO_SGR '\n'
+#define TINFO_EGR '\r'
+#define TINFO_HT  0x09
+
+#define TINFO_BUFSIZE 64
+
+typedef struct _ValueList ValueList;
+struct _ValueList
+{
+  ValueList * next;
+  uint8_t     checksum;
+  uint8_t     flags;
+  char *      name;
+  char *      value;
+};
+
+enum _State_e { TINFO_INIT, TINFO_WAIT_STX, TINFO_WAIT_ETX };
+
+class TInfo
+{
+public:
+  TInfo();
+  void init();
+  _State_e process(char c);
+  void attachADPS(void (*fn_ADPS)(uint8_t phase));
+  void attachData(void (*fn_data)(ValueList * valueslist, uint8_t state));
+  void attachNewFrame(void (*fn_new_frame)(ValueList * valueslist));
+  void attachUpdatedFrame(void (*fn_updated_frame)(ValueList * valueslist));
+  ValueList * addCustomValue(char * name, char * value, uint8_t * flags);
+  ValueList * getList(void);
+  uint8_t valuesDump(void);
+  char * valueGet(char * name, char * value);
+  boolean listDelete();
+  unsigned char calcChecksum(char * etiquette, char * valeur);
+
+private:
+  void clearBuffer();
+  ValueList * valueAdd(char * name, char * value, uint8_t checksum, uint8_t * flags);
+  void valueRemoveFlagged(uint8_t flags);
+  void customLabel(char * plabel, char * pvalue, uint8_t * pflags);
+  ValueList * checkLine(char * pline);
+
+  _State_e  _state;
+  ValueList _valueslist;
+  char      _recv_buff[TINFO_BUFSIZE];
+  uint8_t   _recv_idx;
+  bool      _frame_updated;
+  uint8_t   _separator;
+
+  void (*_fn_ADPS)(uint8_t phase);
+  void (*_fn_data)(ValueList * valueslist, uint8_t state);
+  void (*_fn_new_frame)(ValueList * valueslist);
+  void (*_fn_updated_frame)(ValueList * valueslist);
+};
+
+#endif
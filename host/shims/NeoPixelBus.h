@@ -0,0 +1,39 @@
+// WifInfo host build, NeoPixelBus stand-in, last color set is kept
+#ifndef HOST_NEOPIXELBUS_H
+#define HOST_NEOPIXELBUS_H
+
+#include "Arduino.h"
+
+struct HslColor
+{
+  HslColor(float h, float s, float l) : H(h), S(s), L(l) {}
+  float H, S, L;
+};
+
+struct RgbColor
+{
+  RgbColor(uint8_t brightness) : R(brightness), G(brightness), B(brightness) {}
+  RgbColor(uint8_t r, uint8_t g, uint8_t b) : R(r), G(g), B(b) {}
+  RgbColor(const HslColor & hsl) : R(hsl.L * 255), G(hsl.L * 255), B(hsl.L * 255) {}
+  uint8_t R, G, B;
+};
+
+struct NeoRgbFeature {};
+struct NeoGrbFeature {};
+struct NeoEsp8266BitBang800KbpsMethod {};
+
+template<typename T_COLOR_FEATURE, typename T_METHOD>
+class NeoPixelBus
+{
+public:
+  NeoPixelBus(uint16_t countPixels, uint8_t pin) : _color(0) {}
+  void Begin() {}
+  void Show() {}
+  void SetPixelColor(uint16_t indexPixel, RgbColor color) { _color = color; }
+  RgbColor GetPixelColor(uint16_t indexPixel) const { return _color; }
+
+private:
+  RgbColor _color;
+};
+
+#endif
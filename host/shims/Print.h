@@ -0,0 +1,2 @@
+// Arduino core stand-in, see Arduino.h
+#include "Arduino.h"
@@ -0,0 +1,50 @@
+// **********************************************************************************
+// WifInfo host build, Ticker stand-in
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// Callbacks run from host clock when virtual time reaches them, like
+// the SDK timers run between two loop() instructions.
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#ifndef HOST_TICKER_H
+#define HOST_TICKER_H
+
+#include "Arduino.h"
+
+class Ticker
+{
+public:
+  typedef void (*callback_t)(void);
+  typedef std::function<void(void)> callback_function_t;
+
+  Ticker() {}
+  ~Ticker() { detach(); }
+
+  void attach(float seconds, callback_function_t callback) { arm(seconds * 1000, true, callback); }
+  void attach_ms(uint32_t milliseconds, callback_function_t callback) { arm(milliseconds, true, callback); }
+  void once(float seconds, callback_function_t callback) { arm(seconds * 1000, false, callback); }
+  void once_ms(uint32_t milliseconds, callback_function_t callback) { arm(milliseconds, false, callback); }
+
+  template<typename TArg>
+  void attach(float seconds, void (*callback)(TArg), TArg arg) { arm(seconds * 1000, true, std::bind(callback, arg)); }
+  template<typename TArg>
+  void attach_ms(uint32_t milliseconds, void (*callback)(TArg), TArg arg) { arm(milliseconds, true, std::bind(callback, arg)); }
+  template<typename TArg>
+  void once(float seconds, void (*callback)(TArg), TArg arg) { arm(seconds * 1000, false, std::bind(callback, arg)); }
+  template<typename TArg>
+  void once_ms(uint32_t milliseconds, void (*callback)(TArg), TArg arg) { arm(milliseconds, false, std::bind(callback, arg)); }
+
+  void detach();
+  bool active() const;
+
+private:
+  void arm(uint32_t ms, bool repeat, callback_function_t callback);
+};
+
+#endif
@@ -0,0 +1,475 @@
+// **********************************************************************************
+// WifInfo host build, String, Print and Stream
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#include "Arduino.h"
+
+/* ======================================================================
+String, grows like core WString (realloc to exact size)
+====================================================================== */
+String::String(const char * cstr)
+{
+  init();
+  if (cstr)
+    copy(cstr, strlen(cstr));
+}
+
+String::String(const String & str)
+{
+  init();
+  *this = str;
+}
+
+String::String(const __FlashStringHelper * str)
+{
+  init();
+  if (str)
+    copy((const char *) str, strlen((const char *) str));
+}
+
+String::String(char c)
+{
+  init();
+  copy(&c, 1);
+}
+
+static void numToString(char * buf, unsigned long long n, bool neg, unsigned char base)
+{
+  char tmp[66];
+  char * p = tmp + sizeof(tmp) - 1;
+
+  if (base < 2)
+    base = 10;
+  *p = '\0';
+  do {
+    int d = n % base;
+    *--p = d < 10 ? '0' + d : 'a' + d - 10;
+    n /= base;
+  } while (n);
+  if (neg)
+    *--p = '-';
+  strcpy(buf, p);
+}
+
+#define STRING_NUM(type, neg)                                   \
+String::String(type value, unsigned char base)                      \
+{                                                               \
+  init();                                                       \
+  char buf[68];                                                 \
+  bool n = (neg) && base == 10 && (long long) value < 0;        \
+  numToString(buf, n ? -(long long) value : (unsigned long long) value, n, base); \
+  copy(buf, strlen(buf));                                       \
+}
+
+STRING_NUM(unsigned char, false)
+STRING_NUM(int, true)
+STRING_NUM(unsigned int, false)
+STRING_NUM(long, true)
+STRING_NUM(unsigned long, false)
+
+String::String(float value, unsigned char decimalPlaces)
+{
+  init();
+  char buf[40];
+  snprintf(buf, sizeof(buf), "%.*f", decimalPlaces, value);
+  copy(buf, strlen(buf));
+}
+
+String::String(double value, unsigned char decimalPlaces)
+{
+  init();
+  char buf[40];
+  snprintf(buf, sizeof(buf), "%.*f", decimalPlaces, value);
+  copy(buf, strlen(buf));
+}
+
+String::~String()
+{
+  if (_buf != _sso)
+    free(_buf);
+}
+
+bool String::reserve(unsigned int size)
+{
+  char * p;
+
+  if (_cap >= size)
+    return true;
+
+  if (_buf == _sso) {
+    p = (char *) malloc(size + 1);
+    if (p)
+      memcpy(p, _sso, _len + 1);
+  } else
+    p = (char *) realloc(_buf, size + 1);
+  if (!p)
+    return false;
+  _buf = p;
+  _cap = size;
+  return true;
+}
+
+void String::copy(const char * cstr, unsigned int length)
+{
+  if (!reserve(length)) {
+    _len = 0;
+    return;
+  }
+  memmove(_buf, cstr, length);
+  _buf[length] = '\0';
+  _len = length;
+}
+
+String & String::operator =(const String & rhs)
+{
+  if (this != &rhs) {
+    copy(rhs._buf, rhs._len);
+  }
+  return *this;
+}
+
+String & String::operator =(const char * cstr)
+{
+  copy(cstr ? cstr : "", cstr ? strlen(cstr) : 0);
+  return *this;
+}
+
+String & String::operator =(const __FlashStringHelper * str)
+{
+  return *this = (const char *) str;
+}
+
+bool String::concat(const char * cstr, unsigned int length)
+{
+  if (!cstr)
+    return false;
+  if (!length)
+    return true;
+  // cstr may point into our own buffer
+  if (cstr >= _buf && cstr < _buf + _cap + 1) {
+    size_t off = cstr - _buf;
+    if (!reserve(_len + length))
+      return false;
+    cstr = _buf + off;
+  } else if (!reserve(_len + length))
+    return false;
+  memmove(_buf + _len, cstr, length);
+  _len += length;
+  _buf[_len] = '\0';
+  return true;
+}
+
+String & String::operator +=(const String & rhs)  { concat(rhs.c_str(), rhs._len); return *this; }
+String & String::operator +=(const char * cstr)   { if (cstr) concat(cstr, strlen(cstr)); return *this; }
+String & String::operator +=(char c)              { concat(&c, 1); return *this; }
+String & String::operator +=(unsigned char num)   { return *this += String(num); }
+String & String::operator +=(int num)             { return *this += String(num); }
+String & String::operator +=(unsigned int num)    { return *this += String(num); }
+String & String::operator +=(long num)            { return *this += String(num); }
+String & String::operator +=(unsigned long num)   { return *this += String(num); }
+String & String::operator +=(float num)           { return *this += String(num); }
+String & String::operator +=(double num)          { return *this += String(num); }
+String & String::operator +=(const __FlashStringHelper * str) { return *this += (const char *) str; }
+
+String operator +(const String & lhs, const String & rhs)  { String s(lhs); s += rhs; return s; }
+String operator +(const String & lhs, const char * cstr)   { String s(lhs); s += cstr; return s; }
+String operator +(const String & lhs, char c)              { String s(lhs); s += c; return s; }
+String operator +(const String & lhs, const __FlashStringHelper * rhs) { String s(lhs); s += rhs; return s; }
+String operator +(const char * lhs, const String & rhs)    { String s(lhs); s += rhs; return s; }
+
+int String::compareTo(const String & s) const
+{
+  return strcmp(c_str(), s.c_str());
+}
+
+bool String::equals(const char * cstr) const
+{
+  return strcmp(c_str(), cstr ? cstr : "") == 0;
+}
+
+bool String::equalsIgnoreCase(const String & s) const
+{
+  return _len == s._len && strcasecmp(c_str(), s.c_str()) == 0;
+}
+
+bool String::startsWith(const String & prefix) const
+{
+  return _len >= prefix._len && !strncmp(c_str(), prefix.c_str(), prefix._len);
+}
+
+bool String::endsWith(const String & suffix) const
+{
+  return _len >= suffix._len && !strcmp(c_str() + _len - suffix._len, suffix.c_str());
+}
+
+char String::operator [](unsigned int index) const
+{
+  return index < _len ? _buf[index] : 0;
+}
+
+char & String::operator [](unsigned int index)
+{
+  static char dummy;
+
+  if (index >= _len) {
+    dummy = 0;
+    return dummy;
+  }
+  return _buf[index];
+}
+
+int String::indexOf(char ch, unsigned int fromIndex) const
+{
+  if (fromIndex >= _len)
+    return -1;
+  const char * p = strchr(_buf + fromIndex, ch);
+  return p ? p - _buf : -1;
+}
+
+int String::indexOf(const String & str, unsigned int fromIndex) const
+{
+  if (fromIndex >= _len)
+    return -1;
+  const char * p = strstr(_buf + fromIndex, str.c_str());
+  return p ? p - _buf : -1;
+}
+
+int String::lastIndexOf(char ch) const
+{
+  const char * p = strrchr(_buf, ch);
+  return p ? p - _buf : -1;
+}
+
+String String::substring(unsigned int left, unsigned int right) const
+{
+  String s;
+
+  if (left > right)
+    std::swap(left, right);
+  if (right > _len)
+    right = _len;
+  if (left < right)
+    s.copy(_buf + left, right - left);
+  return s;
+}
+
+void String::remove(unsigned int index)
+{
+  remove(index, (unsigned int) -1);
+}
+
+void String::remove(unsigned int index, unsigned int count)
+{
+  if (index >= _len)
+    return;
+  if (count > _len - index)
+    count = _len - index;
+  memmove(_buf + index, _buf + index + count, _len - index - count + 1);
+  _len -= count;
+}
+
+void String::replace(const String & find, const String & replace)
+{
+  String out;
+  int from = 0;
+  int at;
+
+  if (!_len || !find._len)
+    return;
+  while ((at = indexOf(find, from)) >= 0) {
+    out.concat(_buf + from, at - from);
+    out += replace;
+    from = at + find._len;
+  }
+  out.concat(_buf + from, _len - from);
+  *this = out;
+}
+
+void String::toLowerCase(void)
+{
+  for (unsigned int i = 0; i < _len; i++)
+    _buf[i] = tolower(_buf[i]);
+}
+
+void String::toUpperCase(void)
+{
+  for (unsigned int i = 0; i < _len; i++)
+    _buf[i] = toupper(_buf[i]);
+}
+
+void String::trim(void)
+{
+  unsigned int b = 0;
+  unsigned int e = _len;
+
+  while (b < e && isspace((unsigned char) _buf[b]))
+    b++;
+  while (e > b && isspace((unsigned char) _buf[e - 1]))
+    e--;
+  if (b || e != _len) {
+    memmove(_buf, _buf + b, e - b);
+    _len = e - b;
+    _buf[_len] = '\0';
+  }
+}
+
+/* ======================================================================
+Print
+====================================================================== */
+size_t Print::write(const uint8_t * buffer, size_t size)
+{
+  size_t n = 0;
+
+  while (size--) {
+    if (!write(*buffer++))
+      break;
+    n++;
+  }
+  return n;
+}
+
+size_t Print::printNumber(unsigned long long n, int base)
+{
+  char buf[68];
+
+  numToString(buf, n, false, base);
+  return write(buf);
+}
+
+size_t Print::print(const __FlashStringHelper * s) { return write((const char *) s); }
+size_t Print::print(const String & s)              { return write(s.c_str(), s.length()); }
+size_t Print::print(const char s[])                { return write(s); }
+size_t Print::print(char c)                        { return write((uint8_t) c); }
+size_t Print::print(unsigned char n, int base)     { return printNumber(n, base); }
+size_t Print::print(unsigned int n, int base)      { return printNumber(n, base); }
+size_t Print::print(unsigned long n, int base)     { return printNumber(n, base); }
+size_t Print::print(unsigned long long n, int base) { return printNumber(n, base); }
+size_t Print::print(int n, int base)               { return print((long long) n, base); }
+size_t Print::print(long n, int base)              { return print((long long) n, base); }
+
+size_t Print::print(long long n, int base)
+{
+  if (base == 10 && n < 0)
+    return write('-') + printNumber(-n, 10);
+  return printNumber(base == 10 ? n : (unsigned long) n, base);
+}
+
+size_t Print::print(double n, int digits)
+{
+  char buf[40];
+
+  snprintf(buf, sizeof(buf), "%.*f", digits, n);
+  return write(buf);
+}
+
+size_t Print::println(void) { return write("\r\n"); }
+size_t Print::println(const __FlashStringHelper * s) { return print(s) + println(); }
+size_t Print::println(const String & s)              { return print(s) + println(); }
+size_t Print::println(const char s[])                { return print(s) + println(); }
+size_t Print::println(char c)                        { return print(c) + println(); }
+size_t Print::println(unsigned char n, int base)     { return print(n, base) + println(); }
+size_t Print::println(int n, int base)               { return print(n, base) + println(); }
+size_t Print::println(unsigned int n, int base)      { return print(n, base) + println(); }
+size_t Print::println(long n, int base)              { return print(n, base) + println(); }
+size_t Print::println(unsigned long n, int base)     { return print(n, base) + println(); }
+size_t Print::println(long long n, int base)         { return print(n, base) + println(); }
+size_t Print::println(unsigned long long n, int base) { return print(n, base) + println(); }
+size_t Print::println(double n, int digits)          { return print(n, digits) + println(); }
+
+// Same as core: 64 bytes on stack, heap if longer
+static size_t vprint(Print * p, const char * format, va_list arg)
+{
+  char temp[64];
+  char * buffer = temp;
+  va_list copy;
+  size_t len;
+
+  va_copy(copy, arg);
+  len = vsnprintf(temp, sizeof(temp), format, copy);
+  va_end(copy);
+  if (len > sizeof(temp) - 1) {
+    buffer = (char *) malloc(len + 1);
+    if (!buffer)
+      return 0;
+    vsnprintf(buffer, len + 1, format, arg);
+  }
+  len = p->write((const uint8_t *) buffer, len);
+  if (buffer != temp)
+    free(buffer);
+  return len;
+}
+
+size_t Print::printf(const char * format, ...)
+{
+  va_list arg;
+  va_start(arg, format);
+  size_t len = vprint(this, format, arg);
+  va_end(arg);
+  return len;
+}
+
+size_t Print::printf_P(PGM_P format, ...)
+{
+  va_list arg;
+  va_start(arg, format);
+  size_t len = vprint(this, format, arg);
+  va_end(arg);
+  return len;
+}
+
+/* ======================================================================
+Stream
+====================================================================== */
+int Stream::timedRead()
+{
+  unsigned long start = millis();
+
+  do {
+    int c = read();
+    if (c >= 0)
+      return c;
+    yield();
+  } while (millis() - start < _timeout);
+  return -1;
+}
+
+size_t Stream::readBytes(char * buffer, size_t length)
+{
+  size_t count = 0;
+
+  while (count < length) {
+    int c = timedRead();
+    if (c < 0)
+      break;
+    *buffer++ = (char) c;
+    count++;
+  }
+  return count;
+}
+
+String Stream::readStringUntil(char terminator)
+{
+  String ret;
+  int c;
+
+  while ((c = timedRead()) >= 0 && c != terminator)
+    ret += (char) c;
+  return ret;
+}
+
+String Stream::readString()
+{
+  String ret;
+  int c;
+
+  while ((c = timedRead()) >= 0)
+    ret += (char) c;
+  return ret;
+}
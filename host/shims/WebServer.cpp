@@ -0,0 +1,602 @@
+// **********************************************************************************
+// WifInfo host build, ESP8266WebServer
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// Follows core 3.x ESP8266WebServer-impl.h and Parsing-impl.h: the
+// parser reads lines with the blocking Stream helpers, responses are
+// written straight to the client.
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#include "host.h"
+#include "ESP8266WebServer.h"
+#include <string>
+
+static const String empty_string;
+
+ESP8266WebServer::ESP8266WebServer(int port) :
+  _server(port), _currentMethod(HTTP_ANY), _currentVersion(0), _currentStatus(HC_NONE),
+  _statusChange(0), _keepAlive(false), _chunked(false), _contentLength(CONTENT_LENGTH_NOT_SET),
+  _clientContentLength(0), _currentHandler(NULL)
+{
+}
+
+void ESP8266WebServer::begin()
+{
+  close();
+  _server.begin();
+}
+
+void ESP8266WebServer::close()
+{
+  _server.close();
+  _currentStatus = HC_NONE;
+  _currentClient = WiFiClient();
+}
+
+void ESP8266WebServer::on(const String & uri, THandlerFunction handler)
+{
+  on(uri, HTTP_ANY, handler);
+}
+
+void ESP8266WebServer::on(const String & uri, HTTPMethod method, THandlerFunction fn)
+{
+  on(uri, method, fn, _fileUploadHandler);
+}
+
+void ESP8266WebServer::on(const String & uri, HTTPMethod method, THandlerFunction fn, THandlerFunction ufn)
+{
+  HostHeapCoreScope core;
+
+  _handlers.push_back({ uri, method, fn, ufn });
+}
+
+void ESP8266WebServer::onNotFound(THandlerFunction fn)
+{
+  _notFoundHandler = fn;
+}
+
+void ESP8266WebServer::onFileUpload(THandlerFunction fn)
+{
+  _fileUploadHandler = fn;
+}
+
+void ESP8266WebServer::serveStatic(const char * uri, FS & fs, const char * path, const char * cache_header)
+{
+  (void) fs;
+  _statics.push_back({ uri, path, cache_header ? cache_header : "" });
+}
+
+// Same state machine as core handleClient()
+void ESP8266WebServer::handleClient()
+{
+  bool keep = false;
+
+  if (_currentStatus == HC_NONE) {
+    WiFiClient client = _server.available();
+    if (!client)
+      return;
+    _currentClient = client;
+    _currentStatus = HC_WAIT_READ;
+    _statusChange = millis();
+  }
+
+  if (_currentClient.connected() || _currentClient.available()) {
+    if (_currentClient.available() && _keepAlive)
+      _currentStatus = HC_WAIT_READ;
+
+    switch (_currentStatus) {
+      case HC_NONE:
+        break;
+
+      case HC_WAIT_READ:
+        if (_currentClient.available()) {
+          switch (_parseRequest(_currentClient)) {
+            case CLIENT_REQUEST_CAN_CONTINUE:
+              _currentClient.setTimeout(HTTP_MAX_SEND_WAIT);
+              _contentLength = CONTENT_LENGTH_NOT_SET;
+              _handleRequest();
+              /* fallthrough */
+            case CLIENT_REQUEST_IS_HANDLED:
+              if (_currentClient.connected() || _currentClient.available()) {
+                _currentStatus = HC_WAIT_CLOSE;
+                _statusChange = millis();
+                keep = true;
+              }
+              break;
+            case CLIENT_MUST_STOP:
+            case CLIENT_IS_GIVEN:
+              _currentClient.stop();
+              break;
+          }
+        } else if (millis() - _statusChange <= HTTP_MAX_DATA_WAIT)
+          keep = true;
+        break;
+
+      case HC_WAIT_CLOSE:
+        if (!_server.hasClient() && millis() - _statusChange <= HTTP_MAX_CLOSE_WAIT) {
+          keep = true;
+          if (_currentClient.available())
+            _currentStatus = HC_WAIT_READ;
+        }
+        break;
+    }
+  }
+
+  if (!keep) {
+    _currentClient = WiFiClient();
+    _currentStatus = HC_NONE;
+    _currentUpload.reset();
+  }
+}
+
+/* ======================================================================
+Request
+====================================================================== */
+const String & ESP8266WebServer::arg(const String & name) const
+{
+  for (size_t i = 0; i < _args.size(); i++)
+    if (_args[i].key == name)
+      return _args[i].value;
+  return empty_string;
+}
+
+const String & ESP8266WebServer::arg(int i) const
+{
+  return i >= 0 && i < (int) _args.size() ? _args[i].value : empty_string;
+}
+
+const String & ESP8266WebServer::argName(int i) const
+{
+  return i >= 0 && i < (int) _args.size() ? _args[i].key : empty_string;
+}
+
+bool ESP8266WebServer::hasArg(const String & name) const
+{
+  for (size_t i = 0; i < _args.size(); i++)
+    if (_args[i].key == name)
+      return true;
+  return false;
+}
+
+void ESP8266WebServer::collectHeaders(const char * headerKeys[], const size_t headerKeysCount)
+{
+  _headers.clear();
+  _headers.push_back({ String("Authorization"), String() });
+  for (size_t i = 0; i < headerKeysCount; i++)
+    _headers.push_back({ String(headerKeys[i]), String() });
+}
+
+const String & ESP8266WebServer::header(const String & name) const
+{
+  for (size_t i = 0; i < _headers.size(); i++)
+    if (_headers[i].key.equalsIgnoreCase(name))
+      return _headers[i].value;
+  return empty_string;
+}
+
+const String & ESP8266WebServer::header(int i) const
+{
+  return i >= 0 && i < (int) _headers.size() ? _headers[i].value : empty_string;
+}
+
+const String & ESP8266WebServer::headerName(int i) const
+{
+  return i >= 0 && i < (int) _headers.size() ? _headers[i].key : empty_string;
+}
+
+bool ESP8266WebServer::hasHeader(const String & name) const
+{
+  for (size_t i = 0; i < _headers.size(); i++)
+    if (_headers[i].key.equalsIgnoreCase(name) && _headers[i].value.length())
+      return true;
+  return false;
+}
+
+void ESP8266WebServer::_collectHeader(const String & name, const String & value)
+{
+  for (size_t i = 0; i < _headers.size(); i++)
+    if (_headers[i].key.equalsIgnoreCase(name))
+      _headers[i].value = value;
+}
+
+String ESP8266WebServer::urlDecode(const String & text)
+{
+  String decoded;
+  unsigned int i = 0;
+
+  while (i < text.length()) {
+    char c = text[i];
+
+    if (c == '+')
+      c = ' ';
+    else if (c == '%' && i + 2 < text.length()) {
+      char hex[3] = { text[i + 1], text[i + 2], 0 };
+      c = (char) strtol(hex, NULL, 16);
+      i += 2;
+    }
+    decoded += c;
+    i++;
+  }
+  return decoded;
+}
+
+void ESP8266WebServer::_parseArguments(const String & data)
+{
+  int pos = 0;
+
+  _args.clear();
+  while (pos < (int) data.length()) {
+    int end = data.indexOf('&', pos);
+    int eq;
+    String pair;
+
+    if (end < 0)
+      end = data.length();
+    pair = data.substring(pos, end);
+    pos = end + 1;
+    if (!pair.length())
+      continue;
+    eq = pair.indexOf('=');
+    if (eq < 0)
+      _args.push_back({ urlDecode(pair), String() });
+    else
+      _args.push_back({ urlDecode(pair.substring(0, eq)), urlDecode(pair.substring(eq + 1)) });
+  }
+}
+
+ESP8266WebServer::ClientFuture ESP8266WebServer::_parseRequest(WiFiClient & client)
+{
+  String req = client.readStringUntil('\r');
+  String search;
+  String boundary;
+  String body;
+  bool form = false;
+  bool encoded = false;
+  int addr_start;
+  int addr_end;
+  int q;
+
+  client.readStringUntil('\n');
+  for (size_t i = 0; i < _headers.size(); i++)
+    _headers[i].value = String();
+
+  addr_start = req.indexOf(' ');
+  addr_end = req.indexOf(' ', addr_start + 1);
+  if (addr_start < 0 || addr_end < 0)
+    return CLIENT_MUST_STOP;
+
+  String method = req.substring(0, addr_start);
+  String url = req.substring(addr_start + 1, addr_end);
+  _currentVersion = atoi(req.substring(addr_end + 8).c_str());
+  q = url.indexOf('?');
+  if (q >= 0) {
+    search = url.substring(q + 1);
+    url = url.substring(0, q);
+  }
+  _currentUri = url;
+  _chunked = false;
+  _clientContentLength = 0;
+  _hostHeader = String();
+
+       if (method == "HEAD")    _currentMethod = HTTP_HEAD;
+  else if (method == "POST")    _currentMethod = HTTP_POST;
+  else if (method == "PUT")     _currentMethod = HTTP_PUT;
+  else if (method == "PATCH")   _currentMethod = HTTP_PATCH;
+  else if (method == "DELETE")  _currentMethod = HTTP_DELETE;
+  else if (method == "OPTIONS") _currentMethod = HTTP_OPTIONS;
+  else                          _currentMethod = HTTP_GET;
+
+  // HTTP/1.1 is kept alive unless client says otherwise
+  _keepAlive = _currentVersion > 0;
+
+  _currentHandler = NULL;
+  for (size_t i = 0; i < _handlers.size(); i++) {
+    const RequestHandler & h = _handlers[i];
+    if ((h.method == HTTP_ANY || h.method == _currentMethod) && h.uri == _currentUri) {
+      _currentHandler = &h;
+      break;
+    }
+  }
+
+  for (;;) {
+    String line = client.readStringUntil('\r');
+    int div;
+
+    client.readStringUntil('\n');
+    if (!line.length())
+      break;
+    div = line.indexOf(':');
+    if (div < 0)
+      break;
+
+    String name = line.substring(0, div);
+    String value = line.substring(div + 1);
+    value.trim();
+    _collectHeader(name, value);
+
+    if (name.equalsIgnoreCase("Content-Type")) {
+      if (value.startsWith("application/x-www-form-urlencoded"))
+        encoded = true;
+      else if (value.startsWith("multipart/")) {
+        boundary = value.substring(value.indexOf('=') + 1);
+        boundary.replace("\"", "");
+        form = true;
+      }
+    } else if (name.equalsIgnoreCase("Content-Length"))
+      _clientContentLength = value.toInt();
+    else if (name.equalsIgnoreCase("Host"))
+      _hostHeader = value;
+    else if (name.equalsIgnoreCase("Connection"))
+      _keepAlive = value.equalsIgnoreCase("keep-alive");
+  }
+
+  if (_currentMethod == HTTP_POST || _currentMethod == HTTP_PUT ||
+      _currentMethod == HTTP_PATCH || _currentMethod == HTTP_DELETE) {
+    if (!form) {
+      while (body.length() < _clientContentLength) {
+        char buf[256];
+        size_t n = client.readBytes(buf, std::min(sizeof(buf), _clientContentLength - body.length()));
+        if (!n)
+          break;
+        body.concat(buf, n);
+      }
+      if (encoded) {
+        if (search.length())
+          search += '&';
+        search += body;
+      }
+    }
+    _parseArguments(search);
+    if (!form && !encoded && body.length())
+      _args.push_back({ String("plain"), body });
+    if (form && !_parseForm(client, boundary, _clientContentLength))
+      return CLIENT_MUST_STOP;
+  } else
+    _parseArguments(search);
+
+  return CLIENT_REQUEST_CAN_CONTINUE;
+}
+
+// Whole body is read then parts are split, file part goes to upload
+// handler by HTTP_UPLOAD_BUFLEN pieces as core does
+bool ESP8266WebServer::_parseForm(WiFiClient & client, const String & boundary, uint32_t len)
+{
+  std::string data;
+  std::string sep = std::string("--") + boundary.c_str();
+  size_t pos;
+
+  while (data.size() < len) {
+    char buf[1460];
+    size_t n = client.readBytes(buf, std::min((size_t) sizeof(buf), (size_t) (len - data.size())));
+    if (!n)
+      return false;
+    data.append(buf, n);
+  }
+
+  pos = data.find(sep);
+  while (pos != std::string::npos) {
+    size_t head = pos + sep.size();
+    size_t head_end;
+    size_t next;
+    std::string hdr;
+    std::string name;
+    std::string filename;
+    size_t p;
+
+    if (data.compare(head, 2, "--") == 0)
+      break;
+    head_end = data.find("\r\n\r\n", head);
+    if (head_end == std::string::npos)
+      return false;
+    hdr = data.substr(head, head_end - head);
+    next = data.find("\r\n" + sep, head_end + 4);
+    if (next == std::string::npos)
+      return false;
+
+    if ((p = hdr.find("name=\"")) != std::string::npos)
+      name = hdr.substr(p + 6, hdr.find('"', p + 6) - p - 6);
+    if ((p = hdr.find("filename=\"")) != std::string::npos)
+      filename = hdr.substr(p + 10, hdr.find('"', p + 10) - p - 10);
+
+    if (p != std::string::npos && _currentHandler && _currentHandler->ufn) {
+      const char * content = data.data() + head_end + 4;
+      size_t size = next - head_end - 4;
+
+      _currentUpload.reset(new HTTPUpload());
+      _currentUpload->status = UPLOAD_FILE_START;
+      _currentUpload->name = name.c_str();
+      _currentUpload->filename = filename.c_str();
+      _currentUpload->totalSize = 0;
+      _currentUpload->currentSize = 0;
+      _currentUpload->contentLength = len;
+      _currentHandler->ufn();
+      for (size_t off = 0; off < size; off += HTTP_UPLOAD_BUFLEN) {
+        size_t n = std::min((size_t) HTTP_UPLOAD_BUFLEN, size - off);
+        memcpy(_currentUpload->buf, content + off, n);
+        _currentUpload->status = UPLOAD_FILE_WRITE;
+        _currentUpload->currentSize = n;
+        _currentHandler->ufn();
+        _currentUpload->totalSize += n;
+      }
+      _currentUpload->status = UPLOAD_FILE_END;
+      _currentUpload->currentSize = 0;
+      _currentHandler->ufn();
+    } else if (!name.empty())
+      _args.push_back({ String(name.c_str()), String(data.substr(head_end + 4, next - head_end - 4).c_str()) });
+
+    pos = next + 2;
+  }
+  return true;
+}
+
+// Content type from extension, as core mime table
+static const char * staticContentType(const String & path)
+{
+  static const char * types[][2] = {
+    { ".html", "text/html" }, { ".htm", "text/html" }, { ".css", "text/css" },
+    { ".txt", "text/plain" }, { ".js", "application/javascript" },
+    { ".json", "application/json" }, { ".png", "image/png" }, { ".gif", "image/gif" },
+    { ".jpg", "image/jpeg" }, { ".ico", "image/x-icon" }, { ".svg", "image/svg+xml" },
+    { ".ttf", "application/x-font-ttf" }, { ".otf", "application/x-font-opentype" },
+    { ".woff", "application/font-woff" }, { ".woff2", "application/font-woff2" },
+    { ".eot", "application/vnd.ms-fontobject" }, { ".gz", "application/x-gzip" }
+  };
+
+  for (size_t i = 0; i < sizeof(types) / sizeof(*types); i++)
+    if (path.endsWith(types[i][0]))
+      return types[i][1];
+  return "application/octet-stream";
+}
+
+bool ESP8266WebServer::_handleStatic()
+{
+  if (_currentMethod != HTTP_GET && _currentMethod != HTTP_HEAD)
+    return false;
+  for (size_t i = 0; i < _statics.size(); i++) {
+    const StaticHandler & h = _statics[i];
+    String path;
+    String type;
+    File file;
+
+    if (!_currentUri.startsWith(h.uri))
+      continue;
+    path = h.path + _currentUri.substring(h.uri.length());
+    if (path.endsWith("/"))
+      path += "index.htm";
+    type = staticContentType(path);
+    if (!SPIFFS.exists(path) && SPIFFS.exists(path + ".gz"))
+      path += ".gz";
+    file = SPIFFS.open(path, "r");
+    if (!file)
+      return false;
+    if (h.cache.length())
+      sendHeader("Cache-Control", h.cache);
+    streamFile(file, type, _currentMethod);
+    file.close();
+    return true;
+  }
+  return false;
+}
+
+void ESP8266WebServer::_handleRequest()
+{
+  hostHeapHandler(true);
+  if (_currentHandler)
+    _currentHandler->fn();
+  else if (_handleStatic())
+    ;
+  else if (_notFoundHandler)
+    _notFoundHandler();
+  else
+    send(404, "text/html", String("Not found: ") + _currentUri);
+  hostHeapHandler(false);
+  _finalizeResponse();
+  _currentUri = "";
+}
+
+void ESP8266WebServer::_finalizeResponse()
+{
+  if (_chunked)
+    sendContent(empty_string);
+}
+
+/* ======================================================================
+Response
+====================================================================== */
+void ESP8266WebServer::sendHeader(const String & name, const String & value, bool first)
+{
+  HostHeapCoreScope core;
+  String line = name + ": " + value + "\r\n";
+
+  if (first)
+    _responseHeaders = line + _responseHeaders;
+  else
+    _responseHeaders += line;
+}
+
+void ESP8266WebServer::_prepareHeader(String & response, int code, const char * content_type, size_t contentLength)
+{
+  response = String("HTTP/1.") + String(_currentVersion) + ' ' + String(code) + ' ' + responseCodeToString(code) + "\r\n";
+
+  sendHeader("Content-Type", content_type ? content_type : "text/html", true);
+  if (_contentLength == CONTENT_LENGTH_NOT_SET)
+    sendHeader("Content-Length", String((unsigned long) contentLength));
+  else if (_contentLength != CONTENT_LENGTH_UNKNOWN)
+    sendHeader("Content-Length", String((unsigned long) _contentLength));
+  else if (_currentVersion) {
+    _chunked = true;
+    sendHeader("Accept-Ranges", "none");
+    sendHeader("Transfer-Encoding", "chunked");
+  } else
+    _keepAlive = false;
+
+  sendHeader("Connection", _keepAlive ? "keep-alive" : "close");
+  if (_keepAlive)
+    sendHeader("Keep-Alive", String("timeout=") + String(HTTP_MAX_CLOSE_WAIT));
+
+  response += _responseHeaders;
+  response += "\r\n";
+  _responseHeaders = "";
+}
+
+void ESP8266WebServer::send(int code, const char * content_type, const String & content)
+{
+  send(code, content_type, content.c_str(), content.length());
+}
+
+void ESP8266WebServer::send(int code, const char * content_type, const char * content, size_t contentLength)
+{
+  HostHeapCoreScope core;
+  String header;
+
+  _prepareHeader(header, code, content_type, contentLength);
+  _currentClient.write((const uint8_t *) header.c_str(), header.length());
+  if (contentLength)
+    sendContent(content, contentLength);
+}
+
+void ESP8266WebServer::sendContent(const char * content, size_t size)
+{
+  HostHeapCoreScope core;
+  if (_chunked) {
+    char chunk[12];
+    int n = sprintf(chunk, "%zx\r\n", size);
+    _currentClient.write((const uint8_t *) chunk, n);
+  }
+  if (size)
+    _currentClient.write((const uint8_t *) content, size);
+  if (_chunked) {
+    _currentClient.write((const uint8_t *) "\r\n", 2);
+    if (!size)
+      _chunked = false;
+  }
+}
+
+const char * ESP8266WebServer::responseCodeToString(int code)
+{
+  switch (code) {
+    case 100: return "Continue";
+    case 200: return "OK";
+    case 201: return "Created";
+    case 204: return "No Content";
+    case 301: return "Moved Permanently";
+    case 302: return "Found";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 408: return "Request Time-out";
+    case 413: return "Request Entity Too Large";
+    case 500: return "Internal Server Error";
+    case 503: return "Service Unavailable";
+    default:  return "";
+  }
+}
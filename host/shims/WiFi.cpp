@@ -0,0 +1,576 @@
+// **********************************************************************************
+// WifInfo host build, station, TCP and UDP
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// WiFiClient behaves like core 3.x ClientContext: write() waits for
+// room in the send buffer (and for acknowledge in sync mode, default)
+// up to timeout, connected() stays true while data can be read.
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#include "host.h"
+#include "WiFiUdp.h"
+#include <map>
+#include <deque>
+
+#define HOST_TCP_SNDBUF   2920      // 2 * TCP_MSS
+#define HOST_TCP_WND      65535
+#define HOST_TCP_RATE     1000000   // ~8Mbit/s effective on ESP8266
+#define HOST_TCP_RTT_US   2000
+#define HOST_TCP_WAIT_US  500
+
+static std::vector<std::weak_ptr<HostTcp>> conns;
+static std::map<uint64_t, HostEndpoint *> endpoints;
+static std::map<std::string, IPAddress> dns;
+static uint32_t dns_lookups;
+static std::map<uint16_t, std::deque<std::shared_ptr<HostTcp>>> backlog;
+static std::map<uint16_t, bool> listening;
+static uint16_t ephemeral = 50000;
+
+static const IPAddress host_local_ip(192, 168, 1, 50);
+
+/* ======================================================================
+Connection, remote side
+====================================================================== */
+HostTcp::HostTcp() :
+  remote_port(0), local_port(0), sndbuf(HOST_TCP_SNDBUF), rcvwnd(HOST_TCP_WND),
+  rate(HOST_TCP_RATE), credit_us(hostMicros()), established(true),
+  dev_closed(false), remote_closed(false), dev_refs(0)
+{
+}
+
+void HostTcp::send(const std::string & data)
+{
+  if (!dev_closed)
+    to_device += data;
+}
+
+std::string HostTcp::recv(size_t max)
+{
+  std::string ret;
+
+  drain();
+  ret = to_remote.substr(0, max);
+  to_remote.erase(0, ret.size());
+  return ret;
+}
+
+void HostTcp::close(void)
+{
+  remote_closed = true;
+}
+
+// Link moves rate bytes/s toward remote, as long as its window allows
+void HostTcp::drain(void)
+{
+  uint64_t now = hostMicros();
+  uint64_t budget;
+  size_t room;
+  size_t n;
+
+  if (remote_closed) {
+    inflight.clear();
+    credit_us = now;
+    return;
+  }
+
+  budget = rate ? (now - credit_us) * rate / 1000000 : inflight.size();
+  room = rcvwnd > to_remote.size() ? rcvwnd - to_remote.size() : 0;
+  n = std::min((uint64_t) std::min(room, inflight.size()), budget);
+  to_remote.append(inflight, 0, n);
+  inflight.erase(0, n);
+
+  // Idle link does not save credit
+  if (n < budget || !rate)
+    credit_us = now;
+  else
+    credit_us += n * 1000000ULL / rate;
+}
+
+void hostNetPump(void)
+{
+  HostHeapCoreScope core;
+  static bool running;
+
+  if (running)
+    return;
+  running = true;
+
+  for (size_t i = 0; i < conns.size(); ) {
+    std::shared_ptr<HostTcp> tcp = conns[i].lock();
+
+    if (!tcp) {
+      conns.erase(conns.begin() + i);
+      continue;
+    }
+    tcp->drain();
+    i++;
+  }
+
+  for (std::map<uint64_t, HostEndpoint *>::iterator it = endpoints.begin(); it != endpoints.end(); ++it)
+    it->second->poll();
+
+  running = false;
+}
+
+static uint64_t endpointKey(IPAddress ip, uint16_t port)
+{
+  return (uint64_t) (uint32_t) ip << 16 | port;
+}
+
+void hostListen(IPAddress ip, uint16_t port, HostEndpoint * endpoint)
+{
+  endpoints[endpointKey(ip, port)] = endpoint;
+}
+
+void hostUnlisten(HostEndpoint * endpoint)
+{
+  for (std::map<uint64_t, HostEndpoint *>::iterator it = endpoints.begin(); it != endpoints.end(); ) {
+    if (it->second == endpoint)
+      it = endpoints.erase(it);
+    else
+      ++it;
+  }
+}
+
+void hostDns(const char * name, IPAddress ip)
+{
+  dns[name] = ip;
+}
+
+uint32_t hostDnsLookups(void)
+{
+  return dns_lookups;
+}
+
+std::shared_ptr<HostTcp> hostConnect(uint16_t port)
+{
+  std::shared_ptr<HostTcp> tcp = std::make_shared<HostTcp>();
+
+  tcp->remote_ip = IPAddress(192, 168, 1, 10);
+  tcp->remote_port = ephemeral++;
+  tcp->local_port = port;
+  conns.push_back(tcp);
+  if (listening[port])
+    backlog[port].push_back(tcp);
+  else
+    tcp->dev_closed = true;
+  return tcp;
+}
+
+/* ======================================================================
+WiFiClient
+====================================================================== */
+// Copies share the connection like ClientContext, dropping the last
+// one closes it as core unref() does
+static void tcpRef(const std::shared_ptr<HostTcp> & tcp)
+{
+  if (tcp)
+    tcp->dev_refs++;
+}
+
+static void tcpUnref(std::shared_ptr<HostTcp> & tcp)
+{
+  if (tcp && --tcp->dev_refs <= 0)
+    tcp->dev_closed = true;
+  tcp.reset();
+}
+
+WiFiClient::WiFiClient() : _sync(true)
+{
+  _timeout = 5000;
+}
+
+WiFiClient::WiFiClient(std::shared_ptr<HostTcp> tcp) : _tcp(tcp), _sync(true)
+{
+  _timeout = 5000;
+  tcpRef(_tcp);
+}
+
+WiFiClient::WiFiClient(const WiFiClient & other) : Client(other), _tcp(other._tcp), _sync(other._sync)
+{
+  tcpRef(_tcp);
+}
+
+WiFiClient & WiFiClient::operator =(const WiFiClient & other)
+{
+  std::shared_ptr<HostTcp> tcp = other._tcp;
+
+  tcpRef(tcp);
+  tcpUnref(_tcp);
+  _tcp = tcp;
+  _sync = other._sync;
+  _timeout = other._timeout;
+  return *this;
+}
+
+WiFiClient::~WiFiClient()
+{
+  tcpUnref(_tcp);
+}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port)
+{
+  std::map<uint64_t, HostEndpoint *>::iterator it = endpoints.find(endpointKey(ip, port));
+  bool host_known = false;
+
+  stop();
+  for (std::map<uint64_t, HostEndpoint *>::iterator e = endpoints.begin(); e != endpoints.end(); ++e)
+    if ((uint32_t) (e->first >> 16) == (uint32_t) ip)
+      host_known = true;
+
+  // Nobody there, SYN is never answered
+  if (!host_known) {
+    hostAdvance(_timeout * 1000ULL);
+    return 0;
+  }
+
+  hostAdvance(HOST_TCP_RTT_US);
+  // Host up, port closed: RST
+  if (it == endpoints.end())
+    return 0;
+
+  _tcp = std::make_shared<HostTcp>();
+  tcpRef(_tcp);
+  _tcp->remote_ip = ip;
+  _tcp->remote_port = port;
+  _tcp->local_port = ephemeral++;
+  conns.push_back(_tcp);
+  it->second->accept(_tcp);
+  return 1;
+}
+
+int WiFiClient::connect(const char * host, uint16_t port)
+{
+  IPAddress ip;
+
+  if (!WiFi.hostByName(host, ip))
+    return 0;
+  return connect(ip, port);
+}
+
+int WiFiClient::connect(const String & host, uint16_t port)
+{
+  return connect(host.c_str(), port);
+}
+
+uint8_t WiFiClient::connected()
+{
+  if (!_tcp || _tcp->dev_closed)
+    return 0;
+  return !_tcp->remote_closed || !_tcp->to_device.empty();
+}
+
+uint8_t WiFiClient::status()
+{
+  return connected() ? 4 : 0;
+}
+
+// Graceful close, what is in flight is still delivered
+void WiFiClient::stop()
+{
+  if (_tcp)
+    _tcp->dev_closed = true;
+  tcpUnref(_tcp);
+}
+
+bool WiFiClient::stop(unsigned int maxWaitMs)
+{
+  flush(maxWaitMs);
+  stop();
+  return true;
+}
+
+WiFiClient::operator bool()
+{
+  return connected();
+}
+
+int WiFiClient::available()
+{
+  if (!_tcp || _tcp->dev_closed)
+    return 0;
+  return _tcp->to_device.size();
+}
+
+int WiFiClient::read()
+{
+  uint8_t c;
+
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+int WiFiClient::read(uint8_t * buf, size_t size)
+{
+  size_t n = std::min(size, (size_t) available());
+
+  if (!n)
+    return 0;
+  memcpy(buf, _tcp->to_device.data(), n);
+  _tcp->to_device.erase(0, n);
+  return n;
+}
+
+int WiFiClient::peek()
+{
+  return available() ? (uint8_t) _tcp->to_device[0] : -1;
+}
+
+// Core only peeks in current pbuf
+size_t WiFiClient::peekBytes(uint8_t * buffer, size_t length)
+{
+  size_t n = std::min(std::min(length, (size_t) available()), (size_t) 1460);
+
+  if (n)
+    memcpy(buffer, _tcp->to_device.data(), n);
+  return n;
+}
+
+size_t WiFiClient::write(uint8_t c)
+{
+  return write(&c, 1);
+}
+
+size_t WiFiClient::write(const uint8_t * buf, size_t size)
+{
+  HostHeapCoreScope core;
+  uint64_t start = hostMicros();
+  std::shared_ptr<HostTcp> tcp = _tcp;
+  size_t done = 0;
+
+  if (!tcp || tcp->dev_closed)
+    return 0;
+
+  while (done < size) {
+    size_t room;
+    size_t n;
+
+    if (tcp->remote_closed)
+      return done;
+    room = tcp->sndbuf > tcp->inflight.size() ? tcp->sndbuf - tcp->inflight.size() : 0;
+    n = std::min(room, size - done);
+    tcp->inflight.append((const char *) buf + done, n);
+    done += n;
+    if (done < size) {
+      if (hostMicros() - start >= _timeout * 1000ULL)
+        return done;
+      hostAdvance(HOST_TCP_WAIT_US);
+    }
+  }
+
+  // Sync mode waits until all is acknowledged
+  while (_sync && !tcp->inflight.empty() && !tcp->remote_closed) {
+    if (hostMicros() - start >= _timeout * 1000ULL)
+      break;
+    hostAdvance(HOST_TCP_WAIT_US);
+  }
+  return done;
+}
+
+int WiFiClient::availableForWrite()
+{
+  if (!_tcp || _tcp->dev_closed || _tcp->remote_closed)
+    return 0;
+  return _tcp->sndbuf > _tcp->inflight.size() ? _tcp->sndbuf - _tcp->inflight.size() : 0;
+}
+
+void WiFiClient::flush()
+{
+  flush(300);
+}
+
+bool WiFiClient::flush(unsigned int maxWaitMs)
+{
+  uint64_t start = hostMicros();
+
+  while (_tcp && !_tcp->inflight.empty() && !_tcp->remote_closed) {
+    if (hostMicros() - start >= maxWaitMs * 1000ULL)
+      return false;
+    hostAdvance(HOST_TCP_WAIT_US);
+  }
+  return true;
+}
+
+void WiFiClient::setNoDelay(bool nodelay) {}
+void WiFiClient::setSync(bool sync) { _sync = sync; }
+bool WiFiClient::getSync() const { return _sync; }
+IPAddress WiFiClient::remoteIP() { return _tcp ? _tcp->remote_ip : IPAddress(); }
+uint16_t WiFiClient::remotePort() { return _tcp ? _tcp->remote_port : 0; }
+IPAddress WiFiClient::localIP() { return host_local_ip; }
+
+/* ======================================================================
+WiFiServer
+====================================================================== */
+WiFiServer::~WiFiServer()
+{
+  close();
+}
+
+void WiFiServer::begin()
+{
+  _listening = true;
+  listening[_port] = true;
+}
+
+void WiFiServer::close()
+{
+  if (_listening)
+    listening[_port] = false;
+  _listening = false;
+}
+
+WiFiClient WiFiServer::available(uint8_t * status)
+{
+  HostHeapCoreScope core;
+  std::deque<std::shared_ptr<HostTcp>> & q = backlog[_port];
+
+  while (!q.empty()) {
+    std::shared_ptr<HostTcp> tcp = q.front();
+
+    q.pop_front();
+    // Gone before we accepted it
+    if (tcp->remote_closed && tcp->to_device.empty())
+      continue;
+    return WiFiClient(tcp);
+  }
+  return WiFiClient();
+}
+
+bool WiFiServer::hasClient()
+{
+  return !backlog[_port].empty();
+}
+
+/* ======================================================================
+IPAddress
+====================================================================== */
+bool IPAddress::fromString(const char * str)
+{
+  unsigned a, b, c, d;
+  char end;
+
+  if (!str || sscanf(str, "%u.%u.%u.%u%c", &a, &b, &c, &d, &end) != 4 ||
+      a > 255 || b > 255 || c > 255 || d > 255)
+    return false;
+  *this = IPAddress(a, b, c, d);
+  return true;
+}
+
+String IPAddress::toString() const
+{
+  char buf[16];
+
+  sprintf(buf, "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+  return String(buf);
+}
+
+size_t printIP(Print & p, const IPAddress & ip)
+{
+  return p.print(ip.toString());
+}
+
+Print & operator <<(Print & p, const IPAddress & ip)
+{
+  printIP(p, ip);
+  return p;
+}
+
+/* ======================================================================
+Station, always connected
+====================================================================== */
+ESP8266WiFiClass WiFi;
+
+int ESP8266WiFiClass::status() { return WL_CONNECTED; }
+void ESP8266WiFiClass::printDiag(Print & p) { p.println(F("Mode: STA\nSSID (4): host")); }
+String ESP8266WiFiClass::SSID() const { return String("host"); }
+String ESP8266WiFiClass::SSID(uint8_t network) { return String(""); }
+String ESP8266WiFiClass::psk() const { return String(""); }
+int ESP8266WiFiClass::begin(const char * ssid, const char * passphrase) { return WL_CONNECTED; }
+bool ESP8266WiFiClass::mode(int m) { return true; }
+int ESP8266WiFiClass::getMode() { return WIFI_STA; }
+IPAddress ESP8266WiFiClass::localIP() { return host_local_ip; }
+IPAddress ESP8266WiFiClass::subnetMask() { return IPAddress(255, 255, 255, 0); }
+IPAddress ESP8266WiFiClass::gatewayIP() { return IPAddress(192, 168, 1, 1); }
+String ESP8266WiFiClass::macAddress() { return String("5C:CF:7F:C0:FF:EE"); }
+bool ESP8266WiFiClass::disconnect(bool wifioff) { return true; }
+bool ESP8266WiFiClass::softAP(const char * ssid, const char * passphrase) { return true; }
+IPAddress ESP8266WiFiClass::softAPIP() { return IPAddress(192, 168, 4, 1); }
+String ESP8266WiFiClass::softAPmacAddress() { return String("5E:CF:7F:C0:FF:EE"); }
+int8_t ESP8266WiFiClass::scanNetworks(bool async, bool show_hidden) { return 0; }
+int8_t ESP8266WiFiClass::scanComplete() { return 0; }
+void ESP8266WiFiClass::scanDelete() {}
+int32_t ESP8266WiFiClass::RSSI() { return -60; }
+int32_t ESP8266WiFiClass::RSSI(uint8_t network) { return 0; }
+uint8_t ESP8266WiFiClass::encryptionType(uint8_t network) { return 0; }
+int32_t ESP8266WiFiClass::channel(uint8_t network) { return 0; }
+
+int ESP8266WiFiClass::hostByName(const char * name, IPAddress & result)
+{
+  return hostByName(name, result, 10000);
+}
+
+int ESP8266WiFiClass::hostByName(const char * name, IPAddress & result, uint32_t timeout_ms)
+{
+  std::map<std::string, IPAddress>::iterator it;
+
+  if (result.fromString(name))
+    return 1;
+  dns_lookups++;
+  it = dns.find(name);
+  if (it == dns.end()) {
+    hostAdvance(HOST_TCP_RTT_US);
+    return 0;
+  }
+  hostAdvance(HOST_TCP_RTT_US);
+  result = it->second;
+  return 1;
+}
+
+/* ======================================================================
+UDP, datagrams are kept for tests
+====================================================================== */
+std::vector<HostUdpPacket> & hostUdpSent(void)
+{
+  static std::vector<HostUdpPacket> sent;
+  return sent;
+}
+
+int WiFiUDP::beginPacket(IPAddress ip, uint16_t port)
+{
+  _ip = ip;
+  _dport = port;
+  _packet.clear();
+  _open = true;
+  return 1;
+}
+
+int WiFiUDP::beginPacket(const char * host, uint16_t port)
+{
+  IPAddress ip;
+
+  if (!WiFi.hostByName(host, ip))
+    return 0;
+  return beginPacket(ip, port);
+}
+
+size_t WiFiUDP::write(const uint8_t * buffer, size_t size)
+{
+  if (!_open)
+    return 0;
+  _packet.append((const char *) buffer, size);
+  return size;
+}
+
+int WiFiUDP::endPacket()
+{
+  if (!_open)
+    return 0;
+  hostUdpSent().push_back({ _ip, _dport, _packet, hostMicros() });
+  _open = false;
+  return 1;
+}
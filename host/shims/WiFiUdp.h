@@ -0,0 +1,46 @@
+// **********************************************************************************
+// WifInfo host build, WiFiUDP stand-in
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// Sent datagrams are kept for tests, see host.h, nothing is received.
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#ifndef HOST_WIFIUDP_H
+#define HOST_WIFIUDP_H
+
+#include "ESP8266WiFi.h"
+#include <string>
+
+class WiFiUDP : public Stream
+{
+public:
+  uint8_t begin(uint16_t port) { _port = port; return 1; }
+  void stop() { _port = 0; }
+  static void stopAll() {}
+  int beginPacket(IPAddress ip, uint16_t port);
+  int beginPacket(const char * host, uint16_t port);
+  int endPacket();
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t * buffer, size_t size) override;
+  using Print::write;
+  int parsePacket() { return 0; }
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  void flush() override {}
+
+private:
+  uint16_t    _port = 0;
+  IPAddress   _ip;
+  uint16_t    _dport = 0;
+  std::string _packet;
+  bool        _open = false;
+};
+
+#endif
@@ -0,0 +1,14 @@
+// WifInfo host build, base64 stand-in
+#ifndef HOST_BASE64_H
+#define HOST_BASE64_H
+
+#include "Arduino.h"
+
+class base64
+{
+public:
+  static String encode(const uint8_t * data, size_t length, bool doNewLines = true);
+  static String encode(const String & text, bool doNewLines = true);
+};
+
+#endif
@@ -0,0 +1,21 @@
+// **********************************************************************************
+// WifInfo host build, ESP8266 core version stand-in
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// Core release the stand-ins imitate, see Wifinfo.h
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#ifndef HOST_CORE_VERSION_H
+#define HOST_CORE_VERSION_H
+
+#define ARDUINO_ESP8266_MAJOR   3
+#define ARDUINO_ESP8266_MINOR   1
+#define ARDUINO_ESP8266_REVISION 2
+
+#endif
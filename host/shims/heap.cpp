@@ -0,0 +1,202 @@
+// **********************************************************************************
+// WifInfo host build, counted heap
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// malloc family is replaced by glibc one plus counters, new and
+// delete go through it too. Sizes are usable sizes, as umm_malloc
+// also rounds blocks up. Blocks allocated by sketch code are kept in
+// a table, so their frees are known whoever does them.
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#include "host.h"
+#include <malloc.h>
+#include <errno.h>
+
+extern "C" {
+void * __libc_malloc(size_t size);
+void * __libc_calloc(size_t n, size_t size);
+void * __libc_realloc(void * p, size_t size);
+void * __libc_memalign(size_t align, size_t size);
+void   __libc_free(void * p);
+}
+
+static HostHeapStats heap;
+static int heap_handler;
+static int heap_core;
+static int heap_sketch;
+static size_t heap_handler_live;
+
+// Sketch blocks, open addressing, no heap of its own
+#define HEAP_SKETCH_SLOTS (1 << 16)
+static struct { void * p; size_t size; } heap_blocks[HEAP_SKETCH_SLOTS];
+
+static inline size_t heapSlot(void * p)
+{
+  return ((uintptr_t) p >> 4) * 2654435761u & (HEAP_SKETCH_SLOTS - 1);
+}
+
+static void heapSketchAdd(void * p, size_t size)
+{
+  size_t i = heapSlot(p);
+
+  while (heap_blocks[i].p)
+    i = (i + 1) & (HEAP_SKETCH_SLOTS - 1);
+  heap_blocks[i].p = p;
+  heap_blocks[i].size = size;
+  heap.sketch_live += size;
+  if (heap.sketch_live > heap.sketch_peak)
+    heap.sketch_peak = heap.sketch_live;
+}
+
+static void heapSketchDel(void * p)
+{
+  size_t i = heapSlot(p);
+  size_t j;
+
+  while (heap_blocks[i].p != p) {
+    if (!heap_blocks[i].p)
+      return;
+    i = (i + 1) & (HEAP_SKETCH_SLOTS - 1);
+  }
+  heap.sketch_live -= heap_blocks[i].size;
+
+  // Move back blocks that would not be found past the hole
+  for (j = (i + 1) & (HEAP_SKETCH_SLOTS - 1); heap_blocks[j].p; j = (j + 1) & (HEAP_SKETCH_SLOTS - 1)) {
+    size_t home = heapSlot(heap_blocks[j].p);
+
+    if (((j - home) & (HEAP_SKETCH_SLOTS - 1)) >= ((j - i) & (HEAP_SKETCH_SLOTS - 1))) {
+      heap_blocks[i] = heap_blocks[j];
+      i = j;
+    }
+  }
+  heap_blocks[i].p = NULL;
+}
+
+static inline void heapAdd(void * p)
+{
+  if (!p)
+    return;
+  heap.mallocs++;
+  heap.live += malloc_usable_size(p);
+  if (heap.live > heap.peak)
+    heap.peak = heap.live;
+  if (heap_handler && !heap_core) {
+    heap.handler_mallocs++;
+    heap.handler_bytes += malloc_usable_size(p);
+    heap_handler_live += malloc_usable_size(p);
+    if (heap_handler_live > heap.handler_peak)
+      heap.handler_peak = heap_handler_live;
+  }
+  if (heap_sketch && !heap_core)
+    heapSketchAdd(p, malloc_usable_size(p));
+}
+
+// Freed by handler, what it got from core is not told apart
+static inline void heapDel(size_t size)
+{
+  if (heap_handler && !heap_core)
+    heap_handler_live -= size < heap_handler_live ? size : heap_handler_live;
+}
+
+extern "C" {
+
+void * malloc(size_t size)
+{
+  void * p = __libc_malloc(size);
+  heapAdd(p);
+  return p;
+}
+
+void * calloc(size_t n, size_t size)
+{
+  void * p = __libc_calloc(n, size);
+  heapAdd(p);
+  return p;
+}
+
+void * realloc(void * p, size_t size)
+{
+  size_t old = p ? malloc_usable_size(p) : 0;
+  void * np = __libc_realloc(p, size);
+
+  if (np || !size) {
+    heap.live -= old;
+    heapDel(old);
+    if (p)
+      heapSketchDel(p);
+    if (p && !size)
+      heap.frees++;
+  }
+  heapAdd(np);
+  return np;
+}
+
+void * memalign(size_t align, size_t size)
+{
+  void * p = __libc_memalign(align, size);
+  heapAdd(p);
+  return p;
+}
+
+void * aligned_alloc(size_t align, size_t size)
+{
+  return memalign(align, size);
+}
+
+int posix_memalign(void ** pp, size_t align, size_t size)
+{
+  void * p = memalign(align, size);
+
+  if (!p)
+    return ENOMEM;
+  *pp = p;
+  return 0;
+}
+
+void free(void * p)
+{
+  if (!p)
+    return;
+  heap.frees++;
+  heap.live -= malloc_usable_size(p);
+  heapDel(malloc_usable_size(p));
+  heapSketchDel(p);
+  __libc_free(p);
+}
+
+}
+
+HostHeapStats hostHeapStats(void)
+{
+  return heap;
+}
+
+void hostHeapResetPeak(void)
+{
+  heap.peak = heap.live;
+}
+
+void hostHeapHandler(bool in)
+{
+  if (in && !heap_handler) {
+    heap_handler_live = 0;
+    heap.handler_peak = 0;
+  }
+  heap_handler += in ? 1 : -1;
+}
+
+void hostHeapCore(bool in)
+{
+  heap_core += in ? 1 : -1;
+}
+
+void hostHeapSketch(bool in)
+{
+  heap_sketch += in ? 1 : -1;
+}
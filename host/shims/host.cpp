@@ -0,0 +1,676 @@
+// **********************************************************************************
+// WifInfo host build, clock, UARTs and board
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#include "host.h"
+#include "Ticker.h"
+#include "EEPROM.h"
+#include "ArduinoOTA.h"
+#include "ESP8266mDNS.h"
+#include "base64.h"
+#include "user_interface.h"
+#include <time.h>
+#include <deque>
+#include <vector>
+
+void setup(void);
+void loop(void);
+
+// Pumped by clock, see WiFi.cpp
+void hostNetPump(void);
+
+#define HOST_YIELD_US     10      // yield() or delay(0), SDK tasks
+#define HOST_STEP_US      1000    // world is updated at least every ms
+#define HOST_WDT_CALLS    10000000 // millis() calls without time moving
+
+static uint64_t now_us;
+static uint32_t still_calls;
+static double   cpu_scale;
+static int      in_sketch;
+static uint64_t cpu_mark;
+
+static void serialCatchUp(void);
+static void tickerRun(void);
+
+/* ======================================================================
+Clock
+====================================================================== */
+// CPU time of this thread, so a busy machine (parallel tests) does not
+// make the sketch look slower
+static uint64_t cpuNs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void cpuMark(void)
+{
+  if (cpu_scale > 0)
+    cpu_mark = cpuNs();
+}
+
+// Charge CPU time spent in sketch since last mark
+static void cpuSync(void)
+{
+  uint64_t t;
+
+  if (cpu_scale <= 0 || !in_sketch)
+    return;
+
+  t = cpuNs();
+  now_us += (t - cpu_mark) * cpu_scale / 1000;
+  cpu_mark = t;
+}
+
+void hostCpuScale(double factor)
+{
+  cpu_scale = factor;
+  cpuMark();
+}
+
+uint64_t hostMicros(void)
+{
+  cpuSync();
+  return now_us;
+}
+
+// Step time up to target, world sees each step
+void hostAdvance(uint64_t us)
+{
+  uint64_t target;
+
+  cpuSync();
+  target = now_us + us;
+  still_calls = 0;
+  do {
+    uint64_t step = target - now_us;
+
+    if (step > HOST_STEP_US)
+      step = HOST_STEP_US;
+    now_us += step;
+    serialCatchUp();
+    hostNetPump();
+    tickerRun();
+  } while (now_us < target);
+  cpuMark();
+}
+
+unsigned long micros(void)
+{
+  cpuSync();
+  // Busy waiting without yield, soft WDT would reset the ESP
+  if (++still_calls > HOST_WDT_CALLS) {
+    fprintf(stderr, "host: soft WDT, time read %u times without yield\n", still_calls);
+    abort();
+  }
+  return (unsigned long) now_us;
+}
+
+unsigned long millis(void)
+{
+  return micros() / 1000;
+}
+
+void delay(unsigned long ms)
+{
+  hostAdvance(ms ? ms * 1000ULL : HOST_YIELD_US);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  // Busy wait on ESP, nothing else runs
+  cpuSync();
+  now_us += us;
+}
+
+void yield(void)
+{
+  hostAdvance(HOST_YIELD_US);
+}
+
+static uint64_t loop_worst;
+
+uint64_t hostLoopOnce(void)
+{
+  uint64_t start = now_us;
+
+  in_sketch++;
+  hostHeapSketch(true);
+  cpuMark();
+  loop();
+  cpuSync();
+  hostHeapSketch(false);
+  in_sketch--;
+
+  // At least an idle pass, SDK runs between two loop()
+  hostAdvance(HOST_LOOP_IDLE_US);
+  if (now_us - start > loop_worst)
+    loop_worst = now_us - start;
+  return now_us - start;
+}
+
+unsigned long hostLoop(unsigned long ms)
+{
+  uint64_t end = hostMicros() + ms * 1000ULL;
+  unsigned long passes = 0;
+
+  while (now_us < end) {
+    hostLoopOnce();
+    passes++;
+  }
+  return passes;
+}
+
+uint64_t hostLoopWorst(void)
+{
+  uint64_t worst = loop_worst;
+
+  loop_worst = 0;
+  return worst;
+}
+
+void hostBoot(void)
+{
+  in_sketch++;
+  hostHeapSketch(true);
+  cpuMark();
+  setup();
+  cpuSync();
+  hostHeapSketch(false);
+  in_sketch--;
+}
+
+/* ======================================================================
+Pins
+====================================================================== */
+void pinMode(uint8_t pin, uint8_t mode) {}
+void digitalWrite(uint8_t pin, uint8_t val) {}
+int digitalRead(uint8_t pin) { return LOW; }
+int analogRead(uint8_t pin) { return 512; }
+long random(long howbig) { return howbig ? rand() % howbig : 0; }
+long random(long howsmall, long howbig) { return howsmall + random(howbig - howsmall); }
+
+/* ======================================================================
+UART0, teleinfo receive. A byte takes 10 bits (7E1 and 8N1)
+====================================================================== */
+typedef struct
+{
+  std::vector<uint8_t> data;
+  size_t        pos;
+  unsigned long baud;
+  bool          loop;
+  uint64_t      start_us;
+  uint64_t      slots;        // bytes times elapsed since start
+} _hostfeed;
+
+static _hostfeed feed;
+static bool     feed_open;
+static std::deque<uint8_t> rx;
+static size_t   rx_size = 256;
+static unsigned long uart_baud;
+static bool     rx_overrun;
+static uint32_t rx_dropped;
+
+bool hostSerialOpen(const char * path, unsigned long baud, bool loop)
+{
+  FILE * f = fopen(path, "rb");
+  uint8_t buf[4096];
+  size_t n;
+
+  if (!f)
+    return false;
+  feed.data.clear();
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+    feed.data.insert(feed.data.end(), buf, buf + n);
+  fclose(f);
+  feed.pos = 0;
+  feed.baud = baud;
+  feed.loop = loop;
+  feed.start_us = now_us;
+  feed.slots = 0;
+  feed_open = !feed.data.empty();
+  return feed_open;
+}
+
+void hostSerialClose(void)
+{
+  feed_open = false;
+}
+
+size_t hostSerialRemaining(void)
+{
+  serialCatchUp();
+  return feed_open ? feed.data.size() - feed.pos : 0;
+}
+
+uint32_t hostSerialDropped(void)
+{
+  return rx_dropped;
+}
+
+static void serialCatchUp(void)
+{
+  HostHeapCoreScope core;
+  uint64_t slots;
+
+  if (!feed_open)
+    return;
+
+  slots = (now_us - feed.start_us) * feed.baud / 10 / 1000000;
+  while (feed.slots < slots) {
+    uint8_t c;
+
+    if (feed.pos >= feed.data.size()) {
+      if (!feed.loop) {
+        feed_open = false;
+        return;
+      }
+      feed.pos = 0;
+    }
+    c = feed.data[feed.pos++];
+    feed.slots++;
+
+    // Nothing received if UART is off, noise at wrong speed
+    if (!uart_baud)
+      continue;
+    if (uart_baud != feed.baud)
+      c = 0xFF;
+    if (rx.size() < rx_size)
+      rx.push_back(c);
+    else {
+      rx_overrun = true;
+      rx_dropped++;
+    }
+  }
+}
+
+/* ======================================================================
+UART1, debug output at line speed through 128 bytes FIFO
+====================================================================== */
+#define HOST_UART_FIFO 128
+
+static unsigned long tx_baud;
+static uint64_t tx_busy_until;
+static std::string debug_out;
+
+const std::string & hostDebugOutput(void)
+{
+  return debug_out;
+}
+
+static void uart1Write(const uint8_t * buffer, size_t size)
+{
+  static int echo = -1;
+
+  if (echo < 0)
+    echo = getenv("HOST_DEBUG") != NULL;
+  if (echo)
+    fwrite(buffer, 1, size, stderr);
+  // Keep last 32KB to 64KB, room is taken once so sketch
+  // allocation counts don't see it
+  if (!debug_out.capacity() || debug_out.capacity() < 65536 + 4096)
+    debug_out.reserve(65536 + 4096);
+  if (debug_out.size() + size > 65536)
+    debug_out.erase(0, std::min(debug_out.size(), (size_t) 32768));
+  debug_out.append((const char *) buffer, size);
+
+  if (!tx_baud)
+    return;
+
+  uint64_t byte_us = 10 * 1000000ULL / tx_baud;
+  for (size_t i = 0; i < size; i++) {
+    uint64_t now = hostMicros();
+
+    if (tx_busy_until < now)
+      tx_busy_until = now;
+    // FIFO full, core waits for room
+    if (tx_busy_until - now >= HOST_UART_FIFO * byte_us)
+      hostAdvance(tx_busy_until - now - (HOST_UART_FIFO - 1) * byte_us);
+    tx_busy_until += byte_us;
+  }
+}
+
+HardwareSerial Serial(0);
+HardwareSerial Serial1(1);
+
+void HardwareSerial::begin(unsigned long baud, int config)
+{
+  if (_uart)
+    tx_baud = baud;
+  else
+    uart_baud = baud;
+}
+
+void HardwareSerial::end()
+{
+  if (!_uart)
+    uart_baud = 0;
+}
+
+void HardwareSerial::swap() {}
+
+void HardwareSerial::updateBaudRate(unsigned long baud)
+{
+  begin(baud);
+}
+
+int HardwareSerial::baudRate(void)
+{
+  return _uart ? tx_baud : uart_baud;
+}
+
+size_t HardwareSerial::setRxBufferSize(size_t size)
+{
+  if (!_uart)
+    rx_size = size;
+  return size;
+}
+
+int HardwareSerial::available(void)
+{
+  if (_uart)
+    return 0;
+  serialCatchUp();
+  return rx.size();
+}
+
+int HardwareSerial::peek(void)
+{
+  return available() ? rx.front() : -1;
+}
+
+int HardwareSerial::read(void)
+{
+  int c = peek();
+
+  if (c >= 0)
+    rx.pop_front();
+  return c;
+}
+
+size_t HardwareSerial::read(char * buffer, size_t size)
+{
+  size_t n = 0;
+
+  serialCatchUp();
+  while (n < size && !rx.empty()) {
+    buffer[n++] = rx.front();
+    rx.pop_front();
+  }
+  return n;
+}
+
+// Like core, waits for missing bytes up to timeout
+size_t HardwareSerial::readBytes(char * buffer, size_t size)
+{
+  unsigned long start = millis();
+  size_t n = 0;
+
+  while (n < size) {
+    n += read(buffer + n, size - n);
+    if (n < size) {
+      if (millis() - start >= _timeout)
+        break;
+      yield();
+    }
+  }
+  return n;
+}
+
+bool HardwareSerial::hasOverrun(void)
+{
+  bool ret = rx_overrun;
+
+  rx_overrun = false;
+  return ret;
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+  return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t * buffer, size_t size)
+{
+  HostHeapCoreScope core;
+
+  // UART0 TX is not wired once swapped
+  if (_uart)
+    uart1Write(buffer, size);
+  return size;
+}
+
+/* ======================================================================
+ESP and SDK
+====================================================================== */
+EspClass ESP;
+
+uint32_t EspClass::getFreeHeap(void)
+{
+  size_t used = hostHeapStats().sketch_live;
+
+  return used > HOST_HEAP_FREE ? 0 : HOST_HEAP_FREE - used;
+}
+
+uint32_t EspClass::getMaxFreeBlockSize(void) { return getFreeHeap(); }
+uint8_t EspClass::getHeapFragmentation(void) { return 0; }
+uint32_t EspClass::getChipId(void) { return 0x00C0FFEE; }
+uint32_t EspClass::getFlashChipRealSize(void) { return 4 * 1024 * 1024; }
+uint32_t EspClass::getFlashChipSize(void) { return 4 * 1024 * 1024; }
+uint32_t EspClass::getSketchSize(void) { return 420 * 1024; }
+uint32_t EspClass::getFreeSketchSpace(void) { return 1024 * 1024 - getSketchSize(); }
+uint32_t EspClass::getCycleCount(void) { return (uint32_t) (hostMicros() * 80); }
+uint8_t EspClass::getCpuFreqMHz(void) { return 80; }
+String EspClass::getResetReason(void) { return String("Power on"); }
+bool EspClass::eraseConfig(void) { return true; }
+
+void EspClass::restart(void)
+{
+  fprintf(stderr, "host: ESP.restart() at %llu ms\n", (unsigned long long) (now_us / 1000));
+  exit(3);
+}
+
+void EspClass::reset(void)
+{
+  restart();
+}
+
+extern "C" {
+bool system_update_cpu_freq(uint8_t freq) { return freq == 80; }
+uint8_t system_get_cpu_freq(void) { return 80; }
+const char * system_get_sdk_version(void) { return "2.2.2-dev(host)"; }
+uint32_t system_get_chip_id(void) { return ESP.getChipId(); }
+uint8_t system_get_boot_version(void) { return 31; }
+uint32_t system_get_free_heap_size(void) { return ESP.getFreeHeap(); }
+}
+
+UpdaterClass Update;
+
+bool UpdaterClass::begin(size_t size, int command)
+{
+  _size = size;
+  _written = 0;
+  _error = false;
+  return true;
+}
+
+size_t UpdaterClass::write(uint8_t * data, size_t len)
+{
+  if (_written + len > _size) {
+    _error = true;
+    return 0;
+  }
+  _written += len;
+  return len;
+}
+
+bool UpdaterClass::end(bool evenIfRemaining)
+{
+  return !_error && _written > 0;
+}
+
+bool UpdaterClass::hasError(void)
+{
+  return _error;
+}
+
+void UpdaterClass::printError(Print & out)
+{
+  if (_error)
+    out.println(F("ERROR[4]: Not Enough Space"));
+}
+
+/* ======================================================================
+Ticker, run from clock like SDK timers
+====================================================================== */
+typedef struct
+{
+  Ticker *  ticker;
+  uint64_t  due;
+  uint64_t  period;
+  bool      repeat;
+  Ticker::callback_function_t fn;
+} _hosttimer;
+
+static std::vector<_hosttimer> timers;
+
+void Ticker::arm(uint32_t ms, bool repeat, callback_function_t callback)
+{
+  detach();
+  timers.push_back({ this, now_us + ms * 1000ULL, ms * 1000ULL, repeat, callback });
+}
+
+void Ticker::detach()
+{
+  for (size_t i = 0; i < timers.size(); i++)
+    if (timers[i].ticker == this) {
+      timers.erase(timers.begin() + i);
+      return;
+    }
+}
+
+bool Ticker::active() const
+{
+  for (size_t i = 0; i < timers.size(); i++)
+    if (timers[i].ticker == this)
+      return true;
+  return false;
+}
+
+// Callbacks can arm or detach, look for due timer again after each
+static void tickerRun(void)
+{
+  static bool running;
+  bool found = true;
+
+  if (running)
+    return;
+  running = true;
+  while (found) {
+    found = false;
+    for (size_t i = 0; i < timers.size(); i++) {
+      if (timers[i].due > now_us)
+        continue;
+
+      Ticker::callback_function_t fn = timers[i].fn;
+      if (timers[i].repeat)
+        timers[i].due += timers[i].period ? timers[i].period : 1000;
+      else
+        timers.erase(timers.begin() + i);
+      fn();
+      found = true;
+      break;
+    }
+  }
+  running = false;
+}
+
+/* ======================================================================
+EEPROM, sector reads as erased flash until written
+====================================================================== */
+EEPROMClass EEPROM;
+static uint8_t eeprom[HOST_EEPROM_SIZE];
+static bool eeprom_init;
+
+static void eepromInit(void)
+{
+  if (!eeprom_init) {
+    memset(eeprom, 0xFF, sizeof(eeprom));
+    eeprom_init = true;
+  }
+}
+
+void EEPROMClass::begin(size_t size)
+{
+  eepromInit();
+  _size = size > HOST_EEPROM_SIZE ? HOST_EEPROM_SIZE : size;
+}
+
+uint8_t EEPROMClass::read(int address)
+{
+  eepromInit();
+  return address >= 0 && address < HOST_EEPROM_SIZE ? eeprom[address] : 0;
+}
+
+void EEPROMClass::write(int address, uint8_t val)
+{
+  eepromInit();
+  if (address >= 0 && address < HOST_EEPROM_SIZE)
+    eeprom[address] = val;
+}
+
+bool EEPROMClass::commit()
+{
+  return true;
+}
+
+void EEPROMClass::end()
+{
+  _size = 0;
+}
+
+uint8_t * EEPROMClass::getDataPtr()
+{
+  eepromInit();
+  return eeprom;
+}
+
+/* ======================================================================
+Others
+====================================================================== */
+ArduinoOTAClass ArduinoOTA;
+MDNSResponder MDNS;
+
+String base64::encode(const uint8_t * data, size_t length, bool doNewLines)
+{
+  static const char tab[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  String out;
+
+  out.reserve((length + 2) / 3 * 4);
+  for (size_t i = 0; i < length; i += 3) {
+    uint32_t v = data[i] << 16;
+    if (i + 1 < length) v |= data[i + 1] << 8;
+    if (i + 2 < length) v |= data[i + 2];
+    out += tab[(v >> 18) & 0x3F];
+    out += tab[(v >> 12) & 0x3F];
+    out += i + 1 < length ? tab[(v >> 6) & 0x3F] : '=';
+    out += i + 2 < length ? tab[v & 0x3F] : '=';
+    if (doNewLines && (i / 3 + 1) % 18 == 0)
+      out += '\n';
+  }
+  return out;
+}
+
+String base64::encode(const String & text, bool doNewLines)
+{
+  return encode((const uint8_t *) text.c_str(), text.length(), doNewLines);
+}
@@ -0,0 +1,184 @@
+// **********************************************************************************
+// WifInfo host build, test side control of the simulated board
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// The sketch runs unmodified on a virtual clock. Time only moves when
+// the sketch waits (delay, yield, blocking socket write...) or when the
+// test advances it, so a run is reproducible. Bytes arrive on the UART
+// at line speed from a raw TIC capture, TCP peers are in process.
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#ifndef HOST_H
+#define HOST_H
+
+#include "Arduino.h"
+#include "ESP8266WiFi.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// Clock
+// =====
+// Virtual time since boot (us)
+uint64_t hostMicros(void);
+
+// Move time forward, run due timers, UART and network peers
+void hostAdvance(uint64_t us);
+
+// Add CPU time spent by the sketch (thread CPU clock, not wall time)
+// times factor to virtual time, 0 (default) means the sketch runs in
+// no time. The ESP8266 at 80MHz is 20 to 40 times slower than a
+// desktop core.
+void hostCpuScale(double factor);
+
+// Run loop() until virtual time reached now + ms, an idle pass costs
+// HOST_LOOP_IDLE_US, returns number of loop() passes
+#define HOST_LOOP_IDLE_US 50
+unsigned long hostLoop(unsigned long ms);
+
+// Run loop() once, returns time taken including idle pass (us)
+uint64_t hostLoopOnce(void);
+
+// Longest loop() pass seen by hostLoop() (us), reset on read
+uint64_t hostLoopWorst(void);
+
+// UART0 (teleinfo)
+// ================
+// Feed raw capture file (bytes as the meter sends them) at baud/10 bytes per
+// second, bytes arrive as garbage if UART runs at another speed
+bool hostSerialOpen(const char * path, unsigned long baud, bool loop = false);
+void hostSerialClose(void);
+
+// Bytes of the capture not delivered yet, and lost on RX overflow
+size_t hostSerialRemaining(void);
+uint32_t hostSerialDropped(void);
+
+// Serial1 (debug) output, echoed on stderr if HOST_DEBUG is set
+const std::string & hostDebugOutput(void);
+
+// Network
+// =======
+// One TCP connection, the "remote" side is driven by the test
+struct HostTcp
+{
+  IPAddress   remote_ip;
+  uint16_t    remote_port;
+  uint16_t    local_port;
+
+  std::string to_device;      // sent by remote, not read by device yet
+  std::string inflight;       // written by device, not received yet
+  std::string to_remote;      // received by remote, not read yet
+  size_t      sndbuf;         // device send buffer (lwIP TCP_SND_BUF)
+  size_t      rcvwnd;         // remote receive window
+  uint32_t    rate;           // link speed (bytes/s)
+  uint64_t    credit_us;      // last time link was drained
+
+  bool        established;
+  bool        dev_closed;     // device called stop()
+  bool        remote_closed;  // remote closed (FIN/RST)
+  int         dev_refs;       // WiFiClient copies, last one gone closes
+
+  HostTcp();
+
+  // Remote side
+  void send(const std::string & data);
+  std::string recv(size_t max = (size_t) -1);
+  void close(void);
+  bool closed(void) const { return dev_closed && inflight.empty(); }
+
+  // Move bytes in flight toward remote
+  void drain(void);
+};
+
+// Something listening on ip:port that the sketch connects to
+class HostEndpoint
+{
+public:
+  virtual ~HostEndpoint() {}
+  virtual void accept(std::shared_ptr<HostTcp> tcp) = 0;
+  virtual void poll(void) {}
+};
+
+void hostListen(IPAddress ip, uint16_t port, HostEndpoint * endpoint);
+void hostUnlisten(HostEndpoint * endpoint);
+void hostDns(const char * name, IPAddress ip);
+uint32_t hostDnsLookups(void);
+
+// Browser side, open a connection to a sketch WiFiServer port
+std::shared_ptr<HostTcp> hostConnect(uint16_t port);
+
+// UDP datagrams sent by the sketch
+struct HostUdpPacket
+{
+  IPAddress   ip;
+  uint16_t    port;
+  std::string data;
+  uint64_t    us;
+};
+std::vector<HostUdpPacket> & hostUdpSent(void);
+
+// Heap
+// ====
+// malloc/free are counted for whole process
+struct HostHeapStats
+{
+  uint64_t mallocs;   // malloc, calloc and realloc calls
+  uint64_t frees;
+  size_t   live;      // bytes allocated now
+  size_t   peak;      // largest live since last reset
+  uint64_t handler_mallocs; // made by web route handlers, core calls excluded
+  uint64_t handler_bytes;   // their size
+  size_t   handler_peak;    // largest of them live at once, last handler
+  size_t   sketch_live;     // allocated by setup() and loop(), core excluded
+  size_t   sketch_peak;
+};
+HostHeapStats hostHeapStats(void);
+void hostHeapResetPeak(void);
+
+// Sketch running, web route handler running, and core (web server
+// responses, sockets, SPIFFS, network peers) called from them, all nest
+void hostHeapSketch(bool in);
+void hostHeapHandler(bool in);
+void hostHeapCore(bool in);
+struct HostHeapCoreScope
+{
+  HostHeapCoreScope() { hostHeapCore(true); }
+  ~HostHeapCoreScope() { hostHeapCore(false); }
+};
+
+// ESP.getFreeHeap() is HOST_HEAP_FREE less sketch_live, host pointers
+// are twice as large so it is pessimistic
+#define HOST_HEAP_FREE 45000
+
+// SPIFFS
+// ======
+// Load all files of a directory (like data/ uploaded to the board)
+bool hostFsLoad(const char * dir);
+// File system size, writes fail past it (default 1MB)
+void hostFsSize(size_t bytes);
+std::string hostFsRead(const char * path);
+
+struct HostFsStats
+{
+  uint32_t opens;
+  uint32_t reads;       // read calls
+  uint64_t read_bytes;
+  uint32_t writes;      // write calls
+  uint64_t write_bytes;
+  uint32_t exists;
+  uint32_t dir_next;
+};
+HostFsStats & hostFsStats(void);
+
+// Board
+// =====
+// Take heap baseline (see HOST_HEAP_FREE) and run setup()
+void hostBoot(void);
+
+#endif
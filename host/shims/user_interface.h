@@ -0,0 +1,23 @@
+// WifInfo host build, ESP8266 SDK stand-in
+#ifndef HOST_USER_INTERFACE_H
+#define HOST_USER_INTERFACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+bool system_update_cpu_freq(uint8_t freq);
+uint8_t system_get_cpu_freq(void);
+const char * system_get_sdk_version(void);
+uint32_t system_get_chip_id(void);
+uint8_t system_get_boot_version(void);
+uint32_t system_get_free_heap_size(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
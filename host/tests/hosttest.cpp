@@ -0,0 +1,547 @@
+// **********************************************************************************
+// WifInfo host build, test helpers
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#include "hosttest.h"
+#include <algorithm>
+#ifdef HOST_ZLIB
+#include <zlib.h>
+#endif
+
+void testFail(const char * file, int line, const char * what)
+{
+  fprintf(stderr, "%s:%d: check failed: %s\n", file, line, what);
+  exit(1);
+}
+
+std::string testData(const char * name)
+{
+  return std::string(HOST_DATA_DIR) + "/" + name;
+}
+
+void testBoot(std::function<void(void)> configure)
+{
+  hostFsLoad(SKETCH_DATA_DIR);
+  ResetConfig();
+  if (configure)
+    configure();
+  saveConfig();
+  hostBoot();
+}
+
+void testFeed(const char * name, bool loop)
+{
+  bool standard = !strcmp(name, TEST_STANDARD);
+
+  tinfoSetMode(standard ? TINFO_MODE_STANDARD : TINFO_MODE_HISTORIQUE);
+  CHECK(hostSerialOpen(testData(name).c_str(), standard ? TINFO_STD_BAUD : TINFO_HIST_BAUD, loop));
+}
+
+bool testFrames(uint32_t n, unsigned long timeout_ms)
+{
+  uint32_t target = tinfo_frames + n;
+  uint64_t end = hostMicros() + timeout_ms * 1000ULL;
+
+  while ((int32_t) (tinfo_frames - target) < 0) {
+    if (hostMicros() >= end)
+      return false;
+    hostLoopOnce();
+  }
+  return true;
+}
+
+uint64_t testPercentile(std::vector<uint64_t> & samples, double p)
+{
+  size_t i;
+
+  if (samples.empty())
+    return 0;
+  std::sort(samples.begin(), samples.end());
+  i = (size_t) (p / 100.0 * (samples.size() - 1) + 0.5);
+  return samples[std::min(i, samples.size() - 1)];
+}
+
+uint64_t testMallocs(std::function<void(void)> fn)
+{
+  uint64_t before = hostHeapStats().mallocs;
+
+  fn();
+  return hostHeapStats().mallocs - before;
+}
+
+/* ======================================================================
+HTTP parsing, Content-Length, chunked or until close
+====================================================================== */
+static std::string lower(std::string s)
+{
+  for (size_t i = 0; i < s.size(); i++)
+    s[i] = tolower((unsigned char) s[i]);
+  return s;
+}
+
+bool testHttpParse(std::string & buf, bool closed, std::string & start_line,
+                   std::map<std::string, std::string> & headers, std::string & body)
+{
+  size_t head_end = buf.find("\r\n\r\n");
+  size_t pos;
+  size_t end;
+  std::map<std::string, std::string> h;
+  std::map<std::string, std::string>::iterator it;
+
+  if (head_end == std::string::npos)
+    return false;
+
+  pos = buf.find("\r\n");
+  start_line = buf.substr(0, pos);
+  while (pos < head_end) {
+    size_t next = buf.find("\r\n", pos + 2);
+    std::string line = buf.substr(pos + 2, next - pos - 2);
+    size_t colon = line.find(':');
+
+    if (colon != std::string::npos) {
+      size_t v = line.find_first_not_of(' ', colon + 1);
+      h[lower(line.substr(0, colon))] = v == std::string::npos ? "" : line.substr(v);
+    }
+    pos = next;
+  }
+  pos = head_end + 4;
+
+  // Requests without length have no body, answers last until close
+  bool is_request = start_line.compare(0, 5, "HTTP/") != 0;
+  bool no_body = !is_request && (start_line.find(" 304") == 8 || start_line.find(" 204") == 8);
+
+  if ((it = h.find("content-length")) != h.end()) {
+    end = pos + strtoul(it->second.c_str(), NULL, 10);
+    if (buf.size() < end)
+      return false;
+    body = buf.substr(pos, end - pos);
+  } else if ((it = h.find("transfer-encoding")) != h.end() && lower(it->second) == "chunked") {
+    body.clear();
+    for (;;) {
+      size_t eol = buf.find("\r\n", pos);
+      size_t len;
+
+      if (eol == std::string::npos)
+        return false;
+      len = strtoul(buf.c_str() + pos, NULL, 16);
+      if (buf.size() < eol + 2 + len + 2)
+        return false;
+      body.append(buf, eol + 2, len);
+      pos = eol + 2 + len + 2;
+      if (!len)
+        break;
+    }
+    end = pos;
+  } else if (is_request || no_body) {
+    body.clear();
+    end = pos;
+  } else {
+    if (!closed)
+      return false;
+    body = buf.substr(pos);
+    end = buf.size();
+  }
+
+  headers = h;
+  buf.erase(0, end);
+  return true;
+}
+
+/* ======================================================================
+HTTP server stand-in
+====================================================================== */
+TestHttpServer::TestHttpServer(const char * name, IPAddress ip, uint16_t port) :
+  delay_ms(0), keep_alive(true), date(0), connections(0), bytes_in(0)
+{
+  hostDns(name, ip);
+  hostListen(ip, port, this);
+}
+
+TestHttpServer::~TestHttpServer()
+{
+  hostUnlisten(this);
+}
+
+void TestHttpServer::accept(std::shared_ptr<HostTcp> tcp)
+{
+  Conn c;
+
+  c.tcp = tcp;
+  c.busy = false;
+  c.answer_us = 0;
+  _conns.push_back(c);
+  connections++;
+}
+
+void TestHttpServer::poll(void)
+{
+  uint64_t now = hostMicros();
+
+  for (size_t i = 0; i < _conns.size(); ) {
+    Conn & c = _conns[i];
+    std::string in = c.tcp->recv();
+
+    c.buf += in;
+    bytes_in += in.size();
+
+    if (!c.busy) {
+      std::string raw = c.buf;
+      std::string line;
+      TestRequest req;
+
+      if (testHttpParse(c.buf, c.tcp->dev_closed, line, req.headers, req.body)) {
+        std::string body = "OK";
+        int status = 200;
+        char head[192];
+        size_t sp1 = line.find(' ');
+        size_t sp2 = line.find(' ', sp1 + 1);
+
+        req.method = line.substr(0, sp1);
+        req.path = line.substr(sp1 + 1, sp2 - sp1 - 1);
+        req.raw = raw.substr(0, raw.size() - c.buf.size());
+        req.us = now;
+        requests.push_back(req);
+        if (handler)
+          status = handler(req, body);
+
+        snprintf(head, sizeof(head), "HTTP/1.1 %d %s\r\nContent-Length: %u\r\nConnection: %s\r\n",
+                 status, status < 300 ? "OK" : "Error", (unsigned) body.size(),
+                 keep_alive ? "keep-alive" : "close");
+        if (date) {
+          time_t t = date + now / 1000000;
+
+          strftime(head + strlen(head), 40, "Date: %a, %d %b %Y %H:%M:%S GMT\r\n", gmtime(&t));
+        }
+        c.answer = std::string(head) + extra_headers + "\r\n" + body;
+        c.answer_us = now + delay_ms * 1000ULL;
+        c.busy = true;
+      }
+    }
+
+    if (c.busy && now >= c.answer_us) {
+      c.tcp->send(c.answer);
+      c.busy = false;
+      if (!keep_alive)
+        c.tcp->close();
+    }
+
+    // Device went away, or we did
+    if ((c.tcp->closed() && !c.busy) || c.tcp->remote_closed) {
+      _conns.erase(_conns.begin() + i);
+      continue;
+    }
+    i++;
+  }
+}
+
+/* ======================================================================
+MQTT broker stand-in
+====================================================================== */
+TestMqttBroker::TestMqttBroker(const char * name, IPAddress ip, uint16_t port) :
+  connects(0), pings(0)
+{
+  hostDns(name, ip);
+  hostListen(ip, port, this);
+}
+
+TestMqttBroker::~TestMqttBroker()
+{
+  hostUnlisten(this);
+}
+
+void TestMqttBroker::accept(std::shared_ptr<HostTcp> tcp)
+{
+  Conn c;
+
+  c.tcp = tcp;
+  _conns.push_back(c);
+}
+
+static std::string mqttString(const std::string & body, size_t & pos)
+{
+  size_t len;
+
+  if (pos + 2 > body.size())
+    return "";
+  len = ((uint8_t) body[pos] << 8) | (uint8_t) body[pos + 1];
+  pos += 2 + len;
+  return body.substr(pos - len, len);
+}
+
+// false to drop connection
+bool TestMqttBroker::packet(Conn & c, uint8_t type, const std::string & body)
+{
+  size_t pos = 0;
+
+  switch (type & 0xF0) {
+    case MQTT_CONNECT:
+      CHECK_EQ(mqttString(body, pos), "MQTT");
+      connects++;
+      c.tcp->send(std::string("\x20\x02\x00\x00", 4));
+      return true;
+
+    case MQTT_PUBLISH: {
+      TestMqttMessage m;
+
+      m.qos = (type >> 1) & 3;
+      m.retain = type & 0x01;
+      m.dup = type & 0x08;
+      m.topic = mqttString(body, pos);
+      if (m.qos) {
+        c.tcp->send(std::string("\x40\x02", 2) + body.substr(pos, 2));
+        pos += 2;
+      }
+      m.payload = body.substr(pos);
+      messages.push_back(m);
+      return true;
+    }
+
+    case MQTT_PINGREQ:
+      pings++;
+      c.tcp->send(std::string("\xD0\x00", 2));
+      return true;
+  }
+  return false;
+}
+
+void TestMqttBroker::poll(void)
+{
+  for (size_t i = 0; i < _conns.size(); ) {
+    Conn & c = _conns[i];
+    bool ok = true;
+
+    c.buf += c.tcp->recv();
+    for (;;) {
+      size_t len = 0;
+      size_t pos = 1;
+      uint8_t shift = 0;
+
+      // Fixed header, remaining length is 1 to 4 bytes
+      while (pos < c.buf.size() && pos < 5) {
+        len |= ((uint8_t) c.buf[pos] & 0x7F) << shift;
+        shift += 7;
+        if (!(c.buf[pos++] & 0x80))
+          break;
+      }
+      if (c.buf.size() < 2 || (c.buf[pos - 1] & 0x80) || c.buf.size() < pos + len)
+        break;
+
+      ok = packet(c, c.buf[0], c.buf.substr(pos, len));
+      c.buf.erase(0, pos + len);
+      if (!ok)
+        break;
+    }
+
+    if (!ok)
+      c.tcp->close();
+    if (!ok || c.tcp->closed() || c.tcp->remote_closed) {
+      _conns.erase(_conns.begin() + i);
+      continue;
+    }
+    i++;
+  }
+}
+
+/* ======================================================================
+JSON syntax check
+====================================================================== */
+static bool jsonValue(const char *& p);
+
+static void jsonSpace(const char *& p)
+{
+  while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')
+    p++;
+}
+
+static bool jsonString(const char *& p)
+{
+  if (*p++ != '"')
+    return false;
+  while (*p != '"') {
+    if ((uint8_t) *p < ' ')
+      return false;
+    if (*p == '\\') {
+      p++;
+      if (*p == 'u') {
+        for (int i = 1; i <= 4; i++)
+          if (!isxdigit((unsigned char) p[i]))
+            return false;
+        p += 4;
+      } else if (!strchr("\"\\/bfnrt", *p) || !*p) {
+        return false;
+      }
+    }
+    p++;
+  }
+  p++;
+  return true;
+}
+
+static bool jsonValue(const char *& p)
+{
+  char * end;
+
+  jsonSpace(p);
+  if (*p == '{' || *p == '[') {
+    char close = *p == '{' ? '}' : ']';
+
+    p++;
+    jsonSpace(p);
+    if (*p == close) {
+      p++;
+      return true;
+    }
+    for (;;) {
+      if (close == '}') {
+        jsonSpace(p);
+        if (!jsonString(p))
+          return false;
+        jsonSpace(p);
+        if (*p++ != ':')
+          return false;
+      }
+      if (!jsonValue(p))
+        return false;
+      jsonSpace(p);
+      if (*p == close) {
+        p++;
+        return true;
+      }
+      if (*p++ != ',')
+        return false;
+    }
+  }
+  if (*p == '"')
+    return jsonString(p);
+  if (!strncmp(p, "true", 4) || !strncmp(p, "null", 4)) {
+    p += 4;
+    return true;
+  }
+  if (!strncmp(p, "false", 5)) {
+    p += 5;
+    return true;
+  }
+  strtod(p, &end);
+  if (end == p)
+    return false;
+  p = end;
+  return true;
+}
+
+bool testJsonValid(const std::string & text)
+{
+  const char * p = text.c_str();
+
+  if (!jsonValue(p))
+    return false;
+  jsonSpace(p);
+  return !*p;
+}
+
+/* ======================================================================
+gzip
+====================================================================== */
+bool testGunzip(const std::string & gz, std::string & out)
+{
+#ifdef HOST_ZLIB
+  z_stream z;
+  char buf[4096];
+  int ret;
+
+  memset(&z, 0, sizeof(z));
+  if (inflateInit2(&z, 16 + MAX_WBITS) != Z_OK)
+    return false;
+  z.next_in = (Bytef *) gz.data();
+  z.avail_in = gz.size();
+  out.clear();
+  do {
+    z.next_out = (Bytef *) buf;
+    z.avail_out = sizeof(buf);
+    ret = inflate(&z, Z_NO_FLUSH);
+    out.append(buf, sizeof(buf) - z.avail_out);
+  } while (ret == Z_OK);
+  inflateEnd(&z);
+  return ret == Z_STREAM_END && !z.avail_in;
+#else
+  (void) gz;
+  (void) out;
+  return false;
+#endif
+}
+
+/* ======================================================================
+Browser
+====================================================================== */
+TestBrowser::TestBrowser(uint16_t port) : read_max(0), _port(port), _start(0), _wire(0)
+{
+}
+
+void TestBrowser::send(const std::string & method, const std::string & path,
+                       const std::string & headers, const std::string & body)
+{
+  std::string req;
+
+  // Server closed our idle connection, open another one
+  if (!tcp || tcp->dev_closed || tcp->remote_closed) {
+    tcp = hostConnect(_port);
+    _buf.clear();
+  }
+  req = method + " " + path + " HTTP/1.1\r\nHost: wifinfo\r\n" + headers;
+  if (!body.empty())
+    req += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+  req += "\r\n" + body;
+  tcp->send(req);
+  _start = hostMicros();
+  _wire = 0;
+}
+
+bool TestBrowser::poll(TestResponse & resp)
+{
+  std::string in = tcp->recv(read_max ? read_max : (size_t) -1);
+  std::string line;
+
+  _buf += in;
+  _wire += in.size();
+  resp.status = 0;
+  resp.wire_bytes = 0;
+  resp.us = 0;
+  if (testHttpParse(_buf, tcp->closed(), line, resp.headers, resp.body)) {
+    resp.status = atoi(line.c_str() + 9);
+    resp.wire_bytes = _wire - _buf.size();
+    resp.us = hostMicros() - _start;
+    return true;
+  }
+  return tcp->closed() && tcp->to_remote.empty();
+}
+
+bool TestBrowser::closed(void) const
+{
+  return !tcp || tcp->closed();
+}
+
+TestResponse TestBrowser::request(const std::string & method, const std::string & path,
+                                  const std::string & headers, const std::string & body,
+                                  unsigned long timeout_ms)
+{
+  TestResponse resp;
+  uint64_t end;
+
+  send(method, path, headers, body);
+  end = hostMicros() + timeout_ms * 1000ULL;
+  while (!poll(resp) && hostMicros() < end)
+    hostLoopOnce();
+  return resp;
+}
+
+TestResponse TestBrowser::get(const std::string & path, const std::string & headers,
+                              unsigned long timeout_ms)
+{
+  return request("GET", path, headers, "", timeout_ms);
+}
@@ -0,0 +1,188 @@
+// **********************************************************************************
+// WifInfo host build, test helpers
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// Boot the sketch with a given config, stand-in servers for the sinks
+// and a browser for the web server. Numbers printed by tests are
+// virtual time (us) unless they say otherwise.
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#ifndef HOSTTEST_H
+#define HOSTTEST_H
+
+#include "host.h"
+#include "Wifinfo.h"
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+// Fail the test with location
+#define CHECK(cond) \
+  do { if (!(cond)) testFail(__FILE__, __LINE__, #cond); } while (0)
+#define CHECK_EQ(a, b) \
+  do { if (!((a) == (b))) testFail(__FILE__, __LINE__, #a " == " #b); } while (0)
+
+void testFail(const char * file, int line, const char * what);
+
+// Recordings in host/data
+std::string testData(const char * name);
+
+// Load sketch data/ in SPIFFS, reset config to defaults, let configure
+// edit it, save it and run setup()
+void testBoot(std::function<void(void)> configure = NULL);
+
+// Feed a recording on UART0 and select decoder mode
+#define TEST_HISTORIC "historique.tic"
+#define TEST_STANDARD "standard.tic"
+void testFeed(const char * name, bool loop = true);
+
+// Run loop() until n more frames have been decoded or timeout (ms)
+bool testFrames(uint32_t n, unsigned long timeout_ms = 60000);
+
+// Percentile p (0..100) of samples, sorted in place
+uint64_t testPercentile(std::vector<uint64_t> & samples, double p);
+
+// Heap allocations counted while fn runs
+uint64_t testMallocs(std::function<void(void)> fn);
+
+// HTTP request as seen by a stand-in server
+struct TestRequest
+{
+  std::string method;
+  std::string path;           // with query string
+  std::map<std::string, std::string> headers; // lower case names
+  std::string body;
+  std::string raw;            // head and body as received
+  uint64_t    us;             // when complete
+};
+
+// HTTP server stand-in (emoncms, jeedom, domoticz, influx). Answers
+// each request after delay_ms, keeps connections open unless close
+class TestHttpServer : public HostEndpoint
+{
+public:
+  TestHttpServer(const char * name, IPAddress ip, uint16_t port = 80);
+  ~TestHttpServer();
+
+  // Status and body for a request, default 200 "OK"
+  std::function<int(const TestRequest & req, std::string & body)> handler;
+  unsigned long delay_ms;
+  bool          keep_alive;
+  std::string   extra_headers; // added to each answer, with CRLF
+  time_t        date;         // if set, Date header, time at boot
+
+  std::vector<TestRequest> requests;
+  uint32_t      connections;
+  uint64_t      bytes_in;     // bytes received, head and body
+
+  void accept(std::shared_ptr<HostTcp> tcp) override;
+  void poll(void) override;
+
+private:
+  struct Conn
+  {
+    std::shared_ptr<HostTcp> tcp;
+    std::string buf;
+    bool        busy;         // request received, not answered yet
+    uint64_t    answer_us;
+    std::string answer;
+  };
+  std::vector<Conn> _conns;
+};
+
+// MQTT message as seen by the broker stand-in
+struct TestMqttMessage
+{
+  std::string topic;
+  std::string payload;
+  uint8_t     qos;
+  bool        retain;
+  bool        dup;
+};
+
+// MQTT 3.1.1 broker stand-in, accepts any CONNECT, acknowledges QoS 1
+// PUBLISH and answers PINGREQ
+class TestMqttBroker : public HostEndpoint
+{
+public:
+  TestMqttBroker(const char * name, IPAddress ip, uint16_t port = 1883);
+  ~TestMqttBroker();
+
+  std::vector<TestMqttMessage> messages;
+  uint32_t      connects;
+  uint32_t      pings;
+
+  void accept(std::shared_ptr<HostTcp> tcp) override;
+  void poll(void) override;
+
+private:
+  struct Conn
+  {
+    std::shared_ptr<HostTcp> tcp;
+    std::string buf;
+  };
+  std::vector<Conn> _conns;
+
+  bool packet(Conn & c, uint8_t type, const std::string & body);
+};
+
+// true if text is one valid JSON value
+bool testJsonValid(const std::string & text);
+
+// Uncompress a gzip member, false if invalid or built without zlib
+bool testGunzip(const std::string & gz, std::string & out);
+
+// HTTP response as seen by the browser
+struct TestResponse
+{
+  int         status;         // 0 if no complete answer
+  std::map<std::string, std::string> headers; // lower case names
+  std::string body;           // de-chunked
+  size_t      wire_bytes;     // head and body as received
+  uint64_t    us;             // request sent to last byte
+};
+
+// Browser, one connection to the sketch web server, keep-alive
+class TestBrowser
+{
+public:
+  TestBrowser(uint16_t port = 80);
+
+  // Send a request, run loop() until the answer is complete
+  TestResponse get(const std::string & path, const std::string & headers = "",
+                   unsigned long timeout_ms = 10000);
+  TestResponse request(const std::string & method, const std::string & path,
+                       const std::string & headers, const std::string & body,
+                       unsigned long timeout_ms = 10000);
+
+  // Split request in two steps, for several browsers at once
+  void send(const std::string & method, const std::string & path,
+            const std::string & headers = "", const std::string & body = "");
+  bool poll(TestResponse & resp);   // true once complete or closed
+  bool closed(void) const;
+
+  // Bytes read per poll (0 no limit), a slow browser
+  size_t read_max;
+
+  std::shared_ptr<HostTcp> tcp;
+
+private:
+  uint16_t    _port;
+  std::string _buf;
+  uint64_t    _start;
+  size_t      _wire;
+};
+
+// Parse one complete HTTP message (request or response) at the start of
+// buf, removes it from buf. Returns false while incomplete.
+bool testHttpParse(std::string & buf, bool closed, std::string & start_line,
+                   std::map<std::string, std::string> & headers, std::string & body);
+
+#endif
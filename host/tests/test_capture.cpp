@@ -0,0 +1,108 @@
+// **********************************************************************************
+// WifInfo host build, capture replay
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// Recordings copied to SPIFFS are replayed with replayStart() while
+// nothing comes on the serial line. Every frame of the file must be
+// decoded, each sink task must run once per period of the virtual clock
+// (line time of the replayed bytes) and not on its real ticker, and the
+// replay must take line time divided by the acceleration factor. At
+// REPLAY_MAX_SPEED the sketch is the limit, not the line time.
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#include "hosttest.h"
+
+#define CAPTURE_FILE "/capture.tic"
+
+static const uint8_t periods[TASK_COUNT] = { 0, 10, 15, 30, 20, 60 };
+
+// Copy a recording to SPIFFS, returns its frames count
+static uint32_t load(const char * name, size_t * size)
+{
+  FILE * f = fopen(testData(name).c_str(), "rb");
+  File out = SPIFFS.open(CAPTURE_FILE, "w");
+  uint32_t frames = 0;
+  char buf[256];
+  size_t n;
+
+  CHECK(f);
+  CHECK(out);
+  *size = 0;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+    for (size_t i = 0; i < n; i++)
+      frames += buf[i] == 0x02;
+    CHECK_EQ(out.write((const uint8_t *) buf, n), n);
+    *size += n;
+  }
+  out.close();
+  fclose(f);
+  return frames;
+}
+
+static void replay(const char * name, uint32_t baud, uint16_t speed)
+{
+  uint32_t runs[TASK_COUNT];
+  uint32_t frames = tinfo_frames;
+  uint32_t expected;
+  uint64_t line_ms, start, took_ms;
+  size_t size;
+
+  expected = load(name, &size);
+  line_ms = size * 10000ULL / baud;
+
+  // Scheduler statistics are reset by start
+  start = hostMicros();
+  CHECK(replayStart(CAPTURE_FILE, baud, speed, false));
+  for (uint8_t task = 0; task < TASK_COUNT; task++)
+    runs[task] = schedtask[task].runs;
+  while (replayActive())
+    hostLoopOnce();
+  took_ms = (hostMicros() - start) / 1000;
+  // Tasks triggered by the last pass
+  hostLoop(10);
+  frames = tinfo_frames - frames;
+
+  printf("capture %-14s x%-4u %4u frames, line %5llus, replay %6llu ms, runs",
+         name, speed, frames, (unsigned long long) (line_ms / 1000),
+         (unsigned long long) took_ms);
+  for (uint8_t task = TASK_SINK_FIRST; task < TASK_COUNT; task++)
+    printf(" %s %u", schedtask[task].name, schedtask[task].runs - runs[task]);
+  printf("\n");
+
+  CHECK_EQ(frames, expected);
+  for (uint8_t task = TASK_SINK_FIRST; task < TASK_COUNT; task++)
+    CHECK_EQ(schedtask[task].runs - runs[task], line_ms / (periods[task] * 1000UL));
+
+  // Line time over speed, a few loop passes late at most, unless the
+  // sketch can't keep up with that speed
+  CHECK(took_ms >= line_ms / speed);
+  if (speed <= 100)
+    CHECK(took_ms <= line_ms / speed + line_ms / speed / 20 + 20);
+}
+
+int main(void)
+{
+  testBoot([]() {
+    config.tic_mode = TINFO_MODE_HISTORIQUE;
+    config.emoncms.freq  = periods[TASK_EMONCMS];
+    config.jeedom.freq   = periods[TASK_JEEDOM];
+    config.domoticz.freq = periods[TASK_DOMOTICZ];
+    config.mqtt.freq     = periods[TASK_MQTT];
+    config.influx.freq   = periods[TASK_INFLUX];
+  });
+
+  replay(TEST_HISTORIC, 1200, 10);
+  replay(TEST_STANDARD, TINFO_STD_BAUD, 10);
+  replay(TEST_STANDARD, TINFO_STD_BAUD, REPLAY_MAX_SPEED);
+
+  // Real tickers are back
+  for (uint8_t task = TASK_SINK_FIRST; task < TASK_COUNT; task++)
+    CHECK_EQ(schedtask[task].period_ms, periods[task] * 1000UL);
+  return 0;
+}
@@ -0,0 +1,212 @@
+// **********************************************************************************
+// WifInfo host build, emoncms bulk upload
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// Posted data=[[time,node,{...}],...] bodies are decoded as emoncms does
+// (form decoding, then samples dated from request age) and each sample
+// must match the frame decoded at that second. Standard mode samples do
+// not fit one request so uploads are split, decoder base values must
+// carry over from a request to the next, and in push on change mode
+// entries after the first of a request only have changed values. Label
+// names are form encoded, NJOURF+1 must not arrive as "NJOURF 1".
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#include "hosttest.h"
+#include <set>
+
+typedef std::map<std::string, uint32_t> Values;
+
+// Frames decoded, by uptime second
+static std::multimap<uint32_t, Values> frames;
+
+// Samples posted, with their uptime second
+struct Sample
+{
+  uint32_t time;
+  Values   values;
+};
+static std::vector<Sample> samples;
+static uint32_t requests;
+static std::set<uint32_t> uploads;  // requests creation times
+
+static Values frameValues(void)
+{
+  Values values;
+  char name[TINFO_LABEL_SIZE];
+  uint32_t number;
+
+  for (uint8_t id = 0; id < LABEL_COUNT; id++) {
+    if (tinfoFrameValue(id, &number)) {
+      strcpy_P(name, (PGM_P) TInfoLabels::labelName(id));
+      values[name] = number;
+    }
+  }
+  return values;
+}
+
+static std::string formDecode(const std::string & s)
+{
+  std::string out;
+
+  for (size_t i = 0; i < s.size(); i++) {
+    if (s[i] == '+')
+      out += ' ';
+    else if (s[i] == '%' && i + 2 < s.size()) {
+      out += (char) strtol(s.substr(i + 1, 2).c_str(), NULL, 16);
+      i += 2;
+    } else
+      out += s[i];
+  }
+  return out;
+}
+
+// Body parameter, form decoded
+static std::string param(const std::string & body, const char * name)
+{
+  std::string key = std::string(name) + "=";
+  size_t start = body.find(key);
+  size_t end;
+
+  if (start == std::string::npos)
+    return "";
+  start += key.size();
+  end = body.find('&', start);
+  return formDecode(body.substr(start, end == std::string::npos ? end : end - start));
+}
+
+// Entries of data=, values of an entry add to previous ones of request
+static int bulk(const TestRequest & req, std::string & body)
+{
+  std::string data = param(req.body, "data");
+  uint32_t created = seconds - strtoul(param(req.body, "sentat").c_str(), NULL, 10);
+  const char * p = data.c_str();
+  Values values;
+
+  body = "ok";
+  requests++;
+  uploads.insert(created);
+  CHECK(req.path.find("/input/bulk.json?apikey=") == 0);
+  CHECK_EQ(*p++, '[');
+  while (*p == '[') {
+    Sample sample;
+    char * end;
+
+    sample.time = created + strtol(p + 1, &end, 10);
+    CHECK_EQ(*end, ',');
+    CHECK_EQ(strtoul(end + 1, &end, 10), (unsigned long) config.emoncms.node);
+    CHECK(!strncmp(end, ",{", 2));
+    p = end + 2;
+    while (*p == '"') {
+      const char * q = strchr(p + 1, '"');
+      std::string name(p + 1, q - p - 1);
+
+      CHECK_EQ(q[1], ':');
+      values[name] = strtoul(q + 2, &end, 10);
+      p = end + (*end == ',');
+    }
+    CHECK(!strncmp(p, "}]", 2));
+    p += 2;
+    p += *p == ',';
+    sample.values = values;
+    samples.push_back(sample);
+  }
+  CHECK(!strcmp(p, "]"));
+  return 200;
+}
+
+// Run until n uploads, keeping decoded frames
+static void upload(uint32_t n)
+{
+  uint32_t seen = tinfo_frames;
+  uint32_t until = requests + n;
+  unsigned long start = millis();
+
+  while (requests < until && millis() - start < 600000UL) {
+    hostLoopOnce();
+    if (tinfo_frames != seen) {
+      seen = tinfo_frames;
+      frames.insert(std::make_pair(seconds, frameValues()));
+    }
+  }
+  CHECK(requests >= until);
+}
+
+// Each sample is a frame of its second (one second off at most, request
+// age is in seconds)
+static void check(const char * mode)
+{
+  uint32_t matched = 0;
+  bool plus = false;
+
+  for (size_t i = 0; i < samples.size(); i++) {
+    const Sample & s = samples[i];
+    bool found = false;
+
+    for (uint32_t t = s.time ? s.time - 1 : 0; t <= s.time + 1 && !found; t++) {
+      std::pair<std::multimap<uint32_t, Values>::iterator,
+                std::multimap<uint32_t, Values>::iterator> range = frames.equal_range(t);
+
+      for (std::multimap<uint32_t, Values>::iterator it = range.first; it != range.second; ++it)
+        found |= it->second == s.values;
+    }
+    matched += found;
+    plus |= s.values.count("NJOURF+1") > 0;
+  }
+
+  printf("emonbulk %-6s %u uploads in %u requests, %u samples, %u matched, %u dropped, "
+         "%u RAM bytes for %u request bytes\n",
+         mode, (unsigned) uploads.size(), requests, (unsigned) samples.size(), matched,
+         emonbulkstat.dropped, emonbulkstat.encoded, emonbulkstat.rendered);
+  CHECK(samples.size() > 0);
+  CHECK_EQ(matched, (uint32_t) samples.size());
+  CHECK_EQ(emonbulkstat.dropped, 0u);
+  CHECK(requests > uploads.size());
+  CHECK(plus);
+}
+
+static void reset(void)
+{
+  samples.clear();
+  uploads.clear();
+  requests = 0;
+  memset(&emonbulkstat, 0, sizeof(emonbulkstat));
+  emonbulkstat.step = config.emoncms.bulk;
+}
+
+int main(void)
+{
+  TestHttpServer * emoncms;
+
+  testBoot([]() {
+    strcpy(config.emoncms.host, "emoncms.local");
+    strcpy(config.emoncms.url, "/input/post.json");
+    strcpy(config.emoncms.apikey, "0123456789abcdef");
+    config.emoncms.node = 3;
+    config.emoncms.freq = 30;
+    config.emoncms.bulk = 2;
+    config.emoncms.push.mode = CFG_PUSH_ALWAYS;
+  });
+  emoncms = new TestHttpServer("emoncms.local", IPAddress(192, 168, 1, 10));
+  emoncms->handler = bulk;
+
+  // All values in each entry
+  testFeed(TEST_STANDARD);
+  upload(8);
+  check("always");
+
+  // Only changes after first entry of a request
+  config.emoncms.push.mode = CFG_PUSH_CHANGE;
+  upload(2);
+  reset();
+  upload(8);
+  check("change");
+
+  delete emoncms;
+  return 0;
+}
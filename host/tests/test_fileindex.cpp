@@ -0,0 +1,170 @@
+// **********************************************************************************
+// WifInfo host build, web files from index
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// Page load of the UI files plus label requests, then the same load
+// revalidated with ETags. Reports flash accesses (opens, reads, exists)
+// per load, latency of each file in virtual time (1 MB/s link, ESP CPU
+// taken as 30 times slower than this machine) and real CPU time of this
+// machine per load.
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#include "hosttest.h"
+#include <chrono>
+
+#define LOADS     50
+#define CPU_SCALE 30
+
+// What the UI asks for, first the files then some labels
+static const char * page[] = {
+  "/", "/css/wifinfo.css", "/js/wifinfo.js", "/fonts/glyphicons.woff2", "/favicon.ico",
+  "/PAPP", "/HCHC", "/IINST"
+};
+#define PAGE  (sizeof(page) / sizeof(*page))
+#define FILES 5
+
+static std::string fileText(const char * path)
+{
+  File f = SPIFFS.open(path, "r");
+  std::string text;
+  char buf[512];
+  size_t n;
+
+  while (f && (n = f.read((uint8_t *) buf, sizeof(buf))) > 0)
+    text.append(buf, n);
+  return text;
+}
+
+struct Load
+{
+  HostFsStats fs;
+  uint64_t    bytes;
+  double      cpu;
+};
+
+// One page load, etags[] filled in or sent back
+static void load(TestBrowser & browser, std::string * etags, bool revalidate,
+                 std::vector<uint64_t> & latency, Load & l)
+{
+  HostFsStats before = hostFsStats();
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+  l.bytes = 0;
+  for (size_t i = 0; i < PAGE; i++) {
+    std::string headers;
+    TestResponse resp;
+
+    if (revalidate && i < FILES)
+      headers = "If-None-Match: " + etags[i] + "\r\n";
+    resp = browser.get(page[i], headers);
+    l.bytes += resp.wire_bytes;
+    if (i >= FILES) {
+      CHECK_EQ(resp.status, 200);
+      continue;
+    }
+
+    latency.push_back(resp.us);
+    if (revalidate) {
+      CHECK_EQ(resp.status, 304);
+      CHECK(resp.body.empty());
+    } else {
+      CHECK_EQ(resp.status, 200);
+      etags[i] = resp.headers["etag"];
+    }
+  }
+  l.cpu = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  l.fs = hostFsStats();
+  l.fs.opens -= before.opens;
+  l.fs.reads -= before.reads;
+  l.fs.read_bytes -= before.read_bytes;
+  l.fs.exists -= before.exists;
+}
+
+static void report(const char * what, std::vector<uint64_t> & latency, Load & l)
+{
+  printf("fileindex %-11s %u opens, %u reads (%llu kB), %u exists, %llu kB on wire, "
+         "file p50 %.1f ms p99 %.1f ms, %.0f us host CPU\n",
+         what, l.fs.opens, l.fs.reads, (unsigned long long) (l.fs.read_bytes / 1000), l.fs.exists,
+         (unsigned long long) (l.bytes / 1000), testPercentile(latency, 50) / 1000.0,
+         testPercentile(latency, 99) / 1000.0, l.cpu * 1e6);
+}
+
+int main(void)
+{
+  TestBrowser browser;
+  TestResponse resp;
+  std::string etags[FILES];
+  std::vector<uint64_t> latency;
+  Load l;
+  Load sum = {};
+  HostFsStats before;
+
+  // Serial is closed during the loads, which last longer than the
+  // mode detection timeout in virtual time: no detection, labels stay
+  testBoot([]() { config.tic_mode = TINFO_MODE_HISTORIQUE; });
+  testFeed(TEST_HISTORIC);
+  CHECK(testFrames(2));
+  hostSerialClose();
+  hostLoop(100);
+  printf("fileindex %u files indexed\n", fileindexstat.files);
+  CHECK(!fileindexstat.full);
+
+  // What is sent is what is on flash, .gz wins
+  resp = browser.get("/");
+  CHECK(resp.body == fileText("/index.htm.gz"));
+  CHECK_EQ(resp.headers["content-encoding"], "gzip");
+  CHECK_EQ(resp.headers["cache-control"], "no-cache");
+  resp = browser.get("/js/wifinfo.js");
+  CHECK(resp.body == fileText("/js/wifinfo.js.gz"));
+  CHECK_EQ(resp.headers["content-type"], "application/javascript");
+  CHECK_EQ(resp.headers["cache-control"], "max-age=86400");
+
+  hostCpuScale(CPU_SCALE);
+  for (int i = 0; i < LOADS; i++) {
+    load(browser, etags, false, latency, l);
+    sum.fs.opens += l.fs.opens;
+    sum.fs.reads += l.fs.reads;
+    sum.fs.read_bytes += l.fs.read_bytes;
+    sum.fs.exists += l.fs.exists;
+    sum.bytes += l.bytes;
+    sum.cpu += l.cpu;
+    CHECK_EQ(l.fs.opens, (uint32_t) FILES);
+    CHECK_EQ(l.fs.exists, 0u);
+  }
+  sum.fs.opens /= LOADS;
+  sum.fs.reads /= LOADS;
+  sum.fs.read_bytes /= LOADS;
+  sum.fs.exists /= LOADS;
+  sum.bytes /= LOADS;
+  sum.cpu /= LOADS;
+  report("page load", latency, sum);
+
+  latency.clear();
+  sum = Load();
+  for (int i = 0; i < LOADS; i++) {
+    load(browser, etags, true, latency, l);
+    sum.bytes += l.bytes;
+    sum.cpu += l.cpu;
+    CHECK_EQ(l.fs.opens, 0u);
+    CHECK_EQ(l.fs.reads, 0u);
+    CHECK_EQ(l.fs.exists, 0u);
+  }
+  sum.bytes /= LOADS;
+  sum.cpu /= LOADS;
+  report("revalidated", latency, sum);
+  hostCpuScale(0);
+
+  // A web file that is not there, index knows without flash
+  before = hostFsStats();
+  resp = browser.get("/css/nothere.css");
+  CHECK_EQ(resp.status, 404);
+  CHECK_EQ(hostFsStats().opens, before.opens);
+  CHECK_EQ(hostFsStats().exists, before.exists);
+  return 0;
+}
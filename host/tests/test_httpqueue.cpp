@@ -0,0 +1,66 @@
+// **********************************************************************************
+// WifInfo host build, sink request queue
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// A sink whose failed requests could not be spooled (SPIFFS full) has
+// backoff set and nothing to replay, it must still retry from RAM once
+// the backoff delay is over.
+//
+// Failed connects keep the resolved address, name is looked up again
+// only after SINK_DNS_FAILS of them, so a server that moved is found.
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#include "hosttest.h"
+
+int main(void)
+{
+  TestHttpServer * domoticz;
+  _httpspool * sp = &httpspool[SINK_DOMOTICZ];
+  FSInfo info;
+  uint32_t lookups;
+
+  testBoot([]() {
+    strcpy(config.domoticz.host, "domoticz.local");
+    config.domoticz.freq = 10;
+    config.domoticz.idx_p1sm = 1;
+  });
+
+  // Name resolves, nobody listens
+  delete new TestHttpServer("domoticz.local", IPAddress(192, 168, 1, 20));
+
+  // No room left to spool
+  SPIFFS.info(info);
+  hostFsSize(info.usedBytes);
+
+  lookups = hostDnsLookups();
+  testFeed(TEST_HISTORIC);
+  hostLoop(60000);
+  lookups = hostDnsLookups() - lookups;
+  printf("httpqueue: server down, backoff %us, spooled %u, dropped %u, "
+         "%u connects, %u lookups\n",
+         sp->backoff, sp->count, httpsinkstat[SINK_DOMOTICZ].dropped,
+         httpsinkstat[SINK_DOMOTICZ].connects, lookups);
+  CHECK(sp->backoff > 0);
+  CHECK_EQ(sp->count, 0u);
+  CHECK(httpsinkstat[SINK_DOMOTICZ].dropped > 0);
+  CHECK(lookups <= 1 + httpsinkstat[SINK_DOMOTICZ].connects / SINK_DNS_FAILS);
+
+
+  // Server back on another address, requests flow again after at most
+  // one backoff delay and a few failures to the old one
+  domoticz = new TestHttpServer("domoticz.local", IPAddress(192, 168, 1, 21));
+  hostLoop(SINK_DNS_FAILS * HTTP_BACKOFF_MAX * 1000UL + 30000);
+  printf("httpqueue: server back, %u requests, backoff %us\n",
+         (unsigned) domoticz->requests.size(), sp->backoff);
+  CHECK(domoticz->requests.size() > 0);
+  CHECK_EQ(sp->backoff, 0u);
+
+  delete domoticz;
+  return 0;
+}
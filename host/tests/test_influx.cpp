@@ -0,0 +1,208 @@
+// **********************************************************************************
+// WifInfo host build, InfluxDB sink
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// InfluxDB stand-in answers 204 with a Date header, checks syntax of each
+// line of each /write, nanosecond timestamps going forward, and counts
+// requests and bytes for several batch sizes, with and without gzip.
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#include "hosttest.h"
+
+#define FRAMES 60
+
+static uint32_t writes;
+static uint32_t lines;
+static uint64_t body_bytes;
+static uint64_t plain_bytes;
+static std::string last_stamp;
+
+// Name, tag key or tag value up to an unescaped stop char
+static bool lpToken(const char *& p, const char * stops)
+{
+  const char * start = p;
+
+  while (*p && !strchr(stops, *p)) {
+    if (*p == '\\' && p[1])
+      p++;
+    p++;
+  }
+  return p > start;
+}
+
+static bool lpField(const char *& p)
+{
+  char * end;
+
+  if (!lpToken(p, "=, \n") || *p++ != '=')
+    return false;
+
+  // String
+  if (*p == '"') {
+    for (p++; *p != '"'; p++) {
+      if (!*p || *p == '\n')
+        return false;
+      if (*p == '\\' && p[1])
+        p++;
+    }
+    p++;
+    return true;
+  }
+  if (!strncmp(p, "true", 4) || !strncmp(p, "false", 5)) {
+    p += *p == 't' ? 4 : 5;
+    return true;
+  }
+
+  // Integer or float
+  strtod(p, &end);
+  if (end == p)
+    return false;
+  p = end;
+  if (*p == 'i')
+    p++;
+  return true;
+}
+
+// One line: measurement[,tag=value...] field=value[,...] timestamp
+static bool lpLine(const std::string & line, std::string & stamp)
+{
+  const char * p = line.c_str();
+  const char * t;
+
+  if (!lpToken(p, ", "))
+    return false;
+  while (*p == ',') {
+    p++;
+    if (!lpToken(p, "=, ") || *p++ != '=' || !lpToken(p, ", "))
+      return false;
+  }
+  if (*p++ != ' ')
+    return false;
+  do {
+    if (!lpField(p))
+      return false;
+  } while (*p == ',' && p++);
+  if (*p++ != ' ')
+    return false;
+
+  // Nanoseconds, from 2001 on they have 19 digits
+  for (t = p; isdigit((unsigned char) *p); p++)
+    ;
+  stamp.assign(t, p - t);
+  return !*p && stamp.size() == 19;
+}
+
+static int influxServer(const TestRequest & req, std::string & body)
+{
+  std::string text = req.body;
+  size_t pos = 0;
+
+  body.clear();
+  if (req.path == "/ping")
+    return 204;
+
+  CHECK(req.method == "POST");
+  CHECK(req.path.compare(0, strlen(INFLUX_WRITE_URL), INFLUX_WRITE_URL) == 0);
+  CHECK_EQ(strtoul(req.headers.at("content-length").c_str(), NULL, 10), req.body.size());
+  body_bytes += req.body.size();
+  if (req.headers.count("content-encoding")) {
+    CHECK_EQ(req.headers.at("content-encoding"), "gzip");
+#ifdef HOST_ZLIB
+    CHECK(testGunzip(req.body, text));
+#else
+    return 204;
+#endif
+  }
+  plain_bytes += text.size();
+
+  while (pos < text.size()) {
+    size_t end = text.find('\n', pos);
+    std::string line = text.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+    std::string stamp;
+
+    if (!lpLine(line, stamp)) {
+      fprintf(stderr, "bad line: %s\n", line.c_str());
+      CHECK(false);
+    }
+    CHECK(last_stamp.empty() || stamp > last_stamp);
+    last_stamp = stamp;
+    lines++;
+    pos = end == std::string::npos ? text.size() : end + 1;
+  }
+  writes++;
+  return 204;
+}
+
+static void run(uint8_t batch, uint8_t gzip, TestHttpServer * influx)
+{
+  uint64_t bytes;
+  uint32_t early;
+
+  config.influx.batch = batch;
+  config.influx.gzip = gzip;
+  influxSetup();
+  hostLoop(1000);
+
+  writes = 0;
+  lines = 0;
+  body_bytes = 0;
+  plain_bytes = 0;
+  bytes = influx->bytes_in;
+  early = influxstat.early;
+  CHECK(testFrames(FRAMES, FRAMES * 3000UL));
+  influxSetup();
+  hostLoop(1000);
+
+  early = influxstat.early - early;
+  printf("influx batch %2u%s: %u lines, %2u writes (%2u early), %5.1f kB on wire, "
+         "body %5.1f kB (%5.1f kB plain)\n",
+         batch, gzip ? " gzip" : "     ", lines, writes, early, (influx->bytes_in - bytes) / 1000.0,
+         body_bytes / 1000.0, plain_bytes / 1000.0);
+  CHECK(lines >= FRAMES - 1);
+  CHECK(writes >= lines / batch);
+  // Batch is full, request is full, or flush on config change
+  CHECK(writes <= lines / batch + early + 2);
+}
+
+int main(void)
+{
+  TestHttpServer * influx;
+
+  testBoot([]() {
+    strcpy(config.influx.host, "influx.local");
+    config.influx.freq = 60;
+  });
+  influx = new TestHttpServer("influx.local", IPAddress(192, 168, 1, 23), CFG_INFX_DEFAULT_PORT);
+  influx->handler = influxServer;
+  influx->date = 1686823200;   // Thu, 15 Jun 2023 10:00:00 GMT
+
+  testFeed(TEST_HISTORIC);
+
+  // Clock comes from first answer, a /ping while it's unknown
+  CHECK(testFrames(3));
+  hostLoop(2000);
+  CHECK(influxstat.pings > 0);
+
+  printf("influx %s\n", TEST_HISTORIC);
+  run(1, 0, influx);
+  run(10, 0, influx);
+#ifdef HOST_ZLIB
+  run(10, 1, influx);
+#endif
+
+  printf("influx %s\n", TEST_STANDARD);
+  testFeed(TEST_STANDARD);
+  CHECK(testFrames(2));
+  run(10, 0, influx);
+
+  printf("influx: %u connections for %u requests\n", influx->connections,
+         (unsigned) influx->requests.size());
+  CHECK(influx->connections <= 2);
+  return 0;
+}
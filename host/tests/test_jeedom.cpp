@@ -0,0 +1,137 @@
+// **********************************************************************************
+// WifInfo host build, jeedom request size
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// Bytes on the wire per tick (one tick per frame) for each format, push
+// mode and label filter, in both teleinfo modes. Then checks that a label
+// out of TeleinfoFrame (no dirty bit) is sent each time it changes, and
+// that label names are encoded like values (NJOURF+1).
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#include "hosttest.h"
+
+#define TICKS 100
+
+static TestHttpServer * jeedom;
+
+static void jeedomConfig(uint8_t format, uint8_t mode, uint8_t filter, const char * labels)
+{
+  config.jeedom.format = format;
+  config.jeedom.push.mode = mode;
+  config.jeedom.filter = filter;
+  strcpy(config.jeedom.labels, labels);
+  jeedomSetup();
+}
+
+// Average request bytes per tick
+static double ticks(const char * what)
+{
+  uint64_t bytes = jeedom->bytes_in;
+  size_t requests = jeedom->requests.size();
+
+  for (int i = 0; i < TICKS; i++) {
+    CHECK(testFrames(1));
+    CHECK(jeedomPost());
+    hostLoop(100);
+  }
+  bytes = jeedom->bytes_in - bytes;
+  requests = jeedom->requests.size() - requests;
+  printf("jeedom %-28s %3u requests, %4.0f B/tick\n", what, (unsigned) requests,
+         (double) bytes / TICKS);
+  return (double) bytes / TICKS;
+}
+
+// Each format carries NJOURF+1 so that server decodes it back
+static void namesEncoded(void)
+{
+  static const uint8_t formats[] = { CFG_JDOM_GET, CFG_JDOM_FORM, CFG_JDOM_JSON };
+  static const char * const expected[] = { "&NJOURF%2B1=", "&NJOURF%2B1=", ",\"NJOURF+1\":\"" };
+
+  for (uint8_t i = 0; i < sizeof(formats); i++) {
+    const TestRequest * req;
+
+    jeedomConfig(formats[i], CFG_PUSH_ALWAYS, CFG_JDOM_ALL, "");
+    CHECK(testFrames(1));
+    CHECK(jeedomPost());
+    hostLoop(100);
+    req = &jeedom->requests.back();
+    CHECK((formats[i] == CFG_JDOM_GET ? req->path : req->body).find(expected[i]) != std::string::npos);
+  }
+  printf("jeedom NJOURF+1 name encoded in GET, FORM and JSON\n");
+}
+
+static void wire(const char * name)
+{
+  double get, form, json, change, filtered;
+
+  printf("jeedom %s\n", name);
+  testFeed(name);
+  CHECK(testFrames(2));
+
+  jeedomConfig(CFG_JDOM_GET, CFG_PUSH_ALWAYS, CFG_JDOM_ALL, "");
+  get = ticks("GET, every tick (baseline)");
+  jeedomConfig(CFG_JDOM_FORM, CFG_PUSH_ALWAYS, CFG_JDOM_ALL, "");
+  form = ticks("FORM, every tick");
+  jeedomConfig(CFG_JDOM_JSON, CFG_PUSH_ALWAYS, CFG_JDOM_ALL, "");
+  json = ticks("JSON, every tick");
+  jeedomConfig(CFG_JDOM_FORM, CFG_PUSH_CHANGE, CFG_JDOM_ALL, "");
+  change = ticks("FORM, on change");
+  jeedomConfig(CFG_JDOM_FORM, CFG_PUSH_CHANGE, CFG_JDOM_INCLUDE, "PAPP,HCHC,HCHP");
+  filtered = ticks("FORM, on change, 3 labels");
+
+  CHECK(get > 0 && form > 0 && json > 0);
+  if (!strcmp(name, TEST_STANDARD))
+    namesEncoded();
+  CHECK(change < form);
+  CHECK(filtered < change);
+}
+
+int main(void)
+{
+  size_t requests;
+  std::string last;
+  uint32_t changes = 0;
+
+  testBoot([]() {
+    strcpy(config.jeedom.host, "jeedom.local");
+    strcpy(config.jeedom.apikey, "0123456789abcdef0123456789abcdef");
+    config.jeedom.push.heartbeat = 0;
+    config.jeedom.push.db_power = 100;
+    config.jeedom.push.db_current = 1;
+    config.jeedom.push.db_index = 100;
+  });
+  jeedom = new TestHttpServer("jeedom.local", IPAddress(192, 168, 1, 22));
+
+  wire(TEST_HISTORIC);
+  wire(TEST_STANDARD);
+
+  // URMS1 is not a frame field, frame fields do not move past deadbands
+  config.jeedom.push.db_power = 60000;
+  config.jeedom.push.db_current = 255;
+  config.jeedom.push.db_index = 60000;
+  jeedomConfig(CFG_JDOM_FORM, CFG_PUSH_CHANGE, CFG_JDOM_INCLUDE, "URMS1");
+  CHECK(testFrames(1));
+  CHECK(jeedomPost());
+  hostLoop(100);
+  last = tinfolabels.get(LABEL_URMS1);
+  requests = jeedom->requests.size();
+  for (int i = 0; i < TICKS; i++) {
+    CHECK(testFrames(1));
+    if (last != tinfolabels.get(LABEL_URMS1))
+      changes++;
+    last = tinfolabels.get(LABEL_URMS1);
+    CHECK(jeedomPost());
+    hostLoop(100);
+  }
+  requests = jeedom->requests.size() - requests;
+  printf("jeedom URMS1 only, %u changes, %u requests\n", changes, (unsigned) requests);
+  CHECK(changes > 0);
+  CHECK_EQ(requests, (size_t) changes);
+  return 0;
+}
@@ -0,0 +1,119 @@
+// **********************************************************************************
+// WifInfo host build, frame JSON cache size and free heap
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// All sinks on, four browsers polling /json and /tinfo.json, in both
+// teleinfo modes. Reports size of frame bodies against JSONCACHE_SIZE,
+// cache hits and the lowest ESP.getFreeHeap() seen. Bodies of the
+// recordings must all fit, with a few more labels.
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#include "hosttest.h"
+
+#define BROWSERS 4
+#define FRAMES   10
+
+static uint32_t heap_min;
+
+// Run loop() for ms while browsers poll, lowest free heap seen
+static void browse(unsigned long ms)
+{
+  TestBrowser browsers[BROWSERS];
+  bool busy[BROWSERS] = { false };
+  unsigned long end = millis() + ms;
+  uint32_t n = 0;
+
+  while ((long) (millis() - end) < 0) {
+    for (int i = 0; i < BROWSERS; i++) {
+      TestResponse resp;
+
+      if (!busy[i]) {
+        browsers[i].send("GET", n++ & 1 ? "/tinfo.json" : "/json");
+        busy[i] = true;
+      } else if (browsers[i].poll(resp)) {
+        CHECK_EQ(resp.status, 200);
+        busy[i] = false;
+      }
+    }
+    hostLoopOnce();
+    if (ESP.getFreeHeap() < heap_min)
+      heap_min = ESP.getFreeHeap();
+  }
+}
+
+static void mode(const char * name)
+{
+  uint32_t overflows;
+  uint32_t hits = jsoncachestat.hits;
+  uint32_t misses = jsoncachestat.misses;
+  uint16_t len[JSONCACHE_BODIES];
+
+  testFeed(name);
+  CHECK(testFrames(2));
+  jsoncachestat.max_size = 0;
+  overflows = jsoncachestat.overflows;
+  heap_min = ESP.getFreeHeap();
+
+  browse(FRAMES * 2000UL);
+  for (uint8_t b = 0; b < JSONCACHE_BODIES; b++)
+    CHECK(jsonCacheBody(b, &len[b]));
+  printf("jsoncache %-14s /json %u + /tinfo.json %u bytes, max %u of %u, "
+         "%u hits, %u misses, %u overflows, free heap min %u\n",
+         name, len[JSONCACHE_JSON], len[JSONCACHE_TINFO], jsoncachestat.max_size,
+         JSONCACHE_SIZE, jsoncachestat.hits - hits, jsoncachestat.misses - misses,
+         jsoncachestat.overflows - overflows, heap_min);
+  CHECK_EQ(jsoncachestat.overflows, overflows);
+  CHECK(jsoncachestat.max_size <= JSONCACHE_SIZE);
+}
+
+int main(void)
+{
+  char name[16];
+
+  testBoot([]() {
+    strcpy(config.emoncms.host, "emoncms.local");
+    strcpy(config.emoncms.apikey, "0123456789abcdef0123456789abcdef");
+    config.emoncms.node = 1;
+    config.emoncms.freq = 10;
+    strcpy(config.jeedom.host, "jeedom.local");
+    strcpy(config.jeedom.apikey, "0123456789abcdef0123456789abcdef");
+    config.jeedom.freq = 10;
+    strcpy(config.domoticz.host, "domoticz.local");
+    config.domoticz.idx_txt = 1;
+    config.domoticz.idx_p1sm = 2;
+    config.domoticz.freq = 10;
+    strcpy(config.mqtt.host, "broker.local");
+    config.mqtt.mode = CFG_MQTT_FRAME;
+    config.mqtt.freq = 10;
+    strcpy(config.influx.host, "influx.local");
+    config.influx.freq = 10;
+  });
+  TestHttpServer emoncms("emoncms.local", IPAddress(192, 168, 1, 21));
+  TestHttpServer jeedom("jeedom.local", IPAddress(192, 168, 1, 22));
+  TestHttpServer domoticz("domoticz.local", IPAddress(192, 168, 1, 20));
+  TestHttpServer influx("influx.local", IPAddress(192, 168, 1, 23), CFG_INFX_DEFAULT_PORT);
+  TestMqttBroker broker("broker.local", IPAddress(192, 168, 1, 30));
+  influx.date = 1686823200;
+
+  printf("jsoncache boot, free heap %u\n", ESP.getFreeHeap());
+  mode(TEST_HISTORIC);
+  mode(TEST_STANDARD);
+
+  // Room left for labels the recording does not have
+  hostSerialClose();
+  hostLoop(100);
+  for (int i = 0; i < 4; i++) {
+    sprintf(name, "XTRA%d", i);
+    tinfolabels.set(name, "0123456789");
+  }
+  jsonCacheFrame();
+  printf("jsoncache 4 more labels, %u of %u bytes\n", jsoncachestat.size, JSONCACHE_SIZE);
+  CHECK(jsoncachestat.size <= JSONCACHE_SIZE);
+  return 0;
+}
@@ -0,0 +1,104 @@
+// **********************************************************************************
+// WifInfo host build, JSON answers heap use
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// JSON answers are streamed by chunks, heap their handler holds at once
+// (web server and socket excluded) must not depend on labels or files
+// count. Reports size, allocations and peak of each answer.
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#include "hosttest.h"
+
+static const char * routes[] = {
+  "/json", "/tinfo.json", "/system.json", "/config.json", "/spiffs.json"
+};
+#define ROUTES (sizeof(routes) / sizeof(*routes))
+
+struct Usage
+{
+  uint64_t mallocs;
+  uint64_t bytes;
+  size_t   peak;
+  size_t   size;
+};
+
+static void measure(const char * what, Usage * usage)
+{
+  TestBrowser browser;
+
+  printf("jsonheap %s\n", what);
+  for (size_t i = 0; i < ROUTES; i++) {
+    HostHeapStats before;
+    TestResponse resp;
+    uint32_t chunks;
+
+    // First one fills caches
+    browser.get(routes[i]);
+    before = hostHeapStats();
+    chunks = jsonwriterstat.chunks;
+    resp = browser.get(routes[i]);
+    CHECK_EQ(resp.status, 200);
+    CHECK(testJsonValid(resp.body));
+    usage[i].mallocs = hostHeapStats().handler_mallocs - before.handler_mallocs;
+    usage[i].bytes = hostHeapStats().handler_bytes - before.handler_bytes;
+    usage[i].peak = hostHeapStats().handler_peak;
+    usage[i].size = resp.body.size();
+    chunks = jsonwriterstat.chunks - chunks;
+    printf("  %-12s %4u bytes in %2u chunks, %2llu mallocs (%llu bytes), peak %u bytes\n", routes[i],
+           (unsigned) usage[i].size, chunks, (unsigned long long) usage[i].mallocs,
+           (unsigned long long) usage[i].bytes, (unsigned) usage[i].peak);
+  }
+}
+
+int main(void)
+{
+  Usage hist[ROUTES];
+  Usage std[ROUTES];
+  Usage more[ROUTES];
+  char name[16];
+
+  testBoot();
+
+  testFeed(TEST_HISTORIC);
+  CHECK(testFrames(2));
+  hostSerialClose();
+  hostLoop(100);
+  measure("historique", hist);
+
+  testFeed(TEST_STANDARD);
+  CHECK(testFrames(2));
+  hostSerialClose();
+  hostLoop(100);
+  measure("standard", std);
+
+  // More unknown labels and more files
+  for (int i = 0; i < 8; i++) {
+    File f;
+
+    sprintf(name, "XTRA%d", i);
+    tinfolabels.set(name, "0123456789");
+    sprintf(name, "/file%02d.txt", i);
+    f = SPIFFS.open(name, "w");
+    f.print("some data");
+    f.close();
+  }
+  jsonCacheFrame();
+  measure("standard, 8 more labels, 8 more files", more);
+
+  // Served from frame cache or streamed (too big for it), never more
+  // than a few Strings
+  for (size_t i = 0; i < ROUTES; i++)
+    CHECK(hist[i].peak <= 72 && std[i].peak <= 72 && more[i].peak <= 72);
+  CHECK_EQ(std[4].peak, more[4].peak);
+  // Labels, then files, make answers bigger
+  CHECK(std[0].size > hist[0].size && more[0].size > std[0].size);
+  CHECK(std[1].size > hist[1].size && more[1].size > std[1].size);
+  CHECK(more[4].size > std[4].size);
+  return 0;
+}
@@ -0,0 +1,101 @@
+// **********************************************************************************
+// WifInfo host build, teleinfo labels lookup
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// TInfoLabels::labelId() against a strcmp walk of the names, as the
+// TInfo list was searched before. Both must agree on every known label
+// and on unknown ones, then labels of a frame of each recording are
+// looked up many times and real CPU time of this machine is reported.
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#include "hosttest.h"
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+#define ROUNDS 20000
+
+// Labels of first complete frame of a recording
+static std::vector<std::string> frameLabels(const char * name)
+{
+  std::ifstream file(testData(name).c_str(), std::ios::binary);
+  std::stringstream data;
+  std::string raw;
+  std::vector<std::string> labels;
+  size_t stx, etx, i;
+
+  data << file.rdbuf();
+  raw = data.str();
+  stx = raw.find('\x02');
+  etx = raw.find('\x03', stx);
+  i = stx;
+
+  while ((i = raw.find('\n', i)) != std::string::npos && i < etx) {
+    size_t end = raw.find_first_of(" \t", ++i);
+
+    labels.push_back(raw.substr(i, end - i));
+  }
+  return labels;
+}
+
+static uint8_t linearId(const char * name)
+{
+  for (uint8_t id = 0; id < LABEL_COUNT; id++) {
+    if (!strcmp_P(name, (PGM_P) TInfoLabels::labelName(id)))
+      return id;
+  }
+  return LABEL_UNKNOWN;
+}
+
+// Lookups time of labels (ns per lookup)
+static double bench(const std::vector<std::string> & labels, uint8_t (*lookup)(const char *))
+{
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  volatile uint32_t sum = 0;
+
+  for (int r = 0; r < ROUNDS; r++) {
+    for (size_t i = 0; i < labels.size(); i++)
+      sum = sum + lookup(labels[i].c_str());
+  }
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count() *
+         1e9 / ((double) ROUNDS * labels.size());
+}
+
+int main(void)
+{
+  static const char * const unknown[] = { "MSG1", "MSG2", "ADC0", "PAP", "EASF11", "", "NJOURF+2" };
+  const char * modes[] = { TEST_HISTORIC, TEST_STANDARD };
+  char name[TINFO_LABEL_SIZE];
+
+  for (uint8_t id = 0; id < LABEL_COUNT; id++) {
+    strcpy_P(name, (PGM_P) TInfoLabels::labelName(id));
+    CHECK_EQ(TInfoLabels::labelId(name), id);
+    CHECK_EQ(linearId(name), id);
+  }
+  for (size_t i = 0; i < sizeof(unknown) / sizeof(unknown[0]); i++) {
+    CHECK_EQ(TInfoLabels::labelId(unknown[i]), LABEL_UNKNOWN);
+    CHECK_EQ(linearId(unknown[i]), LABEL_UNKNOWN);
+  }
+
+  for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+    std::vector<std::string> labels = frameLabels(modes[m]);
+    double hash, linear;
+
+    CHECK(labels.size() > 10);
+    for (size_t i = 0; i < labels.size(); i++)
+      CHECK_EQ(TInfoLabels::labelId(labels[i].c_str()), linearId(labels[i].c_str()));
+
+    hash = bench(labels, TInfoLabels::labelId);
+    linear = bench(labels, linearId);
+    printf("labels %-14s %2u per frame: labelId %.1f ns, strcmp walk %.1f ns (x%.1f, host CPU)\n",
+           modes[m], (unsigned) labels.size(), hash, linear, linear / hash);
+    CHECK(hash < linear);
+  }
+  return 0;
+}
@@ -0,0 +1,191 @@
+// **********************************************************************************
+// WifInfo host build, /log.json reader
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// Logs both files through Info(), then checks /log.json against a naive
+// reader (whole files, reversed) for a full read, pages, ?since= polls
+// and a poll across a rotation. Reports heap and real CPU time of this
+// machine for a full read and for a poll with nothing new.
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#include "hosttest.h"
+#include <chrono>
+
+#define READS 200
+
+static std::string fileText(const char * path)
+{
+  File f = SPIFFS.open(path, "r");
+  std::string text;
+  char buf[256];
+  size_t n;
+
+  if (!f)
+    return text;
+  while ((n = f.read((uint8_t *) buf, sizeof(buf))) > 0)
+    text.append(buf, n);
+  f.close();
+  return text;
+}
+
+// Complete lines of both files, newest first, as logReadText() sends them
+static std::vector<std::string> events(void)
+{
+  std::string text = fileText(LOG_FILE_OLD) + fileText(LOG_FILE);
+  std::vector<std::string> lines;
+  std::string line;
+  size_t start = 0;
+
+  // A "\r\n" line is an empty event, "\n\n" has none
+  for (size_t i = 0; i < text.size(); i++) {
+    char c = text[i];
+
+    if (c == '\n') {
+      if (i > start)
+        lines.insert(lines.begin(), line);
+      line.clear();
+      start = i + 1;
+      continue;
+    }
+    if (c == '"' || c == '\\')
+      line += '\\';
+    if ((uint8_t) c >= ' ')
+      line += c;
+  }
+  return lines;
+}
+
+static std::string table(const std::vector<std::string> & lines, size_t offset, size_t limit)
+{
+  std::string json = "[\r\n";
+
+  for (size_t i = offset; i < lines.size() && i < offset + limit; i++) {
+    if (i > offset)
+      json += ",\r\n";
+    json += "{\"ev\":\"" + lines[i] + "\"}";
+  }
+  return json + "\r\n]";
+}
+
+static void logEvents(int from, int count)
+{
+  for (int i = from; i < from + count; i++) {
+    Infof("event %04d \"quoted\" C:\\path\r\n", i);
+  }
+}
+
+int main(void)
+{
+  static char buf[32 * 1024];
+  TestBrowser browser;
+  TestResponse resp;
+  std::vector<std::string> all;
+  std::string cursor;
+  std::string old;
+  size_t size;
+  int n = 0;
+  int mark;
+
+  testBoot([]() {
+    config.config |= CFG_INFO;
+  });
+
+  // Fill both files, about 19 KB
+  while (fileText(LOG_FILE_OLD).empty() || fileText(LOG_FILE).size() < 9000) {
+    logEvents(n, 10);
+    n += 10;
+  }
+  size = fileText(LOG_FILE_OLD).size() + fileText(LOG_FILE).size();
+
+  // Full read
+  all = events();
+  resp = browser.get("/log.json");
+  CHECK_EQ(resp.status, 200);
+  CHECK(resp.body == table(all, 0, all.size()));
+  CHECK(testJsonValid(resp.body));
+  CHECK(resp.headers.count("x-log-cursor"));
+  printf("logread %u bytes of logs, %u events, answer %u bytes, handler peak %u bytes\n",
+         (unsigned) size, (unsigned) all.size(), (unsigned) resp.body.size(),
+         (unsigned) hostHeapStats().handler_peak);
+
+  // Pages
+  for (size_t offset = 0; offset < all.size() + 50; offset += 50) {
+    resp = browser.get("/log.json?offset=" + std::to_string(offset) + "&limit=50");
+    CHECK(resp.body == table(all, offset, 50));
+  }
+
+  // New events only, then nothing new
+  cursor = resp.headers["x-log-cursor"];
+  logEvents(n, 5);
+  n += 5;
+  resp = browser.get("/log.json?since=" + cursor);
+  CHECK(resp.body == table(events(), 0, 5));
+  CHECK(!resp.headers.count("x-log-reset"));
+  cursor = resp.headers["x-log-cursor"];
+  resp = browser.get("/log.json?since=" + cursor);
+  CHECK(resp.body == "[\r\n\r\n]");
+  CHECK_EQ(resp.headers["x-log-cursor"], cursor);
+
+  // Across a rotation, cursor stays valid
+  mark = n;
+  old = fileText(LOG_FILE_OLD);
+  size = fileText(LOG_FILE).size();
+  logEvents(n, 40);
+  n += 40;
+  while (fileText(LOG_FILE).size() >= size) {
+    logEvents(n, 1);
+    n++;
+  }
+  CHECK(fileText(LOG_FILE_OLD) != old);
+  all = events();
+  resp = browser.get("/log.json?since=" + cursor);
+  CHECK(!resp.headers.count("x-log-reset"));
+  CHECK(resp.body == table(all, 0, n - mark));
+  printf("logread since %s across rotation: %d events\n", cursor.c_str(), n - mark);
+
+  // Rotated out, everything again
+  resp = browser.get("/log.json?since=1");
+  CHECK_EQ(resp.headers["x-log-reset"], "1");
+  CHECK(resp.body == table(all, 0, all.size()));
+
+  // Reader alone, rendered in RAM
+  {
+    uint32_t end = logReadEnd();
+    uint64_t mallocs;
+    double full, poll;
+
+    hostHeapResetPeak();
+    size = hostHeapStats().live;
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    mallocs = testMallocs([&]() {
+      for (int i = 0; i < READS; i++) {
+        JSONWriter out(buf, sizeof(buf));
+        logReadJSON(out, 0, end, 0, 0);
+        CHECK(!out.overflow());
+      }
+    });
+    full = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    size = hostHeapStats().peak - size;
+
+    t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < READS; i++) {
+      JSONWriter out(buf, sizeof(buf));
+      end = logReadEnd();
+      if (logReadValid(end))
+        logReadJSON(out, end, end, 0, 0);
+    }
+    poll = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    printf("logread full read %.1f us, %llu mallocs per read, peak %u bytes; "
+           "poll with nothing new %.2f us (host CPU)\n",
+           full * 1e6 / READS, (unsigned long long) (mallocs / READS), (unsigned) size,
+           poll * 1e6 / READS);
+  }
+  return 0;
+}
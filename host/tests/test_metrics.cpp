@@ -0,0 +1,78 @@
+// **********************************************************************************
+// WifInfo host build, /metrics scrape cost
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// Scrapes /metrics in both teleinfo modes, reports size, chunks, heap
+// allocations of the handler (web server and socket excluded) and real
+// CPU time of this machine per scrape, for the whole request and for
+// rendering alone.
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#include "hosttest.h"
+#include <chrono>
+
+#define SCRAPES 200
+
+static void scrape(const char * name)
+{
+  TestBrowser browser;
+  TestResponse resp;
+  uint64_t mallocs;
+  uint64_t bytes;
+  uint32_t chunks;
+  double secs;
+  double render;
+
+  testFeed(name);
+  CHECK(testFrames(2));
+  hostSerialClose();
+
+  // Warm up, first answer may differ (new labels, connection)
+  resp = browser.get("/metrics");
+  CHECK_EQ(resp.status, 200);
+
+  // Rendering alone, once server dropped our idle connection answer
+  // goes nowhere
+  hostLoop(HTTP_MAX_CLOSE_WAIT + 100);
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < SCRAPES; i++)
+    metricsRender();
+  render = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+  mallocs = hostHeapStats().handler_mallocs;
+  bytes = hostHeapStats().handler_bytes;
+  chunks = metricsstat.chunks;
+  t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < SCRAPES; i++) {
+    resp = browser.get("/metrics");
+    CHECK_EQ(resp.status, 200);
+  }
+  secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  mallocs = hostHeapStats().handler_mallocs - mallocs;
+  bytes = hostHeapStats().handler_bytes - bytes;
+  chunks = metricsstat.chunks - chunks;
+
+  printf("metrics %-14s %u bytes in %u chunks, %llu mallocs (%llu bytes) per scrape, "
+         "%.1f us per request, %.1f us to render (host CPU)\n",
+         name, (unsigned) resp.body.size(), chunks / SCRAPES,
+         (unsigned long long) (mallocs / SCRAPES), (unsigned long long) (bytes / SCRAPES),
+         secs * 1e6 / SCRAPES, render * 1e6 / SCRAPES);
+  CHECK(resp.body.find("# TYPE teleinfo_") != std::string::npos);
+  CHECK(resp.body.find("# EOF") != std::string::npos);
+  CHECK_EQ(mallocs, 0u);
+}
+
+int main(void)
+{
+  testBoot();
+
+  scrape(TEST_HISTORIC);
+  scrape(TEST_STANDARD);
+  return 0;
+}
@@ -0,0 +1,77 @@
+// **********************************************************************************
+// WifInfo host build, MQTT frame message
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// Session with a broker stand-in, frame message must be valid JSON in
+// both teleinfo modes, even with quotes and backslashes in text values.
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#include "hosttest.h"
+
+static TestMqttBroker * broker;
+
+// Last frame message published
+static std::string frame(void)
+{
+  for (size_t i = broker->messages.size(); i > 0; i--)
+    if (broker->messages[i - 1].topic == CFG_MQTT_DEFAULT_TOPIC)
+      return broker->messages[i - 1].payload;
+  return "";
+}
+
+static void publish(const char * name)
+{
+  size_t count = broker->messages.size();
+  std::string msg;
+
+  testFeed(name);
+  CHECK(testFrames(3));
+
+  // Task has a phase, first run can be up to two periods away
+  hostLoop(config.mqtt.freq * 2000UL);
+  CHECK(broker->messages.size() > count);
+
+  msg = frame();
+  printf("mqtt %-14s %u bytes: %.60s...\n", name, (unsigned) msg.size(), msg.c_str());
+  CHECK(testJsonValid(msg));
+}
+
+int main(void)
+{
+  std::string msg;
+
+  testBoot([]() {
+    strcpy(config.mqtt.host, "broker.local");
+    config.mqtt.mode = CFG_MQTT_FRAME;
+    config.mqtt.qos = 1;
+    config.mqtt.freq = 10;
+  });
+  broker = new TestMqttBroker("broker.local", IPAddress(192, 168, 1, 30));
+
+  publish(TEST_HISTORIC);
+  CHECK(frame().find("\"PTEC\":\"HP..\"") != std::string::npos ||
+        frame().find("\"PTEC\":\"HC..\"") != std::string::npos);
+  publish(TEST_STANDARD);
+  CHECK(frame().find("\"NGTF\":\"H PLEINE/CREUSE \"") != std::string::npos);
+
+  // Text from meter is not trusted
+  hostSerialClose();
+  tinfolabels.set("QUOTE\"", "say \"hi\" \\o/");
+  CHECK(mqttPost());
+  hostLoop(1000);
+  msg = frame();
+  CHECK(testJsonValid(msg));
+  CHECK(msg.find("\"QUOTE\\\"\":\"say \\\"hi\\\" \\\\o/\"") != std::string::npos);
+
+  printf("mqtt: %u sessions, %u messages, %u acknowledged\n", broker->connects,
+         (unsigned) broker->messages.size(), mqttstat.acked);
+  CHECK_EQ(broker->connects, 1u);
+  CHECK_EQ(mqttstat.acked, mqttstat.published);
+  return 0;
+}
@@ -0,0 +1,134 @@
+// **********************************************************************************
+// WifInfo host build, teleinfo ingestion benchmark
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// Replays the recordings at line speed through UART0 and reports frames
+// decoded per second and worst bytes pending in RX ring per loop() pass,
+// while the sketch is idle, serves web pages, or waits on a slow or dead
+// sink server. Then feeds them as fast as possible to get decoder
+// throughput on this machine (real time, not virtual).
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#include "hosttest.h"
+#include <chrono>
+
+static size_t fileFrames(const char * name)
+{
+  FILE * f = fopen(testData(name).c_str(), "rb");
+  size_t n = 0;
+  int c;
+
+  CHECK(f);
+  while ((c = fgetc(f)) != EOF)
+    n += c == 0x02;
+  fclose(f);
+  return n;
+}
+
+// Whole recording at line speed, returns frames decoded
+static uint32_t replay(const char * name, const char * load)
+{
+  TestBrowser browser;
+  uint32_t frames = tinfo_frames;
+  uint64_t start;
+  uint64_t secs;
+
+  testFeed(name, false);
+  tinfo_rx_max_pending = 0;
+  tinfo_rx_overruns = 0;
+  start = hostMicros();
+  while (hostSerialRemaining()) {
+    // Browser reloading the UI, uncached
+    if (!strcmp(load, "web")) {
+      browser.get("/");
+      browser.get("/json");
+      browser.get("/system.json");
+    } else {
+      hostLoopOnce();
+    }
+  }
+  // Last frame
+  hostLoop(100);
+  frames = tinfo_frames - frames;
+  secs = (hostMicros() - start) / 1000000;
+
+  printf("replay %-14s %-9s %4u frames in %3llus (%.2f frames/s), "
+         "max pending %4u bytes, overruns %u, dropped %u\n",
+         name, load, frames, (unsigned long long) secs, secs ? (double) frames / secs : 0.0,
+         tinfo_rx_max_pending, tinfo_rx_overruns, hostSerialDropped());
+  CHECK_EQ(hostSerialDropped(), 0u);
+  CHECK_EQ(tinfo_rx_overruns, 0u);
+  CHECK(tinfo_rx_max_pending < TINFO_RX_BUFFER_SIZE);
+  return frames;
+}
+
+// Decoder alone, real CPU time of this machine
+static void throughput(const char * name)
+{
+  FILE * f = fopen(testData(name).c_str(), "rb");
+  std::string data;
+  char buf[4096];
+  size_t n;
+  uint32_t frames = tinfo_frames;
+  double secs;
+  int runs = 20;
+
+  CHECK(f);
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+    data.append(buf, n);
+  fclose(f);
+
+  tinfoSetMode(!strcmp(name, TEST_STANDARD) ? TINFO_MODE_STANDARD : TINFO_MODE_HISTORIQUE);
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < runs; i++)
+    for (size_t off = 0; off < data.size(); off += TINFO_FEED_CHUNK)
+      tinfoFeed(data.data() + off, std::min((size_t) TINFO_FEED_CHUNK, data.size() - off));
+  secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  frames = tinfo_frames - frames;
+
+  printf("decode %-14s %u frames, %.0f frames/s, %.1f MB/s (host CPU)\n",
+         name, frames, frames / secs, data.size() * runs / secs / 1e6);
+  CHECK_EQ(frames, fileFrames(name) * runs);
+}
+
+int main(void)
+{
+  TestHttpServer * domoticz;
+
+  testBoot([]() {
+    strcpy(config.domoticz.host, "domoticz.local");
+    config.domoticz.freq = 10;
+    config.domoticz.idx_p1sm = 1;
+  });
+  domoticz = new TestHttpServer("domoticz.local", IPAddress(192, 168, 1, 20));
+
+  // First frame of a file can't be complete, last one is always
+  CHECK(replay(TEST_HISTORIC, "idle") >= fileFrames(TEST_HISTORIC) - 1);
+  CHECK(replay(TEST_STANDARD, "idle") >= fileFrames(TEST_STANDARD) - 1);
+  CHECK(replay(TEST_STANDARD, "web") >= fileFrames(TEST_STANDARD) - 1);
+
+  CHECK(domoticz->requests.size() > 0);
+
+  // Domoticz takes 5 s to answer each request
+  domoticz->delay_ms = 5000;
+  domoticz->requests.clear();
+  CHECK(replay(TEST_STANDARD, "sink-slow") >= fileFrames(TEST_STANDARD) - 1);
+  printf("replay sink-slow: %u domoticz requests, %u timeouts, worst loop pass %llu us\n",
+         (unsigned) domoticz->requests.size(), httpstat.timeouts,
+         (unsigned long long) hostLoopWorst());
+  CHECK(domoticz->requests.size() > 0);
+
+  // Domoticz host down, name still resolves, connect() times out
+  delete domoticz;
+  CHECK(replay(TEST_STANDARD, "sink-down") >= fileFrames(TEST_STANDARD) - 1);
+
+  throughput(TEST_HISTORIC);
+  throughput(TEST_STANDARD);
+  return 0;
+}
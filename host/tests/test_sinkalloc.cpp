@@ -0,0 +1,107 @@
+// **********************************************************************************
+// WifInfo host build, sink requests without heap
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// emoncmsPost, jeedomPost and domoticzPost render into http_buffer and
+// queue in the arena, counts heap allocations of each call in every
+// jeedom format and both teleinfo modes. Ring arena shared by request
+// queue and MQTT outbox is checked on its own first.
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#include "hosttest.h"
+
+// Blocks of a 100 bytes arena, freed in allocation order
+static void ring(void)
+{
+  uint16_t tail = 0;
+
+  CHECK_EQ(ringAlloc(100, &tail, 0, true, 101), 100);
+  CHECK_EQ(ringAlloc(100, &tail, 0, true, 40), 0);
+  CHECK_EQ(ringAlloc(100, &tail, 0, false, 40), 40);
+  // Not at end, oldest still at start
+  CHECK_EQ(ringAlloc(100, &tail, 0, false, 30), 100);
+  CHECK_EQ(tail, 80);
+  // Oldest freed, wraps to start
+  CHECK_EQ(ringAlloc(100, &tail, 40, false, 30), 0);
+  // Up to oldest, but never reaching it
+  CHECK_EQ(ringAlloc(100, &tail, 40, false, 10), 100);
+  CHECK_EQ(ringAlloc(100, &tail, 40, false, 9), 30);
+  CHECK_EQ(tail, 39);
+  printf("sinkalloc: ring arena wraps and keeps blocks in order\n");
+}
+
+static void sinks(const char * name)
+{
+  static const char * formats[] = { "get", "form", "json" };
+  uint64_t mallocs;
+  uint32_t calls;
+
+  testFeed(name);
+  CHECK(testFrames(3));
+
+  for (uint8_t f = CFG_JDOM_GET; f <= CFG_JDOM_JSON; f++) {
+    config.jeedom.format = f;
+    calls = 0;
+    for (int i = 0; i < 10; i++) {
+      CHECK(testFrames(1));
+
+      mallocs = testMallocs([]() { emoncmsPost(); });
+      CHECK_EQ(mallocs, 0u);
+      mallocs = testMallocs([]() { jeedomPost(); });
+      CHECK_EQ(mallocs, 0u);
+      mallocs = testMallocs([]() { domoticzPost(); });
+      CHECK_EQ(mallocs, 0u);
+      calls += 3;
+
+      // Let queue empty
+      hostLoop(500);
+    }
+    printf("sinkalloc %-14s jeedom %-4s %u calls, 0 mallocs\n", name, formats[f], calls);
+  }
+}
+
+int main(void)
+{
+  ring();
+
+  // Sinks are called by hand, not from scheduler
+  testBoot([]() {
+    strcpy(config.emoncms.host, "emoncms.local");
+    strcpy(config.emoncms.apikey, "0123456789abcdef0123456789abcdef");
+    config.emoncms.node = 1;
+    strcpy(config.jeedom.host, "jeedom.local");
+    strcpy(config.jeedom.apikey, "0123456789abcdef0123456789abcdef");
+    strcpy(config.jeedom.adco, "031428097115");
+    strcpy(config.domoticz.host, "domoticz.local");
+    strcpy(config.domoticz.usr, "admin");
+    strcpy(config.domoticz.pwd, "secret");
+    config.domoticz.idx_txt = 1;
+    config.domoticz.idx_p1sm = 2;
+    config.domoticz.idx_crt = 3;
+    config.domoticz.idx_elec = 4;
+    config.domoticz.idx_kwh = 5;
+    config.domoticz.idx_pct = 6;
+  });
+  jeedomSetup();
+
+  TestHttpServer emoncms("emoncms.local", IPAddress(192, 168, 1, 21));
+  TestHttpServer jeedom("jeedom.local", IPAddress(192, 168, 1, 22));
+  TestHttpServer domoticz("domoticz.local", IPAddress(192, 168, 1, 20));
+
+  sinks(TEST_HISTORIC);
+  sinks(TEST_STANDARD);
+
+  CHECK(emoncms.requests.size() > 0);
+  CHECK(jeedom.requests.size() > 0);
+  CHECK(domoticz.requests.size() > 0);
+  printf("sinkalloc: requests emoncms %u, jeedom %u, domoticz %u\n",
+         (unsigned) emoncms.requests.size(), (unsigned) jeedom.requests.size(),
+         (unsigned) domoticz.requests.size());
+  return 0;
+}
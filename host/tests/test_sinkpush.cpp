@@ -0,0 +1,75 @@
+// **********************************************************************************
+// WifInfo host build, push on change bookkeeping
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// Heartbeat full refresh stays pending until every due message of it has
+// been pushed, a sink failing part of it retries on next call.
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#include "hosttest.h"
+
+#define DEVICE_A (FRAME_HCHC | FRAME_HCHP | FRAME_PAPP)
+#define DEVICE_B (FRAME_IINST)
+
+static void heartbeat(void)
+{
+  uint32_t dirty;
+
+  // First push is a full one
+  dirty = tinfoFrameDirty(SINK_DOMOTICZ);
+  CHECK_EQ(dirty, 0xFFFFFFFFUL);
+  CHECK(tinfoFrameDue(SINK_DOMOTICZ, dirty, DEVICE_A));
+  CHECK(tinfoFrameDue(SINK_DOMOTICZ, dirty, DEVICE_B));
+  tinfoFramePushed(SINK_DOMOTICZ, DEVICE_A | DEVICE_B);
+
+  // Nothing moved
+  CHECK(tinfoFrameDirty(SINK_DOMOTICZ) != 0xFFFFFFFFUL);
+
+  // Heartbeat reached, device B fails
+  hostLoop(config.domoticz.push.heartbeat * 1000UL);
+  dirty = tinfoFrameDirty(SINK_DOMOTICZ);
+  CHECK_EQ(dirty, 0xFFFFFFFFUL);
+  CHECK(tinfoFrameDue(SINK_DOMOTICZ, dirty, DEVICE_A));
+  CHECK(tinfoFrameDue(SINK_DOMOTICZ, dirty, DEVICE_B));
+  tinfoFramePushed(SINK_DOMOTICZ, DEVICE_A);
+
+  // Still a full refresh, now complete
+  dirty = tinfoFrameDirty(SINK_DOMOTICZ);
+  CHECK_EQ(dirty, 0xFFFFFFFFUL);
+  CHECK(tinfoFrameDue(SINK_DOMOTICZ, dirty, DEVICE_A));
+  CHECK(tinfoFrameDue(SINK_DOMOTICZ, dirty, DEVICE_B));
+  tinfoFramePushed(SINK_DOMOTICZ, DEVICE_A | DEVICE_B);
+
+  // Heartbeat restarted from last push
+  CHECK(tinfoFrameDirty(SINK_DOMOTICZ) != 0xFFFFFFFFUL);
+  hostLoop(config.domoticz.push.heartbeat * 1000UL / 2);
+  CHECK(tinfoFrameDirty(SINK_DOMOTICZ) != 0xFFFFFFFFUL);
+  printf("sinkpush: heartbeat retried until full refresh pushed\n");
+}
+
+int main(void)
+{
+  // Sink stays disabled, we drive push bookkeeping ourselves
+  testBoot([]() {
+    config.domoticz.push.mode = CFG_PUSH_CHANGE;
+    config.domoticz.push.heartbeat = 60;
+    config.domoticz.push.db_power = 60000;
+    config.domoticz.push.db_current = 255;
+    config.domoticz.push.db_index = 60000;
+  });
+
+  // Values stop moving, only the heartbeat makes a full refresh
+  testFeed(TEST_HISTORIC);
+  CHECK(testFrames(3));
+  hostSerialClose();
+  hostLoop(100);
+
+  heartbeat();
+  return 0;
+}
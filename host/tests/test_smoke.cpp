@@ -0,0 +1,56 @@
+// **********************************************************************************
+// WifInfo host build, boot, decode both modes and answer web requests
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#include "hosttest.h"
+
+int main(void)
+{
+  TestBrowser browser;
+  TestResponse resp;
+
+  // Info messages go to debug serial and to the SPIFFS log
+  testBoot([]() { config.config |= CFG_INFO; });
+  CHECK(hostDebugOutput().find("HTTP server started") != std::string::npos);
+  CHECK(hostFsRead("/log.txt").find("HTTP server started") != std::string::npos);
+
+  // Historic
+  testFeed(TEST_HISTORIC);
+  CHECK(testFrames(5));
+  resp = browser.get("/json");
+  CHECK_EQ(resp.status, 200);
+  CHECK(resp.body.find("\"ADCO\":31428097115") != std::string::npos);
+  CHECK(resp.body.find("\"PAPP\":") != std::string::npos);
+  resp = browser.get("/PTEC");
+  CHECK_EQ(resp.status, 200);
+
+  // Linky standard
+  testFeed(TEST_STANDARD);
+  CHECK(testFrames(5));
+  resp = browser.get("/json");
+  CHECK_EQ(resp.status, 200);
+  CHECK(resp.body.find("\"SINSTS\":") != std::string::npos);
+  CHECK(resp.body.find("\"HCHP\":") != std::string::npos);
+  CHECK_EQ(tinfostd.checksumErrors(), 0u);
+
+  // UI files from SPIFFS
+  resp = browser.get("/");
+  CHECK_EQ(resp.status, 200);
+  CHECK_EQ(resp.body, hostFsRead("/index.htm.gz"));
+  resp = browser.get("/system.json");
+  CHECK_EQ(resp.status, 200);
+  resp = browser.get("/nothing-here");
+  CHECK_EQ(resp.status, 404);
+
+  CHECK_EQ(hostSerialDropped(), 0u);
+  printf("smoke: %u frames, worst loop pass %llu us\n", tinfo_frames,
+         (unsigned long long) hostLoopWorst());
+  return 0;
+}
@@ -0,0 +1,119 @@
+// **********************************************************************************
+// WifInfo host build, /events subscribers
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// A deltas and a whole frame subscriber, each event must be one valid
+// JSON data line. Whole frame must still go out when /json is not in
+// frame cache, rendered into the client.
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#include "hosttest.h"
+
+struct Event
+{
+  std::string name;
+  std::string data;
+};
+
+// Events received so far, headers and comments skipped
+static std::vector<Event> events(TestBrowser & browser, std::string & buf)
+{
+  std::vector<Event> list;
+  size_t end;
+
+  buf += browser.tcp->recv();
+  while ((end = buf.find("\n\n")) != std::string::npos) {
+    std::string block = buf.substr(0, end);
+    Event e;
+    size_t pos = 0;
+
+    buf.erase(0, end + 2);
+    while (pos < block.size()) {
+      size_t eol = block.find('\n', pos);
+      std::string line = block.substr(pos, eol == std::string::npos ? std::string::npos : eol - pos);
+
+      if (!line.compare(0, 7, "event: "))
+        e.name = line.substr(7);
+      else if (!line.compare(0, 6, "data: "))
+        e.data = line.substr(6);
+      pos = eol == std::string::npos ? block.size() : eol + 1;
+    }
+    if (!e.name.empty())
+      list.push_back(e);
+  }
+  return list;
+}
+
+static std::string oneLine(std::string json)
+{
+  size_t pos;
+
+  while ((pos = json.find_first_of("\r\n")) != std::string::npos)
+    json.erase(pos, 1);
+  return json;
+}
+
+int main(void)
+{
+  TestBrowser deltas, full, late, browser;
+  std::string deltas_buf, full_buf, late_buf;
+  std::vector<Event> list;
+  uint32_t frames = 0, changes = 0;
+  std::string json;
+
+  testBoot();
+  testFeed(TEST_HISTORIC);
+  CHECK(testFrames(2));
+
+  deltas.send("GET", "/events");
+  full.send("GET", "/events?full=1");
+  hostLoop(100);
+  CHECK_EQ(ssestat.clients, 2);
+
+  CHECK(testFrames(10));
+  hostLoop(100);
+  list = events(deltas, deltas_buf);
+  CHECK(!list.empty());
+  CHECK_EQ(list[0].name, "frame");
+  for (size_t i = 0; i < list.size(); i++) {
+    CHECK(testJsonValid(list[i].data));
+    changes += list[i].name == "delta";
+  }
+  list = events(full, full_buf);
+  CHECK(list.size() >= 10);
+  for (size_t i = 0; i < list.size(); i++) {
+    CHECK_EQ(list[i].name, "frame");
+    CHECK(testJsonValid(list[i].data));
+    frames++;
+  }
+  printf("sse %u frame events, %u delta events\n", frames, changes);
+  CHECK(changes > 0);
+
+  // Not in frame cache, rendered into clients
+  hostSerialClose();
+  hostLoop(100);
+  jsonCacheClear();
+  json = oneLine(browser.get("/json").body);
+  CHECK(testJsonValid(json));
+
+  late.send("GET", "/events?full=1");
+  hostLoop(100);
+  list = events(late, late_buf);
+  CHECK_EQ(list.size(), 1u);
+  CHECK_EQ(list[0].name, "frame");
+  CHECK_EQ(list[0].data, json);
+
+  sseFrame();
+  hostLoop(100);
+  list = events(full, full_buf);
+  CHECK_EQ(list.size(), 1u);
+  CHECK_EQ(list[0].data, json);
+  printf("sse frame out of cache, %u bytes\n", (unsigned) json.size());
+  return 0;
+}
@@ -0,0 +1,85 @@
+// **********************************************************************************
+// WifInfo host build, Linky standard mode decoder
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// Values go to the labels table only, decoding allocates nothing, and
+// /tinfo.json is rendered from that table with historic aliases. A PREF
+// longer than its field gives no ISOUSC.
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#include "hosttest.h"
+
+// One frame of a single group, checksum on everything up to last HT
+static std::string stdFrame(const char * label, const char * value)
+{
+  std::string data = std::string(label) + "\t" + value + "\t";
+  uint32_t sum = 0;
+
+  for (size_t i = 0; i < data.size(); i++)
+    sum += (uint8_t) data[i];
+  return "\x02\n" + data + (char) ((sum & 0x3F) + 0x20) + "\r\x03";
+}
+
+int main(void)
+{
+  TestBrowser browser;
+  TestResponse resp;
+  std::string data;
+  uint64_t mallocs;
+  uint32_t frames;
+  FILE * f;
+  char buf[4096];
+  size_t n;
+
+  testBoot();
+
+  f = fopen(testData(TEST_STANDARD).c_str(), "rb");
+  CHECK(f);
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+    data.append(buf, n);
+  fclose(f);
+
+  // First pass adds labels, second one only updates them
+  tinfoSetMode(TINFO_MODE_STANDARD);
+  tinfoFeed(data.data(), data.size());
+  frames = tinfo_frames;
+  mallocs = testMallocs([&]() { tinfoFeed(data.data(), data.size()); });
+  frames = tinfo_frames - frames;
+  printf("tinfostd: %u frames decoded, %llu mallocs\n", frames, (unsigned long long) mallocs);
+  CHECK(frames >= 100);
+  CHECK_EQ(mallocs, 0u);
+  CHECK_EQ(tinfostd.checksumErrors(), 0u);
+
+  // Standard labels with their historic alias, longest ones are whole
+  CHECK_EQ(std::string(tinfolabels.get(LABEL_NGTF)), "H PLEINE/CREUSE ");
+  CHECK_EQ(std::string(tinfolabels.get(LABEL_LTARF)), " HEURE  CREUSE  ");
+  CHECK_EQ(std::string(tinfolabels.get(LABEL_OPTARIF)), "HC..");
+  CHECK_EQ(std::string(tinfolabels.get(LABEL_ISOUSC)), "45");
+  CHECK_EQ(std::string(tinfolabels.get(LABEL_ADCO)), tinfolabels.get(LABEL_ADSC));
+  CHECK_EQ(std::string(tinfolabels.get(LABEL_PAPP)), tinfolabels.get(LABEL_SINSTS));
+
+  // Bogus PREF, ISOUSC keeps last good one
+  frames = tinfo_frames;
+  data = stdFrame("PREF", "99999999999");
+  tinfoFeed(data.data(), data.size());
+  CHECK_EQ(tinfo_frames, frames + 1);
+  CHECK_EQ(std::string(tinfolabels.get(LABEL_PREF)), "99999999999");
+  CHECK_EQ(std::string(tinfolabels.get(LABEL_ISOUSC)), "45");
+  data = stdFrame("PREF", "12");
+  tinfoFeed(data.data(), data.size());
+  CHECK_EQ(std::string(tinfolabels.get(LABEL_ISOUSC)), "60");
+
+  // Table from labels, checksum as historic one
+  resp = browser.get("/tinfo.json");
+  CHECK_EQ(resp.status, 200);
+  CHECK(resp.body.find("{\"na\":\"ADSC\", \"va\":\"041876543210\", \"ck\":\"") != std::string::npos);
+  CHECK(resp.body.find("{\"na\":\"OPTARIF\", \"va\":\"HC..\", \"ck\":\"<\"") != std::string::npos);
+  CHECK(resp.body.find("{\"na\":\"MSG1\", \"va\":\"PAS DE") != std::string::npos);
+  return 0;
+}
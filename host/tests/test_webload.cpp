@@ -0,0 +1,99 @@
+// **********************************************************************************
+// WifInfo host build, concurrent web load
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// Browsers on kept alive connections asking each a request after the
+// other (JSON answers and UI files) while frames are decoded, first as
+// many as WEB_CONNS then twice more, a refused browser retries after a
+// second as the 503 asks. Reports requests per second and latency
+// percentiles in virtual time (1 MB/s per connection, ESP CPU taken as
+// 30 times slower than this machine) and connections statistics.
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#include "hosttest.h"
+
+#define LOAD_MS   10000UL
+#define CPU_SCALE 30
+
+static const char * paths[] = {
+  "/json", "/tinfo.json", "/", "/css/wifinfo.css", "/js/wifinfo.js", "/PAPP"
+};
+#define PATHS (sizeof(paths) / sizeof(*paths))
+
+// Browsers asking for LOAD_MS, answers not 200 counted in failed
+static void load(int browsers, bool all_served)
+{
+  std::vector<TestBrowser> list(browsers);
+  std::vector<bool> busy(browsers, false);
+  std::vector<uint64_t> retry(browsers, 0);
+  std::vector<uint64_t> latency;
+  _webconnstat before = webconnstat;
+  uint64_t end = hostMicros() + LOAD_MS * 1000ULL;
+  uint64_t bytes = 0;
+  uint32_t failed = 0;
+  uint32_t n = 0;
+
+  webconnstat.max_conns = webconnstat.conns;
+  webconnstat.max_us = 0;
+  while (hostMicros() < end) {
+    for (int i = 0; i < browsers; i++) {
+      TestResponse resp;
+
+      if (!busy[i]) {
+        if (hostMicros() < retry[i])
+          continue;
+        list[i].send("GET", paths[n++ % PATHS]);
+        busy[i] = true;
+      } else if (list[i].poll(resp)) {
+        busy[i] = false;
+        if (resp.status != 200) {
+          retry[i] = hostMicros() + 1000000ULL;
+          failed++;
+          continue;
+        }
+        latency.push_back(resp.us);
+        bytes += resp.wire_bytes;
+      }
+    }
+    hostLoopOnce();
+  }
+
+  printf("webload %d browsers: %.1f req/s, %llu kB/s, p50 %.1f ms p99 %.1f ms, %u failed; "
+         "%u accepted, %u refused, %u evicted, %u reused, max %u conns, worst handler %u us\n",
+         browsers, latency.size() * 1000.0 / LOAD_MS,
+         (unsigned long long) (bytes / LOAD_MS), testPercentile(latency, 50) / 1000.0,
+         testPercentile(latency, 99) / 1000.0, failed,
+         webconnstat.accepted - before.accepted, webconnstat.refused - before.refused,
+         webconnstat.evicted - before.evicted, webconnstat.reused - before.reused,
+         webconnstat.max_conns, webconnstat.max_us);
+  CHECK(!latency.empty());
+  if (all_served) {
+    CHECK_EQ(failed, 0u);
+    CHECK(webconnstat.max_conns <= WEB_CONNS);
+    CHECK(webconnstat.reused - before.reused > 0);
+  }
+
+  // Connections of this load closed by server before next one
+  list.clear();
+  hostLoop(WEB_IDLE_MS + 1000);
+}
+
+int main(void)
+{
+  testBoot();
+  testFeed(TEST_HISTORIC);
+  CHECK(testFrames(2));
+
+  hostCpuScale(CPU_SCALE);
+  load(1, true);
+  load(WEB_CONNS, true);
+  load(WEB_CONNS * 2, false);
+  hostCpuScale(0);
+  return 0;
+}
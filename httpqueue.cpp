@@ -0,0 +1,1316 @@
+// **********************************************************************************
+// ESP8266 Teleinfo asynchronous HTTP requests queue
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use, see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+
+#include "httpqueue.h"
+#include <base64.h>
+
+// Request engine statistics
+_httpstat httpstat;
+
+// Pending requests, FIFO
+static _httpreq http_queue[HTTP_QUEUE_SIZE];
+static uint8_t http_head = 0;
+static uint8_t http_count = 0;
+
+// URLs of pending requests, allocated in FIFO order
+static char http_arena[HTTP_ARENA_SIZE];
+static uint16_t http_arena_tail = 0;
+
+// Request engine
+static uint8_t http_state = HTTP_IDLE;
+static unsigned long http_start;
+static unsigned long http_mark;  // end of previous phase
+static char http_line[HTTP_LINE_SIZE];
+static uint8_t http_line_idx;
+static int http_code;
+static uint8_t http_body;
+static uint32_t http_body_left;
+static bool http_close;
+static bool http_reused;
+
+// Connections pool, one per sink server
+static WiFiClient http_clients[SINK_HTTP_COUNT];
+static unsigned long http_last_used[SINK_HTTP_COUNT];
+static _sinkaddr http_addr[SINK_HTTP_COUNT];
+
+// Sinks render their URL here, then we render requests to send
+char http_buffer[HTTP_BUFFER_SIZE];
+
+// Domoticz basic authentication, computed once
+static char http_auth[HTTP_AUTH_SIZE];
+
+// Per sink connection statistics
+_httpsinkstat httpsinkstat[SINK_HTTP_COUNT];
+
+// Per domoticz device statistics, slots taken as devices show up
+_httpidxstat httpidxstat[HTTP_IDX_COUNT];
+
+// Per sink spool, and spool file name tag in SINK_xxx order
+_httpspool httpspool[SINK_HTTP_COUNT];
+static const char http_spool_tags[] PROGMEM = "ejdi";
+
+// Records time base, see httpClock()
+static uint32_t http_clock_base = 0;
+
+// Wall clock from servers Date header, see httpEpoch()
+static uint32_t http_epoch = 0;
+static unsigned long http_epoch_ms;
+
+/* ======================================================================
+Function: sinkServer
+Purpose : get server of a sink
+Input   : sink (SINK_xxx)
+          pointer on host name
+          pointer on port
+Output  : -
+Comments: -
+====================================================================== */
+static void sinkServer(uint8_t sink, const char ** host, uint16_t * port)
+{
+  switch (sink) {
+    case SINK_EMONCMS:
+      *host = config.emoncms.host;
+      *port = config.emoncms.port;
+      break;
+    case SINK_JEEDOM:
+      *host = config.jeedom.host;
+      *port = config.jeedom.port;
+      break;
+    case SINK_INFLUX:
+      *host = config.influx.host;
+      *port = config.influx.port;
+      break;
+    default:
+      *host = config.domoticz.host;
+      *port = config.domoticz.port;
+      break;
+  }
+}
+
+/* ======================================================================
+Function: sinkResolve
+Purpose : get address of a server
+Input   : resolved address
+          host name
+Output  : true if we have an address to connect to
+Comments: lookup is blocking in SDK, so we do it with a short timeout
+          and only for first connect, after SINK_DNS_FAILS connect
+          failures or every SINK_DNS_REFRESH. Callers connect under
+          their backoff so this is as rare as retries. When lookup
+          fails we keep previous address.
+====================================================================== */
+boolean sinkResolve(_sinkaddr * addr, const char * host)
+{
+  IPAddress ip;
+
+  if (addr->ip.isSet() && addr->fails < SINK_DNS_FAILS &&
+      seconds - addr->time < SINK_DNS_REFRESH)
+    return true;
+
+  if (WiFi.hostByName(host, ip, SINK_DNS_TIMEOUT))
+    addr->ip = ip;
+  else
+    Debugf("DNS %s failed\r\n", host);
+  addr->time = seconds;
+  addr->fails = 0;
+  return addr->ip.isSet();
+}
+
+/* ======================================================================
+Function: sinkConnected
+Purpose : account a connect to a resolved address
+Input   : resolved address
+          true if connected
+Output  : -
+Comments: -
+====================================================================== */
+void sinkConnected(_sinkaddr * addr, boolean ok)
+{
+  if (ok)
+    addr->fails = 0;
+  else if (addr->fails < SINK_DNS_FAILS)
+    addr->fails++;
+}
+
+/* ======================================================================
+Function: sinkForget
+Purpose : drop a resolved address
+Input   : resolved address
+Output  : -
+Comments: server name changed, next connect looks it up
+====================================================================== */
+void sinkForget(_sinkaddr * addr)
+{
+  addr->ip = IPAddress();
+  addr->time = 0;
+  addr->fails = 0;
+}
+
+/* ======================================================================
+Function: httpClock
+Purpose : get time of a new record
+Input   : -
+Output  : seconds
+Comments: uptime, going on after last spooled record when we rebooted
+          so ages stay right (but downtime is not counted)
+====================================================================== */
+static uint32_t httpClock(void)
+{
+  return http_clock_base + seconds;
+}
+
+/* ======================================================================
+Function: httpDrop
+Purpose : account a lost record
+Input   : sink (SINK_xxx)
+Output  : -
+Comments: -
+====================================================================== */
+static void httpDrop(uint8_t sink)
+{
+  httpstat.dropped++;
+  httpsinkstat[sink].dropped++;
+}
+
+/* ======================================================================
+Function: ringAlloc
+Purpose : find room for a block in a FIFO ring arena
+Input   : arena size
+          pointer on end of newest block, updated
+          offset of oldest block
+          true if arena holds no block
+          block size
+Output  : block offset, arena size if no room
+Comments: blocks are freed in allocation order, so the free space is
+          after the newest block, or at arena start if not enough
+          space at the end (oldest one is still after). Caller resets
+          tail to 0 when its last block is freed.
+====================================================================== */
+uint16_t ringAlloc(uint16_t arena, uint16_t * tail, uint16_t head, boolean empty, uint16_t size)
+{
+  uint16_t offset;
+
+  if (empty) {
+    offset = size > arena ? arena : 0;
+  } else if (*tail > head) {
+    if (size <= arena - *tail)
+      offset = *tail;
+    else if (size < head)
+      offset = 0;
+    else
+      offset = arena;
+  } else {
+    offset = size < head - *tail ? *tail : arena;
+  }
+
+  if (offset != arena)
+    *tail = offset + size;
+  return offset;
+}
+
+/* ======================================================================
+Function: httpAlloc
+Purpose : add a request to RAM queue
+Input   : sink (SINK_xxx)
+          URL size (with \0)
+          record time
+          HTTP_REQ_xxx flags
+Output  : where to copy URL, NULL if no room
+Comments: -
+====================================================================== */
+static char * httpAlloc(uint8_t sink, uint16_t size, uint32_t time, uint8_t flags)
+{
+  uint16_t offset;
+  _httpreq * req;
+
+  if (http_count >= HTTP_QUEUE_SIZE)
+    return NULL;
+
+  offset = ringAlloc(HTTP_ARENA_SIZE, &http_arena_tail, http_queue[http_head].offset,
+                     !http_count, size);
+  if (offset == HTTP_ARENA_SIZE)
+    return NULL;
+
+  req = &http_queue[(http_head + http_count) % HTTP_QUEUE_SIZE];
+  req->sink = sink;
+  req->offset = offset;
+  req->size = size;
+  req->flags = flags;
+  req->time = time;
+
+  if (++http_count > httpstat.max_pending)
+    httpstat.max_pending = http_count;
+
+  return http_arena + offset;
+}
+
+/* ======================================================================
+Function: httpPop
+Purpose : remove oldest request from RAM queue
+Input   : -
+Output  : -
+Comments: following ones moved to spool are removed too
+====================================================================== */
+static void httpPop(void)
+{
+  do {
+    http_head = (http_head + 1) % HTTP_QUEUE_SIZE;
+    if (!--http_count)
+      http_arena_tail = 0;
+  } while (http_count && (http_queue[http_head].flags & HTTP_REQ_SPILLED));
+}
+
+/* ======================================================================
+Function: spoolName
+Purpose : get file name of a spool segment
+Input   : where to put name (16 chars)
+          sink (SINK_xxx)
+          segment number
+Output  : -
+Comments: -
+====================================================================== */
+static void spoolName(char * name, uint8_t sink, uint16_t seg)
+{
+  sprintf_P(name, PSTR(HTTP_SPOOL_DIR "%c%u"), pgm_read_byte(&http_spool_tags[sink]), seg);
+}
+
+/* ======================================================================
+Function: spoolClear
+Purpose : remove all segments of a sink spool
+Input   : sink (SINK_xxx)
+Output  : -
+Comments: segments numbers start again from 0
+====================================================================== */
+static void spoolClear(uint8_t sink)
+{
+  _httpspool * sp = &httpspool[sink];
+  uint16_t seg = sp->head;
+  char name[16];
+
+  do {
+    spoolName(name, sink, seg);
+    SPIFFS.remove(name);
+  } while (seg++ != sp->tail);
+
+  sp->head = sp->tail = 0;
+  sp->read = sp->write = 0;
+  sp->count = 0;
+  sp->next = 0;
+  sp->loaded = false;
+}
+
+/* ======================================================================
+Function: spoolPeek
+Purpose : get size and time of next record to replay
+Input   : sink (SINK_xxx)
+Output  : true if there is one
+Comments: skip replayed ones, go to next segment when one has been
+          fully read
+====================================================================== */
+static bool spoolPeek(uint8_t sink)
+{
+  _httpspool * sp = &httpspool[sink];
+  char name[16];
+  _httprec rec;
+  File f;
+
+  while (sp->count) {
+    spoolName(name, sink, sp->head);
+    f = SPIFFS.open(name, "r");
+    while (f && f.seek(sp->read, SeekSet) && f.read((uint8_t *) &rec, sizeof(rec)) == sizeof(rec) &&
+           sp->read + sizeof(rec) + (rec.size & ~HTTP_REC_SENT) <= f.size()) {
+      if (!(rec.size & HTTP_REC_SENT)) {
+        f.close();
+        sp->oldest = rec.time;
+        sp->next = rec.size;
+        return true;
+      }
+      // Replayed before we restarted
+      sp->read += sizeof(rec) + (rec.size & ~HTTP_REC_SENT);
+    }
+    f.close();
+
+    // Nothing more here, should not happen on last one
+    if (sp->head == sp->tail) {
+      while (sp->count--)
+        httpDrop(sink);
+      spoolClear(sink);
+      break;
+    }
+
+    SPIFFS.remove(name);
+    sp->head++;
+    sp->read = 0;
+  }
+  return false;
+}
+
+/* ======================================================================
+Function: spoolAppend
+Purpose : add a record to a sink spool
+Input   : sink (SINK_xxx)
+          record time
+          URL
+          URL length
+Output  : true if record has been written
+Comments: -
+====================================================================== */
+static bool spoolAppend(uint8_t sink, uint32_t time, const char * url, uint16_t len)
+{
+  _httpspool * sp = &httpspool[sink];
+  _httprec rec = { time, len };
+  char name[16];
+  bool ok;
+  File f;
+
+  // Forget what a failed write left
+  if (!sp->count && sp->write)
+    spoolClear(sink);
+
+  // Current segment full, start a new one
+  if (sp->write && sp->write + sizeof(rec) + len > HTTP_SPOOL_SEG_SIZE) {
+    if (sp->tail - sp->head + 1 >= HTTP_SPOOL_SEGMENTS)
+      return false;
+    sp->tail++;
+    sp->write = 0;
+  }
+
+  spoolName(name, sink, sp->tail);
+  f = SPIFFS.open(name, "a");
+  if (!f)
+    return false;
+  ok = f.write((const uint8_t *) &rec, sizeof(rec)) == sizeof(rec) &&
+       f.write((const uint8_t *) url, len) == len;
+  f.close();
+
+  if (!ok) {
+    // Partial record ends this segment, reader will skip it
+    sp->write = HTTP_SPOOL_SEG_SIZE;
+    return false;
+  }
+
+  sp->write += sizeof(rec) + len;
+  if (!sp->count++) {
+    sp->oldest = time;
+    sp->next = len;
+  }
+  httpsinkstat[sink].spooled++;
+  return true;
+}
+
+/* ======================================================================
+Function: spoolPop
+Purpose : remove replayed record from spool
+Input   : sink (SINK_xxx)
+Output  : -
+Comments: segment is removed once all its records have been replayed
+====================================================================== */
+static void spoolPop(uint8_t sink)
+{
+  _httpspool * sp = &httpspool[sink];
+  uint16_t size = sp->next | HTTP_REC_SENT;
+  char name[16];
+  File f;
+
+  sp->loaded = false;
+  if (!sp->count)
+    return;
+
+  // Flag it, so it's not sent again if we restart
+  spoolName(name, sink, sp->head);
+  f = SPIFFS.open(name, "r+");
+  if (f && f.seek(sp->read + offsetof(_httprec, size), SeekSet))
+    f.write((const uint8_t *) &size, sizeof(size));
+  f.close();
+
+  sp->read += sizeof(_httprec) + sp->next;
+  if (--sp->count)
+    spoolPeek(sink);
+  else
+    spoolClear(sink);
+}
+
+/* ======================================================================
+Function: spoolLoad
+Purpose : put next spooled record in RAM queue to replay it
+Input   : sink (SINK_xxx)
+Output  : true if loaded
+Comments: record stays in spool until server accepted it
+====================================================================== */
+static bool spoolLoad(uint8_t sink)
+{
+  _httpspool * sp = &httpspool[sink];
+  char name[16];
+  char * url;
+  bool ok;
+  File f;
+
+  url = httpAlloc(sink, sp->next + 1, sp->oldest, HTTP_REQ_SPOOLED);
+  if (!url)
+    return false;
+
+  spoolName(name, sink, sp->head);
+  f = SPIFFS.open(name, "r");
+  ok = f && f.seek(sp->read + sizeof(_httprec), SeekSet) &&
+       f.read((uint8_t *) url, sp->next) == sp->next;
+  f.close();
+  url[sp->next] = '\0';
+  sp->loaded = true;
+
+  if (!ok) {
+    // Unreadable, skip it
+    http_queue[(http_head + http_count - 1) % HTTP_QUEUE_SIZE].flags = HTTP_REQ_SPILLED;
+    httpDrop(sink);
+    spoolPop(sink);
+    return false;
+  }
+  return true;
+}
+
+/* ======================================================================
+Function: httpSpill
+Purpose : move a sink requests from RAM queue to its spool
+Input   : sink (SINK_xxx)
+Output  : -
+Comments: called before spooling a new record so spool keeps the order,
+          if the one being sent is moved, it may be sent twice
+====================================================================== */
+static void httpSpill(uint8_t sink)
+{
+  for (uint8_t i = 0; i < http_count; i++) {
+    _httpreq * req = &http_queue[(http_head + i) % HTTP_QUEUE_SIZE];
+
+    if (req->sink != sink || req->flags)
+      continue;
+
+    req->flags = HTTP_REQ_SPILLED;
+    if (!spoolAppend(sink, req->time, http_arena + req->offset, req->size - 1))
+      httpDrop(sink);
+  }
+}
+
+/* ======================================================================
+Function: httpReplay
+Purpose : queue next spooled request of a sink if it's time to
+Input   : sink (SINK_xxx)
+Output  : -
+Comments: one at a time, with backoff when server is down and rate
+          limited when it's back, so we don't flood it
+====================================================================== */
+static void httpReplay(uint8_t sink)
+{
+  _httpspool * sp = &httpspool[sink];
+
+  if (!sp->count || sp->loaded || millis() - sp->wait_start < sp->wait_ms)
+    return;
+
+  // Keep room for fresh requests
+  if (http_count >= HTTP_QUEUE_SIZE / 2)
+    return;
+
+  if (spoolLoad(sink)) {
+    sp->wait_start = millis();
+    sp->wait_ms = HTTP_REPLAY_MS;
+  }
+}
+
+/* ======================================================================
+Function: httpEnqueue
+Purpose : queue a request to a sink server
+Input   : sink (SINK_xxx)
+          url, optionally followed by HTTP_BODY_SEP and a POST body
+Output  : true if request has been queued or spooled
+Comments: request will be done later by httpHandle() from main loop,
+          it goes to flash when RAM queue is full or server is down
+          a body ending with HTTP_AGE_PARAM gets the request age (s)
+====================================================================== */
+boolean httpEnqueue(uint8_t sink, const char * url)
+{
+  _httpspool * sp = &httpspool[sink];
+  uint16_t size = strlen(url) + 1;
+  uint32_t time = httpClock();
+  char * p;
+
+  // Could never be replayed
+  if (size > HTTP_URL_SIZE) {
+    httpDrop(sink);
+    return false;
+  }
+
+  // Older ones are waiting in spool, stay behind them. With nothing
+  // spooled (spool full or broken) backoff would block the sink forever,
+  // so try again from RAM once its delay is over
+  if (!sp->count && (!sp->backoff || millis() - sp->wait_start >= sp->wait_ms)) {
+    p = httpAlloc(sink, size, time, 0);
+    if (p) {
+      memcpy(p, url, size);
+      return true;
+    }
+  }
+
+  httpSpill(sink);
+  if (spoolAppend(sink, time, url, size - 1))
+    return true;
+
+  httpDrop(sink);
+  return false;
+}
+
+/* ======================================================================
+Function: httpPhase
+Purpose : account end of a request phase
+Input   : phase (HTTP_PHASE_xxx)
+Output  : -
+Comments: histogram buckets are powers of 2 of milliseconds
+====================================================================== */
+static void httpPhase(uint8_t phase)
+{
+  uint32_t ms = millis() - http_mark;
+  uint8_t b = 0;
+
+  for (ms >>= 1; ms && b < HTTP_HISTO_BUCKETS - 1; ms >>= 1)
+    b++;
+  httpsinkstat[http_queue[http_head].sink].histo[phase][b]++;
+  http_mark = millis();
+}
+
+/* ======================================================================
+Function: httpIdxAccount
+Purpose : account a domoticz request to its device
+Input   : request URL
+          true if server said 2xx
+          request duration
+Output  : -
+Comments: devices are few, once all slots are taken others are ignored
+====================================================================== */
+static void httpIdxAccount(const char * url, bool ok, uint32_t elapsed)
+{
+  const char * p = strstr_P(url, PSTR("idx="));
+  uint16_t idx;
+
+  if (!p || !(idx = atoi(p + 4)))
+    return;
+
+  for (uint8_t i = 0; i < HTTP_IDX_COUNT; i++) {
+    _httpidxstat * st = &httpidxstat[i];
+
+    if (st->idx && st->idx != idx)
+      continue;
+
+    st->idx = idx;
+    st->requests++;
+    if (!ok)
+      st->failed++;
+    st->total_ms += elapsed;
+    if (elapsed > st->max_ms)
+      st->max_ms = elapsed;
+    return;
+  }
+}
+
+/* ======================================================================
+Function: httpDone
+Purpose : end current request and remove it from queue
+Input   : true if server answered 200 OK
+          true if connection can be kept for next request
+Output  : -
+Comments: when server is down or failing, request and following ones
+          of this sink go to spool, and we wait before replaying them
+====================================================================== */
+static void httpDone(bool ok, bool keep)
+{
+  _httpreq * req = &http_queue[http_head];
+  _httpsinkstat * st = &httpsinkstat[req->sink];
+  _httpspool * sp = &httpspool[req->sink];
+  uint32_t elapsed = millis() - http_start;
+  bool retry = !ok && (!http_code || http_code >= 500);
+  const char * host;
+  uint16_t port;
+
+  if (!keep)
+    http_clients[req->sink].stop();
+  http_last_used[req->sink] = millis();
+
+  sinkServer(req->sink, &host, &port);
+  Debugf("http://%s:%d%s => %d in %d ms%s\r\n", host, port, http_arena + req->offset,
+         http_code, elapsed, http_reused ? " (keep-alive)" : "");
+
+  if (ok)
+    httpstat.ok++;
+  else
+    httpstat.failed++;
+  if (elapsed > httpstat.max_ms)
+    httpstat.max_ms = elapsed;
+
+  st->requests++;
+  if (!ok)
+    st->failed++;
+  st->status[http_code >= 100 && http_code < 600 ? http_code / 100 : 0]++;
+  if (ok)
+    st->ok_ms = millis() ? millis() : 1;
+  st->total_ms += elapsed;
+  if (elapsed > st->max_ms)
+    st->max_ms = elapsed;
+  if (http_state >= HTTP_STATUS)
+    httpPhase(HTTP_PHASE_RESPONSE);
+  if (req->sink == SINK_DOMOTICZ)
+    httpIdxAccount(http_arena + req->offset, ok, elapsed);
+
+  if (req->flags & HTTP_REQ_SPOOLED) {
+    if (retry)
+      sp->loaded = false;
+    else
+      spoolPop(req->sink);
+  }
+
+  if (retry) {
+    httpSpill(req->sink);
+    sp->backoff = sp->backoff ? min(sp->backoff * 2, HTTP_BACKOFF_MAX) : HTTP_BACKOFF_MIN;
+    sp->wait_start = millis();
+    sp->wait_ms = sp->backoff * 1000UL;
+  } else {
+    // Server answered, even if it did not like it
+    sp->backoff = 0;
+  }
+
+  httpPop();
+  http_state = HTTP_IDLE;
+}
+
+/* ======================================================================
+Function: httpConnect
+Purpose : get a connection to current request server
+Input   : -
+Output  : true if connected
+Comments: pooled connection is reused if server kept it open
+          SDK connect is blocking, so we use a resolved address and 
+          a short timeout, UART buffer hold the teleinfo meanwhile
+====================================================================== */
+static bool httpConnect(void)
+{
+  _httpreq * req = &http_queue[http_head];
+  WiFiClient * client = &http_clients[req->sink];
+  _sinkaddr * addr = &http_addr[req->sink];
+  const char * host;
+  uint16_t port;
+
+  http_reused = client->connected();
+  if (http_reused) 
+    return true;
+
+  // Server closed, forget what could remain
+  client->stop();
+
+  sinkServer(req->sink, &host, &port);
+
+  if (!*host)
+    return false;
+
+  if (!sinkResolve(addr, host))
+    return false;
+
+  httpsinkstat[req->sink].connects++;
+
+  client->setTimeout(HTTP_CONNECT_TIMEOUT);
+  if (!client->connect(addr->ip, port)) {
+    // Server may have changed address, looked up again after a few
+    sinkConnected(addr, false);
+    return false;
+  }
+  sinkConnected(addr, true);
+  client->setNoDelay(true);
+  return true;
+}
+
+/* ======================================================================
+Function: httpWrite
+Purpose : send request rendered in shared buffer
+Input   : sink, request size
+Output  : true if all has been written
+Comments: -
+====================================================================== */
+static bool httpWrite(uint8_t sink, uint16_t len)
+{
+  if (http_clients[sink].write((const uint8_t *) http_buffer, len) != len)
+    return false;
+  httpsinkstat[sink].bytes += len;
+  return true;
+}
+
+/* ======================================================================
+Function: httpSend
+Purpose : send current request
+Input   : -
+Output  : true if request has been sent
+Comments: only domoticz use basic authentication
+          request is built in shared buffer to go in one TCP segment
+          a body after the URL (see httpEnqueue) makes it a POST,
+          JSON if it starts with '{', form encoded otherwise
+          InfluxDB body may be gzipped, plain when it would not shrink
+====================================================================== */
+static bool httpSend(void)
+{
+  _httpreq * req = &http_queue[http_head];
+  const char * url = http_arena + req->offset;
+  const char * body = strchr(url, HTTP_BODY_SEP);
+  uint16_t zlen = 0;
+  const char * host;
+  uint16_t port;
+
+  sinkServer(req->sink, &host, &port);
+
+  // Compressed body waits after headers room, then joins them
+  if (body && req->sink == SINK_INFLUX && config.influx.gzip)
+    zlen = gzipCompress((const uint8_t *) body + 1, strlen(body + 1),
+                        (uint8_t *) http_buffer + HTTP_GZIP_ROOM, HTTP_BUFFER_SIZE - HTTP_GZIP_ROOM);
+
+  PString r(http_buffer, zlen ? HTTP_GZIP_ROOM : HTTP_BUFFER_SIZE);
+
+  if (body) {
+    uint16_t len = strlen(++body);
+    bool age = len >= sizeof(HTTP_AGE_PARAM) - 1 && 
+               !strcmp_P(body + len - (sizeof(HTTP_AGE_PARAM) - 1), PSTR(HTTP_AGE_PARAM));
+    char age_str[12];
+
+    // Server dates samples we held from their age when it gets them
+    *age_str = '\0';
+    if (age)
+      sprintf_P(age_str, PSTR("%lu"), (unsigned long) (httpClock() - req->time));
+
+    r += F("POST ");
+    r.write((const uint8_t *) url, body - 1 - url);
+    r += F(" HTTP/1.1\r\nContent-Type: ");
+    if (req->sink == SINK_INFLUX)
+      r += F("text/plain; charset=utf-8");
+    else
+      r += *body == '{' ? F("application/json") : F("application/x-www-form-urlencoded");
+    if (zlen)
+      r += F("\r\nContent-Encoding: gzip");
+    r += F("\r\nContent-Length: ");
+    r.appendUInt(zlen ? zlen : len + strlen(age_str));
+    r += F("\r\nHost: ");
+    r += host;
+    r += F("\r\nUser-Agent: WifInfo\r\nConnection: keep-alive\r\n\r\n");
+    if (zlen) {
+      if (r.overflow())
+        return false;
+      memmove(http_buffer + r.length(), http_buffer + HTTP_GZIP_ROOM, zlen);
+      return httpWrite(req->sink, r.length() + zlen);
+    }
+    r += body;
+    r += age_str;
+  } else {
+    r += F("GET ");
+    r += url;
+    r += F(" HTTP/1.1\r\nHost: ");
+    r += host;
+    if (req->sink == SINK_DOMOTICZ && *http_auth) {
+      r += F("\r\nAuthorization: Basic ");
+      r += http_auth;
+    }
+    r += F("\r\nUser-Agent: WifInfo\r\nConnection: keep-alive\r\n\r\n");
+  }
+
+  if (r.overflow())
+    return false;
+
+  return httpWrite(req->sink, r.length());
+}
+
+/* ======================================================================
+Function: httpReadLine
+Purpose : read a response line as it comes
+Input   : connection
+Output  : true when a full line is in http_line
+Comments: too long lines are truncated, we only need their start
+====================================================================== */
+static bool httpReadLine(WiFiClient * client)
+{
+  while (client->available()) {
+    char c = client->read();
+
+    if (c == '\n') {
+      http_line[http_line_idx] = '\0';
+      http_line_idx = 0;
+      return true;
+    }
+
+    if (c != '\r' && http_line_idx < sizeof(http_line) - 1)
+      http_line[http_line_idx++] = c;
+  }
+  return false;
+}
+
+/* ======================================================================
+Function: httpDate
+Purpose : parse an HTTP date
+Input   : header value, like " Sun, 06 Nov 1994 08:49:37 GMT"
+Output  : seconds since 1970, 0 if not understood
+Comments: only RFC 1123 format, the one servers send
+====================================================================== */
+static uint32_t httpDate(const char * value)
+{
+  static const char months[] PROGMEM = "JanFebMarAprMayJunJulAugSepOctNovDec";
+  unsigned int day, year, hour, minute, second;
+  char month[4];
+  const char * p;
+  int32_t y, m, era, doy, days;
+
+  p = strchr(value, ',');
+  if (!p || sscanf(p + 1, "%u %3s %u %u:%u:%u", &day, month, &year, &hour, &minute, &second) != 6)
+    return 0;
+
+  for (m = 0; m < 12; m++) {
+    if (!strncmp_P(month, months + m * 3, 3))
+      break;
+  }
+  if (m == 12 || year < 1970)
+    return 0;
+
+  // Days from civil, March based years
+  y = year - (m < 2);
+  m = m < 2 ? m + 10 : m - 2;
+  era = y / 400;
+  doy = (153 * m + 2) / 5 + day - 1;
+  days = era * 146097 + (y - era * 400) * 365 + (y - era * 400) / 4 - (y - era * 400) / 100 + doy - 719468;
+
+  return days * 86400UL + hour * 3600UL + minute * 60UL + second;
+}
+
+/* ======================================================================
+Function: httpHeader
+Purpose : handle a response header line
+Input   : -
+Output  : true if it was the last one (empty line)
+Comments: only body length, connection and date headers matter
+====================================================================== */
+static bool httpHeader(void)
+{
+  if (!*http_line) {
+    // No body for these ones
+    if (http_code == 204 || http_code == 304) {
+      http_body = HTTP_BODY_LENGTH;
+      http_body_left = 0;
+    }
+    return true;
+  }
+
+  if (!strncasecmp_P(http_line, PSTR("Content-Length:"), 15)) {
+    http_body_left = atol(http_line + 15);
+    http_body = HTTP_BODY_LENGTH;
+  } else if (!strncasecmp_P(http_line, PSTR("Transfer-Encoding:"), 18)) {
+    if (strstr_P(http_line + 18, PSTR("chunked")))
+      http_body = HTTP_BODY_CHUNK_SIZE;
+  } else if (!strncasecmp_P(http_line, PSTR("Connection:"), 11)) {
+    if (strstr_P(http_line + 11, PSTR("close")))
+      http_close = true;
+  } else if (!strncasecmp_P(http_line, PSTR("Date:"), 5)) {
+    uint32_t date = httpDate(http_line + 5);
+    uint32_t now;
+    uint16_t ms;
+
+    // Only fix a real drift, each resync may move us back up to 1 s
+    if (date && (!httpEpoch(millis(), &now, &ms) || 
+                 (date > now ? date - now : now - date) > HTTP_EPOCH_DRIFT)) {
+      http_epoch = date;
+      http_epoch_ms = millis();
+    }
+  }
+  return false;
+}
+
+/* ======================================================================
+Function: httpReadBody
+Purpose : discard response body as it comes
+Input   : connection
+Output  : true when body has been fully received
+Comments: -
+====================================================================== */
+static bool httpReadBody(WiFiClient * client)
+{
+  uint8_t buff[128];
+  size_t len;
+
+  for (;;) {
+    switch (http_body) {
+      case HTTP_BODY_CHUNK_SIZE:
+        if (!httpReadLine(client))
+          return false;
+        http_body_left = strtoul(http_line, NULL, 16);
+        http_body = http_body_left ? HTTP_BODY_CHUNK_DATA : HTTP_BODY_TRAILER;
+        break;
+
+      case HTTP_BODY_CHUNK_END:
+        if (!httpReadLine(client))
+          return false;
+        http_body = HTTP_BODY_CHUNK_SIZE;
+        break;
+
+      case HTTP_BODY_TRAILER:
+        if (!httpReadLine(client))
+          return false;
+        if (!*http_line)
+          return true;
+        break;
+
+      case HTTP_BODY_CLOSE:
+        if (client->available()) {
+          client->read(buff, sizeof(buff));
+          break;
+        }
+        return !client->connected();
+
+      default:
+        // Known length, alone or in a chunk
+        if (!http_body_left) {
+          if (http_body == HTTP_BODY_LENGTH)
+            return true;
+          http_body = HTTP_BODY_CHUNK_END;
+          break;
+        }
+        len = client->available();
+        if (!len)
+          return false;
+        if (len > sizeof(buff))
+          len = sizeof(buff);
+        if (len > http_body_left)
+          len = http_body_left;
+        http_body_left -= client->read(buff, len);
+        break;
+    }
+  }
+}
+
+/* ======================================================================
+Function: httpHandle
+Purpose : advance request engine one step
+Input   : -
+Output  : -
+Comments: to be called from main loop, never wait for the server
+====================================================================== */
+void httpHandle(void)
+{
+  WiFiClient * client = &http_clients[http_queue[http_head].sink];
+
+  switch (http_state) {
+    case HTTP_IDLE:
+      // Close connections we don't use anymore
+      for (uint8_t i = 0; i < SINK_HTTP_COUNT; i++) {
+        if (millis() - http_last_used[i] >= HTTP_KEEPALIVE_MS && http_clients[i].connected())
+          http_clients[i].stop();
+      }
+
+      if (WiFi.status() != WL_CONNECTED)
+        return;
+
+      for (uint8_t i = 0; i < SINK_HTTP_COUNT; i++)
+        httpReplay(i);
+
+      // Forget requests moved to spool
+      if (http_count && (http_queue[http_head].flags & HTTP_REQ_SPILLED))
+        httpPop();
+
+      if (!http_count)
+        return;
+      http_start = millis();
+      http_mark = http_start;
+      http_code = 0;
+      http_state = HTTP_CONNECT;
+      break;
+
+    case HTTP_CONNECT:
+      if (httpConnect()) {
+        httpPhase(HTTP_PHASE_CONNECT);
+        http_state = HTTP_SEND;
+      } else {
+        httpDone(false, false);
+      }
+      break;
+
+    case HTTP_SEND:
+      http_line_idx = 0;
+      if (httpSend()) {
+        httpPhase(HTTP_PHASE_SEND);
+        http_state = HTTP_STATUS;
+      } else if (http_reused) {
+        // Server closed our idle connection, open a new one
+        client->stop();
+        http_state = HTTP_CONNECT;
+      } else {
+        httpDone(false, false);
+      }
+      break;
+
+    case HTTP_STATUS:
+      if (httpReadLine(client)) {
+        // HTTP/1.1 200 OK
+        char * p = strchr(http_line, ' ');
+
+        http_code = p ? atoi(p + 1) : 0;
+        http_body = HTTP_BODY_CLOSE;
+        http_body_left = 0;
+        http_close = strncmp_P(http_line, PSTR("HTTP/1.1"), 8) != 0;
+        http_state = HTTP_HEADERS;
+      } else if (!client->connected() && !client->available()) {
+        if (http_reused && !http_line_idx) {
+          // Closed while we sent, open a new one and send again
+          client->stop();
+          http_reused = false;
+          http_state = HTTP_CONNECT;
+        } else {
+          httpDone(false, false);
+        }
+      }
+      break;
+
+    case HTTP_HEADERS:
+      while (http_state == HTTP_HEADERS && httpReadLine(client)) {
+        if (httpHeader())
+          http_state = HTTP_BODY;
+      }
+      if (http_state == HTTP_HEADERS && !client->connected() && !client->available())
+        httpDone(false, false);
+      break;
+
+    case HTTP_BODY:
+      if (httpReadBody(client))
+        httpDone(HTTP_OK(http_code), !http_close && http_body != HTTP_BODY_CLOSE);
+      else if (!client->connected() && !client->available())
+        httpDone(HTTP_OK(http_code), false);
+      break;
+  }
+
+  // Server too slow ?
+  if (http_state != HTTP_IDLE && millis() - http_start >= HTTP_REQUEST_TIMEOUT) {
+    if (http_state == HTTP_BODY) {
+      // We already have the answer
+      httpDone(HTTP_OK(http_code), false);
+    } else {
+      httpstat.timeouts++;
+      httpsinkstat[http_queue[http_head].sink].timeouts++;
+      httpDone(false, false);
+    }
+  }
+}
+
+/* ======================================================================
+Function: httpPending
+Purpose : return number of requests waiting
+Input   : -
+Output  : queue depth
+Comments: -
+====================================================================== */
+uint8_t httpPending(void)
+{
+  return http_count;
+}
+
+/* ======================================================================
+Function: httpSpooled
+Purpose : return number of records waiting in flash
+Input   : -
+Output  : spools depth
+Comments: -
+====================================================================== */
+uint32_t httpSpooled(void)
+{
+  uint32_t count = 0;
+
+  for (uint8_t i = 0; i < SINK_HTTP_COUNT; i++)
+    count += httpspool[i].count;
+  return count;
+}
+
+/* ======================================================================
+Function: httpSinkPending
+Purpose : return number of records waiting for a sink
+Input   : sink (SINK_xxx)
+Output  : records in RAM queue and spool
+Comments: -
+====================================================================== */
+uint32_t httpSinkPending(uint8_t sink)
+{
+  uint32_t count = httpspool[sink].count;
+
+  for (uint8_t i = 0; i < http_count; i++) {
+    _httpreq * req = &http_queue[(http_head + i) % HTTP_QUEUE_SIZE];
+
+    if (req->sink == sink && !req->flags)
+      count++;
+  }
+  return count;
+}
+
+/* ======================================================================
+Function: httpOldest
+Purpose : return age of oldest record waiting
+Input   : -
+Output  : seconds, 0 if none
+Comments: -
+====================================================================== */
+uint32_t httpOldest(void)
+{
+  uint32_t now = httpClock();
+  uint32_t oldest = now;
+
+  for (uint8_t i = 0; i < http_count; i++) {
+    _httpreq * req = &http_queue[(http_head + i) % HTTP_QUEUE_SIZE];
+
+    if (!(req->flags & HTTP_REQ_SPILLED) && req->time < oldest)
+      oldest = req->time;
+  }
+
+  for (uint8_t i = 0; i < SINK_HTTP_COUNT; i++) {
+    if (httpspool[i].count && httpspool[i].oldest < oldest)
+      oldest = httpspool[i].oldest;
+  }
+  return now - oldest;
+}
+
+/* ======================================================================
+Function: httpEpoch
+Purpose : get wall clock time of a millis() stamp
+Input   : millis() value
+          pointer on seconds since 1970
+          pointer on milliseconds
+Output  : false if no server gave us its date yet
+Comments: Date header of last response of any sink, one second 
+          resolution, so times are late by up to one second
+====================================================================== */
+boolean httpEpoch(unsigned long ms, uint32_t * sec, uint16_t * msec)
+{
+  int32_t delta = (int32_t) (ms - http_epoch_ms);
+  int32_t s = delta / 1000;
+  int32_t r = delta % 1000;
+
+  if (!http_epoch)
+    return false;
+
+  if (r < 0) {
+    r += 1000;
+    s--;
+  }
+  *sec = http_epoch + s;
+  *msec = r;
+  return true;
+}
+
+/* ======================================================================
+Function: httpSetup
+Purpose : prepare sinks connections from configuration
+Input   : -
+Output  : -
+Comments: to be called at start and when configuration changed,
+          servers may have changed so pooled connections are closed
+====================================================================== */
+void httpSetup(void)
+{
+  for (uint8_t i = 0; i < SINK_HTTP_COUNT; i++) {
+    http_clients[i].stop();
+    sinkForget(&http_addr[i]);
+
+    // Give spooled requests a chance with new settings
+    httpspool[i].backoff = 0;
+    httpspool[i].wait_ms = 0;
+  }
+
+  *http_auth = '\0';
+  if (*config.domoticz.usr && *config.domoticz.pwd) {
+    String auth = config.domoticz.usr;
+
+    auth += ':';
+    auth += config.domoticz.pwd;
+    strncpy(http_auth, base64::encode(auth, false).c_str(), sizeof(http_auth) - 1);
+  }
+}
+
+/* ======================================================================
+Function: httpSpoolSetup
+Purpose : find requests spooled before we restarted
+Input   : -
+Output  : -
+Comments: to be called once at start, file system mounted
+====================================================================== */
+void httpSpoolSetup(void)
+{
+  Dir dir = SPIFFS.openDir(HTTP_SPOOL_DIR);
+  bool found[SINK_HTTP_COUNT] = { false };
+  uint32_t last = 0;
+
+  // Segments range of each sink
+  while (dir.next()) {
+    String name = dir.fileName();
+    char tag = name[sizeof(HTTP_SPOOL_DIR) - 1];
+    uint16_t seg = atoi(name.c_str() + sizeof(HTTP_SPOOL_DIR));
+
+    for (uint8_t i = 0; i < SINK_HTTP_COUNT; i++) {
+      _httpspool * sp = &httpspool[i];
+
+      if (tag != (char) pgm_read_byte(&http_spool_tags[i]))
+        continue;
+
+      if (!found[i] || seg < sp->head)
+        sp->head = seg;
+      if (!found[i] || seg > sp->tail)
+        sp->tail = seg;
+      found[i] = true;
+    }
+  }
+
+  // Count records, and keep latest time
+  for (uint8_t i = 0; i < SINK_HTTP_COUNT; i++) {
+    _httpspool * sp = &httpspool[i];
+    uint16_t seg = sp->head;
+
+    if (!found[i])
+      continue;
+
+    do {
+      uint32_t offset = 0;
+      char name[16];
+      _httprec rec;
+      File f;
+
+      spoolName(name, i, seg);
+      f = SPIFFS.open(name, "r");
+      while (f && f.seek(offset, SeekSet) && f.read((uint8_t *) &rec, sizeof(rec)) == sizeof(rec) &&
+             offset + sizeof(rec) + (rec.size & ~HTTP_REC_SENT) <= f.size()) {
+        offset += sizeof(rec) + (rec.size & ~HTTP_REC_SENT);
+        if (!(rec.size & HTTP_REC_SENT))
+          sp->count++;
+        if (rec.time > last)
+          last = rec.time;
+      }
+      if (seg == sp->tail)
+        sp->write = f ? f.size() : 0;
+      f.close();
+    } while (seg++ != sp->tail);
+
+    Debugf("Spool %c: %d records in segments %d to %d\r\n", pgm_read_byte(&http_spool_tags[i]),
+           sp->count, sp->head, sp->tail);
+
+    if (sp->count)
+      spoolPeek(i);
+    else
+      spoolClear(i);
+  }
+
+  // Records time go on from spooled ones
+  if (last)
+    http_clock_base = last + 1;
+}
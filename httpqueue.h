@@ -0,0 +1,203 @@
+// **********************************************************************************
+// ESP8266 Teleinfo asynchronous HTTP requests queue Include file
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use , see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#ifndef HTTPQUEUE_H
+#define HTTPQUEUE_H
+
+// Include main project include file
+#include "Wifinfo.h"
+
+#define HTTP_QUEUE_SIZE      8     // max pending requests
+#define HTTP_ARENA_SIZE      3072  // bytes shared by pending requests URLs
+#define HTTP_CONNECT_TIMEOUT 1000  // TCP connect (ms), blocking in SDK
+#define HTTP_REQUEST_TIMEOUT 5000  // whole request (ms)
+#define HTTP_KEEPALIVE_MS    30000 // close pooled connection idle for (ms)
+#define HTTP_LINE_SIZE       48    // status/header line we keep
+#define HTTP_AUTH_SIZE       92    // base64 of domoticz usr:pwd
+#define HTTP_URL_SIZE        (HTTP_ARENA_SIZE / 2) // max URL (and body) we can queue
+#define HTTP_BUFFER_SIZE     (HTTP_URL_SIZE + 256) // URL then full request
+#define HTTP_GZIP_ROOM       320   // headers before gzipped body in buffer
+
+#define HTTP_SPOOL_DIR       "/q/" // spool segment files, /q/<sink><segment>
+#define HTTP_SPOOL_SEG_SIZE  4096  // bytes per spool segment file
+#define HTTP_SPOOL_SEGMENTS  16    // max segments per sink
+#define HTTP_BACKOFF_MIN     5     // first retry delay (s)
+#define HTTP_BACKOFF_MAX     300   // retry delay cap (s)
+#define HTTP_REPLAY_MS       500   // min delay between two replayed requests of a sink
+#define HTTP_EPOCH_DRIFT     2     // server date change (s) we follow
+#define HTTP_HISTO_BUCKETS   12    // latency buckets, <2ms, <4ms, ... <2048ms, more
+#define HTTP_IDX_COUNT       8     // domoticz devices we keep latency of
+
+#define SINK_DNS_TIMEOUT     500   // name lookup (ms), blocking in SDK
+#define SINK_DNS_FAILS       3     // connect failures in a row before a new lookup
+#define SINK_DNS_REFRESH     3600  // new lookup at next connect after (s)
+
+// Queued URL may be followed by a POST body
+#define HTTP_BODY_SEP        '\n'
+#define HTTP_AGE_PARAM       "sentat=" // body end, request age (s) is added when sent
+
+// Status of a request done
+#define HTTP_OK(code)        ((code) >= 200 && (code) < 300)
+
+// Queued request flags
+#define HTTP_REQ_SPOOLED     0x01  // replayed from spool, stay there until done
+#define HTTP_REQ_SPILLED     0x02  // moved to spool, just free it
+
+// Spooled record size flag, set once replayed
+#define HTTP_REC_SENT        0x8000
+
+// Request engine states
+enum
+{
+  HTTP_IDLE = 0,  // nothing to do
+  HTTP_CONNECT,   // open connection to sink server or reuse it
+  HTTP_SEND,      // send request
+  HTTP_STATUS,    // wait for status line
+  HTTP_HEADERS,   // read headers we need
+  HTTP_BODY       // discard body
+};
+
+// Measured phases of a request
+enum
+{
+  HTTP_PHASE_CONNECT = 0, // connection opened or reused
+  HTTP_PHASE_SEND,        // request written
+  HTTP_PHASE_RESPONSE,    // status, headers and body read
+  HTTP_PHASE_COUNT
+};
+
+// Body transfer of current response
+enum
+{
+  HTTP_BODY_LENGTH = 0, // Content-Length
+  HTTP_BODY_CLOSE,      // until server close
+  HTTP_BODY_CHUNK_SIZE, // chunked, size line
+  HTTP_BODY_CHUNK_DATA, // chunked, chunk data
+  HTTP_BODY_CHUNK_END,  // chunked, CRLF after data
+  HTTP_BODY_TRAILER     // chunked, trailer until empty line
+};
+
+// One queued request
+typedef struct
+{
+  uint8_t       sink;     // SINK_xxx, give server, port and auth
+  uint16_t      offset;   // URL offset in arena
+  uint16_t      size;     // URL space used in arena (with \0)
+  uint8_t       flags;    // HTTP_REQ_xxx
+  uint32_t      time;     // record time (s), see httpClock()
+} _httpreq;
+
+#pragma pack(push)  // push current alignment to stack
+#pragma pack(1)     // set alignment to 1 byte boundary
+
+// Spooled record header, followed by URL (without \0)
+// 6 Bytes
+typedef struct
+{
+  uint32_t time;          // record time (s)
+  uint16_t size;          // URL length, HTTP_REC_SENT once replayed
+} _httprec;
+
+#pragma pack(pop)
+
+// Per sink spool of requests not sent yet
+typedef struct
+{
+  uint16_t      head;     // segment we read
+  uint16_t      tail;     // segment we write
+  uint32_t      read;     // next record offset in head segment
+  uint32_t      write;    // tail segment size
+  uint32_t      count;    // records in spool
+  uint32_t      oldest;   // time of next record to replay
+  uint16_t      next;     // URL length of next record to replay
+  bool          loaded;   // next record is in RAM queue
+  uint16_t      backoff;  // retry delay (s), 0 when server answers
+  unsigned long wait_start; // millis() when we started to wait
+  uint32_t      wait_ms;  // before next replay, backoff or rate limit
+} _httpspool;
+
+// Server address, looked up again only now and then
+typedef struct
+{
+  IPAddress     ip;       // last address of name, kept when lookup fails
+  uint32_t      time;     // uptime (s) of last lookup
+  uint8_t       fails;    // connect failures in a row
+} _sinkaddr;
+
+// Request engine statistics
+typedef struct
+{
+  uint32_t ok;            // 2xx status received
+  uint32_t failed;        // connect error or other status
+  uint32_t timeouts;      // no answer in time
+  uint32_t dropped;       // records lost, spool full
+  uint8_t  max_pending;   // max queue depth seen
+  uint32_t max_ms;        // worst request duration
+} _httpstat;
+
+// Per sink connection statistics
+typedef struct
+{
+  uint32_t requests;      // requests done
+  uint32_t failed;        // requests without 2xx answer
+  uint32_t timeouts;      // no answer in time
+  uint32_t status[6];     // answers by status class, [0] no answer
+  uint32_t connects;      // new TCP connections
+  uint32_t total_ms;      // cumulated request duration
+  uint32_t max_ms;        // worst request duration
+  uint32_t bytes;         // bytes sent
+  unsigned long ok_ms;    // millis() of last 2xx, 0 if none yet
+  uint32_t spooled;       // records written to flash
+  uint32_t dropped;       // records lost
+  uint32_t histo[HTTP_PHASE_COUNT][HTTP_HISTO_BUCKETS]; // phases latency
+} _httpsinkstat;
+
+// Per domoticz device request statistics
+typedef struct
+{
+  uint16_t idx;           // device, 0 if slot free
+  uint32_t requests;      // requests done
+  uint32_t failed;        // requests without 2xx answer
+  uint32_t total_ms;      // cumulated request duration
+  uint32_t max_ms;        // worst request duration
+} _httpidxstat;
+
+// Exported variables/object instancied in main sketch
+// ===================================================
+extern _httpstat httpstat;
+extern char http_buffer[];
+extern _httpsinkstat httpsinkstat[];
+extern _httpidxstat httpidxstat[];
+extern _httpspool httpspool[];
+
+// declared exported function from httpqueue.cpp
+// ===================================================
+boolean httpEnqueue(uint8_t sink, const char * url);
+void httpHandle(void);
+uint8_t httpPending(void);
+uint32_t httpSpooled(void);
+uint32_t httpSinkPending(uint8_t sink);
+uint32_t httpOldest(void);
+boolean httpEpoch(unsigned long ms, uint32_t * sec, uint16_t * msec);
+void httpSetup(void);
+void httpSpoolSetup(void);
+uint16_t ringAlloc(uint16_t arena, uint16_t * tail, uint16_t head, boolean empty, uint16_t size);
+boolean sinkResolve(_sinkaddr * addr, const char * host);
+void sinkConnected(_sinkaddr * addr, boolean ok);
+void sinkForget(_sinkaddr * addr);
+
+#endif
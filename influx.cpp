@@ -0,0 +1,345 @@
+// **********************************************************************************
+// ESP8266 Teleinfo InfluxDB line protocol sink
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use, see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+
+#include "influx.h"
+
+// Sink statistics
+_influxstat influxstat;
+
+// Lines waiting for a write, each one is millis() when sampled then
+// line without timestamp and '\n', we stamp them once we know the date
+static uint8_t  influx_batch[INFLUX_BATCH_SIZE];
+static uint16_t influx_used = 0;
+static uint8_t  influx_count = 0;
+static uint16_t influx_body = 0;  // size of body they will render
+
+/* ======================================================================
+Function: influxEscape
+Purpose : append a name or tag value
+Input   : where to render, text
+Output  : -
+Comments: commas, equal signs and spaces are escaped
+====================================================================== */
+static void influxEscape(PString & out, const char * text)
+{
+  for (; *text; text++) {
+    if (*text == ',' || *text == '=' || *text == ' ')
+      out += '\\';
+    out += *text;
+  }
+}
+
+/* ======================================================================
+Function: influxField
+Purpose : append a field of a label
+Input   : where to render
+          name (flash or RAM)
+          label id, LABEL_UNKNOWN if not known
+          value as sent by meter
+          true for first field
+Output  : -
+Comments: numbers become integers, text stays as string (OPTARIF,
+          PTEC, Linky LTARF, ...)
+====================================================================== */
+static void influxField(PString & out, const __FlashStringHelper * fname, const char * name,
+                        uint8_t id, const char * value, bool first)
+{
+  const char * p = value;
+  uint32_t number;
+
+  if (!first)
+    out += ',';
+  if (fname)
+    out += fname;
+  else
+    influxEscape(out, name);
+  out += '=';
+
+  if (id != LABEL_OPTARIF && id != LABEL_PTEC && id != LABEL_HHPHC && tinfoFrameNumber(id, &number)) {
+    out.appendUInt(number);
+    out += 'i';
+    return;
+  }
+
+  // Short digit string fits in an integer
+  while (*p >= '0' && *p <= '9' && p - value < 10)
+    p++;
+  if (!*p && p > value && p - value < 10) {
+    out.appendUInt(strtoul(value, NULL, 10));
+    out += 'i';
+    return;
+  }
+
+  out += '"';
+  for (p = value; *p; p++) {
+    if (*p == '"' || *p == '\\')
+      out += '\\';
+    out += *p;
+  }
+  out += '"';
+}
+
+/* ======================================================================
+Function: influxLine
+Purpose : render current frame as a line without timestamp
+Input   : where to render
+Output  : false if frame has no field
+Comments: meter address (ADCO or ADSC) is the tag
+====================================================================== */
+static bool influxLine(PString & out)
+{
+  const char * adco = tinfolabels.has(LABEL_ADCO) ? tinfolabels.get(LABEL_ADCO) : tinfolabels.get(LABEL_ADSC);
+  bool first = true;
+
+  influxEscape(out, *config.influx.measurement ? config.influx.measurement : CFG_INFX_DEFAULT_MEAS);
+  if (*adco) {
+    out += F(",adco=");
+    influxEscape(out, adco);
+  }
+  out += ' ';
+
+  for (uint8_t id = 0; id < LABEL_COUNT; id++) {
+    if (!tinfolabels.has(id) || id == LABEL_ADCO || id == LABEL_ADSC)
+      continue;
+    influxField(out, TInfoLabels::labelName(id), NULL, id, tinfolabels.get(id), first);
+    first = false;
+  }
+
+  // Then unknown ones, but virtual
+  for (uint8_t i = 0; i < tinfolabels.extraCount(); i++) {
+    if (*tinfolabels.extraName(i) == '_')
+      continue;
+    influxField(out, NULL, tinfolabels.extraName(i), LABEL_UNKNOWN, tinfolabels.extraValue(i), first);
+    first = false;
+  }
+  return !first;
+}
+
+/* ======================================================================
+Function: influxUrl
+Purpose : render write URL
+Input   : where to render
+Output  : -
+Comments: default precision is nanoseconds
+====================================================================== */
+static void influxUrl(PString & url)
+{
+  url += F(INFLUX_WRITE_URL);
+  url += *config.influx.db ? config.influx.db : CFG_INFX_DEFAULT_DB;
+  if (*config.influx.usr) {
+    url += F("&u=");
+    url += config.influx.usr;
+    url += F("&p=");
+    url += config.influx.pwd;
+  }
+}
+
+/* ======================================================================
+Function: influxClock
+Purpose : check we know the date to stamp lines
+Input   : -
+Output  : true if known
+Comments: when unknown, ask a server for it with a ping request
+====================================================================== */
+static bool influxClock(void)
+{
+  uint32_t sec;
+  uint16_t msec;
+
+  if (httpEpoch(millis(), &sec, &msec))
+    return true;
+
+  if (!httpSinkPending(SINK_INFLUX) && httpEnqueue(SINK_INFLUX, INFLUX_PING_URL))
+    influxstat.pings++;
+  return false;
+}
+
+/* ======================================================================
+Function: influxFlush
+Purpose : queue a write with lines held
+Input   : -
+Output  : true if there is nothing held anymore
+Comments: lines are kept until a server gave us its date
+====================================================================== */
+static bool influxFlush(void)
+{
+  PString req(http_buffer, HTTP_URL_SIZE);
+  uint32_t sec;
+  uint16_t msec;
+  uint16_t body;
+  uint16_t i = 0;
+
+  if (!influx_count)
+    return true;
+
+  // Clock unknown, lines stay there
+  if (!influxClock())
+    return false;
+
+  influxUrl(req);
+  req += HTTP_BODY_SEP;
+  body = req.length();
+
+  while (i < influx_used) {
+    unsigned long ms;
+    const char * line = (const char *) influx_batch + i + sizeof(ms);
+    uint16_t len = strchr(line, '\n') - line;
+    char stamp[INFLUX_TIME_SIZE + 1];
+
+    memcpy(&ms, influx_batch + i, sizeof(ms));
+    httpEpoch(ms, &sec, &msec);
+    sprintf_P(stamp, PSTR(" %lu%03u000000"), (unsigned long) sec, msec);
+
+    req.write((const uint8_t *) line, len);
+    req += stamp;
+    req += '\n';
+    i += sizeof(ms) + len + 1;
+  }
+
+  influxstat.bytes += req.length() - body;
+  if (!req.overflow() && httpEnqueue(SINK_INFLUX, req)) {
+    influxstat.requests++;
+    sinkpush[SINK_INFLUX].sent++;
+  } else {
+    influxstat.dropped += influx_count;
+  }
+
+  influx_used = 0;
+  influx_count = 0;
+  influx_body = 0;
+  return true;
+}
+
+/* ======================================================================
+Function: influxSample
+Purpose : hold current frame for next write
+Input   : -
+Output  : -
+Comments: called on each frame, a write is queued when batch size
+          is reached or when next line would not fit in a request
+====================================================================== */
+void influxSample(void)
+{
+  unsigned long ms = millis();
+  uint16_t url;
+  uint16_t room;
+
+  if (!*config.influx.host || tinfolabels.empty())
+    return;
+
+  // Ask date early, before buffer is full
+  influxClock();
+
+  // Request size left for body
+  {
+    PString req(http_buffer, HTTP_URL_SIZE);
+
+    influxUrl(req);
+    url = req.length() + 1;
+  }
+
+  for (uint8_t retry = 0; ; retry++) {
+    room = INFLUX_BATCH_SIZE - influx_used;
+    if (room > sizeof(ms) + 1) {
+      PString line((char *) influx_batch + influx_used + sizeof(ms), room - sizeof(ms) - 1);
+
+      if (!influxLine(line))
+        return;
+
+      // Fits in buffer and in the request once stamped ?
+      if (!line.overflow() &&
+          url + influx_body + line.length() + INFLUX_TIME_SIZE + 1 < HTTP_URL_SIZE) {
+        memcpy(influx_batch + influx_used, &ms, sizeof(ms));
+        influx_used += sizeof(ms) + line.length();
+        influx_batch[influx_used++] = '\n';
+        influx_body += line.length() + INFLUX_TIME_SIZE + 1;
+        influx_count++;
+        influxstat.lines++;
+        break;
+      }
+    }
+
+    // Room for this line only with a new request, or never
+    if (retry || !influx_count || !influxFlush()) {
+      influxstat.dropped++;
+      return;
+    }
+    influxstat.early++;
+  }
+
+  if (influx_count >= (config.influx.batch ? config.influx.batch : 1))
+    influxFlush();
+}
+
+/* ======================================================================
+Function: influxPost
+Purpose : write lines held, if any
+Input   : -
+Output  : true if nothing is held anymore
+Comments: called by flush interval ticker, so a line never waits
+          more than this interval for a small batch to fill
+====================================================================== */
+boolean influxPost(void)
+{
+  if (!*config.influx.host)
+    return false;
+  return influxFlush();
+}
+
+/* ======================================================================
+Function: influxSetup
+Purpose : apply configuration
+Input   : -
+Output  : -
+Comments: lines held are written to the new server, or forgotten
+          if sink has been disabled
+====================================================================== */
+void influxSetup(void)
+{
+  if (*config.influx.host) {
+    influxFlush();
+  } else {
+    influx_used = 0;
+    influx_count = 0;
+    influx_body = 0;
+  }
+}
+
+/* ======================================================================
+Function: influxUsed
+Purpose : return RAM used by lines held
+Input   : -
+Output  : bytes
+Comments: -
+====================================================================== */
+uint16_t influxUsed(void)
+{
+  return influx_used;
+}
+
+/* ======================================================================
+Function: influxCount
+Purpose : return number of lines held
+Input   : -
+Output  : lines
+Comments: -
+====================================================================== */
+uint8_t influxCount(void)
+{
+  return influx_count;
+}
@@ -0,0 +1,52 @@
+// **********************************************************************************
+// ESP8266 Teleinfo InfluxDB line protocol sink Include file
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use , see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#ifndef INFLUX_H
+#define INFLUX_H
+
+// Include main project include file
+#include "Wifinfo.h"
+
+#define INFLUX_BATCH_SIZE   HTTP_URL_SIZE // lines held, millis() stamp then text
+#define INFLUX_TIME_SIZE    20            // " " then nanoseconds since 1970
+#define INFLUX_WRITE_URL    "/write?db="
+#define INFLUX_PING_URL     "/ping"       // answer gives us server date
+
+// Sink statistics
+typedef struct
+{
+  uint32_t lines;         // frames sampled
+  uint32_t requests;      // writes queued
+  uint32_t dropped;       // lines lost, no room or write not queued
+  uint32_t early;         // writes forced by request size
+  uint32_t pings;         // date requests while clock unknown
+  uint32_t bytes;         // body bytes queued
+} _influxstat;
+
+// Exported variables/object instancied in main sketch
+// ===================================================
+extern _influxstat influxstat;
+
+// declared exported function from influx.cpp
+// ===================================================
+void influxSample(void);
+boolean influxPost(void);
+void influxSetup(void);
+uint16_t influxUsed(void);
+uint8_t influxCount(void);
+
+#endif
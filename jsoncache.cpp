@@ -0,0 +1,151 @@
+// **********************************************************************************
+// ESP8266 Teleinfo per frame JSON cache
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use, see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+
+#include "jsoncache.h"
+
+// Cache statistics
+_jsoncachestat jsoncachestat;
+
+static _jsoncache jsoncache;
+
+/* ======================================================================
+Function: jsonCacheRender
+Purpose : render one body in cache
+Input   : cache
+          body (JSONCACHE_xxx)
+          its renderer
+          where it starts in cache
+          where to add its whole size
+Output  : where next one starts
+Comments: a body that does not fit is not cached, it will be rendered
+          on the fly for each request
+====================================================================== */
+static uint16_t jsonCacheRender(_jsoncache * c, uint8_t body, void (*render)(JSONWriter &), 
+                                uint16_t off, uint16_t * size)
+{
+  JSONWriter out(c->buf + off, sizeof(c->buf) - off);
+
+  render(out);
+
+  *size += out.total();
+  c->off[body] = off;
+  if (out.overflow()) {
+    c->len[body] = 0;
+    jsoncachestat.overflows++;
+    return off;
+  }
+  c->len[body] = out.length();
+  return off + out.length();
+}
+
+/* ======================================================================
+Function: jsonCacheFrame
+Purpose : render bodies of the frame we just received
+Input   : -
+Output  : -
+Comments: called from NewFrame() and UpdatedFrame() once frame is
+          decoded. Requests are answered in one go from loop() too, 
+          so none can see a frame being rendered, one copy is enough
+====================================================================== */
+void jsonCacheFrame(void)
+{
+  _jsoncache * c = &jsoncache;
+  unsigned long start = micros();
+  uint32_t elapsed;
+  uint16_t off = 0;
+  uint16_t size = 0;
+
+  off = jsonCacheRender(c, JSONCACHE_JSON, getJSONData, off, &size);
+  off = jsonCacheRender(c, JSONCACHE_TINFO, getTinfoJSONData, off, &size);
+  c->seq = tinfo_frames;
+  c->ms = millis();
+
+  jsoncachestat.renders++;
+  jsoncachestat.size = size;
+  if (size > jsoncachestat.max_size)
+    jsoncachestat.max_size = size;
+  elapsed = micros() - start;
+  if (elapsed > jsoncachestat.max_us)
+    jsoncachestat.max_us = elapsed;
+}
+
+/* ======================================================================
+Function: jsonCacheSend
+Purpose : answer request with cached body
+Input   : body (JSONCACHE_xxx)
+Output  : false if not in cache, caller has to render it
+Comments: ETag changes with each frame, a client sending back the one
+          it has gets a 304 without body
+====================================================================== */
+bool jsonCacheSend(uint8_t body)
+{
+  _jsoncache * c = &jsoncache;
+  char etag[JSONCACHE_ETAG_SIZE];
+
+  if (!c->seq || !c->len[body]) {
+    jsoncachestat.misses++;
+    return false;
+  }
+
+  sprintf_P(etag, PSTR("\"%x-%x\""), c->seq, c->ms);
+  server.sendHeader(F("ETag"), etag);
+  server.sendHeader(F("Cache-Control"), F("no-cache"));
+
+  if (server.hasHeader(F("If-None-Match")) && server.header(F("If-None-Match")) == etag) {
+    jsoncachestat.notmod++;
+    server.send(304);
+    return true;
+  }
+
+  jsoncachestat.hits++;
+  server.setContentLength(c->len[body]);
+  server.send(200, JSON_CONTENT_TYPE, "");
+  server.sendContent(c->buf + c->off[body], c->len[body]);
+  return true;
+}
+
+/* ======================================================================
+Function: jsonCacheBody
+Purpose : get cached body of last frame
+Input   : body (JSONCACHE_xxx)
+          where to put its size
+Output  : body, NULL if not in cache
+Comments: not null terminated, valid until next jsonCacheFrame()
+====================================================================== */
+const char * jsonCacheBody(uint8_t body, uint16_t * len)
+{
+  _jsoncache * c = &jsoncache;
+
+  if (!c->seq || !c->len[body])
+    return NULL;
+
+  *len = c->len[body];
+  return c->buf + c->off[body];
+}
+
+/* ======================================================================
+Function: jsonCacheClear
+Purpose : forget cached frames
+Input   : -
+Output  : -
+Comments: values are gone, e.g. teleinfo mode changed
+====================================================================== */
+void jsonCacheClear(void)
+{
+  jsoncache.seq = 0;
+}
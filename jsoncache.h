@@ -0,0 +1,68 @@
+// **********************************************************************************
+// ESP8266 Teleinfo per frame JSON cache Include file
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use , see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#ifndef JSONCACHE_H
+#define JSONCACHE_H
+
+// Include main project include file
+#include "Wifinfo.h"
+
+#define JSONCACHE_SIZE      3584  // room for all bodies of one frame, 3.3 KB in standard mode
+#define JSONCACHE_ETAG_SIZE 20    // "seq-ms" in hex with quotes
+
+// Cached bodies, rendered once per frame
+enum {
+  JSONCACHE_JSON = 0,   // /json, see getJSONData()
+  JSONCACHE_TINFO,      // /tinfo.json, see getTinfoJSONData()
+  JSONCACHE_BODIES
+};
+
+// Bodies of last frame
+typedef struct
+{
+  uint32_t seq;                     // tinfo_frames when rendered, 0 if empty
+  uint32_t ms;                      // millis() when rendered, makes ETag unique across reboots
+  uint16_t len[JSONCACHE_BODIES];   // 0 if it did not fit
+  uint16_t off[JSONCACHE_BODIES];   // where it is in buf
+  char     buf[JSONCACHE_SIZE];
+} _jsoncache;
+
+// Cache statistics
+typedef struct
+{
+  uint32_t renders;       // frames rendered
+  uint32_t hits;          // requests served from cache
+  uint32_t notmod;        // 304 answered
+  uint32_t misses;        // requests rendered on the fly
+  uint32_t overflows;     // bodies too big for cache
+  uint32_t max_us;        // worst render time
+  uint16_t size;          // last frame bodies size, cached or not
+  uint16_t max_size;      // biggest one, what JSONCACHE_SIZE should be
+} _jsoncachestat;
+
+// Exported variables/object instancied in main sketch
+// ===================================================
+extern _jsoncachestat jsoncachestat;
+
+// declared exported function from jsoncache.cpp
+// ===================================================
+void jsonCacheFrame(void);
+bool jsonCacheSend(uint8_t body);
+const char * jsonCacheBody(uint8_t body, uint16_t * len);
+void jsonCacheClear(void);
+
+#endif
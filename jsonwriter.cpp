@@ -0,0 +1,130 @@
+// **********************************************************************************
+// ESP8266 Teleinfo chunked JSON responses
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use, see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+
+#include "jsonwriter.h"
+
+// Chunked responses statistics
+_jsonwriterstat jsonwriterstat;
+
+/* ======================================================================
+Function: JSONWriter::sendChunk
+Purpose : send what is in staging buffer
+Input   : -
+Output  : -
+Comments: -
+====================================================================== */
+void JSONWriter::sendChunk(void)
+{
+  if (!_len)
+    return;
+
+  if (_out) {
+    _out->write((const uint8_t *) _buf, _len);
+  } else {
+    server.sendContent(_buf, _len);
+    jsonwriterstat.chunks++;
+  }
+  _bytes += _len;
+  _len = 0;
+}
+
+/* ======================================================================
+Function: JSONWriter::begin
+Purpose : start response
+Input   : HTTP status code
+Output  : -
+Comments: length is unknown, body will be sent chunked
+====================================================================== */
+void JSONWriter::begin(int code)
+{
+  _len = 0;
+  _bytes = 0;
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(code, JSON_CONTENT_TYPE, "");
+}
+
+/* ======================================================================
+Function: JSONWriter::end
+Purpose : send what is left and close response
+Input   : -
+Output  : -
+Comments: -
+====================================================================== */
+void JSONWriter::end(void)
+{
+  sendChunk();
+  server.sendContent("");
+
+  jsonwriterstat.responses++;
+  if (_bytes > jsonwriterstat.max_bytes)
+    jsonwriterstat.max_bytes = _bytes;
+}
+
+/* ======================================================================
+Function: JSONWriter::write
+Purpose : add one char
+Input   : char
+Output  : 1, 0 if buffer given to constructor is full
+Comments: -
+====================================================================== */
+size_t JSONWriter::write(uint8_t c)
+{
+  if (_len >= _size) {
+    if (!_chunked) {
+      _overflow = true;
+      _bytes++;
+      return 0;
+    }
+    sendChunk();
+  }
+  _buf[_len++] = c;
+  return 1;
+}
+
+/* ======================================================================
+Function: JSONWriter::write
+Purpose : add a block
+Input   : block and its size
+Output  : size written
+Comments: block may be bigger than buffer, it is then sent in pieces
+====================================================================== */
+size_t JSONWriter::write(const uint8_t *buffer, size_t size)
+{
+  size_t left = size;
+
+  while (left) {
+    size_t room = _size - _len;
+
+    if (!room) {
+      if (!_chunked) {
+        _overflow = true;
+        _bytes += left;
+        return size - left;
+      }
+      sendChunk();
+      room = _size;
+    }
+    if (room > left)
+      room = left;
+    memcpy(_buf + _len, buffer, room);
+    _len += room;
+    buffer += room;
+    left -= room;
+  }
+  return size;
+}
@@ -0,0 +1,90 @@
+// **********************************************************************************
+// ESP8266 Teleinfo chunked JSON responses Include file
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use , see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#ifndef JSONWRITER_H
+#define JSONWRITER_H
+
+// Include main project include file
+#include "Wifinfo.h"
+
+#define JSON_CHUNK_SIZE     256   // staging buffer, sent as one HTTP chunk
+#define JSON_CONTENT_TYPE   "text/json"
+
+// Chunked responses statistics
+typedef struct
+{
+  uint32_t responses;     // responses streamed
+  uint32_t chunks;        // chunks sent, all responses
+  uint32_t max_bytes;     // biggest response
+} _jsonwriterstat;
+
+// Writes a response body through a fixed buffer, so what we render
+// never lives in heap whatever its size. Used like a String:
+//   JSONWriter response;
+//   response.begin();
+//   response += F("{\"x\":"); response += x; response += '}';
+//   response.end();
+// Given a buffer, it renders there and sends nothing, see jsoncache.h
+// Given a Print, it renders through its buffer into it, see sse.cpp
+class JSONWriter : public Print
+{
+private:
+  char     _chunk[JSON_CHUNK_SIZE];
+  char *   _buf;
+  Print *  _out;       // where chunks go, web server response if NULL
+  uint16_t _size;
+  uint16_t _len;
+  uint32_t _bytes;     // sent, or dropped when given a buffer
+  bool     _chunked;   // send buffer when full, else drop what does not fit
+  bool     _overflow;
+  void sendChunk(void);
+
+public:
+  JSONWriter() : _buf(_chunk), _out(NULL), _size(JSON_CHUNK_SIZE), _len(0), _bytes(0),
+                 _chunked(true), _overflow(false) {}
+  JSONWriter(char * buf, size_t size) : _buf(buf), _out(NULL), _size(size), _len(0), _bytes(0),
+                 _chunked(false), _overflow(false) {}
+  JSONWriter(Print & out) : _buf(_chunk), _out(&out), _size(JSON_CHUNK_SIZE), _len(0), _bytes(0),
+                 _chunked(true), _overflow(false) {}
+
+  // start response with unknown length, then finish it
+  void begin(int code = 200);
+  void end(void);
+
+  // send what is in buffer to the Print given
+  virtual void flush(void) { sendChunk(); }
+
+  // what has been rendered in buffer, and if something was dropped
+  inline size_t length(void) { return _len; }
+  inline bool overflow(void) { return _overflow; }
+
+  // whole size of what has been rendered, dropped part included
+  inline size_t total(void) { return _bytes + _len; }
+
+  virtual size_t write(uint8_t c);
+  virtual size_t write(const uint8_t *buffer, size_t size);
+
+  // Concatenation, same as String
+  template<class T> inline JSONWriter &operator +=(T arg)
+  { print(arg); return *this; }
+};
+
+// Exported variables/object instancied in main sketch
+// ===================================================
+extern _jsonwriterstat jsonwriterstat;
+
+#endif
@@ -0,0 +1,291 @@
+// **********************************************************************************
+// ESP8266 Teleinfo log file reader
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use, see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+
+#include "logread.h"
+
+// One read request
+typedef struct
+{
+  JSONWriter * out;
+  uint16_t     skip;    // events still to skip (offset)
+  uint16_t     left;    // events still to send (limit)
+  uint16_t     count;   // events sent
+} _logread;
+
+// Cursor of first byte of LOG_FILE
+static uint32_t log_base = 0;
+static bool log_base_set = false;
+
+/* ======================================================================
+Function: logReadSize
+Purpose : size of a log file
+Input   : path
+Output  : size, 0 if there is no such file
+Comments: -
+====================================================================== */
+static size_t logReadSize(const char * path)
+{
+  File f = SPIFFS.open(path, "r");
+  size_t size = 0;
+
+  if (f) {
+    size = f.size();
+    f.close();
+  }
+  return size;
+}
+
+/* ======================================================================
+Function: logReadBase
+Purpose : cursor of first byte of LOG_FILE
+Input   : -
+Output  : -
+Comments: at boot, cursor 0 is start of LOG_FILE_OLD
+====================================================================== */
+static uint32_t logReadBase(void)
+{
+  if (!log_base_set) {
+    log_base = logReadSize(LOG_FILE_OLD);
+    log_base_set = true;
+  }
+  return log_base;
+}
+
+/* ======================================================================
+Function: logReadRotated
+Purpose : LOG_FILE is becoming LOG_FILE_OLD
+Input   : its size
+Output  : -
+Comments: called by floggerflush() before rename, so cursors of
+          clients stay valid
+====================================================================== */
+void logReadRotated(size_t size)
+{
+  log_base = logReadBase() + size;
+}
+
+/* ======================================================================
+Function: logReadLast
+Purpose : find end of last complete line
+Input   : opened file
+Output  : position after last '\n', 0 if none
+Comments: line being written is not complete, we don't send it yet
+====================================================================== */
+static uint32_t logReadLast(File & f)
+{
+  char buf[LOG_READ_BLOCK];
+  uint32_t end = f.size();
+
+  while (end) {
+    uint32_t start = end > sizeof(buf) ? end - sizeof(buf) : 0;
+    size_t n;
+
+    f.seek(start, SeekSet);
+    n = f.read((uint8_t *) buf, end - start);
+    while (n--) {
+      if (buf[n] == '\n')
+        return start + n + 1;
+    }
+    end = start;
+  }
+  return 0;
+}
+
+/* ======================================================================
+Function: logReadEnd
+Purpose : cursor after last complete line
+Input   : -
+Output  : cursor
+Comments: what ?since= has to be next time to get only new lines
+====================================================================== */
+uint32_t logReadEnd(void)
+{
+  uint32_t end = logReadBase();
+  File f = SPIFFS.open(LOG_FILE, "r");
+
+  if (f) {
+    end += logReadLast(f);
+    f.close();
+  }
+  return end;
+}
+
+/* ======================================================================
+Function: logReadValid
+Purpose : check a cursor from a client
+Input   : cursor
+Output  : true if lines after it are still there
+Comments: false once they have been rotated out, or after a reboot
+          when it is beyond what we have
+====================================================================== */
+bool logReadValid(uint32_t since)
+{
+  uint32_t base = logReadBase();
+  size_t old = logReadSize(LOG_FILE_OLD);
+
+  return since + old >= base && since <= logReadEnd();
+}
+
+/* ======================================================================
+Function: logReadText
+Purpose : send part of a line as JSON string content
+Input   : where to render
+          text and its size
+Output  : -
+Comments: quotes and backslashes are escaped, control chars (\r)
+          are dropped
+====================================================================== */
+static void logReadText(JSONWriter & out, const char * text, size_t len)
+{
+  while (len--) {
+    char c = *text++;
+
+    if (c == '"' || c == '\\')
+      out += '\\';
+    if ((uint8_t) c >= ' ')
+      out += c;
+  }
+}
+
+/* ======================================================================
+Function: logReadLine
+Purpose : send one event
+Input   : read request
+          file, block read and where it starts in file
+          line start and end in file
+Output  : false if limit is reached
+Comments: line is in block most of the time, else we read it again
+====================================================================== */
+static bool logReadLine(_logread * r, File & f, const char * block, size_t n, uint32_t pos,
+                        uint32_t start, uint32_t end)
+{
+  JSONWriter & out = *r->out;
+
+  if (start == end)
+    return true;
+  if (r->skip) {
+    r->skip--;
+    return true;
+  }
+
+  if (r->count)
+    out += F(",\r\n");
+  out += F("{\"ev\":\"");
+  if (end <= pos + n) {
+    logReadText(out, block + start - pos, end - start);
+  } else {
+    char chunk[LOG_READ_CHUNK];
+
+    f.seek(start, SeekSet);
+    while (start < end) {
+      size_t len = f.read((uint8_t *) chunk, end - start > sizeof(chunk) ? sizeof(chunk) : end - start);
+
+      if (!len)
+        break;
+      logReadText(out, chunk, len);
+      start += len;
+    }
+  }
+  out += F("\"}");
+
+  r->count++;
+  return --r->left != 0;
+}
+
+/* ======================================================================
+Function: logReadFile
+Purpose : send lines of a file, newest first
+Input   : read request
+          file path
+          first and last byte in file (from is at a line start)
+Output  : false if limit is reached
+Comments: file is read backward by blocks, whatever its size
+====================================================================== */
+static bool logReadFile(_logread * r, const char * path, uint32_t from, uint32_t to)
+{
+  char block[LOG_READ_BLOCK];
+  File f;
+  uint32_t line_end = to;   // end of line being looked for
+  uint32_t pos = to;        // start of block read
+  bool more = true;
+
+  if (from >= to || !(f = SPIFFS.open(path, "r")))
+    return true;
+
+  while (more && pos > from) {
+    uint32_t end = pos;
+    size_t n, i;
+
+    pos = end - from > sizeof(block) ? end - sizeof(block) : from;
+    f.seek(pos, SeekSet);
+    n = i = f.read((uint8_t *) block, end - pos);
+
+    // '\n' ending last line does not start an empty one
+    if (end == to && n && block[n - 1] == '\n')
+      line_end = pos + --i;
+
+    while (more && i--) {
+      if (block[i] == '\n') {
+        more = logReadLine(r, f, block, n, pos, pos + i + 1, line_end);
+        line_end = pos + i;
+      }
+    }
+
+    // First line of range
+    if (more && pos == from)
+      more = logReadLine(r, f, block, n, pos, from, line_end);
+  }
+
+  f.close();
+  return more;
+}
+
+/* ======================================================================
+Function: logReadJSON
+Purpose : send events as a JSON table, newest first
+Input   : where to render
+          cursor, events written before are not sent
+          cursor from logReadEnd(), events written after are not sent
+          events to skip, events to send (0 for all)
+Output  : events sent
+Comments: memory use does not depend on log size, files are read
+          backward by blocks and rendered through out
+====================================================================== */
+uint16_t logReadJSON(JSONWriter & out, uint32_t since, uint32_t end, uint16_t offset, uint16_t limit)
+{
+  _logread r;
+  uint32_t base = logReadBase();
+  size_t old = logReadSize(LOG_FILE_OLD);
+  bool more = true;
+
+  r.out = &out;
+  r.skip = offset;
+  r.left = limit ? limit : 0xFFFF;
+  r.count = 0;
+
+  out += F("[\r\n");
+
+  if (end > base)
+    more = logReadFile(&r, LOG_FILE, since > base ? since - base : 0, end - base);
+
+  if (more && since < base && old)
+    logReadFile(&r, LOG_FILE_OLD, since + old > base ? since + old - base : 0, old);
+
+  out += F("\r\n]");
+  return r.count;
+}
@@ -0,0 +1,40 @@
+// **********************************************************************************
+// ESP8266 Teleinfo log file reader Include file
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use , see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#ifndef LOGREAD_H
+#define LOGREAD_H
+
+// Include main project include file
+#include "Wifinfo.h"
+
+#define LOG_FILE          "/log.txt"  // current log, floggerflush() appends there
+#define LOG_FILE_OLD      "/log.1"    // previous one
+#define LOG_READ_BLOCK    128         // read backward by blocks of this size
+#define LOG_READ_CHUNK    32          // line spanning blocks is read again by this size
+
+// Events are read newest first from both files. A cursor is a byte
+// position in the log since boot, lines written after cursor c are
+// the ones ?since=c returns, see logReadEnd()
+
+// declared exported function from logread.cpp
+// ===================================================
+void logReadRotated(size_t size);
+uint32_t logReadEnd(void);
+bool logReadValid(uint32_t since);
+uint16_t logReadJSON(JSONWriter & out, uint32_t since, uint32_t end, uint16_t offset, uint16_t limit);
+
+#endif
@@ -0,0 +1,269 @@
+// **********************************************************************************
+// ESP8266 Teleinfo Prometheus metrics
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use, see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+
+#include "metrics.h"
+
+// Scrape statistics
+_metricsstat metricsstat;
+
+// Sink label values, SINK_xxx order
+static const char * const metrics_sinks[SINK_COUNT] = { "emoncms", "jeedom", "domoticz", "influxdb", "mqtt" };
+
+/* ======================================================================
+Function: metricsFlush
+Purpose : send what has been rendered as one chunk
+Input   : where we render
+          true to send even if there is room for another line
+Output  : -
+Comments: called before each line, so a line never gets truncated
+====================================================================== */
+static void metricsFlush(PString & out, bool force)
+{
+  if (!out.length() || (!force && out.length() + METRICS_LINE_SIZE < out.capacity()))
+    return;
+
+  server.sendContent((const char *) out, out.length());
+  metricsstat.chunks++;
+  metricsstat.bytes += out.length();
+  out.begin();
+}
+
+/* ======================================================================
+Function: metricsFamily
+Purpose : render type and help of a metric family
+Input   : where we render
+          family name, type and help text
+Output  : -
+Comments: -
+====================================================================== */
+static void metricsFamily(PString & out, const __FlashStringHelper * name,
+                          const __FlashStringHelper * type, const __FlashStringHelper * help)
+{
+  metricsFlush(out, false);
+  out += F("# TYPE ");
+  out += name;
+  out += ' ';
+  out += type;
+  out += F("\n# HELP ");
+  out += name;
+  out += ' ';
+  out += help;
+  out += '\n';
+}
+
+/* ======================================================================
+Function: metricsSample
+Purpose : render a sample of a health metric family
+Input   : where we render
+          family name
+          true for a counter (_total suffix)
+          sink label value, NULL if none
+          value
+Output  : -
+Comments: -
+====================================================================== */
+static void metricsSample(PString & out, const __FlashStringHelper * name, bool total,
+                          const char * sink, uint32_t value)
+{
+  metricsFlush(out, false);
+  out += name;
+  if (total)
+    out += F("_total");
+  if (sink) {
+    out += F("{sink=\"");
+    out += sink;
+    out += F("\"}");
+  }
+  out += ' ';
+  out.appendUInt(value);
+  out += '\n';
+}
+
+/* ======================================================================
+Function: metricsEscape
+Purpose : render a label value
+Input   : where we render, value
+Output  : -
+Comments: -
+====================================================================== */
+static void metricsEscape(PString & out, const char * value)
+{
+  for (; *value; value++) {
+    if (*value == '"' || *value == '\\')
+      out += '\\';
+    out += *value;
+  }
+}
+
+/* ======================================================================
+Function: metricsMeter
+Purpose : render meter identity
+Input   : where we render
+Output  : -
+Comments: as an info family, so it can be joined with values
+====================================================================== */
+static void metricsMeter(PString & out)
+{
+  const char * adco = tinfolabels.has(LABEL_ADCO) ? tinfolabels.get(LABEL_ADCO) : tinfolabels.get(LABEL_ADSC);
+
+  metricsFamily(out, F("teleinfo_meter"), F("info"), F("Meter address and tariff option"));
+  out += F("teleinfo_meter_info{adco=\"");
+  metricsEscape(out, adco);
+  if (tinfolabels.has(LABEL_OPTARIF)) {
+    out += F("\",optarif=\"");
+    metricsEscape(out, tinfolabels.get(LABEL_OPTARIF));
+  }
+  if (tinfolabels.has(LABEL_NGTF)) {
+    out += F("\",ngtf=\"");
+    metricsEscape(out, tinfolabels.get(LABEL_NGTF));
+  }
+  out += F("\"} 1\n");
+}
+
+/* ======================================================================
+Function: metricsLabel
+Purpose : render family name of a teleinfo label
+Input   : where we render, label id
+Output  : -
+Comments: teleinfo_ then label in lower case, SMAXSN-1 is smaxsn_1
+          and NJOURF+1 is njourf_1
+====================================================================== */
+static void metricsLabel(PString & out, uint8_t id)
+{
+  PGM_P p = (PGM_P) TInfoLabels::labelName(id);
+  char c;
+
+  out += F("teleinfo_");
+  while ((c = pgm_read_byte(p++)))
+    out += (char) (isalnum(c) ? tolower(c) : '_');
+}
+
+/* ======================================================================
+Function: metricsValues
+Purpose : render all numeric values of last frame
+Input   : where we render
+Output  : -
+Comments: energy indexes are counters, anything else is a gauge,
+          OPTARIF, PTEC and HHPHC are the codes emoncms gets
+====================================================================== */
+static void metricsValues(PString & out)
+{
+  for (uint8_t id = 0; id < LABEL_COUNT; id++) {
+    bool counter = (id >= LABEL_BASE && id <= LABEL_BBRHPJR) || (id >= LABEL_EAST && id <= LABEL_ERQ4);
+    uint32_t value;
+
+    if (!tinfoFrameValue(id, &value))
+      continue;
+
+    metricsFlush(out, false);
+    out += F("# TYPE ");
+    metricsLabel(out, id);
+    out += counter ? F(" counter\n") : F(" gauge\n");
+    metricsLabel(out, id);
+    if (counter)
+      out += F("_total");
+    out += ' ';
+    out.appendUInt(value);
+    out += '\n';
+  }
+}
+
+/* ======================================================================
+Function: metricsHealth
+Purpose : render device health
+Input   : where we render
+Output  : -
+Comments: checksum errors are counted by standard mode decoder only
+====================================================================== */
+static void metricsHealth(PString & out)
+{
+  metricsFamily(out, F("wifinfo_uptime_seconds"), F("gauge"), F("Time since boot"));
+  metricsSample(out, F("wifinfo_uptime_seconds"), false, NULL, seconds);
+
+  metricsFamily(out, F("wifinfo_heap_free_bytes"), F("gauge"), F("Free heap"));
+  metricsSample(out, F("wifinfo_heap_free_bytes"), false, NULL, ESP.getFreeHeap());
+
+  metricsFamily(out, F("wifinfo_wifi_rssi_dbm"), F("gauge"), F("WiFi signal"));
+  out += F("wifinfo_wifi_rssi_dbm ");
+  out.appendInt(WiFi.RSSI());
+  out += '\n';
+
+  metricsFamily(out, F("wifinfo_frames"), F("counter"), F("Teleinfo frames received"));
+  metricsSample(out, F("wifinfo_frames"), true, NULL, tinfo_frames);
+
+  metricsFamily(out, F("wifinfo_frames_updated"), F("counter"), F("Teleinfo frames with a changed value"));
+  metricsSample(out, F("wifinfo_frames_updated"), true, NULL, tinfo_updated_frames);
+
+  metricsFamily(out, F("wifinfo_checksum_errors"), F("counter"), F("Teleinfo groups with bad checksum"));
+  metricsSample(out, F("wifinfo_checksum_errors"), true, NULL, tinfostd.checksumErrors());
+
+  metricsFamily(out, F("wifinfo_rx_overruns"), F("counter"), F("Serial receive buffer overruns"));
+  metricsSample(out, F("wifinfo_rx_overruns"), true, NULL, tinfo_rx_overruns);
+
+  // Sinks, MQTT has no request that can fail, only messages dropped
+  metricsFamily(out, F("wifinfo_sink_requests"), F("counter"), F("Requests done or messages published"));
+  for (uint8_t i = 0; i < SINK_HTTP_COUNT; i++)
+    metricsSample(out, F("wifinfo_sink_requests"), true, metrics_sinks[i], httpsinkstat[i].requests);
+  metricsSample(out, F("wifinfo_sink_requests"), true, metrics_sinks[SINK_MQTT], mqttstat.published);
+
+  metricsFamily(out, F("wifinfo_sink_failures"), F("counter"), F("Requests failed or timed out"));
+  for (uint8_t i = 0; i < SINK_HTTP_COUNT; i++)
+    metricsSample(out, F("wifinfo_sink_failures"), true, metrics_sinks[i], httpsinkstat[i].failed);
+
+  metricsFamily(out, F("wifinfo_sink_dropped"), F("counter"), F("Records lost"));
+  for (uint8_t i = 0; i < SINK_HTTP_COUNT; i++)
+    metricsSample(out, F("wifinfo_sink_dropped"), true, metrics_sinks[i], httpsinkstat[i].dropped);
+  metricsSample(out, F("wifinfo_sink_dropped"), true, metrics_sinks[SINK_MQTT], mqttstat.dropped);
+
+  metricsFamily(out, F("wifinfo_sink_pending"), F("gauge"), F("Requests waiting in queue or spool"));
+  for (uint8_t i = 0; i < SINK_HTTP_COUNT; i++)
+    metricsSample(out, F("wifinfo_sink_pending"), false, metrics_sinks[i], httpSinkPending(i));
+}
+
+/* ======================================================================
+Function: metricsRender
+Purpose : send all metrics in OpenMetrics text format
+Input   : -
+Output  : -
+Comments: response must have been started with unknown length, text is
+          rendered in a stack buffer and sent in chunks, nothing is
+          allocated whatever the number of labels
+====================================================================== */
+void metricsRender(void)
+{
+  char buf[METRICS_CHUNK_SIZE];
+  PString out(buf, sizeof(buf));
+  unsigned long start = micros();
+  uint32_t elapsed;
+
+  metricsstat.scrapes++;
+  metricsstat.bytes = 0;
+
+  if (!tinfolabels.empty()) {
+    metricsMeter(out);
+    metricsValues(out);
+  }
+  metricsHealth(out);
+
+  out += F("# EOF\n");
+  metricsFlush(out, true);
+
+  elapsed = micros() - start;
+  if (elapsed > metricsstat.max_us)
+    metricsstat.max_us = elapsed;
+}
@@ -0,0 +1,45 @@
+// **********************************************************************************
+// ESP8266 Teleinfo Prometheus metrics Include file
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use , see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#ifndef METRICS_H
+#define METRICS_H
+
+// Include main project include file
+#include "Wifinfo.h"
+
+#define METRICS_CHUNK_SIZE    512   // rendered on stack, sent as one HTTP chunk
+#define METRICS_LINE_SIZE     128   // longest line we render
+#define METRICS_CONTENT_TYPE  "application/openmetrics-text; version=1.0.0; charset=utf-8"
+
+// Scrape statistics
+typedef struct
+{
+  uint32_t scrapes;       // /metrics requests
+  uint32_t chunks;        // chunks sent, all scrapes
+  uint16_t bytes;         // last scrape size
+  uint32_t max_us;        // worst scrape render and send time
+} _metricsstat;
+
+// Exported variables/object instancied in main sketch
+// ===================================================
+extern _metricsstat metricsstat;
+
+// declared exported function from metrics.cpp
+// ===================================================
+void metricsRender(void);
+
+#endif
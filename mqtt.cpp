@@ -0,0 +1,720 @@
+// **********************************************************************************
+// ESP8266 Teleinfo MQTT 3.1.1 client
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use , see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// One persistent session (clean session 0, client id is our hostname) is kept
+// with the broker. Messages are rendered in http_buffer, QoS 0 ones are written
+// right away and lost if we're not connected, QoS 1 ones are kept in a small
+// outbox until the broker acknowledge them, and sent again with DUP flag on
+// next session if the connection drops before.
+//
+// **********************************************************************************
+#include "mqtt.h"
+
+// Receive parser states
+enum
+{
+  MQTT_RX_TYPE = 0,   // first byte of packet
+  MQTT_RX_LENGTH,     // remaining length bytes
+  MQTT_RX_BODY        // variable header, only 2 first bytes kept
+};
+
+static WiFiClient mqtt_client;
+static _sinkaddr mqtt_addr;
+static uint8_t mqtt_state = MQTT_OFF;
+static unsigned long mqtt_start;      // millis() of CONNECT
+static unsigned long mqtt_last_tx;    // millis() of last packet sent
+static unsigned long mqtt_last_rx;    // millis() of last packet received
+static bool mqtt_ping;                // PINGREQ waiting for PINGRESP
+static unsigned long mqtt_ping_start; // millis() of PINGREQ
+static uint16_t mqtt_backoff;         // reconnect delay (s)
+static unsigned long mqtt_wait_start; // millis() when we started to wait
+static uint16_t mqtt_packet_id;
+
+// QoS 1 outbox, in order, mqtt_out_sent first ones have been written
+// to current session
+static _mqttmsg mqtt_outbox[MQTT_OUTBOX_COUNT];
+static uint8_t mqtt_out_head;
+static uint8_t mqtt_out_count;
+static uint8_t mqtt_out_sent;
+static uint16_t mqtt_arena_tail;
+static uint8_t mqtt_arena[MQTT_OUTBOX_SIZE];
+
+// Incoming packet
+static uint8_t mqtt_rx_state;
+static uint8_t mqtt_rx_type;
+static uint32_t mqtt_rx_left;
+static uint8_t mqtt_rx_shift;
+static uint8_t mqtt_rx[2];
+static uint8_t mqtt_rx_len;
+
+_mqttstat mqttstat;
+
+/* ======================================================================
+Function: mqttClose
+Purpose : drop broker connection
+Input   : true if broker is failing, so we wait longer before retrying
+Output  : -
+Comments: QoS 1 packets not acknowledged will go again on next session
+====================================================================== */
+static void mqttClose(bool failed)
+{
+  mqtt_client.stop();
+  mqtt_state = *config.mqtt.host ? MQTT_DOWN : MQTT_OFF;
+  mqtt_out_sent = 0;
+  mqtt_ping = false;
+  mqtt_rx_state = MQTT_RX_TYPE;
+
+  if (failed)
+    mqtt_backoff = mqtt_backoff ? min(mqtt_backoff * 2, MQTT_BACKOFF_MAX) : MQTT_BACKOFF_MIN;
+  mqtt_wait_start = millis();
+}
+
+/* ======================================================================
+Function: mqttWrite
+Purpose : write a whole packet to broker
+Input   : packet
+          packet size
+Output  : true if written
+Comments: connection is dropped on error
+====================================================================== */
+static bool mqttWrite(const uint8_t * packet, uint16_t size)
+{
+  if (mqtt_client.write(packet, size) != size) {
+    DebuglnF("MQTT write failed");
+    mqttClose(true);
+    return false;
+  }
+  mqtt_last_tx = millis();
+  return true;
+}
+
+/* ======================================================================
+Function: mqttString
+Purpose : render a MQTT string (length then chars)
+Input   : where to render
+          string
+Output  : after string
+Comments: -
+====================================================================== */
+static uint8_t * mqttString(uint8_t * p, const char * s)
+{
+  uint16_t len = strlen(s);
+
+  *p++ = len >> 8;
+  *p++ = len & 0xFF;
+  memcpy(p, s, len);
+  return p + len;
+}
+
+/* ======================================================================
+Function: mqttHeader
+Purpose : put PUBLISH fixed and variable header before a payload
+Input   : payload, at least MQTT_HEAD_ROOM after buffer start
+          payload size
+          MQTT_PUB_xxx flags
+          topic
+          packet identifier (QoS 1 only)
+          where to put packet size
+Output  : packet start
+Comments: payload is less than 16K, so remaining length fits in 2 bytes
+====================================================================== */
+static uint8_t * mqttHeader(uint8_t * payload, uint16_t len, uint8_t flags,
+                            const char * topic, uint16_t id, uint16_t * size)
+{
+  uint16_t tlen = strlen(topic);
+  uint16_t remain = 2 + tlen + (id ? 2 : 0) + len;
+  uint8_t * p = payload;
+
+  if (id) {
+    *--p = id & 0xFF;
+    *--p = id >> 8;
+  }
+  p -= tlen;
+  memcpy(p, topic, tlen);
+  *--p = tlen & 0xFF;
+  *--p = tlen >> 8;
+
+  if (remain >= 128) {
+    *--p = remain >> 7;
+    *--p = (remain & 0x7F) | 0x80;
+  } else {
+    *--p = remain;
+  }
+  *--p = MQTT_PUBLISH | flags;
+
+  *size = payload + len - p;
+  return p;
+}
+
+/* ======================================================================
+Function: mqttAlloc
+Purpose : add a packet to QoS 1 outbox
+Input   : packet identifier
+          packet size
+Output  : where to copy packet, NULL if no room
+Comments: arena is managed by ringAlloc() like httpqueue one
+====================================================================== */
+static uint8_t * mqttAlloc(uint16_t id, uint16_t size)
+{
+  uint16_t offset;
+  _mqttmsg * msg;
+
+  if (mqtt_out_count >= MQTT_OUTBOX_COUNT)
+    return NULL;
+
+  offset = ringAlloc(MQTT_OUTBOX_SIZE, &mqtt_arena_tail, mqtt_outbox[mqtt_out_head].offset,
+                     !mqtt_out_count, size);
+  if (offset == MQTT_OUTBOX_SIZE)
+    return NULL;
+
+  msg = &mqtt_outbox[(mqtt_out_head + mqtt_out_count) % MQTT_OUTBOX_COUNT];
+  msg->id = id;
+  msg->offset = offset;
+  msg->size = size;
+  msg->sent = 0;
+
+  if (++mqtt_out_count > mqttstat.max_inflight)
+    mqttstat.max_inflight = mqtt_out_count;
+
+  return mqtt_arena + offset;
+}
+
+/* ======================================================================
+Function: mqttAcked
+Purpose : handle a PUBACK
+Input   : packet identifier
+Output  : -
+Comments: outbox is freed up to first packet not acknowledged
+====================================================================== */
+static void mqttAcked(uint16_t id)
+{
+  for (uint8_t i = 0; i < mqtt_out_sent; i++) {
+    _mqttmsg * msg = &mqtt_outbox[(mqtt_out_head + i) % MQTT_OUTBOX_COUNT];
+
+    if (msg->id == id) {
+      msg->id = 0;
+      mqttstat.acked++;
+      break;
+    }
+  }
+
+  while (mqtt_out_sent && !mqtt_outbox[mqtt_out_head].id) {
+    mqtt_out_head = (mqtt_out_head + 1) % MQTT_OUTBOX_COUNT;
+    mqtt_out_sent--;
+    if (!--mqtt_out_count)
+      mqtt_arena_tail = 0;
+  }
+}
+
+/* ======================================================================
+Function: mqttFlush
+Purpose : write outbox packets not sent in this session
+Input   : -
+Output  : -
+Comments: a few at a time, packets of a previous session get DUP flag
+====================================================================== */
+static void mqttFlush(void)
+{
+  for (uint8_t n = 0; n < MQTT_SEND_BURST && mqtt_out_sent < mqtt_out_count; n++) {
+    _mqttmsg * msg = &mqtt_outbox[(mqtt_out_head + mqtt_out_sent) % MQTT_OUTBOX_COUNT];
+    uint8_t * packet = mqtt_arena + msg->offset;
+
+    // Acknowledged in previous session, behind one that was not
+    if (!msg->id) {
+      mqtt_out_sent++;
+      continue;
+    }
+
+    if (msg->sent) {
+      *packet |= MQTT_PUB_DUP;
+      mqttstat.resent++;
+    }
+    if (!mqttWrite(packet, msg->size))
+      return;
+    msg->sent = millis() | 1;
+    mqtt_out_sent++;
+  }
+}
+
+/* ======================================================================
+Function: mqttPublish
+Purpose : publish a message rendered in http_buffer
+Input   : topic
+          rendered payload, starting at http_buffer + MQTT_HEAD_ROOM
+          true if message has to be retained
+Output  : true if message has been sent or queued
+Comments: QoS 0 message is lost when we're not connected
+====================================================================== */
+static bool mqttPublish(const char * topic, PString & payload, bool retain)
+{
+  uint8_t flags = retain ? MQTT_PUB_RETAIN : 0;
+  uint16_t id = 0;
+  uint8_t * packet;
+  uint16_t size;
+
+  if (payload.overflow()) {
+    Debugf("MQTT %s payload too long (%u)\r\n", topic, (unsigned) payload.length());
+    mqttstat.dropped++;
+    return false;
+  }
+
+  if (config.mqtt.qos) {
+    flags |= MQTT_PUB_QOS1;
+    if (!++mqtt_packet_id)
+      mqtt_packet_id = 1;
+    id = mqtt_packet_id;
+  }
+
+  packet = mqttHeader((uint8_t *) http_buffer + MQTT_HEAD_ROOM, payload.length(),
+                      flags, topic, id, &size);
+
+  if (id) {
+    uint8_t * p = mqttAlloc(id, size);
+
+    if (!p) {
+      mqttstat.dropped++;
+      return false;
+    }
+    memcpy(p, packet, size);
+    mqttstat.published++;
+    if (mqtt_state == MQTT_UP)
+      mqttFlush();
+    return true;
+  }
+
+  if (mqtt_state != MQTT_UP || !mqttWrite(packet, size)) {
+    mqttstat.dropped++;
+    return false;
+  }
+  mqttstat.published++;
+  return true;
+}
+
+/* ======================================================================
+Function: mqttStatus
+Purpose : publish our state on retained status topic
+Input   : -
+Output  : -
+Comments: only when last will is set, so broker clears it on our death
+====================================================================== */
+static void mqttStatus(void)
+{
+  char topic[CFG_MQTT_TOPIC_SIZE + sizeof(MQTT_STATUS_TOPIC)];
+  uint8_t * packet;
+  uint16_t size;
+
+  sprintf_P(topic, PSTR("%s" MQTT_STATUS_TOPIC), config.mqtt.topic);
+  memcpy_P(http_buffer + MQTT_HEAD_ROOM, PSTR(MQTT_ONLINE), sizeof(MQTT_ONLINE) - 1);
+  packet = mqttHeader((uint8_t *) http_buffer + MQTT_HEAD_ROOM, sizeof(MQTT_ONLINE) - 1,
+                      MQTT_PUB_RETAIN, topic, 0, &size);
+  mqttWrite(packet, size);
+}
+
+/* ======================================================================
+Function: mqttConnect
+Purpose : open broker connection and send CONNECT
+Input   : -
+Output  : true if CONNECT has been sent
+Comments: SDK connect is blocking, so we use a resolved address and
+          a short timeout, UART buffer hold the teleinfo meanwhile
+====================================================================== */
+static bool mqttConnect(void)
+{
+  uint8_t * start = (uint8_t *) http_buffer + 8;
+  uint8_t * p = start;
+  uint8_t flags = 0;
+  uint16_t remain;
+
+  if (!sinkResolve(&mqtt_addr, config.mqtt.host))
+    return false;
+
+  mqttstat.connects++;
+  mqtt_client.setTimeout(MQTT_CONNECT_TIMEOUT);
+  if (!mqtt_client.connect(mqtt_addr.ip, config.mqtt.port)) {
+    // Broker may have changed address, looked up again after a few
+    sinkConnected(&mqtt_addr, false);
+    return false;
+  }
+  sinkConnected(&mqtt_addr, true);
+  mqtt_client.setNoDelay(true);
+
+  // Variable header, protocol level 4 is 3.1.1
+  p = mqttString(p, "MQTT");
+  *p++ = 4;
+  if (config.mqtt.mode & CFG_MQTT_LWT)
+    flags |= 0x04 | 0x20;   // Will flag, will retain, will QoS 0
+  if (*config.mqtt.usr) {
+    flags |= 0x80;
+    if (*config.mqtt.pwd)
+      flags |= 0x40;
+  }
+  *p++ = flags;             // Clean session 0, broker keeps our QoS 1 state
+  *p++ = config.mqtt.keepalive >> 8;
+  *p++ = config.mqtt.keepalive & 0xFF;
+
+  // Payload
+  p = mqttString(p, config.host);
+  if (flags & 0x04) {
+    char topic[CFG_MQTT_TOPIC_SIZE + sizeof(MQTT_STATUS_TOPIC)];
+
+    sprintf_P(topic, PSTR("%s" MQTT_STATUS_TOPIC), config.mqtt.topic);
+    p = mqttString(p, topic);
+    p = mqttString(p, MQTT_OFFLINE);
+  }
+  if (flags & 0x80)
+    p = mqttString(p, config.mqtt.usr);
+  if (flags & 0x40)
+    p = mqttString(p, config.mqtt.pwd);
+
+  // Fixed header, CONNECT is less than 16K
+  remain = p - start;
+  if (remain >= 128) {
+    *--start = remain >> 7;
+    *--start = (remain & 0x7F) | 0x80;
+  } else {
+    *--start = remain;
+  }
+  *--start = MQTT_CONNECT;
+
+  mqtt_rx_state = MQTT_RX_TYPE;
+  mqtt_ping = false;
+  mqtt_start = millis();
+  mqtt_last_rx = mqtt_start;
+  if (!mqttWrite(start, p - start))
+    return false;
+
+  mqtt_state = MQTT_WAIT_CONNACK;
+  return true;
+}
+
+/* ======================================================================
+Function: mqttPacket
+Purpose : handle a packet received from broker
+Input   : -
+Output  : -
+Comments: packet type is in mqtt_rx_type, 2 first bytes in mqtt_rx
+====================================================================== */
+static void mqttPacket(void)
+{
+  mqtt_last_rx = millis();
+
+  switch (mqtt_rx_type & 0xF0) {
+    case MQTT_CONNACK:
+      if (mqtt_state != MQTT_WAIT_CONNACK)
+        break;
+      if (mqtt_rx_len < 2 || mqtt_rx[1]) {
+        Debugf("MQTT refused (%d)\r\n", mqtt_rx_len < 2 ? -1 : mqtt_rx[1]);
+        mqttClose(true);
+        break;
+      }
+      Debugf("MQTT connected in %lu ms%s\r\n", millis() - mqtt_start,
+             mqtt_rx[0] & 0x01 ? " (session present)" : "");
+      mqttstat.sessions++;
+      mqtt_state = MQTT_UP;
+      mqtt_backoff = 0;
+      if (config.mqtt.mode & CFG_MQTT_LWT)
+        mqttStatus();
+      break;
+
+    case MQTT_PUBACK:
+      if (mqtt_rx_len >= 2)
+        mqttAcked((mqtt_rx[0] << 8) | mqtt_rx[1]);
+      break;
+
+    case MQTT_PINGRESP:
+      mqtt_ping = false;
+      break;
+  }
+}
+
+/* ======================================================================
+Function: mqttRead
+Purpose : parse bytes received from broker
+Input   : -
+Output  : -
+Comments: we only get small packets (CONNACK, PUBACK, PINGRESP), bodies
+          of anything else are skipped
+====================================================================== */
+static void mqttRead(void)
+{
+  while (mqtt_state >= MQTT_WAIT_CONNACK && mqtt_client.available()) {
+    uint8_t c = mqtt_client.read();
+
+    switch (mqtt_rx_state) {
+      case MQTT_RX_TYPE:
+        mqtt_rx_type = c;
+        mqtt_rx_left = 0;
+        mqtt_rx_shift = 0;
+        mqtt_rx_len = 0;
+        mqtt_rx_state = MQTT_RX_LENGTH;
+        break;
+
+      case MQTT_RX_LENGTH:
+        mqtt_rx_left |= (uint32_t) (c & 0x7F) << mqtt_rx_shift;
+        mqtt_rx_shift += 7;
+        if (c & 0x80) {
+          // Remaining length is 4 bytes max
+          if (mqtt_rx_shift > 21)
+            mqttClose(true);
+          break;
+        }
+        mqtt_rx_state = MQTT_RX_BODY;
+        if (!mqtt_rx_left) {
+          mqtt_rx_state = MQTT_RX_TYPE;
+          mqttPacket();
+        }
+        break;
+
+      case MQTT_RX_BODY:
+        if (mqtt_rx_len < sizeof(mqtt_rx))
+          mqtt_rx[mqtt_rx_len++] = c;
+        if (!--mqtt_rx_left) {
+          mqtt_rx_state = MQTT_RX_TYPE;
+          mqttPacket();
+        }
+        break;
+    }
+  }
+}
+
+/* ======================================================================
+Function: mqttHandle
+Purpose : keep broker session alive
+Input   : -
+Output  : -
+Comments: called from main loop, never blocks except on TCP connect
+====================================================================== */
+void mqttHandle(void)
+{
+  unsigned long keepalive = config.mqtt.keepalive * 1000UL;
+
+  switch (mqtt_state) {
+    case MQTT_OFF:
+      break;
+
+    case MQTT_DOWN:
+      if (millis() - mqtt_wait_start < mqtt_backoff * 1000UL)
+        break;
+      if (!mqttConnect())
+        mqttClose(true);
+      break;
+
+    case MQTT_WAIT_CONNACK:
+      mqttRead();
+      if (mqtt_state == MQTT_WAIT_CONNACK &&
+          (!mqtt_client.connected() || millis() - mqtt_start >= MQTT_CONNACK_TIMEOUT)) {
+        DebuglnF("MQTT no CONNACK");
+        mqttClose(true);
+      }
+      break;
+
+    case MQTT_UP:
+      mqttRead();
+      if (mqtt_state != MQTT_UP)
+        break;
+
+      if (!mqtt_client.connected()) {
+        DebuglnF("MQTT connection lost");
+        mqttClose(true);
+        break;
+      }
+
+      // Broker do not answer anymore, a new session will resend
+      if ((mqtt_ping && millis() - mqtt_ping_start >= keepalive / 2) ||
+          (mqtt_out_sent && millis() - mqtt_outbox[mqtt_out_head].sent >= MQTT_PUBACK_TIMEOUT)) {
+        DebuglnF("MQTT broker timeout");
+        mqttClose(true);
+        break;
+      }
+
+      mqttFlush();
+
+      // Ping when we're quiet, or broker is, to know it's still there
+      if (keepalive && !mqtt_ping && mqtt_state == MQTT_UP &&
+          (millis() - mqtt_last_tx >= keepalive / 2 || millis() - mqtt_last_rx >= keepalive / 2)) {
+        static const uint8_t pingreq[2] = { MQTT_PINGREQ, 0 };
+
+        if (mqttWrite(pingreq, sizeof(pingreq))) {
+          mqtt_ping = true;
+          mqtt_ping_start = millis();
+        }
+      }
+      break;
+  }
+}
+
+/* ======================================================================
+Function: mqttEscape
+Purpose : render a text value as JSON string content
+Input   : where to render
+          text
+Output  : -
+Comments: quotes and backslashes are escaped, control chars are 
+          dropped, as logReadText() does
+====================================================================== */
+static void mqttEscape(PString & out, const char * text)
+{
+  for (; *text; text++) {
+    if (*text == '"' || *text == '\\')
+      out += '\\';
+    if ((uint8_t) *text >= ' ')
+      out += *text;
+  }
+}
+
+/* ======================================================================
+Function: mqttPost
+Purpose : publish teleinfo to broker
+Input   : -
+Output  : true if messages have been sent or queued
+Comments: domoticz/in messages and/or one message with whole frame
+====================================================================== */
+boolean mqttPost(void)
+{
+  boolean ret = true;
+  uint32_t dirty;
+  uint32_t pushed = 0;
+
+  if (mqtt_state == MQTT_OFF || !tinfoframe.valid)
+    return false;
+
+  dirty = tinfoFrameDirty(SINK_MQTT);
+
+  if (config.mqtt.mode & CFG_MQTT_DOMOTICZ) {
+    PString msg(http_buffer + MQTT_HEAD_ROOM, HTTP_BUFFER_SIZE - MQTT_HEAD_ROOM);
+
+    // {"command":"switchlight","idx":IDX,"switchcmd":"On"}
+    if (config.domoticz.idx_txt && (tinfoframe.ptec == PTEC_HP || tinfoframe.ptec == PTEC_HC) &&
+        tinfoFrameDue(SINK_MQTT, dirty, FRAME_PTEC)) {
+      msg.begin();
+      msg += F("{\"command\":\"switchlight\",\"idx\":");
+      msg.appendUInt(config.domoticz.idx_txt);
+      msg += F(",\"switchcmd\":\"");
+      msg += tinfoframe.ptec == PTEC_HP ? F("On") : F("Off");
+      msg += F("\"}");
+      if (mqttPublish(MQTT_DOMOTICZ_TOPIC, msg, false))
+        pushed |= FRAME_PTEC;
+      else
+        ret = false;
+    }
+
+    // {"idx":IDX,"nvalue":0,"svalue":"VALUE"}
+    for (uint8_t dev = 0; dev < DMCZ_DEVICES; dev++) {
+      uint32_t mask;
+      uint16_t idx = domoticzDevice(dev, &mask);
+
+      if (!idx || !tinfoFrameDue(SINK_MQTT, dirty, mask))
+        continue;
+
+      msg.begin();
+      msg += F("{\"idx\":");
+      msg.appendUInt(idx);
+      msg += F(",\"nvalue\":0,\"svalue\":\"");
+      domoticzValue(dev, msg);
+      msg += F("\"}");
+      if (mqttPublish(MQTT_DOMOTICZ_TOPIC, msg, false))
+        pushed |= mask;
+      else
+        ret = false;
+    }
+  }
+
+  // {"_UPTIME":SEC,"LABEL":NUMBER,"LABEL":"TEXT",...}
+  if ((config.mqtt.mode & CFG_MQTT_FRAME) && *config.mqtt.topic &&
+      tinfoFrameDue(SINK_MQTT, dirty, dirty)) {
+    PString msg(http_buffer + MQTT_HEAD_ROOM, HTTP_BUFFER_SIZE - MQTT_HEAD_ROOM);
+    uint32_t number;
+
+    msg += F("{\"_UPTIME\":");
+    msg.appendUInt(seconds);
+
+    for (uint8_t id = 0; id < LABEL_COUNT; id++) {
+      if (!tinfolabels.has(id))
+        continue;
+
+      msg += F(",\"");
+      msg += TInfoLabels::labelName(id);
+      msg += F("\":");
+      if (tinfoFrameNumber(id, &number)) {
+        msg.appendUInt(number);
+      } else {
+        msg += '"';
+        mqttEscape(msg, tinfolabels.get(id));
+        msg += '"';
+      }
+    }
+
+    for (uint8_t i = 0; i < tinfolabels.extraCount(); i++) {
+      msg += F(",\"");
+      mqttEscape(msg, tinfolabels.extraName(i));
+      msg += F("\":\"");
+      mqttEscape(msg, tinfolabels.extraValue(i));
+      msg += '"';
+    }
+    msg += '}';
+
+    if (mqttPublish(config.mqtt.topic, msg, config.mqtt.mode & CFG_MQTT_RETAIN))
+      pushed |= dirty;
+    else
+      ret = false;
+  }
+
+  tinfoFramePushed(SINK_MQTT, pushed);
+  return ret;
+}
+
+/* ======================================================================
+Function: mqttSetup
+Purpose : (re)start broker session from config
+Input   : -
+Output  : -
+Comments: called at boot and when config changed, outbox is kept
+====================================================================== */
+void mqttSetup(void)
+{
+  if (mqtt_state == MQTT_UP) {
+    static const uint8_t disconnect[2] = { MQTT_DISCONNECT, 0 };
+    mqttWrite(disconnect, sizeof(disconnect));
+  }
+
+  sinkForget(&mqtt_addr);
+  mqtt_backoff = 0;
+  mqttClose(false);
+}
+
+/* ======================================================================
+Function: mqttState
+Purpose : get broker session state
+Input   : -
+Output  : MQTT_xxx state
+Comments: -
+====================================================================== */
+uint8_t mqttState(void)
+{
+  return mqtt_state;
+}
+
+/* ======================================================================
+Function: mqttInflight
+Purpose : get QoS 1 messages not acknowledged yet
+Input   : -
+Output  : message count
+Comments: -
+====================================================================== */
+uint8_t mqttInflight(void)
+{
+  return mqtt_out_count;
+}
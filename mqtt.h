@@ -0,0 +1,95 @@
+// **********************************************************************************
+// ESP8266 Teleinfo MQTT 3.1.1 client Include file
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use , see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#ifndef MQTT_H
+#define MQTT_H
+
+// Include main project include file
+#include "Wifinfo.h"
+
+#define MQTT_HEAD_ROOM        80    // before payload in http_buffer, for PUBLISH header and topic
+#define MQTT_OUTBOX_SIZE      3072  // bytes shared by QoS 1 packets not acknowledged
+#define MQTT_OUTBOX_COUNT     16    // max QoS 1 packets not acknowledged
+#define MQTT_CONNECT_TIMEOUT  1000  // TCP connect (ms), blocking in SDK
+#define MQTT_CONNACK_TIMEOUT  5000  // broker answer to CONNECT (ms)
+#define MQTT_PUBACK_TIMEOUT   10000 // broker answer to PUBLISH (ms) before we reconnect
+#define MQTT_BACKOFF_MIN      5     // first reconnect delay (s)
+#define MQTT_BACKOFF_MAX      300   // reconnect delay cap (s)
+#define MQTT_SEND_BURST       4     // max QoS 1 packets written per call
+
+#define MQTT_DOMOTICZ_TOPIC   "domoticz/in"
+#define MQTT_STATUS_TOPIC     "/status"  // after config topic, last will and state
+#define MQTT_ONLINE           "online"
+#define MQTT_OFFLINE          "offline"
+
+// Control packet types (first byte, high nibble)
+#define MQTT_CONNECT          0x10
+#define MQTT_CONNACK          0x20
+#define MQTT_PUBLISH          0x30
+#define MQTT_PUBACK           0x40
+#define MQTT_PINGREQ          0xC0
+#define MQTT_PINGRESP         0xD0
+#define MQTT_DISCONNECT       0xE0
+
+// PUBLISH flags (first byte, low nibble)
+#define MQTT_PUB_RETAIN       0x01
+#define MQTT_PUB_QOS1         0x02
+#define MQTT_PUB_DUP          0x08
+
+// Session states
+enum
+{
+  MQTT_OFF = 0,     // no broker configured
+  MQTT_DOWN,        // not connected, waiting to retry
+  MQTT_WAIT_CONNACK,// CONNECT sent
+  MQTT_UP           // session opened
+};
+
+// One QoS 1 packet waiting for its PUBACK
+typedef struct
+{
+  uint16_t      id;       // packet identifier, 0 once acknowledged
+  uint16_t      offset;   // packet offset in outbox
+  uint16_t      size;     // whole packet size
+  unsigned long sent;     // millis() when written to socket
+} _mqttmsg;
+
+// Client statistics
+typedef struct
+{
+  uint32_t connects;      // CONNECT sent
+  uint32_t sessions;      // CONNACK accepted
+  uint32_t published;     // new PUBLISH
+  uint32_t acked;         // PUBACK received
+  uint32_t resent;        // QoS 1 PUBLISH sent again on new session
+  uint32_t dropped;       // messages lost, not connected or outbox full
+  uint8_t  max_inflight;  // max QoS 1 packets waiting seen
+} _mqttstat;
+
+// Exported variables/object instancied in main sketch
+// ===================================================
+extern _mqttstat mqttstat;
+
+// declared exported function from mqtt.cpp
+// ===================================================
+boolean mqttPost(void);
+void mqttHandle(void);
+void mqttSetup(void);
+uint8_t mqttState(void);
+uint8_t mqttInflight(void);
+
+#endif
@@ -0,0 +1,175 @@
+// **********************************************************************************
+// ESP8266 Teleinfo cooperative scheduler
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use, see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+
+#include "sched.h"
+
+// Tasks, TASK_xxx order is priority order
+_schedtask schedtask[TASK_COUNT];
+
+/* ======================================================================
+Function: schedRegister
+Purpose : declare a task
+Input   : task (TASK_xxx)
+          name
+          task body
+          stage (STAGE_xxx) to account run time in, STAGE_COUNT if none
+          expected worst run time, 0 for default
+Output  : -
+Comments: task is not armed, see schedSet() and schedTrigger()
+====================================================================== */
+void schedRegister(uint8_t task, const char * name, void (*run)(void), uint8_t stage, uint32_t budget_us)
+{
+  _schedtask * t = &schedtask[task];
+
+  memset(t, 0, sizeof(_schedtask));
+  t->name = name;
+  t->run = run;
+  t->stage = stage;
+  t->budget_us = budget_us ? budget_us : SCHED_TASK_BUDGET_US;
+}
+
+/* ======================================================================
+Function: schedSet
+Purpose : set period of a task
+Input   : task (TASK_xxx)
+          period (ms), 0 to stop it
+Output  : -
+Comments: first run is one period later plus a phase depending on
+          task, so sinks with same period don't fire in same pass
+====================================================================== */
+void schedSet(uint8_t task, uint32_t period_ms)
+{
+  _schedtask * t = &schedtask[task];
+
+  t->period_ms = period_ms;
+  t->armed = period_ms != 0;
+  if (t->armed)
+    t->due_ms = millis() + period_ms + (task * SCHED_PHASE_MS) % period_ms;
+}
+
+/* ======================================================================
+Function: schedTrigger
+Purpose : make a task due now
+Input   : task (TASK_xxx)
+Output  : -
+Comments: a task without period runs once, a periodic one is due
+          again one period after this run
+====================================================================== */
+void schedTrigger(uint8_t task)
+{
+  _schedtask * t = &schedtask[task];
+
+  if (!t->armed || (long) (t->due_ms - millis()) > 0) {
+    t->due_ms = millis();
+    t->armed = true;
+  }
+}
+
+/* ======================================================================
+Function: schedNext
+Purpose : find task to run
+Input   : current time
+Output  : task index, TASK_COUNT if none is due
+Comments: first due task in priority order
+====================================================================== */
+static uint8_t schedNext(unsigned long now)
+{
+  for (uint8_t i = 0; i < TASK_COUNT; i++) {
+    if (schedtask[i].run && schedtask[i].armed && (long) (now - schedtask[i].due_ms) >= 0)
+      return i;
+  }
+  return TASK_COUNT;
+}
+
+/* ======================================================================
+Function: schedHandle
+Purpose : run due tasks
+Input   : -
+Output  : -
+Comments: to be called from main loop, after serial ingestion
+          tasks run while pass budget allows it, first one always runs
+          so a task longer than budget is never starved
+====================================================================== */
+void schedHandle(void)
+{
+  unsigned long pass = micros();
+  bool ran = false;
+  uint8_t i;
+
+  while ((i = schedNext(millis())) < TASK_COUNT) {
+    _schedtask * t = &schedtask[i];
+    unsigned long now = millis();
+    unsigned long start;
+    uint32_t late = now - t->due_ms;
+    uint32_t elapsed;
+
+    // Not enough time left in this pass, all due tasks wait next one
+    if (ran && micros() - pass + t->budget_us > SCHED_PASS_BUDGET_US) {
+      for (uint8_t j = i; j < TASK_COUNT; j++) {
+        if (schedtask[j].armed && (long) (now - schedtask[j].due_ms) >= 0)
+          schedtask[j].deferred++;
+      }
+      break;
+    }
+
+    // Next deadline first, task may change its own period
+    if (t->period_ms) {
+      uint32_t periods = late / t->period_ms;
+
+      t->missed += periods;
+      t->due_ms += (periods + 1) * t->period_ms;
+    } else {
+      t->armed = false;
+    }
+
+    start = micros();
+    t->run();
+    elapsed = micros() - start;
+    ran = true;
+
+    if (t->stage < STAGE_COUNT)
+      stageAccount(t->stage, start);
+
+    t->runs++;
+    t->total_us += elapsed;
+    if (elapsed > t->max_us)
+      t->max_us = elapsed;
+    if (elapsed > t->budget_us)
+      t->over++;
+    t->late_ms += late;
+    if (late > t->late_max_ms)
+      t->late_max_ms = late;
+  }
+}
+
+/* ======================================================================
+Function: schedReset
+Purpose : clear tasks statistics
+Input   : -
+Output  : -
+Comments: -
+====================================================================== */
+void schedReset(void)
+{
+  for (uint8_t i = 0; i < TASK_COUNT; i++) {
+    _schedtask * t = &schedtask[i];
+
+    t->runs = t->total_us = t->max_us = t->over = 0;
+    t->late_ms = t->late_max_ms = t->missed = t->deferred = 0;
+  }
+}
@@ -0,0 +1,74 @@
+// **********************************************************************************
+// ESP8266 Teleinfo cooperative scheduler Include file
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use , see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#ifndef SCHED_H
+#define SCHED_H
+
+// Include main project include file
+#include "Wifinfo.h"
+
+#define SCHED_PASS_BUDGET_US  20000 // time tasks may take in one loop() pass
+#define SCHED_TASK_BUDGET_US  10000 // default expected worst run time of a task
+#define SCHED_PHASE_MS        1500  // offset between tasks of same period
+
+// Scheduled tasks, when several are due first one runs first
+// Sink tasks come last, from TASK_SINK_FIRST, replay drives them
+enum {
+  TASK_SYSINFO = 0, // uptime and sysinfo, every second
+  TASK_EMONCMS,     // emoncmsPost()
+  TASK_JEEDOM,      // jeedomPost()
+  TASK_DOMOTICZ,    // domoticzPost()
+  TASK_MQTT,        // mqttPost()
+  TASK_INFLUX,      // influxPost()
+  TASK_COUNT,
+  TASK_SINK_FIRST = TASK_EMONCMS
+};
+
+// One scheduled task
+typedef struct
+{
+  const char *  name;       // for statistics
+  void       (* run)(void); // task body
+  uint8_t       stage;      // STAGE_xxx its run time is accounted in, STAGE_COUNT if none
+  uint32_t      budget_us;  // expected worst run time
+  uint32_t      period_ms;  // 0 if not periodic
+  unsigned long due_ms;     // millis() deadline
+  bool          armed;      // due_ms is valid
+  // Statistics
+  uint32_t      runs;       // times it ran
+  uint32_t      total_us;   // cumulated run time
+  uint32_t      max_us;     // worst run time
+  uint32_t      over;       // runs longer than budget
+  uint32_t      late_ms;    // cumulated lateness
+  uint32_t      late_max_ms;// worst lateness
+  uint32_t      missed;     // periods skipped because we were too late
+  uint32_t      deferred;   // passes it was due but had no budget left
+} _schedtask;
+
+// Exported variables/object instancied in main sketch
+// ===================================================
+extern _schedtask schedtask[TASK_COUNT];
+
+// declared exported function from sched.cpp
+// ===================================================
+void schedRegister(uint8_t task, const char * name, void (*run)(void), uint8_t stage, uint32_t budget_us);
+void schedSet(uint8_t task, uint32_t period_ms);
+void schedTrigger(uint8_t task);
+void schedHandle(void);
+void schedReset(void);
+
+#endif
@@ -0,0 +1,428 @@
+// **********************************************************************************
+// ESP8266 Teleinfo Server-Sent Events
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use, see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+
+#include "sse.h"
+
+// Push statistics
+_ssestat ssestat;
+
+static _sseclient sse_clients[SSE_CLIENTS];
+
+// Changed values of last frame, rendered once for all clients
+static char     sse_delta[SSE_DELTA_SIZE];
+static uint16_t sse_delta_len;    // 0 if nothing changed
+static bool     sse_delta_trunc;  // did not fit, whole frame goes instead
+
+/* ======================================================================
+Function: sseClose
+Purpose : free a client slot
+Input   : client
+Output  : -
+Comments: -
+====================================================================== */
+static void sseClose(_sseclient * c)
+{
+  c->client.stop();
+  c->client = WiFiClient();
+  c->active = false;
+  ssestat.clients--;
+}
+
+/* ======================================================================
+Function: sseWrite
+Purpose : write to a client what is in staging buffer
+Input   : client
+          staging buffer and its length
+Output  : false if the stack did not take it all
+Comments: -
+====================================================================== */
+static bool sseWrite(_sseclient * c, const char * buf, size_t len)
+{
+  size_t sent = c->client.write((const uint8_t *) buf, len);
+
+  ssestat.bytes += sent;
+  return sent == len;
+}
+
+/* ======================================================================
+Function: sseHead
+Purpose : render head of an event
+Input   : where to render, at least SSE_EVENT_HEAD
+          event name
+Output  : its length
+Comments: -
+====================================================================== */
+static size_t sseHead(char * buf, PGM_P event)
+{
+  size_t n;
+
+  strcpy_P(buf, PSTR("event: "));
+  strcat_P(buf, event);
+  n = strlen(buf);
+  n += sprintf_P(buf + n, PSTR("\nid: %lu\ndata: "), (unsigned long) tinfo_frames);
+  return n;
+}
+
+/* ======================================================================
+Function: sseEvent
+Purpose : send one event to a client
+Input   : client
+          event name
+          JSON body and its length
+Output  : false if the stack did not take it all
+Comments: CR and LF are removed from body, it has to be on a single
+          data line, JSON does not need them anyway
+====================================================================== */
+static bool sseEvent(_sseclient * c, PGM_P event, const char * body, uint16_t len)
+{
+  char buf[SSE_CHUNK_SIZE];
+  size_t n = sseHead(buf, event);
+
+  for (uint16_t i = 0; i < len; i++) {
+    if (body[i] == '\r' || body[i] == '\n')
+      continue;
+    if (n == sizeof(buf)) {
+      if (!sseWrite(c, buf, n))
+        return false;
+      n = 0;
+    }
+    buf[n++] = body[i];
+  }
+  if (n + 2 > sizeof(buf)) {
+    if (!sseWrite(c, buf, n))
+      return false;
+    n = 0;
+  }
+  buf[n++] = '\n';
+  buf[n++] = '\n';
+  return sseWrite(c, buf, n);
+}
+
+// Event data written to a client, CR and LF removed as sseEvent() does
+class SSEData : public Print
+{
+private:
+  _sseclient * _c;
+  bool         _failed;
+
+public:
+  SSEData(_sseclient * c) : _c(c), _failed(false) {}
+  inline bool failed(void) { return _failed; }
+
+  virtual size_t write(uint8_t c) { return write(&c, 1); }
+  virtual size_t write(const uint8_t *buffer, size_t size)
+  {
+    char buf[SSE_CHUNK_SIZE];
+    size_t n = 0;
+
+    for (size_t i = 0; i < size && !_failed; i++) {
+      if (buffer[i] == '\r' || buffer[i] == '\n')
+        continue;
+      buf[n++] = buffer[i];
+      if (n == sizeof(buf)) {
+        _failed = !sseWrite(_c, buf, n);
+        n = 0;
+      }
+    }
+    if (n && !_failed)
+      _failed = !sseWrite(_c, buf, n);
+    return _failed ? 0 : size;
+  }
+};
+
+/* ======================================================================
+Function: sseEventRender
+Purpose : send one event to a client, body rendered on the fly
+Input   : client
+          event name
+          body renderer
+Output  : false if the stack did not take it all
+Comments: for a body that is not in frame cache
+====================================================================== */
+static bool sseEventRender(_sseclient * c, PGM_P event, void (*render)(JSONWriter &))
+{
+  char buf[SSE_EVENT_HEAD];
+  SSEData data(c);
+  JSONWriter out(data);
+
+  if (!sseWrite(c, buf, sseHead(buf, event)))
+    return false;
+  render(out);
+  out.flush();
+  return !data.failed() && sseWrite(c, "\n\n", 2);
+}
+
+/* ======================================================================
+Function: sseFull
+Purpose : whole frame body
+Input   : where to put its size
+Output  : body, NULL if it is not in frame cache
+Comments: size is then the one sseEventRender() will send at most
+====================================================================== */
+static const char * sseFull(uint16_t * len)
+{
+  const char * full = jsonCacheBody(JSONCACHE_JSON, len);
+
+  if (!full) {
+    JSONWriter out(NULL, 0);
+
+    getJSONData(out);
+    *len = out.total();
+  }
+  return full;
+}
+
+/* ======================================================================
+Function: sseSend
+Purpose : send last frame to a client, if it can take it now
+Input   : client
+          whole frame body and its length, see sseFull()
+Output  : -
+Comments: WiFiClient::write() waits for acknowledges when TCP send
+          buffer is full, so we only write what fits in it. A client
+          that can't take an event misses it and gets whole frame
+          next time, after SSE_MAX_SKIPS frames in a row it's dropped.
+          Whole frame not in cache is rendered into client.
+====================================================================== */
+static void sseSend(_sseclient * c, const char * full, uint16_t full_len)
+{
+  const char * body;
+  uint16_t len;
+  PGM_P event;
+  bool sent;
+
+  if (c->full || !c->deltas || sse_delta_trunc) {
+    if (tinfolabels.empty())
+      return;
+    event = PSTR("frame");
+    body = full;
+    len = full_len;
+  } else {
+    // Nothing changed, nothing to tell
+    if (!sse_delta_len)
+      return;
+    event = PSTR("delta");
+    body = sse_delta;
+    len = sse_delta_len;
+  }
+
+  if ((size_t) c->client.availableForWrite() < (size_t) len + SSE_EVENT_HEAD) {
+    ssestat.skipped++;
+    c->full = true;
+    if (++c->skips >= SSE_MAX_SKIPS) {
+      ssestat.dropped++;
+      sseClose(c);
+    }
+    return;
+  }
+
+  if (body)
+    sent = sseEvent(c, event, body, len);
+  else
+    sent = sseEventRender(c, event, getJSONData);
+  if (!sent) {
+    ssestat.closed++;
+    sseClose(c);
+    return;
+  }
+
+  ssestat.events++;
+  c->full = false;
+  c->skips = 0;
+  c->last_ms = millis();
+}
+
+/* ======================================================================
+Function: sseRenderDelta
+Purpose : render values changed by last frame
+Input   : -
+Output  : -
+Comments: same format as /json, without _UPTIME
+====================================================================== */
+static void sseRenderDelta(void)
+{
+  JSONWriter out(sse_delta, sizeof(sse_delta));
+  bool first = true;
+  uint32_t number;
+
+  out += '{';
+  for (uint8_t id = 0; id < LABEL_COUNT; id++) {
+    if (!tinfolabels.changed(id))
+      continue;
+
+    out += first ? F("\"") : F(",\"");
+    first = false;
+    out += TInfoLabels::labelName(id);
+    out += F("\":");
+    if (tinfoFrameNumber(id, &number))
+      out += number;
+    else if (*tinfolabels.get(id))
+      formatNumberJSON(out, (char *) tinfolabels.get(id));
+    else
+      out += F("\"\"");
+  }
+
+  for (uint8_t i = 0; i < tinfolabels.extraCount(); i++) {
+    if (!tinfolabels.extraChanged(i))
+      continue;
+
+    out += first ? F("\"") : F(",\"");
+    first = false;
+    out += tinfolabels.extraName(i);
+    out += F("\":");
+    if (*tinfolabels.extraValue(i))
+      formatNumberJSON(out, (char *) tinfolabels.extraValue(i));
+    else
+      out += F("\"\"");
+  }
+  out += '}';
+
+  sse_delta_len = first ? 0 : out.length();
+  sse_delta_trunc = out.overflow();
+}
+
+/* ======================================================================
+Function: sseSubscribe
+Purpose : make a client of /events a subscriber
+Input   : client of request
+          true if it wants only changed values
+Output  : false if there is no slot left, nothing has been sent then
+Comments: headers are written on the connection, it is kept open
+          when web server is done with request. Last frame is sent
+          right away so client has all values
+====================================================================== */
+bool sseSubscribe(WiFiClient & client, bool deltas)
+{
+  _sseclient * c = NULL;
+  const char * full;
+  uint16_t full_len = 0;
+
+  // Reap gone clients, we may get their slot
+  sseHandle();
+
+  for (uint8_t i = 0; i < SSE_CLIENTS; i++) {
+    if (!sse_clients[i].active) {
+      c = &sse_clients[i];
+      break;
+    }
+  }
+
+  if (!c) {
+    ssestat.rejected++;
+    return false;
+  }
+
+  // Headers and reconnect delay browsers have to use, then events
+  // go out as soon as written
+  client.print(F("HTTP/1.1 200 OK\r\n"
+                 "Content-Type: text/event-stream\r\n"
+                 "Cache-Control: no-cache\r\n"
+                 "Connection: keep-alive\r\n"
+                 "Access-Control-Allow-Origin: *\r\n\r\n"
+                 "retry: 5000\n\n"));
+  client.setNoDelay(true);
+
+  c->client = client;
+  c->active = true;
+  c->deltas = deltas;
+  c->full = true;
+  c->skips = 0;
+  c->last_ms = millis();
+  ssestat.connects++;
+  ssestat.clients++;
+
+  full = sseFull(&full_len);
+  sseSend(c, full, full_len);
+  return true;
+}
+
+/* ======================================================================
+Function: sseFrame
+Purpose : push frame we just received to subscribers
+Input   : -
+Output  : -
+Comments: called from NewFrame() and UpdatedFrame() after
+          jsonCacheFrame(), whole frame is the cached /json body, or
+          rendered for each client when it did not fit. Delta is what
+          tinfolabels tells changed in this frame.
+====================================================================== */
+void sseFrame(void)
+{
+  unsigned long start = micros();
+  const char * full;
+  uint16_t full_len = 0;
+  uint32_t elapsed;
+
+  if (!ssestat.clients)
+    return;
+
+  sseRenderDelta();
+  full = sseFull(&full_len);
+
+  for (uint8_t i = 0; i < SSE_CLIENTS; i++) {
+    _sseclient * c = &sse_clients[i];
+
+    if (!c->active)
+      continue;
+
+    if (!c->client.connected()) {
+      ssestat.closed++;
+      sseClose(c);
+      continue;
+    }
+
+    sseSend(c, full, full_len);
+  }
+
+  elapsed = micros() - start;
+  if (elapsed > ssestat.max_us)
+    ssestat.max_us = elapsed;
+}
+
+/* ======================================================================
+Function: sseHandle
+Purpose : free slots of gone clients, keep idle ones alive
+Input   : -
+Output  : -
+Comments: to be called from main loop, a comment line is sent to an
+          idle client so proxies and browsers don't time it out
+====================================================================== */
+void sseHandle(void)
+{
+  for (uint8_t i = 0; i < SSE_CLIENTS; i++) {
+    _sseclient * c = &sse_clients[i];
+
+    if (!c->active)
+      continue;
+
+    if (!c->client.connected()) {
+      ssestat.closed++;
+      sseClose(c);
+      continue;
+    }
+
+    if (millis() - c->last_ms >= SSE_KEEPALIVE_MS && c->client.availableForWrite() >= 3) {
+      if (!sseWrite(c, ":\n\n", 3)) {
+        ssestat.closed++;
+        sseClose(c);
+        continue;
+      }
+      c->last_ms = millis();
+    }
+  }
+}
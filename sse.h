@@ -0,0 +1,66 @@
+// **********************************************************************************
+// ESP8266 Teleinfo Server-Sent Events Include file
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use , see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#ifndef SSE_H
+#define SSE_H
+
+// Include main project include file
+#include "Wifinfo.h"
+
+#define SSE_CLIENTS         4     // subscribers at the same time
+#define SSE_DELTA_SIZE      512   // changed values of one frame
+#define SSE_CHUNK_SIZE      256   // staging buffer, one TCP write
+#define SSE_EVENT_HEAD      40    // "event: delta\nid: 4294967295\ndata: " and final "\n\n"
+#define SSE_MAX_SKIPS       5     // frames in a row a client could not take before we drop it
+#define SSE_KEEPALIVE_MS    15000 // comment line sent to an idle client
+
+// One subscriber of /events
+typedef struct
+{
+  WiFiClient    client;
+  bool          active;   // slot used
+  bool          deltas;   // wants only changed values
+  bool          full;     // next event must be whole frame
+  uint8_t       skips;    // frames in a row skipped
+  unsigned long last_ms;  // millis() of last write
+} _sseclient;
+
+// Push statistics
+typedef struct
+{
+  uint32_t connects;      // subscriptions accepted
+  uint32_t rejected;      // subscriptions refused, no slot left
+  uint32_t closed;        // clients gone
+  uint32_t dropped;       // clients dropped because too slow
+  uint32_t events;        // events sent, all clients
+  uint32_t skipped;       // events not sent, client send buffer full
+  uint32_t bytes;         // bytes sent, all clients
+  uint32_t max_us;        // worst push time of a frame
+  uint8_t  clients;       // clients connected now
+} _ssestat;
+
+// Exported variables/object instancied in main sketch
+// ===================================================
+extern _ssestat ssestat;
+
+// declared exported function from sse.cpp
+// ===================================================
+bool sseSubscribe(WiFiClient & client, bool deltas);
+void sseFrame(void);
+void sseHandle(void);
+
+#endif
@@ -0,0 +1,431 @@
+// **********************************************************************************
+// ESP8266 Teleinfo decoded frame
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use, see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+
+#include "tinfoframe.h"
+
+// Last decoded frame
+TeleinfoFrame tinfoframe;
+
+// What each sink has already sent
+_sinkpush sinkpush[SINK_COUNT];
+
+// Deadband applied to a numeric field
+enum
+{
+  DEADBAND_INDEX = 0,
+  DEADBAND_CURRENT,
+  DEADBAND_POWER
+};
+
+// Numeric labels and where they go in TeleinfoFrame
+typedef struct
+{
+  uint8_t  id;      // LABEL_xxx
+  uint8_t  size;    // field size (2 or 4)
+  uint16_t offset;  // field offset in TeleinfoFrame
+  uint32_t bit;     // FRAME_xxx
+  uint8_t  deadband;// DEADBAND_xxx
+} _framefield;
+
+#define FRAME_FIELD(l, f, b, d) { l, sizeof(((TeleinfoFrame *) 0)->f), offsetof(TeleinfoFrame, f), b, d }
+
+static const _framefield frame_fields[] PROGMEM = {
+  FRAME_FIELD(LABEL_BASE,    base,    FRAME_BASE,    DEADBAND_INDEX),
+  FRAME_FIELD(LABEL_HCHC,    hchc,    FRAME_HCHC,    DEADBAND_INDEX),
+  FRAME_FIELD(LABEL_HCHP,    hchp,    FRAME_HCHP,    DEADBAND_INDEX),
+  FRAME_FIELD(LABEL_EJPHN,   ejphn,   FRAME_EJPHN,   DEADBAND_INDEX),
+  FRAME_FIELD(LABEL_EJPHPM,  ejphpm,  FRAME_EJPHPM,  DEADBAND_INDEX),
+  FRAME_FIELD(LABEL_BBRHCJB, bbrhcjb, FRAME_BBRHCJB, DEADBAND_INDEX),
+  FRAME_FIELD(LABEL_BBRHPJB, bbrhpjb, FRAME_BBRHPJB, DEADBAND_INDEX),
+  FRAME_FIELD(LABEL_BBRHCJW, bbrhcjw, FRAME_BBRHCJW, DEADBAND_INDEX),
+  FRAME_FIELD(LABEL_BBRHPJW, bbrhpjw, FRAME_BBRHPJW, DEADBAND_INDEX),
+  FRAME_FIELD(LABEL_BBRHCJR, bbrhcjr, FRAME_BBRHCJR, DEADBAND_INDEX),
+  FRAME_FIELD(LABEL_BBRHPJR, bbrhpjr, FRAME_BBRHPJR, DEADBAND_INDEX),
+  FRAME_FIELD(LABEL_ISOUSC,  isousc,  FRAME_ISOUSC,  DEADBAND_CURRENT),
+  FRAME_FIELD(LABEL_IINST,   iinst,   FRAME_IINST,   DEADBAND_CURRENT),
+  FRAME_FIELD(LABEL_IINST1,  iinst1,  FRAME_IINST1,  DEADBAND_CURRENT),
+  FRAME_FIELD(LABEL_IINST2,  iinst2,  FRAME_IINST2,  DEADBAND_CURRENT),
+  FRAME_FIELD(LABEL_IINST3,  iinst3,  FRAME_IINST3,  DEADBAND_CURRENT),
+  FRAME_FIELD(LABEL_IMAX,    imax,    FRAME_IMAX,    DEADBAND_CURRENT),
+  FRAME_FIELD(LABEL_PMAX,    pmax,    FRAME_PMAX,    DEADBAND_POWER),
+  FRAME_FIELD(LABEL_PAPP,    papp,    FRAME_PAPP,    DEADBAND_POWER)
+};
+
+#define FRAME_FIELDS (sizeof(frame_fields) / sizeof(_framefield))
+
+// Tariff codes, index is OPTARIF_xxx/PTEC_xxx - 1
+static const char optarif_codes[][4] PROGMEM = { 
+  {'B','A','S'}, {'H','C','.'}, {'E','J','P'}, {'B','B','R'} 
+};
+static const char ptec_codes[][4] PROGMEM = { 
+  {'T','H','.','.'}, {'H','C','.','.'}, {'H','P','.','.'}, {'H','N','.','.'}, 
+  {'P','M','.','.'}, {'H','C','J','B'}, {'H','C','J','W'}, {'H','C','J','R'}, 
+  {'H','P','J','B'}, {'H','P','J','W'}, {'H','P','J','R'} 
+};
+
+// label id => index in frame_fields + 1 (0 if not numeric)
+static uint8_t frame_field_of[LABEL_COUNT];
+
+/* ======================================================================
+Function: fieldGet
+Purpose : read a numeric field of a frame
+Input   : frame
+          field description
+Output  : field value
+Comments: -
+====================================================================== */
+static uint32_t fieldGet(const TeleinfoFrame * f, const _framefield * ff)
+{
+  const uint8_t * p = (const uint8_t *) f + ff->offset;
+
+  if (ff->size == sizeof(uint16_t))
+    return *(const uint16_t *) p;
+  return *(const uint32_t *) p;
+}
+
+/* ======================================================================
+Function: fieldSet
+Purpose : write a numeric field of a frame
+Input   : frame
+          field description
+          value (saturated on 16 bits fields)
+Output  : -
+Comments: -
+====================================================================== */
+static void fieldSet(TeleinfoFrame * f, const _framefield * ff, uint32_t value)
+{
+  uint8_t * p = (uint8_t *) f + ff->offset;
+
+  if (ff->size == sizeof(uint16_t))
+    *(uint16_t *) p = value > 0xFFFF ? 0xFFFF : value;
+  else
+    *(uint32_t *) p = value;
+}
+
+/* ======================================================================
+Function: parseNumber
+Purpose : convert a teleinfo value to number
+Input   : value
+          pointer on result
+Output  : true if value was a plain number
+Comments: leading zeros are just digits here, no strtoul() needed
+====================================================================== */
+static bool parseNumber(const char * p, uint32_t * result)
+{
+  uint32_t n = 0;
+
+  if (!*p)
+    return false;
+
+  while (*p) {
+    if (*p < '0' || *p > '9')
+      return false;
+    n = n * 10 + (*p++ - '0');
+  }
+  *result = n;
+  return true;
+}
+
+/* ======================================================================
+Function: parseCode
+Purpose : find teleinfo value in a table of fixed size codes
+Input   : value
+          codes table (PROGMEM)
+          number of entries
+          number of chars to compare
+Output  : index + 1 in table, 0 if not found
+Comments: -
+====================================================================== */
+static uint8_t parseCode(const char * value, const char (*codes)[4], uint8_t count, uint8_t len)
+{
+  for (uint8_t i = 0; i < count; i++) {
+    if (!strncmp_P(value, codes[i], len))
+      return i + 1;
+  }
+  return 0;
+}
+
+/* ======================================================================
+Function: tinfoFrameClear
+Purpose : invalidate decoded frame
+Input   : -
+Output  : -
+Comments: -
+====================================================================== */
+void tinfoFrameClear(void)
+{
+  memset(&tinfoframe, 0, sizeof(tinfoframe));
+}
+
+/* ======================================================================
+Function: tinfoFrameDecode
+Purpose : decode values of the frame we just received
+Input   : -
+Output  : -
+Comments: called once per frame, consumers then use tinfoframe 
+          and never parse teleinfo values again
+====================================================================== */
+void tinfoFrameDecode(void)
+{
+  TeleinfoFrame f;
+  uint32_t n;
+  const char * value;
+
+  memset(&f, 0, sizeof(f));
+  f.frame = tinfo_frames;
+
+  // Numeric fields
+  for (uint8_t i = 0; i < FRAME_FIELDS; i++) {
+    _framefield ff;
+
+    memcpy_P(&ff, &frame_fields[i], sizeof(ff));
+    frame_field_of[ff.id] = i + 1;
+
+    if (!tinfolabels.has(ff.id) || !parseNumber(tinfolabels.get(ff.id), &n))
+      continue;
+
+    fieldSet(&f, &ff, n);
+    f.valid |= ff.bit;
+  }
+
+  if (tinfolabels.has(LABEL_ADCO)) {
+    strlcpy(f.adco, tinfolabels.get(LABEL_ADCO), sizeof(f.adco));
+    f.valid |= FRAME_ADCO;
+  }
+
+  if (tinfolabels.has(LABEL_OPTARIF)) {
+    f.optarif = parseCode(tinfolabels.get(LABEL_OPTARIF), optarif_codes, OPTARIF_BBR, 3);
+    f.valid |= FRAME_OPTARIF;
+  }
+
+  if (tinfolabels.has(LABEL_PTEC)) {
+    f.ptec = parseCode(tinfolabels.get(LABEL_PTEC), ptec_codes, PTEC_HPJR, 4);
+    f.valid |= FRAME_PTEC;
+  }
+
+  value = tinfolabels.get(LABEL_HHPHC);
+  if (*value) {
+    f.hhphc = *value;
+    f.valid |= FRAME_HHPHC;
+  }
+
+  tinfoframe = f;
+}
+
+/* ======================================================================
+Function: tinfoFrameNumber
+Purpose : get decoded value of a numeric label
+Input   : label id (LABEL_xxx)
+          pointer on result
+Output  : true if label is numeric and has been received
+Comments: -
+====================================================================== */
+bool tinfoFrameNumber(uint8_t id, uint32_t * value)
+{
+  _framefield ff;
+  uint8_t i;
+
+  if (id >= LABEL_COUNT || !(i = frame_field_of[id]))
+    return false;
+
+  memcpy_P(&ff, &frame_fields[i - 1], sizeof(ff));
+  if (!(tinfoframe.valid & ff.bit))
+    return false;
+
+  *value = fieldGet(&tinfoframe, &ff);
+  return true;
+}
+
+/* ======================================================================
+Function: tinfoFrameBit
+Purpose : get TeleinfoFrame field of a label
+Input   : label id (LABEL_xxx)
+Output  : its FRAME_xxx bit, 0 if label is not a frame field
+Comments: changes of these labels are seen by tinfoFrameDirty()
+====================================================================== */
+uint32_t tinfoFrameBit(uint8_t id)
+{
+  _framefield ff;
+  uint8_t i;
+
+  switch (id) {
+    case LABEL_ADCO:    return FRAME_ADCO;
+    case LABEL_OPTARIF: return FRAME_OPTARIF;
+    case LABEL_PTEC:    return FRAME_PTEC;
+    case LABEL_HHPHC:   return FRAME_HHPHC;
+  }
+
+  if (id >= LABEL_COUNT || !(i = frame_field_of[id]))
+    return 0;
+
+  memcpy_P(&ff, &frame_fields[i - 1], sizeof(ff));
+  return ff.bit;
+}
+
+/* ======================================================================
+Function: tinfoFrameValue
+Purpose : get value of a label as a number
+Input   : label id (LABEL_xxx)
+          pointer on result
+Output  : true if label has a numeric value
+Comments: same mapping than emoncmsPost() for OPTARIF, PTEC and HHPHC,
+          numbers too long for 32 bits (ADCO, PRM) are ids, not values
+====================================================================== */
+bool tinfoFrameValue(uint8_t id, uint32_t * number)
+{
+  const char * value;
+  uint32_t n = 0;
+  uint8_t len = 0;
+
+  if (!tinfolabels.has(id))
+    return false;
+
+  switch (id) {
+    case LABEL_OPTARIF: *number = tinfoframe.optarif;         return true;
+    case LABEL_PTEC:    *number = tinfoframe.ptec;            return true;
+    case LABEL_HHPHC:   *number = (uint8_t) tinfoframe.hhphc; return true;
+  }
+
+  if (tinfoFrameNumber(id, number))
+    return true;
+
+  for (value = tinfolabels.get(id); *value; value++, len++) {
+    if (*value < '0' || *value > '9' || len >= 9)
+      return false;
+    n = n * 10 + (*value - '0');
+  }
+  *number = n;
+  return len > 0;
+}
+
+/* ======================================================================
+Function: tinfoFrameDirty
+Purpose : get fields a sink has to send
+Input   : sink (SINK_xxx)
+Output  : FRAME_xxx bits of fields changed since last push
+Comments: in CFG_PUSH_ALWAYS mode, on first push or when heartbeat 
+          is reached all bits are set (full refresh)
+          only TeleinfoFrame fields have a bit, other labels are
+          never reported as changed
+          a numeric field is changed only if it moved more than its 
+          deadband from the value we pushed, so slow drifts are sent
+====================================================================== */
+uint32_t tinfoFrameDirty(uint8_t sink)
+{
+  const _pushcfg * push = sink == SINK_EMONCMS ? &config.emoncms.push :
+                          sink == SINK_JEEDOM  ? &config.jeedom.push  : 
+                          sink == SINK_MQTT    ? &config.mqtt.push    : &config.domoticz.push;
+  _sinkpush * s = &sinkpush[sink];
+  const TeleinfoFrame * last = &s->pushed;
+  uint16_t deadbands[3] = { push->db_index, push->db_current, push->db_power };
+  uint32_t dirty;
+
+  s->due = 0;
+
+  // Heartbeat stays pending until tinfoFramePushed() got all of it
+  if (push->heartbeat && millis() - s->refresh_ms >= push->heartbeat * 1000UL)
+    s->refresh = true;
+
+  if (push->mode != CFG_PUSH_CHANGE || !last->frame || s->refresh)
+    return 0xFFFFFFFF;
+
+  // New fields
+  dirty = tinfoframe.valid & ~last->valid;
+
+  for (uint8_t i = 0; i < FRAME_FIELDS; i++) {
+    _framefield ff;
+    uint32_t a, b;
+
+    memcpy_P(&ff, &frame_fields[i], sizeof(ff));
+    if (!(tinfoframe.valid & last->valid & ff.bit))
+      continue;
+
+    a = fieldGet(&tinfoframe, &ff);
+    b = fieldGet(last, &ff);
+    if ((a > b ? a - b : b - a) > deadbands[ff.deadband])
+      dirty |= ff.bit;
+  }
+
+  if (strcmp(tinfoframe.adco, last->adco))  dirty |= FRAME_ADCO;
+  if (tinfoframe.optarif != last->optarif)  dirty |= FRAME_OPTARIF;
+  if (tinfoframe.ptec != last->ptec)        dirty |= FRAME_PTEC;
+  if (tinfoframe.hhphc != last->hhphc)      dirty |= FRAME_HHPHC;
+
+  return dirty & tinfoframe.valid;
+}
+
+/* ======================================================================
+Function: tinfoFrameDue
+Purpose : check if a sink message has to be sent
+Input   : sink (SINK_xxx)
+          fields to send (from tinfoFrameDirty)
+          fields used by this message
+Output  : true if message has to be sent
+Comments: count sent and avoided messages, remember fields of due
+          ones so tinfoFramePushed() knows when a refresh is complete
+====================================================================== */
+boolean tinfoFrameDue(uint8_t sink, uint32_t dirty, uint32_t mask)
+{
+  if (dirty & mask) {
+    sinkpush[sink].due |= mask;
+    sinkpush[sink].sent++;
+    return true;
+  }
+  sinkpush[sink].skipped++;
+  return false;
+}
+
+/* ======================================================================
+Function: tinfoFramePushed
+Purpose : record values a sink has successfully sent
+Input   : sink (SINK_xxx)
+          FRAME_xxx bits of fields sent
+Output  : -
+Comments: heartbeat restarts only once every due message of a full 
+          refresh has been sent, a failed one is retried on next call
+====================================================================== */
+void tinfoFramePushed(uint8_t sink, uint32_t mask)
+{
+  _sinkpush * s = &sinkpush[sink];
+  TeleinfoFrame * last = &s->pushed;
+
+  if (s->refresh && (mask & s->due) == s->due) {
+    s->refresh = false;
+    s->refresh_ms = millis();
+  }
+
+  mask &= tinfoframe.valid;
+  if (!mask)
+    return;
+
+  for (uint8_t i = 0; i < FRAME_FIELDS; i++) {
+    _framefield ff;
+
+    memcpy_P(&ff, &frame_fields[i], sizeof(ff));
+    if (mask & ff.bit)
+      fieldSet(last, &ff, fieldGet(&tinfoframe, &ff));
+  }
+
+  if (mask & FRAME_ADCO)    strcpy(last->adco, tinfoframe.adco);
+  if (mask & FRAME_OPTARIF) last->optarif = tinfoframe.optarif;
+  if (mask & FRAME_PTEC)    last->ptec = tinfoframe.ptec;
+  if (mask & FRAME_HHPHC)   last->hhphc = tinfoframe.hhphc;
+
+  last->valid |= mask;
+  last->frame = tinfoframe.frame;
+}
@@ -0,0 +1,150 @@
+// **********************************************************************************
+// ESP8266 Teleinfo decoded frame Include file
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use , see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#ifndef TINFOFRAME_H
+#define TINFOFRAME_H
+
+// Include main project include file
+#include "Wifinfo.h"
+
+// Tariff option (OPTARIF), values are the ones sent to emoncms
+enum
+{
+  OPTARIF_UNKNOWN = 0,
+  OPTARIF_BASE,     // BASE
+  OPTARIF_HC,       // HC..
+  OPTARIF_EJP,      // EJP.
+  OPTARIF_BBR       // BBRx (Tempo)
+};
+
+// Current tariff period (PTEC), values are the ones sent to emoncms
+enum
+{
+  PTEC_UNKNOWN = 0,
+  PTEC_TH,          // TH.. Toutes les Heures
+  PTEC_HC,          // HC.. Heures Creuses
+  PTEC_HP,          // HP.. Heures Pleines
+  PTEC_HN,          // HN.. Heures Normales
+  PTEC_PM,          // PM.. Heures de Pointe Mobile
+  PTEC_HCJB,        // HCJB Heures Creuses Jours Bleus
+  PTEC_HCJW,        // HCJW Heures Creuses Jours Blancs
+  PTEC_HCJR,        // HCJR Heures Creuses Jours Rouges
+  PTEC_HPJB,        // HPJB Heures Pleines Jours Bleus
+  PTEC_HPJW,        // HPJW Heures Pleines Jours Blancs
+  PTEC_HPJR         // HPJR Heures Pleines Jours Rouges
+};
+
+// Validity bits of TeleinfoFrame fields
+#define FRAME_ADCO     0x00000001UL
+#define FRAME_OPTARIF  0x00000002UL
+#define FRAME_PTEC     0x00000004UL
+#define FRAME_HHPHC    0x00000008UL
+#define FRAME_BASE     0x00000010UL
+#define FRAME_HCHC     0x00000020UL
+#define FRAME_HCHP     0x00000040UL
+#define FRAME_EJPHN    0x00000080UL
+#define FRAME_EJPHPM   0x00000100UL
+#define FRAME_BBRHCJB  0x00000200UL
+#define FRAME_BBRHPJB  0x00000400UL
+#define FRAME_BBRHCJW  0x00000800UL
+#define FRAME_BBRHPJW  0x00001000UL
+#define FRAME_BBRHCJR  0x00002000UL
+#define FRAME_BBRHPJR  0x00004000UL
+#define FRAME_ISOUSC   0x00008000UL
+#define FRAME_IINST    0x00010000UL
+#define FRAME_IINST1   0x00020000UL
+#define FRAME_IINST2   0x00040000UL
+#define FRAME_IINST3   0x00080000UL
+#define FRAME_IMAX     0x00100000UL
+#define FRAME_PMAX     0x00200000UL
+#define FRAME_PAPP     0x00400000UL
+
+// Teleinfo values decoded once per frame, fields are 0 when not valid
+typedef struct
+{
+  uint32_t valid;       // FRAME_xxx bits of received fields
+  uint32_t frame;       // tinfo_frames when decoded
+  char     adco[13];    // meter address
+  uint8_t  optarif;     // OPTARIF_xxx
+  uint8_t  ptec;        // PTEC_xxx
+  char     hhphc;       // A to Y
+  // Indexes (Wh)
+  uint32_t base;
+  uint32_t hchc;
+  uint32_t hchp;
+  uint32_t ejphn;
+  uint32_t ejphpm;
+  uint32_t bbrhcjb;
+  uint32_t bbrhpjb;
+  uint32_t bbrhcjw;
+  uint32_t bbrhpjw;
+  uint32_t bbrhcjr;
+  uint32_t bbrhpjr;
+  // Currents (A) and powers (VA/W)
+  uint16_t isousc;
+  uint16_t iinst;
+  uint16_t iinst1;
+  uint16_t iinst2;
+  uint16_t iinst3;
+  uint16_t imax;
+  uint16_t pmax;
+  uint16_t papp;
+} TeleinfoFrame;
+
+// Sinks we keep track of pushed values
+enum
+{
+  SINK_EMONCMS = 0,
+  SINK_JEEDOM,
+  SINK_DOMOTICZ,
+  SINK_INFLUX,
+  SINK_HTTP_COUNT,                // sinks above go through httpqueue
+  SINK_MQTT = SINK_HTTP_COUNT,
+  SINK_COUNT
+};
+
+// Push state of a sink
+// Only the TeleinfoFrame fields above are tracked, other labels (standard
+// mode text, unknown ones) are never dirty, sinks sending them compare
+// values themselves (see jeedomChanged())
+typedef struct
+{
+  TeleinfoFrame pushed;     // values at last successful push
+  unsigned long refresh_ms; // last full refresh pushed (heartbeat)
+  boolean       refresh;    // heartbeat reached, full refresh not pushed yet
+  uint32_t      due;        // fields of messages due since tinfoFrameDirty()
+  uint32_t      sent;       // requests sent
+  uint32_t      skipped;    // requests avoided by push on change
+} _sinkpush;
+
+// Exported variables/object instancied in main sketch
+// ===================================================
+extern TeleinfoFrame tinfoframe;
+extern _sinkpush sinkpush[SINK_COUNT];
+
+// declared exported function from tinfoframe.cpp
+// ===================================================
+void tinfoFrameClear(void);
+void tinfoFrameDecode(void);
+bool tinfoFrameNumber(uint8_t id, uint32_t * value);
+uint32_t tinfoFrameBit(uint8_t id);
+bool tinfoFrameValue(uint8_t id, uint32_t * number);
+uint32_t tinfoFrameDirty(uint8_t sink);
+boolean tinfoFrameDue(uint8_t sink, uint32_t dirty, uint32_t mask);
+void tinfoFramePushed(uint8_t sink, uint32_t mask);
+
+#endif
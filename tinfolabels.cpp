@@ -0,0 +1,245 @@
+// **********************************************************************************
+// ESP8266 Teleinfo labels table
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use, see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+
+#include "tinfolabels.h"
+
+// Last value of each label
+TInfoLabels tinfolabels;
+
+// Known labels names, indexed by LABEL_xxx
+constexpr char tinfo_label_names[][TINFO_LABEL_SIZE] PROGMEM = {
+  "ADCO", "OPTARIF", "ISOUSC", "BASE", "HCHC", "HCHP", "EJPHN", "EJPHPM",
+  "BBRHCJB", "BBRHPJB", "BBRHCJW", "BBRHPJW", "BBRHCJR", "BBRHPJR", "PEJP",
+  "PTEC", "DEMAIN", "IINST", "IINST1", "IINST2", "IINST3", "IMAX", "IMAX1",
+  "IMAX2", "IMAX3", "PMAX", "PAPP", "HHPHC", "MOTDETAT", "ADPS", "ADIR1",
+  "ADIR2", "ADIR3", "PPOT", "ADSC", "VTIC", "DATE", "NGTF", "LTARF", "EAST",
+  "EASF01", "EASF02", "EASF03", "EASF04", "EASF05", "EASF06", "EASF07",
+  "EASF08", "EASF09", "EASF10", "EASD01", "EASD02", "EASD03", "EASD04", "EAIT",
+  "ERQ1", "ERQ2", "ERQ3", "ERQ4", "IRMS1", "IRMS2", "IRMS3", "URMS1", "URMS2",
+  "URMS3", "PREF", "PCOUP", "SINSTS", "SINSTS1", "SINSTS2", "SINSTS3",
+  "SMAXSN", "SMAXSN1", "SMAXSN2", "SMAXSN3", "SMAXSN-1", "SMAXSN1-1",
+  "SMAXSN2-1", "SMAXSN3-1", "SINSTI", "SMAXIN", "SMAXIN-1", "CCASN", "CCASN-1",
+  "CCAIN", "CCAIN-1", "UMOY1", "UMOY2", "UMOY3", "STGE", "PRM", "RELAIS",
+  "NTARF", "NJOURF", "NJOURF+1"
+};
+
+// Perfect hash table, slot => LABEL_xxx + 1 (0 is free slot)
+constexpr uint8_t tinfo_label_slots[TINFO_LABEL_SLOTS] PROGMEM = {
+    0,   0,   0,   0,   0,   0,   0,  22,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,   0,   0,  44,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,   0,   0,   0,   0,  54,   0,   0,   0,   0,   0,  12,  90,   0,
+    0,  15,   0,   0,  57,   0,   0,   0,   0,   0,  87,   0,   0,   0,   0,   0,
+    0,  84,  49,   0,   0,   0,   0,   0,   0,   0,  33,   0,  47,   0,  40,   0,
+    0,   0,  50,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+   65,   0,  79,   0,   0,   9,   0,   0,   0,   0,   0,   0,   0,  82,   0,   0,
+    0,   0,  30,   0,   0,   0,  25,   0,   0,   0,   0,   0,  62,   0,   0,  67,
+   43,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,  61,   0,  95,   0,   0,   0,   0,   0,  77,   0,   0,   0,   0,
+    3,   0,  59,   0,   0,   0,   0,  58,   0,  16,   0,  18,   0,   0,   0,   0,
+    0,   0,   0,   0,   0,  52,   0,  81,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,  10,   0,  72,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,  88,   0,   0,  73,   0,   0,  24,  35,   0,   7,   0,   0,   0,
+    0,  48,   0,   0,   0,   0,   0,   0,  92,   0,   0,  46,  51,  32,   0,   0,
+    0,   0,   0,  28,   0,   0,  60,   0,   0,  29,  38,   0,   0,   0,   0,  76,
+    0,   0,   0,   0,   2,   0,   0,   0,   0,   0,   8,   0,   0,  17,   0,   0,
+    0,   0,   0,   0,  31,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,  42,
+    0,   0,   0,   0,   0,   0,   0,  86,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,  56,   0,   0,   0,   0,   0,   0,   0,   0,  63,   0,   0,   0,   0,   0,
+    0,   0,   0,  74,  89,   0,   0,   0,   0,   0,   0,   0,  23,   0,  36,   0,
+    0,   0,   0,  71,   0,   0,  45,   1,   6,  94,   0,  68,   0,   0,   0,   0,
+    0,   0,   0,  55,   0,   0,   0,   0,   0,  21,   0,   0,   0,   0,   0,   0,
+    0,  66,   0,  78,   0,  69,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,  19,   0,   0,   0,   0,   0,   0,   0,   0,   0,   5,   0,  27,
+    0,   0,   0,   0,   0,  13,   0,   0,  37,   0,   0,   0,   0,   0,   0,   0,
+   75,  34,   0,  93,   0,   0,  53,   0,   0,  80,   0,   0,  70,   4,   0,   0,
+    0,   0,   0,  91,   0,   0,   0,  64,  85,   0,  41,   0,   0,   0,   0,   0,
+    0,   0,  14,   0,   0,   0,   0,   0,   0,   0,  20,   0,   0,  83,  26,   0,
+    0,   0,   0,  39,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,  11,   0
+};
+
+static_assert(sizeof(tinfo_label_names) / TINFO_LABEL_SIZE == LABEL_COUNT, 
+              "tinfo_label_names does not match LABEL_xxx list");
+
+// Check at compile time that each known label lands in its own slot
+constexpr bool tinfoLabelsPerfect(uint8_t id)
+{
+  return id >= LABEL_COUNT || 
+         (tinfo_label_slots[tinfoLabelSlot(tinfo_label_names[id])] == id + 1 && tinfoLabelsPerfect(id + 1));
+}
+
+static_assert(tinfoLabelsPerfect(0), "labels hash table must be regenerated");
+
+/* ======================================================================
+Function: labelId
+Purpose : return known label index
+Input   : label name
+Output  : LABEL_xxx or LABEL_UNKNOWN
+Comments: one hash and one compare, whatever the number of labels
+====================================================================== */
+uint8_t TInfoLabels::labelId(const char * name)
+{
+  uint8_t id = pgm_read_byte(&tinfo_label_slots[tinfoLabelSlot(name)]);
+
+  if (!id || strcmp_P(name, tinfo_label_names[id - 1]))
+    return LABEL_UNKNOWN;
+
+  return id - 1;
+}
+
+/* ======================================================================
+Function: labelName
+Purpose : return known label name
+Input   : LABEL_xxx
+Output  : name stored in flash
+Comments: -
+====================================================================== */
+const __FlashStringHelper * TInfoLabels::labelName(uint8_t id)
+{
+  return FPSTR(tinfo_label_names[id]);
+}
+
+/* ======================================================================
+Function: clear
+Purpose : forget all received values
+Input   : -
+Output  : -
+Comments: -
+====================================================================== */
+void TInfoLabels::clear(void)
+{
+  memset(_present, 0, sizeof(_present));
+  _extra_count = 0;
+  memset(_changed, 0, sizeof(_changed));
+  _extra_changed = 0;
+  frameDone();
+}
+
+/* ======================================================================
+Function: frameDone
+Purpose : end of frame, its changes become the last frame ones
+Input   : -
+Output  : -
+Comments: like flags of TInfo list, changed() tells about the last
+          complete frame until the next one ends
+====================================================================== */
+void TInfoLabels::frameDone(void)
+{
+  memcpy(_frame_changed, _changed, sizeof(_changed));
+  _frame_extra_changed = _extra_changed;
+  memset(_changed, 0, sizeof(_changed));
+  _extra_changed = 0;
+}
+
+/* ======================================================================
+Function: empty
+Purpose : check if we received at least one value
+Input   : -
+Output  : true if table is empty
+Comments: -
+====================================================================== */
+bool TInfoLabels::empty(void) const
+{
+  for (uint8_t i = 0; i < sizeof(_present) / sizeof(_present[0]); i++) {
+    if (_present[i])
+      return false;
+  }
+  return _extra_count == 0;
+}
+
+/* ======================================================================
+Function: set
+Purpose : store a received value
+Input   : label name
+          value
+Output  : TINFO_FLAGS_ADDED, TINFO_FLAGS_UPDATED or TINFO_FLAGS_NOTHING
+          TINFO_FLAGS_NONE if no room for an unknown label
+Comments: values are truncated to table size
+====================================================================== */
+uint8_t TInfoLabels::set(const char * name, const char * value)
+{
+  uint8_t id = labelId(name);
+  bool present = true;
+  size_t size;
+  char * dst;
+  uint32_t * changed;
+  uint32_t bit;
+
+  if (id != LABEL_UNKNOWN) {
+    dst = _values[id];
+    size = TINFO_VALUE_SIZE;
+    changed = &_changed[id >> 5];
+    bit = 1UL << (id & 31);
+    if (!has(id)) {
+      present = false;
+      _present[id >> 5] |= 1UL << (id & 31);
+    }
+  } else {
+    uint8_t i;
+
+    for (i = 0; i < _extra_count; i++) {
+      if (!strcmp(_extra[i].name, name))
+        break;
+    }
+
+    // New one
+    if (i == _extra_count) {
+      if (_extra_count >= TINFO_EXTRA_COUNT || strlen(name) >= TINFO_LABEL_SIZE)
+        return TINFO_FLAGS_NONE;
+      strcpy(_extra[i].name, name);
+      _extra_count++;
+      present = false;
+    }
+
+    dst = _extra[i].value;
+    size = TINFO_EXTRA_SIZE;
+    changed = &_extra_changed;
+    bit = 1UL << i;
+  }
+
+  if (present && !strncmp(dst, value, size - 1))
+    return TINFO_FLAGS_NOTHING;
+
+  strncpy(dst, value, size - 1);
+  dst[size - 1] = '\0';
+  *changed |= bit;
+
+  return present ? TINFO_FLAGS_UPDATED : TINFO_FLAGS_ADDED;
+}
+
+/* ======================================================================
+Function: get
+Purpose : return value of a label
+Input   : label name
+Output  : value or NULL if not received
+Comments: -
+====================================================================== */
+const char * TInfoLabels::get(const char * name) const
+{
+  uint8_t id = labelId(name);
+
+  if (id != LABEL_UNKNOWN)
+    return has(id) ? _values[id] : NULL;
+
+  for (uint8_t i = 0; i < _extra_count; i++) {
+    if (!strcmp(_extra[i].name, name))
+      return _extra[i].value;
+  }
+  return NULL;
+}
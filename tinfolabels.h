@@ -0,0 +1,210 @@
+// **********************************************************************************
+// ESP8266 Teleinfo labels table Include file
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use , see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#ifndef TINFOLABELS_H
+#define TINFOLABELS_H
+
+// Include main project include file
+#include "Wifinfo.h"
+
+#define TINFO_LABEL_SIZE   10   // Longest known label is SMAXSN1-1
+#define TINFO_VALUE_SIZE   17   // Longest known values are NGTF/LTARF (16 chars)
+#define TINFO_EXTRA_COUNT  12   // Unknown labels we can keep
+#define TINFO_EXTRA_SIZE   32   // Unknown labels value size (MSG1, ...)
+
+// Perfect hash parameters, table in tinfolabels.cpp has been generated
+// for these values, a static_assert check it's still collision free
+#define TINFO_LABEL_SLOTS  512
+#define TINFO_LABEL_SEED   0x811cb553UL
+
+// Known labels, order must match tinfo_label_names[]
+enum
+{
+  // Historic mode
+  LABEL_ADCO,
+  LABEL_OPTARIF,
+  LABEL_ISOUSC,
+  LABEL_BASE,
+  LABEL_HCHC,
+  LABEL_HCHP,
+  LABEL_EJPHN,
+  LABEL_EJPHPM,
+  LABEL_BBRHCJB,
+  LABEL_BBRHPJB,
+  LABEL_BBRHCJW,
+  LABEL_BBRHPJW,
+  LABEL_BBRHCJR,
+  LABEL_BBRHPJR,
+  LABEL_PEJP,
+  LABEL_PTEC,
+  LABEL_DEMAIN,
+  LABEL_IINST,
+  LABEL_IINST1,
+  LABEL_IINST2,
+  LABEL_IINST3,
+  LABEL_IMAX,
+  LABEL_IMAX1,
+  LABEL_IMAX2,
+  LABEL_IMAX3,
+  LABEL_PMAX,
+  LABEL_PAPP,
+  LABEL_HHPHC,
+  LABEL_MOTDETAT,
+  LABEL_ADPS,
+  LABEL_ADIR1,
+  LABEL_ADIR2,
+  LABEL_ADIR3,
+  LABEL_PPOT,
+  // Linky standard mode
+  LABEL_ADSC,
+  LABEL_VTIC,
+  LABEL_DATE,
+  LABEL_NGTF,
+  LABEL_LTARF,
+  LABEL_EAST,
+  LABEL_EASF01,
+  LABEL_EASF02,
+  LABEL_EASF03,
+  LABEL_EASF04,
+  LABEL_EASF05,
+  LABEL_EASF06,
+  LABEL_EASF07,
+  LABEL_EASF08,
+  LABEL_EASF09,
+  LABEL_EASF10,
+  LABEL_EASD01,
+  LABEL_EASD02,
+  LABEL_EASD03,
+  LABEL_EASD04,
+  LABEL_EAIT,
+  LABEL_ERQ1,
+  LABEL_ERQ2,
+  LABEL_ERQ3,
+  LABEL_ERQ4,
+  LABEL_IRMS1,
+  LABEL_IRMS2,
+  LABEL_IRMS3,
+  LABEL_URMS1,
+  LABEL_URMS2,
+  LABEL_URMS3,
+  LABEL_PREF,
+  LABEL_PCOUP,
+  LABEL_SINSTS,
+  LABEL_SINSTS1,
+  LABEL_SINSTS2,
+  LABEL_SINSTS3,
+  LABEL_SMAXSN,
+  LABEL_SMAXSN1,
+  LABEL_SMAXSN2,
+  LABEL_SMAXSN3,
+  LABEL_SMAXSN_M1,
+  LABEL_SMAXSN1_M1,
+  LABEL_SMAXSN2_M1,
+  LABEL_SMAXSN3_M1,
+  LABEL_SINSTI,
+  LABEL_SMAXIN,
+  LABEL_SMAXIN_M1,
+  LABEL_CCASN,
+  LABEL_CCASN_M1,
+  LABEL_CCAIN,
+  LABEL_CCAIN_M1,
+  LABEL_UMOY1,
+  LABEL_UMOY2,
+  LABEL_UMOY3,
+  LABEL_STGE,
+  LABEL_PRM,
+  LABEL_RELAIS,
+  LABEL_NTARF,
+  LABEL_NJOURF,
+  LABEL_NJOURF_P1,
+  LABEL_COUNT,
+  LABEL_UNKNOWN = 0xFF
+};
+
+// FNV-1a hash of a label, usable at compile time
+constexpr uint32_t tinfoLabelHash(const char * s, uint32_t h = TINFO_LABEL_SEED)
+{
+  return *s ? tinfoLabelHash(s + 1, (h ^ (uint8_t) *s) * 16777619UL) : h;
+}
+
+constexpr uint16_t tinfoLabelFold(uint32_t h)
+{
+  return (h ^ (h >> 16)) & (TINFO_LABEL_SLOTS - 1);
+}
+
+// Slot of a label in the perfect hash table
+constexpr uint16_t tinfoLabelSlot(const char * s)
+{
+  return tinfoLabelFold(tinfoLabelHash(s));
+}
+
+// Unknown label kept in overflow area
+typedef struct
+{
+  char name[TINFO_LABEL_SIZE];
+  char value[TINFO_EXTRA_SIZE];
+} _tinfoextra;
+
+// Fixed size table of last received value of each label
+class TInfoLabels
+{
+public:
+  TInfoLabels() { clear(); }
+  void clear(void);
+  bool empty(void) const;
+  uint8_t set(const char * name, const char * value);
+
+  // O(1) access to a known label, empty string if not received
+  inline bool has(uint8_t id) const 
+  { return id < LABEL_COUNT && (_present[id >> 5] & (1UL << (id & 31))); }
+  inline const char * get(uint8_t id) const 
+  { return has(id) ? _values[id] : ""; }
+
+  // Access by name, known or not, NULL if not received
+  const char * get(const char * name) const;
+
+  // Overflow area
+  inline uint8_t extraCount(void) const { return _extra_count; }
+  inline const char * extraName(uint8_t i) const { return _extra[i].name; }
+  inline const char * extraValue(uint8_t i) const { return _extra[i].value; }
+
+  // Values added or updated in last complete frame, frameDone() is
+  // called on each frame end
+  inline bool changed(uint8_t id) const
+  { return id < LABEL_COUNT && (_frame_changed[id >> 5] & (1UL << (id & 31))); }
+  inline bool extraChanged(uint8_t i) const { return _frame_extra_changed & (1UL << i); }
+  void frameDone(void);
+
+  static uint8_t labelId(const char * name);
+  static const __FlashStringHelper * labelName(uint8_t id);
+
+private:
+  char        _values[LABEL_COUNT][TINFO_VALUE_SIZE];
+  uint32_t    _present[(LABEL_COUNT + 31) / 32];
+  uint32_t    _changed[(LABEL_COUNT + 31) / 32];        // set in frame being received
+  uint32_t    _frame_changed[(LABEL_COUNT + 31) / 32];  // set in last complete frame
+  _tinfoextra _extra[TINFO_EXTRA_COUNT];
+  uint8_t     _extra_count;
+  uint32_t    _extra_changed;   // one bit per extra, TINFO_EXTRA_COUNT <= 32
+  uint32_t    _frame_extra_changed;
+};
+
+// Exported variables/object instancied in main sketch
+// ===================================================
+extern TInfoLabels tinfolabels;
+
+#endif
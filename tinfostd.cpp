@@ -0,0 +1,314 @@
+// **********************************************************************************
+// ESP8266 Teleinfo Linky standard mode decoder
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use, see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+
+#include "tinfostd.h"
+
+// Standard mode decoder
+TInfoStd tinfostd;
+
+// Effective running mode (never AUTO)
+uint8_t tinfo_mode = TINFO_MODE_HISTORIQUE;
+static unsigned long tinfo_mode_since = 0;
+
+// Standard labels also published under their historic name
+// so all consumers keep working whatever the meter mode is
+typedef struct
+{
+  uint8_t      std;
+  const char * hist;
+} _tinfoalias;
+
+static const _tinfoalias tinfo_aliases[] = {
+  { LABEL_ADSC,   "ADCO"    },
+  { LABEL_NGTF,   "OPTARIF" },
+  { LABEL_PREF,   "ISOUSC"  },
+  { LABEL_EAST,   "BASE"    },
+  { LABEL_EASF01, "HCHC"    },
+  { LABEL_EASF02, "HCHP"    },
+  { LABEL_LTARF,  "PTEC"    },
+  { LABEL_IRMS1,  "IINST"   },
+  { LABEL_IRMS2,  "IINST2"  },
+  { LABEL_IRMS3,  "IINST3"  },
+  { LABEL_SMAXSN, "PMAX"    },
+  { LABEL_SINSTS, "PAPP"    }
+};
+
+/* ======================================================================
+Function: TInfoStd
+Purpose : class constructor
+Input   : -
+Output  : -
+Comments: -
+====================================================================== */
+TInfoStd::TInfoStd()
+{
+  _fn_new_frame = NULL;
+  _fn_updated_frame = NULL;
+  _checksum_errors = 0;
+  init();
+}
+
+/* ======================================================================
+Function: init
+Purpose : reset decoder state
+Input   : -
+Output  : -
+Comments: -
+====================================================================== */
+void TInfoStd::init(void)
+{
+  _idx = 0;
+  _in_frame = false;
+  _in_group = false;
+  _frame_updated = false;
+}
+
+void TInfoStd::attachNewFrame(void (*fn_new_frame)(ValueList * valueslist))
+{
+  _fn_new_frame = fn_new_frame;
+}
+
+void TInfoStd::attachUpdatedFrame(void (*fn_updated_frame)(ValueList * valueslist))
+{
+  _fn_updated_frame = fn_updated_frame;
+}
+
+/* ======================================================================
+Function: process
+Purpose : process one received char
+Input   : char received on serial
+Output  : -
+Comments: a group is <LF>label<HT>[horodate<HT>]value<HT>checksum<CR>
+          it is kept in our buffer until <CR> and decoded there
+====================================================================== */
+void TInfoStd::process(char c)
+{
+  c &= 0x7F;
+
+  switch (c) {
+    case TINFO_STX:
+      _in_frame = true;
+      _in_group = false;
+      _frame_updated = false;
+      break;
+
+    case TINFO_ETX:
+      // Values are in tinfolabels, callbacks get no list
+      if (_in_frame) {
+        if (_frame_updated) {
+          if (_fn_updated_frame)
+            _fn_updated_frame(NULL);
+        } else {
+          if (_fn_new_frame)
+            _fn_new_frame(NULL);
+        }
+      }
+      _in_frame = false;
+      _in_group = false;
+      break;
+
+    // Frame interrupted by meter
+    case 0x04:
+      _in_frame = false;
+      _in_group = false;
+      break;
+
+    case TINFO_SGR:
+      _idx = 0;
+      _in_group = _in_frame;
+      break;
+
+    case TINFO_EGR:
+      if (_in_group) {
+        _buf[_idx] = '\0';
+        decodeGroup();
+      }
+      _in_group = false;
+      break;
+
+    default:
+      if (_in_group) {
+        // Too long, can't be a valid group
+        if (_idx >= sizeof(_buf) - 1)
+          _in_group = false;
+        else
+          _buf[_idx++] = c;
+      }
+      break;
+  }
+}
+
+/* ======================================================================
+Function: decodeGroup
+Purpose : check and split the group we just received
+Input   : -
+Output  : -
+Comments: separators are replaced by '\0' in the receive buffer,
+          name and value point directly into it until stored
+====================================================================== */
+void TInfoStd::decodeGroup(void)
+{
+  uint8_t sum = 0;
+  char * name = _buf;
+  char * value;
+  char * p;
+
+  // minimal group is "X<HT>V<HT>C"
+  if (_idx < 5 || _buf[_idx - 2] != TINFO_HT) {
+    _checksum_errors++;
+    return;
+  }
+
+  // Checksum covers everything up to and including last HT
+  for (p = _buf; p < _buf + _idx - 1; p++)
+    sum += (uint8_t) *p;
+
+  if (((sum & 0x3F) + 0x20) != (uint8_t) _buf[_idx - 1]) {
+    _checksum_errors++;
+    return;
+  }
+
+  // Cut checksum
+  _buf[_idx - 2] = '\0';
+
+  // Cut label
+  value = strchr(name, TINFO_HT);
+  if (!value)
+    return;
+  *value++ = '\0';
+
+  // Horodated group ?
+  p = strchr(value, TINFO_HT);
+  if (p) {
+    *p++ = '\0';
+    // Horodate only group (DATE), keep horodate as value
+    if (*p)
+      value = p;
+  }
+
+  if (*name && *value)
+    addValue(name, value);
+}
+
+/* ======================================================================
+Function: addValue
+Purpose : store value in labels table and its historic alias if any
+Input   : label
+          value
+Output  : -
+Comments: values only live in tinfolabels, there is no TInfo list in
+          standard mode, nothing is allocated
+====================================================================== */
+void TInfoStd::addValue(char * name, char * value)
+{
+  uint8_t id = TInfoLabels::labelId(name);
+  char conv[8];
+
+  if (tinfolabels.set(name, value) & (TINFO_FLAGS_ADDED | TINFO_FLAGS_UPDATED))
+    _frame_updated = true;
+
+  for (uint8_t i = 0; id != LABEL_UNKNOWN && i < sizeof(tinfo_aliases) / sizeof(_tinfoalias); i++) {
+    const char * hist = tinfo_aliases[i].hist;
+
+    if (id != tinfo_aliases[i].std)
+      continue;
+
+    // PREF is in kVA, ISOUSC is in A at 200V
+    if (id == LABEL_PREF) {
+      if (strlen(value) > TINFO_PREF_SIZE)
+        break;
+      snprintf_P(conv, sizeof(conv), PSTR("%ld"), atol(value) * 5);
+      value = conv;
+    // Tariff option and period are labels, historic are 4 chars codes
+    } else if (id == LABEL_NGTF) {
+           if (strstr(value, "TEMPO"))  value = strcpy(conv, "BBR(");
+      else if (strstr(value, "EJP"))    value = strcpy(conv, "EJP.");
+      else if (strstr(value, "CREUSE")) value = strcpy(conv, "HC..");
+      else if (strstr(value, "BASE"))   value = strcpy(conv, "BASE");
+    } else if (id == LABEL_LTARF) {
+           if (strstr(value, "CREUSE"))  value = strcpy(conv, "HC..");
+      else if (strstr(value, "PLEINE"))  value = strcpy(conv, "HP..");
+      else if (strstr(value, "NORMALE")) value = strcpy(conv, "HN..");
+      else if (strstr(value, "POINTE"))  value = strcpy(conv, "PM..");
+      else if (strstr(value, "BASE"))    value = strcpy(conv, "TH..");
+    }
+
+    tinfolabels.set(hist, value);
+    break;
+  }
+}
+
+/* ======================================================================
+Function: tinfoSetMode
+Purpose : select teleinfo decoder and serial speed
+Input   : TINFO_MODE_HISTORIQUE or TINFO_MODE_STANDARD
+          (TINFO_MODE_AUTO start with historic)
+Output  : -
+Comments: values of previous mode are cleared
+====================================================================== */
+void tinfoSetMode(uint8_t mode)
+{
+  tinfo_mode = mode == TINFO_MODE_STANDARD ? TINFO_MODE_STANDARD : TINFO_MODE_HISTORIQUE;
+
+  #ifdef DEBUG_SERIAL1
+    Serial.updateBaudRate(tinfo_mode == TINFO_MODE_STANDARD ? TINFO_STD_BAUD : TINFO_HIST_BAUD);
+  #endif
+
+  tinfo.init();
+  tinfostd.init();
+  tinfolabels.clear();
+  tinfoFrameClear();
+  jsonCacheClear();
+  tinfo_mode_since = millis();
+
+  Infof("Teleinfo mode %s\n", tinfoModeName());
+}
+
+/* ======================================================================
+Function: tinfoModeHandle
+Purpose : auto detect teleinfo mode
+Input   : millis() of last frame received
+Output  : -
+Comments: if no frame has been decoded for a while, we try the other
+          mode (and speed), only when configured in auto mode
+====================================================================== */
+void tinfoModeHandle(unsigned long last_frame)
+{
+  unsigned long ref = tinfo_mode_since;
+
+  if (config.tic_mode != TINFO_MODE_AUTO || replayActive())
+    return;
+
+  if ((long) (last_frame - ref) > 0)
+    ref = last_frame;
+
+  if (millis() - ref >= TINFO_DETECT_TIMEOUT)
+    tinfoSetMode(tinfo_mode == TINFO_MODE_STANDARD ? TINFO_MODE_HISTORIQUE : TINFO_MODE_STANDARD);
+}
+
+/* ======================================================================
+Function: tinfoModeName
+Purpose : return running mode name
+Input   : -
+Output  : mode name
+Comments: -
+====================================================================== */
+const char * tinfoModeName(void)
+{
+  return tinfo_mode == TINFO_MODE_STANDARD ? "Standard" : "Historique";
+}
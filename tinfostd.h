@@ -0,0 +1,74 @@
+// **********************************************************************************
+// ESP8266 Teleinfo Linky standard mode decoder Include file
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use , see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#ifndef TINFOSTD_H
+#define TINFOSTD_H
+
+// Include main project include file
+#include "Wifinfo.h"
+
+// Teleinfo modes (config.tic_mode)
+#define TINFO_MODE_AUTO       0 // Detect mode and speed
+#define TINFO_MODE_HISTORIQUE 1 // Historic mode 1200 bps, space separator
+#define TINFO_MODE_STANDARD   2 // Linky standard mode 9600 bps, HT separator
+
+#define TINFO_HIST_BAUD       1200
+#define TINFO_STD_BAUD        9600
+#define TINFO_DETECT_TIMEOUT  10000 // Switch mode if no frame within (ms)
+
+#define TINFO_PREF_SIZE       2     // PREF value digits (kVA)
+
+// Largest standard group is PJOURF+1/PPOINTE (label+98 chars value)
+#define TINFO_STD_BUFSIZE     128
+
+class TInfoStd
+{
+public:
+  TInfoStd();
+  void init(void);
+  void process(char c);
+  void attachNewFrame(void (*fn_new_frame)(ValueList * valueslist));
+  void attachUpdatedFrame(void (*fn_updated_frame)(ValueList * valueslist));
+  uint32_t checksumErrors(void) { return _checksum_errors; }
+
+private:
+  void decodeGroup(void);
+  void addValue(char * name, char * value);
+
+  char    _buf[TINFO_STD_BUFSIZE]; // current group, tokenized in place
+  uint8_t _idx;
+  bool    _in_frame;
+  bool    _in_group;
+  bool    _frame_updated;
+  uint32_t _checksum_errors;
+
+  void (*_fn_new_frame)(ValueList * valueslist);
+  void (*_fn_updated_frame)(ValueList * valueslist);
+};
+
+// Exported variables/object instancied in main sketch
+// ===================================================
+extern TInfoStd tinfostd;
+extern uint8_t tinfo_mode;
+
+// declared exported function from tinfostd.cpp
+// ===================================================
+void tinfoSetMode(uint8_t mode);
+void tinfoModeHandle(unsigned long last_frame);
+const char * tinfoModeName(void);
+
+#endif
@@ -0,0 +1,145 @@
+// **********************************************************************************
+// ESP8266 Teleinfo binary UDP frame datagrams
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use, see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+
+#include "udpframe.h"
+
+// Sender statistics
+_udpframestat udpframestat;
+
+static WiFiUDP udp_frame;
+static uint8_t udp_frame_buf[UDP_FRAME_SIZE];
+static uint32_t udp_frame_seq = 0;
+static bool udp_frame_open = false;
+
+/* ======================================================================
+Function: udpFramePut
+Purpose : write a varint in datagram
+Input   : where to write, updated
+          end of room
+          value
+Output  : false if no room
+Comments: -
+====================================================================== */
+static bool udpFramePut(uint8_t ** p, const uint8_t * end, uint32_t v)
+{
+  do {
+    if (*p >= end)
+      return false;
+    *(*p)++ = (v & 0x7F) | (v > 0x7F ? 0x80 : 0);
+    v >>= 7;
+  } while (v);
+  return true;
+}
+
+/* ======================================================================
+Function: udpFrameEncode
+Purpose : encode current frame in datagram buffer
+Input   : true if frame changed
+Output  : datagram size
+Comments: numeric values only (see tinfoFrameValue), unknown labels
+          have no id so they are not sent
+====================================================================== */
+static uint16_t udpFrameEncode(boolean updated)
+{
+  _udpframehdr hdr;
+  uint8_t * p = udp_frame_buf + sizeof(hdr);
+  const uint8_t * end = udp_frame_buf + sizeof(udp_frame_buf);
+  unsigned long ms = millis();
+
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.magic[0] = UDP_FRAME_MAGIC0;
+  hdr.magic[1] = UDP_FRAME_MAGIC1;
+  hdr.version = UDP_FRAME_VERSION;
+  hdr.flags = updated ? UDP_FRAME_UPDATED : 0;
+  hdr.seq = udp_frame_seq;
+  hdr.uptime_ms = ms;
+  hdr.labels = LABEL_COUNT;
+  if (httpEpoch(ms, &hdr.epoch, &hdr.epoch_ms))
+    hdr.flags |= UDP_FRAME_EPOCH;
+
+  for (uint8_t id = 0; id < LABEL_COUNT; id++) {
+    uint8_t * item = p;
+    uint32_t number;
+
+    if (!tinfoFrameValue(id, &number))
+      continue;
+
+    if (p >= end || (*p++ = id, !udpFramePut(&p, end, number))) {
+      p = item;
+      hdr.flags |= UDP_FRAME_TRUNC;
+      break;
+    }
+    hdr.count++;
+  }
+
+  memcpy(udp_frame_buf, &hdr, sizeof(hdr));
+  return p - udp_frame_buf;
+}
+
+/* ======================================================================
+Function: udpFrameSend
+Purpose : send current frame to receivers
+Input   : true if frame changed
+Output  : -
+Comments: called on each frame, a receiver with decimation N gets one
+          frame out of N, sequence tells it which ones it missed
+====================================================================== */
+void udpFrameSend(boolean updated)
+{
+  uint16_t size = 0;
+
+  if (!config.udp.port || WiFi.status() != WL_CONNECTED)
+    return;
+
+  for (uint8_t i = 0; i < CFG_UDP_RECEIVERS; i++) {
+    _udprcv * rcv = &config.udp.rcv[i];
+
+    if (!rcv->ip || (rcv->every > 1 && udp_frame_seq % rcv->every))
+      continue;
+
+    // Encoded once for all receivers
+    if (!size) {
+      if (!udp_frame_open)
+        udp_frame_open = udp_frame.begin(config.udp.port);
+      size = udpFrameEncode(updated);
+      udpframestat.frames++;
+      udpframestat.size = size;
+    }
+
+    if (udp_frame.beginPacket(IPAddress(rcv->ip), config.udp.port) &&
+        udp_frame.write(udp_frame_buf, size) == size && udp_frame.endPacket())
+      udpframestat.sent++;
+    else
+      udpframestat.errors++;
+  }
+  udp_frame_seq++;
+}
+
+/* ======================================================================
+Function: udpFrameSetup
+Purpose : apply configuration
+Input   : -
+Output  : -
+Comments: local port is bound again on next datagram
+====================================================================== */
+void udpFrameSetup(void)
+{
+  if (udp_frame_open)
+    udp_frame.stop();
+  udp_frame_open = false;
+}
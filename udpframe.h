@@ -0,0 +1,73 @@
+// **********************************************************************************
+// ESP8266 Teleinfo binary UDP frame datagrams Include file
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use , see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#ifndef UDPFRAME_H
+#define UDPFRAME_H
+
+// Include main project include file
+#include "Wifinfo.h"
+
+#define UDP_FRAME_SIZE      512   // max datagram, one Ethernet frame
+#define UDP_FRAME_MAGIC0    'T'
+#define UDP_FRAME_MAGIC1    'F'
+#define UDP_FRAME_VERSION   1
+
+// Datagram flags
+#define UDP_FRAME_UPDATED   0x01  // some value changed since previous frame
+#define UDP_FRAME_EPOCH     0x02  // epoch fields are valid
+#define UDP_FRAME_TRUNC     0x04  // not all values did fit
+
+#pragma pack(push)  // push current alignment to stack
+#pragma pack(1)     // set alignment to 1 byte boundary
+
+// Datagram header, little endian, followed by count pairs of
+// label id (LABEL_xxx, uint8) and value (unsigned LEB128 varint)
+// 20 Bytes
+typedef struct
+{
+  uint8_t  magic[2];      // UDP_FRAME_MAGIC0/1
+  uint8_t  version;       // UDP_FRAME_VERSION
+  uint8_t  flags;         // UDP_FRAME_xxx
+  uint32_t seq;           // frame sequence, same for all receivers
+  uint32_t uptime_ms;     // millis() when frame was received
+  uint32_t epoch;         // seconds since 1970 when frame was received
+  uint16_t epoch_ms;      // milliseconds of epoch
+  uint8_t  labels;        // LABEL_COUNT, known labels table of sender
+  uint8_t  count;         // values following
+} _udpframehdr;
+
+#pragma pack(pop)
+
+// Sender statistics
+typedef struct
+{
+  uint32_t frames;        // frames encoded
+  uint32_t sent;          // datagrams sent
+  uint32_t errors;        // datagrams the stack refused
+  uint16_t size;          // last datagram size
+} _udpframestat;
+
+// Exported variables/object instancied in main sketch
+// ===================================================
+extern _udpframestat udpframestat;
+
+// declared exported function from udpframe.cpp
+// ===================================================
+void udpFrameSend(boolean updated);
+void udpFrameSetup(void);
+
+#endif
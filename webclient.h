@@ -26,15 +26,31 @@
 // Include main project include file
 #include "Wifinfo.h"
 
+class PString;
+
+// Domoticz devices updated with a value (udevice)
+enum
+{
+  DMCZ_P1SM = 0,  // P1 Smart Meter
+  DMCZ_CRT,       // Current
+  DMCZ_ELEC,      // Electric
+  DMCZ_KWH,       // kWh
+  DMCZ_PCT,       // Percentage
+  DMCZ_DEVICES
+};
+
 // Exported variables/object instancied in main sketch
 // ===================================================
 
 // declared exported function from route.cpp
 // ===================================================
-boolean httpPost(char * host, uint16_t port, char * url);
-boolean httpPostBasicAuth(char * host, uint16_t port, char * url, char * basicauthusr, char * basicauthpwd);
 boolean emoncmsPost(void);
 boolean jeedomPost(void);
+void jeedomSetup(void);
 boolean domoticzPost(void);
+uint16_t domoticzDevice(uint8_t dev, uint32_t * mask);
+void domoticzValue(uint8_t dev, PString & out);
+void urlEncode(PString & out, const char * value);
+void urlEncode_P(PString & out, PGM_P value);
 
 #endif
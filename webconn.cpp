@@ -0,0 +1,391 @@
+// **********************************************************************************
+// ESP8266 Teleinfo multi-connection web server
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use, see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+
+#include "webconn.h"
+
+// Connections statistics
+_webconnstat webconnstat;
+
+/* ======================================================================
+Function: WebConnServer::begin
+Purpose : start listening
+Input   : -
+Output  : -
+Comments: responses tell clients they can keep connection open
+====================================================================== */
+void WebConnServer::begin(void)
+{
+  for (uint8_t i = 0; i < WEB_CONNS; i++)
+    _conns[i].state = WEB_CONN_FREE;
+
+  ESP8266WebServer::begin();
+  keepAlive(true);
+}
+
+/* ======================================================================
+Function: WebConnServer::release
+Purpose : close a connection and free its slot
+Input   : connection
+Output  : -
+Comments: -
+====================================================================== */
+void WebConnServer::release(_webconn * c)
+{
+  if (c->state == WEB_CONN_FILE)
+    c->file.close();
+  c->client.stop();
+  c->client = WiFiClient();
+  c->state = WEB_CONN_FREE;
+  webconnstat.conns--;
+}
+
+/* ======================================================================
+Function: WebConnServer::accept
+Purpose : take new connections
+Input   : -
+Output  : -
+Comments: when all slots are used, the connection idle for longest
+          time is closed, if none is idle new one gets a 503. One that
+          just got its response may still be sending it, and stop()
+          would wait for it, so it is not closed
+====================================================================== */
+void WebConnServer::accept(void)
+{
+  WiFiClient client;
+
+  while ((client = _server.available())) {
+    _webconn * c = NULL;
+    _webconn * idle = NULL;
+
+    for (uint8_t i = 0; i < WEB_CONNS; i++) {
+      _webconn * t = &_conns[i];
+
+      if (t->state == WEB_CONN_FREE) {
+        c = t;
+        break;
+      }
+      if (t->state == WEB_CONN_IDLE && !t->head_ms && !t->client.available() &&
+          millis() - t->idle_ms >= WEB_EVICT_MS &&
+          (!idle || (long) (t->idle_ms - idle->idle_ms) < 0))
+        idle = t;
+    }
+
+    if (!c && idle) {
+      webconnstat.evicted++;
+      release(idle);
+      c = idle;
+    }
+
+    if (!c) {
+      webconnstat.refused++;
+      client.print(F("HTTP/1.1 503 Service Unavailable\r\n"
+                     "Retry-After: 1\r\nContent-Length: 0\r\nConnection: close\r\n\r\n"));
+      client.stop();
+      continue;
+    }
+
+    // Writes return once data is queued, not when it's acknowledged
+    c->client = client;
+    c->client.setSync(false);
+    c->state = WEB_CONN_IDLE;
+    c->idle_ms = millis();
+    c->head_ms = 0;
+    c->avail = 0;
+    c->served = 0;
+    c->close = false;
+
+    webconnstat.accepted++;
+    if (++webconnstat.conns > webconnstat.max_conns)
+      webconnstat.max_conns = webconnstat.conns;
+  }
+}
+
+/* ======================================================================
+Function: WebConnServer::ready
+Purpose : check if request of a connection has been received
+Input   : connection
+Output  : WEB_REQ_xxx
+Comments: ESP8266WebServer parser waits for what is missing, so we
+          give it a request only once all of it is there: head up to
+          empty line, and form body if it's not too big. We peek at
+          what has been received, only when more came in.
+          Uploads are parsed as they come, handler gets them by
+          pieces anyway.
+====================================================================== */
+uint8_t WebConnServer::ready(_webconn * c)
+{
+  char head[WEB_HEAD_SIZE + 1];
+  size_t avail = c->client.available();
+  size_t len;
+  char * end;
+  char * p;
+
+  if (!avail)
+    return WEB_REQ_WAIT;
+
+  if (!c->head_ms)
+    c->head_ms = millis();
+  else if (millis() - c->head_ms > WEB_HEAD_WAIT_MS)
+    return WEB_REQ_TIMEOUT;
+
+  // Nothing new since last time
+  if (avail == c->avail)
+    return WEB_REQ_WAIT;
+  c->avail = avail;
+  c->close = false;
+
+  // We only see first received segment, if there is more or if head
+  // is bigger than what we check, parser won't have to wait long
+  len = c->client.peekBytes((uint8_t *) head, WEB_HEAD_SIZE);
+  head[len] = '\0';
+  if (!(end = strstr(head, "\r\n\r\n")))
+    return len == WEB_HEAD_SIZE || avail > len ? WEB_REQ_READY : WEB_REQ_WAIT;
+  *end = '\0';
+
+  // Not HTTP/1.1 or client asked us to close
+  c->close = !strstr(head, " HTTP/1.1") || strcasestr(head, "\r\nConnection: close");
+
+  // Form body must be there too
+  if ((p = strcasestr(head, "\r\nContent-Length:"))) {
+    size_t body = strtoul(p + 17, NULL, 10);
+
+    if (body <= WEB_BODY_SIZE && avail < (size_t) (end - head) + 4 + body)
+      return WEB_REQ_WAIT;
+  }
+
+  return WEB_REQ_READY;
+}
+
+/* ======================================================================
+Function: WebConnServer::request
+Purpose : parse and handle request of a connection
+Input   : connection
+Output  : -
+Comments: same as ESP8266WebServer::handleClient() once request is
+          there, then connection is kept for next one unless client
+          or handler closed it
+====================================================================== */
+void WebConnServer::request(_webconn * c)
+{
+  unsigned long start = micros();
+  uint32_t elapsed;
+
+  webconnstat.requests++;
+  if (c->served++)
+    webconnstat.reused++;
+
+  _conn = c;
+  _detached = false;
+  _currentClient = c->client;
+  _currentStatus = HC_WAIT_READ;
+  _statusChange = millis();
+
+  switch (_parseRequest(_currentClient)) {
+    case CLIENT_REQUEST_CAN_CONTINUE:
+      _currentClient.setTimeout(HTTP_MAX_SEND_WAIT);
+      _contentLength = CONTENT_LENGTH_NOT_SET;
+      _handleRequest();
+      break;
+
+    case CLIENT_REQUEST_IS_HANDLED:
+      break;
+
+    case CLIENT_IS_GIVEN:
+      _detached = true;
+      break;
+
+    default:
+      c->close = true;
+      break;
+  }
+
+  _currentClient = WiFiClient();
+  _currentStatus = HC_NONE;
+  _currentUpload.reset();
+  _conn = NULL;
+
+  c->head_ms = 0;
+  c->avail = 0;
+  c->idle_ms = millis();
+
+  if (_detached) {
+    // Handler owns the connection now
+    c->client = WiFiClient();
+    c->state = WEB_CONN_FREE;
+    webconnstat.conns--;
+  } else if (c->state != WEB_CONN_FILE && (c->close || !c->client.connected())) {
+    release(c);
+  }
+
+  elapsed = micros() - start;
+  if (elapsed > webconnstat.max_us)
+    webconnstat.max_us = elapsed;
+}
+
+/* ======================================================================
+Function: WebConnServer::pump
+Purpose : send next part of a file
+Input   : connection
+Output  : -
+Comments: only what fits in TCP send buffer, so we never wait for
+          client acknowledges. Flash is read by whole chunks, we wait
+          for room for one rather than reading what few bytes the
+          last acknowledge freed
+====================================================================== */
+void WebConnServer::pump(_webconn * c)
+{
+  uint8_t buf[WEB_FILE_CHUNK];
+
+  for (uint8_t i = 0; i < WEB_FILE_CHUNKS && c->left; i++) {
+    size_t room = c->client.availableForWrite();
+    size_t n;
+
+    if (room > sizeof(buf))
+      room = sizeof(buf);
+    if (room > c->left)
+      room = c->left;
+    if (room < sizeof(buf) && room < c->left)
+      return;
+
+    n = c->file.read(buf, room);
+    if (!n || c->client.write((const uint8_t *) buf, n) != n) {
+      release(c);
+      return;
+    }
+    c->left -= n;
+    webconnstat.file_bytes += n;
+  }
+
+  if (c->left)
+    return;
+
+  c->file.close();
+  c->file = File();
+  c->state = WEB_CONN_IDLE;
+  c->idle_ms = millis();
+  if (c->close)
+    release(c);
+}
+
+/* ======================================================================
+Function: WebConnServer::handleConnections
+Purpose : serve clients
+Input   : -
+Output  : -
+Comments: to be called from main loop instead of handleClient(),
+          accepts connections, sends files, then handles at most one
+          request so a pass stays short whatever the number of clients
+====================================================================== */
+void WebConnServer::handleConnections(void)
+{
+  accept();
+
+  for (uint8_t i = 0; i < WEB_CONNS; i++) {
+    _webconn * c = &_conns[i];
+
+    if (c->state == WEB_CONN_FILE) {
+      if (c->client.connected())
+        pump(c);
+      else
+        release(c);
+    } else if (c->state == WEB_CONN_IDLE) {
+      if (!c->client.connected() && !c->client.available()) {
+        release(c);
+      } else if (!c->head_ms && !c->client.available() && millis() - c->idle_ms > WEB_IDLE_MS) {
+        webconnstat.timeouts++;
+        release(c);
+      }
+    }
+  }
+
+  // Connections in turn, so one client can't starve others
+  for (uint8_t i = 0; i < WEB_CONNS; i++) {
+    uint8_t n = (_next + i) % WEB_CONNS;
+    _webconn * c = &_conns[n];
+
+    if (c->state != WEB_CONN_IDLE)
+      continue;
+
+    switch (ready(c)) {
+      case WEB_REQ_WAIT:
+        continue;
+
+      case WEB_REQ_TIMEOUT:
+        webconnstat.timeouts++;
+        c->client.print(F("HTTP/1.1 408 Request Timeout\r\n"
+                          "Content-Length: 0\r\nConnection: close\r\n\r\n"));
+        release(c);
+        continue;
+
+      case WEB_REQ_READY:
+        request(c);
+        _next = (n + 1) % WEB_CONNS;
+        return;
+    }
+  }
+}
+
+/* ======================================================================
+Function: WebConnServer::streamFileAsync
+Purpose : answer request with a file, sent from main loop
+Input   : file, it is closed once sent
+          content type
+Output  : file size
+Comments: same headers as streamFile(), handler returns right away
+          and connection is busy until whole file is sent
+====================================================================== */
+size_t WebConnServer::streamFileAsync(File & file, const String & contentType)
+{
+  size_t size = file.size();
+
+  // Not called from a request of ours
+  if (!_conn) {
+    size = streamFile(file, contentType);
+    file.close();
+    return size;
+  }
+
+  if (String(file.name()).endsWith(".gz") && contentType != F("application/x-gzip"))
+    sendHeader(F("Content-Encoding"), F("gzip"));
+  setContentLength(size);
+  send(200, contentType, "");
+
+  // Nothing more to send
+  if (method() == HTTP_HEAD || !size) {
+    file.close();
+    return size;
+  }
+
+  _conn->file = file;
+  _conn->left = size;
+  _conn->state = WEB_CONN_FILE;
+  webconnstat.files++;
+  return size;
+}
+
+/* ======================================================================
+Function: WebConnServer::detach
+Purpose : give connection of current request to handler
+Input   : -
+Output  : -
+Comments: it stays open and we forget it, see sseSubscribe()
+====================================================================== */
+void WebConnServer::detach(void)
+{
+  _detached = true;
+}
@@ -0,0 +1,111 @@
+// **********************************************************************************
+// ESP8266 Teleinfo multi-connection web server Include file
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CC-BY-SA license:
+// Attribution-NonCommercial-ShareAlike 4.0 International License
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//
+// For any explanation about teleinfo ou use , see my blog
+// http://hallard.me/category/tinfo
+//
+// This program works with the Wifinfo board
+// see schematic here https://github.com/hallard/teleinfo/tree/master/Wifinfo
+//
+// All text above must be included in any redistribution.
+//
+// **********************************************************************************
+#ifndef WEBCONN_H
+#define WEBCONN_H
+
+// Include main project include file
+#include "Wifinfo.h"
+
+#define WEB_CONNS           4     // connections open at the same time
+#define WEB_HEAD_SIZE       1024  // request head we check is complete before parsing
+#define WEB_BODY_SIZE       2048  // form body we wait for before parsing, uploads don't wait
+#define WEB_HEAD_WAIT_MS    3000  // time a client has to send its whole request
+#define WEB_IDLE_MS         5000  // keep-alive connection without request is closed
+#define WEB_EVICT_MS        1000  // idle time before connection can be closed for a new one
+#define WEB_FILE_CHUNK      512   // file bytes read and written at once
+#define WEB_FILE_CHUNKS     4     // chunks written to a connection in one pass
+
+// Connection states
+enum {
+  WEB_CONN_FREE = 0,  // slot not used
+  WEB_CONN_IDLE,      // waiting for a request, or for all of it
+  WEB_CONN_FILE       // response body is a file being sent
+};
+
+// Where we are with request of a connection
+enum {
+  WEB_REQ_WAIT = 0,   // nothing or not all of it yet
+  WEB_REQ_READY,      // can be parsed without waiting
+  WEB_REQ_TIMEOUT     // client is too slow
+};
+
+// One client connection, kept open between requests
+typedef struct
+{
+  WiFiClient    client;
+  File          file;     // WEB_CONN_FILE, what is left of it is sent
+  uint32_t      left;     // file bytes left to send
+  unsigned long idle_ms;  // millis() when accepted or last response done
+  unsigned long head_ms;  // millis() when request started to come, 0 if none
+  size_t        avail;    // bytes received when we last checked request
+  uint16_t      served;   // requests served on this connection
+  uint8_t       state;    // WEB_CONN_xxx
+  bool          close;    // close once response is sent
+} _webconn;
+
+// Connections statistics
+typedef struct
+{
+  uint32_t accepted;      // connections accepted
+  uint32_t refused;       // connections refused, all slots busy
+  uint32_t evicted;       // idle connections closed for a new one
+  uint32_t timeouts;      // connections closed, idle or request too slow
+  uint32_t requests;      // requests handled
+  uint32_t reused;        // requests on a kept alive connection
+  uint32_t files;         // files sent in background
+  uint32_t file_bytes;    // bytes of these files
+  uint32_t max_us;        // worst request handling time
+  uint8_t  conns;         // connections open now
+  uint8_t  max_conns;     // most connections open at the same time
+} _webconnstat;
+
+// ESP8266WebServer routes, parser and responses, but connections
+// are ours: several stay open, a request is handled only once it
+// has been received, and files are sent a chunk per loop() pass.
+// Handlers are the same, they just should not block.
+class WebConnServer : public ESP8266WebServer
+{
+private:
+  _webconn   _conns[WEB_CONNS];
+  _webconn * _conn;       // connection of request being handled
+  uint8_t    _next;       // first connection to look at next pass
+  bool       _detached;
+
+  void accept(void);
+  uint8_t ready(_webconn * c);
+  void request(_webconn * c);
+  void pump(_webconn * c);
+  void release(_webconn * c);
+
+public:
+  WebConnServer(int port) : ESP8266WebServer(port), _conn(NULL), _next(0), _detached(false) {}
+
+  void begin(void);
+  void handleConnections(void);
+
+  // To be used in handlers
+  size_t streamFileAsync(File & file, const String & contentType);
+  void detach(void);
+};
+
+// Exported variables/object instancied in main sketch
+// ===================================================
+extern WebConnServer server;
+extern _webconnstat webconnstat;
+
+#endif
@@ -59,45 +59,33 @@ Output  : Mime content type
 Comments: -
 ====================================================================== */
 String getContentType(String filename) {
-  if(filename.endsWith(".htm")) return F("text/html");
-  else if(filename.endsWith(".html")) return F("text/html");
-  else if(filename.endsWith(".css")) return F("text/css");
-  else if(filename.endsWith(".json")) return F("text/json");
-  else if(filename.endsWith(".js")) return F("application/javascript");
-  else if(filename.endsWith(".png")) return F("image/png");
-  else if(filename.endsWith(".gif")) return F("image/gif");
-  else if(filename.endsWith(".jpg")) return F("image/jpeg");
-  else if(filename.endsWith(".ico")) return F("image/x-icon");
-  else if(filename.endsWith(".xml")) return F("text/xml");
-  else if(filename.endsWith(".pdf")) return F("application/x-pdf");
-  else if(filename.endsWith(".zip")) return F("application/x-zip");
-  else if(filename.endsWith(".gz")) return F("application/x-gzip");
-  else if(filename.endsWith(".otf")) return F("application/x-font-opentype");
-  else if(filename.endsWith(".eot")) return F("application/vnd.ms-fontobject");
-  else if(filename.endsWith(".svg")) return F("image/svg+xml");
-  else if(filename.endsWith(".woff")) return F("application/x-font-woff");
-  else if(filename.endsWith(".woff2")) return F("application/x-font-woff2");
-  else if(filename.endsWith(".ttf")) return F("application/x-font-ttf");
-  return "text/plain";
+  return fileIndexTypeName(fileIndexType(filename.c_str()));
 }
 
 /* ======================================================================
-Function: handleFileRead 
+Function: handleFileFlash 
 Purpose : return content of a file stored on SPIFFS file system
 Input   : file path
 Output  : true if file found and sent
-Comments: -
+Comments: for files not in index (logs, captures, spool), web files
+          are in index so we don't look for them on flash
 ====================================================================== */
-bool handleFileRead(String path) {
+static bool handleFileFlash(String path) {
   if ( path.endsWith("/") ) 
     path += "index.htm";
-  
-  String contentType = getContentType(path);
-  String pathWithGz = path + ".gz";
 
   DebugF("handleFileRead ");
   Debug(path);
 
+  // Not there if it is a web file
+  if (fileIndexKnows(path.c_str())) {
+    Debugln("");
+    return false;
+  }
+
+  String contentType = getContentType(path);
+  String pathWithGz = path + ".gz";
+
   if(SPIFFS.exists(pathWithGz) || SPIFFS.exists(path)) {
     if( SPIFFS.exists(pathWithGz) ){
       path += ".gz";
@@ -107,17 +95,25 @@ bool handleFileRead(String path) {
     DebuglnF(" found on FS");
  
     File file = SPIFFS.open(path, "r");
-    size_t sent = server.streamFile(file, contentType);
-    file.close();
+    server.streamFileAsync(file, contentType);
     return true;
   }
 
   Debugln("");
-
-  server.send(404, "text/plain", "File Not Found");
   return false;
 }
 
+/* ======================================================================
+Function: handleFileRead 
+Purpose : return content of a file stored on SPIFFS file system
+Input   : file path
+Output  : true if file found and sent
+Comments: -
+====================================================================== */
+bool handleFileRead(String path) {
+  return fileIndexSend(path.c_str()) || handleFileFlash(path);
+}
+
 /* ======================================================================
 Function: handleSpiffsOperation 
 Purpose : hadle SPIFFS operation like file upload/replace, file delete
@@ -149,6 +145,7 @@ void handleSpiffsOperation(void)
       {
         if(SPIFFS.remove(file))
         {
+          fileIndexUpdate(file.c_str());
           response += "File deleted!";
           ret = 200;
         }
@@ -175,6 +172,94 @@ void handleSpiffsOperation(void)
   server.send ( ret, "text/plain", response);
 }
 
+/* ======================================================================
+Function: handleCaptureOperation 
+Purpose : handle teleinfo capture/replay operations
+Input   : -
+Output  : - 
+Comments: /capture?action=capture[&file=/capture.tic]
+          /capture?action=replay[&file=/capture.tic][&baud=1200][&speed=60][&loop=1]
+          /capture?action=stop
+====================================================================== */
+void handleCaptureOperation(void)
+{
+  String response="";
+  String file = server.hasArg("file") ? server.arg("file") : String(CAPTURE_DEFAULT_FILE);
+  int ret = 200;
+
+  if (server.hasArg("action"))
+  {
+    String action=server.arg("action");
+
+    if (action == "capture")
+    {
+      if (captureStart(file.c_str()))
+        response += "Capture started!";
+      else {
+        response += "Unable to create file!";
+        ret = 400;
+      }
+    }
+    else if (action == "replay")
+    {
+      uint32_t baud = tinfo_mode == TINFO_MODE_STANDARD ? TINFO_STD_BAUD : TINFO_HIST_BAUD;
+      if (server.hasArg("baud"))
+        baud = server.arg("baud").toInt();
+      uint16_t speed = server.hasArg("speed") ? server.arg("speed").toInt() : 1;
+
+      if (replayStart(file.c_str(), baud, speed, server.arg("loop").toInt() != 0))
+        response += "Replay started!";
+      else {
+        response += "Unable to open file!";
+        ret = 400;
+      }
+    }
+    else if (action == "stop")
+    {
+      captureStop();
+      replayStop();
+      response += "Stopped!";
+    }
+    else
+    {
+      response += "Bad argument(s)!";
+      ret = 400;
+    }
+  }
+  else
+  {
+    response += "Missing argument(s)";
+    ret = 400;
+  }
+
+  server.send ( ret, "text/plain", response);
+}
+
+/* ======================================================================
+Function: handleFormPush
+Purpose : get push on change settings of a sink from config form
+Input   : sink form fields prefix (emon, jdom, dmcz)
+          sink push settings
+Output  : - 
+Comments: -
+====================================================================== */
+static void handleFormPush(const char * prefix, _pushcfg * push)
+{
+  String name = prefix;
+  long itemp;
+
+  itemp = server.arg(name + CFG_FORM_PUSH_MODE).toInt();
+  push->mode = itemp == CFG_PUSH_CHANGE ? CFG_PUSH_CHANGE : CFG_PUSH_ALWAYS;
+  itemp = server.arg(name + CFG_FORM_PUSH_HB).toInt();
+  push->heartbeat = (itemp>=0 && itemp<=65535) ? itemp : 0;
+  itemp = server.arg(name + CFG_FORM_PUSH_DBPWR).toInt();
+  push->db_power = (itemp>=0 && itemp<=65535) ? itemp : 0;
+  itemp = server.arg(name + CFG_FORM_PUSH_DBCUR).toInt();
+  push->db_current = (itemp>=0 && itemp<=255) ? itemp : 0;
+  itemp = server.arg(name + CFG_FORM_PUSH_DBIDX).toInt();
+  push->db_index = (itemp>=0 && itemp<=65535) ? itemp : 0;
+}
+
 /* ======================================================================
 Function: handleFormConfig 
 Purpose : handle main configuration page
@@ -205,6 +290,11 @@ void handleFormConfig(void)
     strncpy(config.ota_auth,server.arg("ota_auth").c_str(), CFG_PSK_SIZE );
     itemp = server.arg("ota_port").toInt();
     config.ota_port = (itemp>=0 && itemp<=65535) ? itemp : DEFAULT_OTA_PORT ;
+    itemp = server.arg("tic_mode").toInt();
+    if (itemp != config.tic_mode && itemp>=TINFO_MODE_AUTO && itemp<=TINFO_MODE_STANDARD) {
+      config.tic_mode = itemp;
+      tinfoSetMode(itemp);
+    }
 
     if(server.hasArg("cfg_debug")) { config.config |= CFG_DEBUG; } else { config.config &= ~CFG_DEBUG; }
     if(server.hasArg("cfg_oled")) { config.config |= CFG_LCD; } else { config.config &= ~CFG_LCD; }
@@ -220,14 +310,14 @@ void handleFormConfig(void)
     itemp = server.arg("emon_port").toInt();
     config.emoncms.port = (itemp>=0 && itemp<=65535) ? itemp : CFG_EMON_DEFAULT_PORT ; 
     itemp = server.arg("emon_freq").toInt();
-    if (itemp>0 && itemp<=86400){
-      // Emoncms Update if needed
-      Tick_emoncms.detach();
-      Tick_emoncms.attach(itemp, Task_emoncms);
-    } else {
+    if (itemp<=0 || itemp>86400)
       itemp = 0 ; 
-    }
     config.emoncms.freq = itemp;
+    // Emoncms Update if needed
+    schedSet(TASK_EMONCMS, itemp * 1000UL);
+    itemp = server.arg("emon_bulk").toInt();
+    config.emoncms.bulk = (itemp>0 && itemp<=255) ? itemp : 0 ;
+    handleFormPush("emon", &config.emoncms.push);
 
     // jeedom
     strncpy(config.jeedom.host,   server.arg("jdom_host").c_str(),  CFG_JDOM_HOST_SIZE );
@@ -237,14 +327,17 @@ void handleFormConfig(void)
     itemp = server.arg("jdom_port").toInt();
     config.jeedom.port = (itemp>=0 && itemp<=65535) ? itemp : CFG_JDOM_DEFAULT_PORT ; 
     itemp = server.arg("jdom_freq").toInt();
-    if (itemp>0 && itemp<=86400){
-      // jeedom Update if needed
-      Tick_jeedom.detach();
-      Tick_jeedom.attach(itemp, Task_jeedom);
-    } else {
+    if (itemp<=0 || itemp>86400)
       itemp = 0 ; 
-    }
     config.jeedom.freq = itemp;
+    // jeedom Update if needed
+    schedSet(TASK_JEEDOM, itemp * 1000UL);
+    itemp = server.arg("jdom_fmt").toInt();
+    config.jeedom.format = (itemp>=CFG_JDOM_GET && itemp<=CFG_JDOM_JSON) ? itemp : CFG_JDOM_GET ;
+    itemp = server.arg("jdom_filter").toInt();
+    config.jeedom.filter = (itemp>=CFG_JDOM_ALL && itemp<=CFG_JDOM_EXCLUDE) ? itemp : CFG_JDOM_ALL ;
+    strncpy(config.jeedom.labels, server.arg("jdom_labels").c_str(), CFG_JDOM_LABELS_SIZE );
+    handleFormPush("jdom", &config.jeedom.push);
 
     // domoticz
     strncpy(config.domoticz.host,   server.arg("dmcz_host").c_str(),  CFG_DMCZ_HOST_SIZE );
@@ -272,14 +365,77 @@ void handleFormConfig(void)
     itemp = server.arg("dmcz_port").toInt();
     config.domoticz.port = (itemp>=0 && itemp<=65535) ? itemp : CFG_DMCZ_DEFAULT_PORT ; 
     itemp = server.arg("dmcz_freq").toInt();
-    if (itemp>0 && itemp<=86400){
-      // domoticz Update if needed
-      Tick_domoticz.detach();
-      Tick_domoticz.attach(itemp, Task_domoticz);
-    } else {
+    if (itemp<=0 || itemp>86400)
       itemp = 0 ; 
-    }
     config.domoticz.freq = itemp;
+    // domoticz Update if needed
+    schedSet(TASK_DOMOTICZ, itemp * 1000UL);
+    handleFormPush("dmcz", &config.domoticz.push);
+
+    // MQTT
+    strncpy(config.mqtt.host,  server.arg("mqtt_host").c_str(),  CFG_MQTT_HOST_SIZE );
+    strncpy(config.mqtt.usr,   server.arg("mqtt_usr").c_str(),   CFG_MQTT_USR_SIZE );
+    strncpy(config.mqtt.pwd,   server.arg("mqtt_pwd").c_str(),   CFG_MQTT_PWD_SIZE );
+    strncpy(config.mqtt.topic, server.arg("mqtt_topic").c_str(), CFG_MQTT_TOPIC_SIZE );
+    itemp = server.arg("mqtt_port").toInt();
+    config.mqtt.port = (itemp>0 && itemp<=65535) ? itemp : CFG_MQTT_DEFAULT_PORT ; 
+    itemp = server.arg("mqtt_qos").toInt();
+    config.mqtt.qos = (itemp==1) ? 1 : 0 ; 
+    itemp = server.arg("mqtt_ka").toInt();
+    config.mqtt.keepalive = (itemp>=0 && itemp<=65535) ? itemp : CFG_MQTT_DEFAULT_KA ; 
+    config.mqtt.mode = 0;
+    if(server.hasArg("mqtt_dz"))     { config.mqtt.mode |= CFG_MQTT_DOMOTICZ; }
+    if(server.hasArg("mqtt_frame"))  { config.mqtt.mode |= CFG_MQTT_FRAME; }
+    if(server.hasArg("mqtt_lwt"))    { config.mqtt.mode |= CFG_MQTT_LWT; }
+    if(server.hasArg("mqtt_retain")) { config.mqtt.mode |= CFG_MQTT_RETAIN; }
+    itemp = server.arg("mqtt_freq").toInt();
+    if (itemp<=0 || itemp>86400)
+      itemp = 0 ; 
+    config.mqtt.freq = itemp;
+    // MQTT Update if needed
+    schedSet(TASK_MQTT, itemp * 1000UL);
+    handleFormPush("mqtt", &config.mqtt.push);
+
+    // InfluxDB
+    strncpy(config.influx.host, server.arg("infx_host").c_str(), CFG_INFX_HOST_SIZE );
+    strncpy(config.influx.db,   server.arg("infx_db").c_str(),   CFG_INFX_DB_SIZE );
+    strncpy(config.influx.usr,  server.arg("infx_usr").c_str(),  CFG_INFX_USR_SIZE );
+    strncpy(config.influx.pwd,  server.arg("infx_pwd").c_str(),  CFG_INFX_PWD_SIZE );
+    strncpy(config.influx.measurement, server.arg("infx_meas").c_str(), CFG_INFX_MEAS_SIZE );
+    itemp = server.arg("infx_port").toInt();
+    config.influx.port = (itemp>0 && itemp<=65535) ? itemp : CFG_INFX_DEFAULT_PORT ; 
+    itemp = server.arg("infx_batch").toInt();
+    config.influx.batch = (itemp>0 && itemp<=255) ? itemp : CFG_INFX_DEFAULT_BATCH ; 
+    config.influx.gzip = server.hasArg("infx_gzip") ? 1 : 0;
+    itemp = server.arg("infx_freq").toInt();
+    if (itemp<=0 || itemp>86400)
+      itemp = 0 ; 
+    config.influx.freq = itemp;
+    // InfluxDB flush if needed
+    schedSet(TASK_INFLUX, itemp * 1000UL);
+
+    // UDP frame datagrams
+    itemp = server.arg("udp_port").toInt();
+    config.udp.port = (itemp>=0 && itemp<=65535) ? itemp : CFG_UDP_DEFAULT_PORT ; 
+    for (uint8_t i = 0; i < CFG_UDP_RECEIVERS; i++) {
+      String name = CFG_FORM_UDP_IP;
+      IPAddress ip;
+
+      name += i;
+      config.udp.rcv[i].ip = ip.fromString(server.arg(name).c_str()) ? (uint32_t) ip : 0;
+      name = CFG_FORM_UDP_DEC;
+      name += i;
+      itemp = server.arg(name).toInt();
+      config.udp.rcv[i].every = (itemp>0 && itemp<=255) ? itemp : 1 ; 
+    }
+
+    // Servers or credentials may have changed
+    httpSetup();
+    mqttSetup();
+    emonBulkSetup();
+    jeedomSetup();
+    influxSetup();
+    udpFrameSetup();
 
     if ( saveConfig() ) {
       ret = 200;
@@ -315,150 +471,161 @@ Comments: -
 void handleRoot(void) 
 {
   LedBluON();
-  handleFileRead("/");
+  if (!handleFileRead("/"))
+    server.send(404, "text/plain", "File Not Found");
   LedBluOFF();
 }
 
 /* ======================================================================
 Function: formatNumberJSON 
 Purpose : check if data value is full number and send correct JSON format
-Input   : String where to add response
+Input   : where to add response
           char * value to check 
 Output  : - 
 Comments: 00150 => 150
           ADCO  => "ADCO"
           1     => 1
+          empty => ""
+          standard mode texts (MSG1, PJOURF+1) are longer than any
+          number, they are always strings
 ====================================================================== */
-void formatNumberJSON( String &response, char * value)
+void formatNumberJSON( JSONWriter &response, char * value)
 {
-  // we have at least something ?
-  if (value && strlen(value))
-  {
-    boolean isNumber = true;
-    uint8_t c;
-    char * p = value;
-
-    // just to be sure
-    if (strlen(p)<=16) {
-      // check if value is number
-      while (*p && isNumber) {
-        if ( *p < '0' || *p > '9' )
-          isNumber = false;
-        p++;
-      }
+  boolean isNumber = value && *value && strlen(value) <= 16;
+  char * p;
 
-      // this will add "" on not number values
-      if (!isNumber) {
-        response += '\"' ;
-        response += value ;
-        response += F("\"") ;
-      } else {
-        // this will remove leading zero on numbers
-        p = value;
-        while (*p=='0' && *(p+1) )
-          p++;
-        response += p ;
-      }
-    } else {
-      Debugln(F("formatNumberJSON error!"));
-    }
+  // check if value is number
+  for (p = value; isNumber && *p; p++) {
+    if ( *p < '0' || *p > '9' )
+      isNumber = false;
+  }
+
+  if (isNumber) {
+    // this will remove leading zero on numbers
+    p = value;
+    while (*p=='0' && *(p+1) )
+      p++;
+    response += p ;
+    return;
+  }
+
+  // this will add "" on not number values
+  response += '\"' ;
+  for (p = value; p && *p; p++) {
+    if (*p == '"' || *p == '\\')
+      response += '\\';
+    if ((uint8_t) *p >= ' ')
+      response += *p;
   }
+  response += '\"' ;
 }
 
 
+/* ======================================================================
+Function: tinfoJSONItem
+Purpose : render one label of teleinfo table
+Input   : where to render
+          true for first item
+          label and value
+          true if value changed in last frame
+Output  : - 
+Comments: checksum is computed as the historic one (label SP value),
+          labels table does not keep the received one
+====================================================================== */
+static void tinfoJSONItem(JSONWriter & response, boolean first_item, const char * name, 
+                          const char * value, bool changed)
+{
+  uint8_t sum = ' ';
+  char checksum;
+
+  for (const char * p = name; *p; p++)
+    sum += *p;
+  for (const char * p = value; *p; p++)
+    sum += *p;
+  checksum = (sum & 0x3F) + ' ';
+
+  // First item do not add , separator
+  if (!first_item)
+    response += F(",\r\n");
+
+  response += F("{\"na\":\"");
+  response += name;
+  response += F("\", \"va\":\"") ;
+  response += value;
+  response += F("\", \"ck\":\"") ;
+  if (checksum == '"' || checksum == '\\' || checksum == '/')
+    response += '\\';
+  response += checksum;
+  response += F("\", \"fl\":");
+  response += changed ? TINFO_FLAGS_UPDATED : TINFO_FLAGS_EXIST;
+  response += '}' ;
+}
+
+/* ======================================================================
+Function: getTinfoJSONData 
+Purpose : dump all teleinfo values in JSON table format for browser
+Input   : where to render
+Output  : - 
+Comments: from labels table, same for historic and standard mode
+====================================================================== */
+void getTinfoJSONData(JSONWriter & response)
+{
+  char name[TINFO_LABEL_SIZE];
+  boolean first_item = true;
+
+  // Json start
+  response += F("[\r\n");
+
+  // Known labels, then unknown ones
+  for (uint8_t id = 0; id < LABEL_COUNT; id++) {
+    if (!tinfolabels.has(id))
+      continue;
+
+    strcpy_P(name, (PGM_P) TInfoLabels::labelName(id));
+    tinfoJSONItem(response, first_item, name, tinfolabels.get(id), tinfolabels.changed(id));
+    first_item = false;
+  }
+
+  for (uint8_t i = 0; i < tinfolabels.extraCount(); i++) {
+    tinfoJSONItem(response, first_item, tinfolabels.extraName(i), tinfolabels.extraValue(i), 
+                  tinfolabels.extraChanged(i));
+    first_item = false;
+  }
+
+  // Json end
+  response += F("\r\n]");
+}
+
 /* ======================================================================
 Function: tinfoJSONTable 
 Purpose : dump all teleinfo values in JSON table format for browser
-Input   : linked list pointer on the concerned data
-          true to dump all values, false for only modified ones
+Input   : -
 Output  : - 
-Comments: -
+Comments: from frame cache when it is there, else streamed
 ====================================================================== */
 void tinfoJSONTable(void)
 {
-  ValueList * me = tinfo.getList();
-  String response = "";
-
   // Just to debug where we are
   Debug(F("Serving /tinfo page...\r\n"));
 
+  // Rendered at frame reception ?
+  if (jsonCacheSend(JSONCACHE_TINFO))
+    return;
+
   // Got at least one ?
-  if (me) {
-    uint8_t index=0;
-
-    boolean first_item = true;
-    // Json start
-    response += F("[\r\n");
-
-    // Loop thru the node
-    while (me->next) {
-
-      // we're there
-      ESP.wdtFeed();
-
-      // go to next node
-      me = me->next;
-
-      // First item do not add , separator
-      if (first_item)
-        first_item = false;
-      else
-        response += F(",\r\n");
-
-/*
-      Debug(F("(")) ;
-      Debug(++index) ;
-      Debug(F(") ")) ;
-
-      if (me->name) Debug(me->name) ;
-      else Debug(F("NULL")) ;
-
-      Debug(F("=")) ;
-
-      if (me->value) Debug(me->value) ;
-      else Debug(F("NULL")) ;
-
-      Debug(F(" '")) ;
-      Debug(me->checksum) ;
-      Debug(F("' ")); 
-
-      // Flags management
-      if ( me->flags) {
-        Debug(F("Flags:0x")); 
-        Debugf("%02X => ", me->flags); 
-        if ( me->flags & TINFO_FLAGS_EXIST)
-          Debug(F("Exist ")) ;
-        if ( me->flags & TINFO_FLAGS_UPDATED)
-          Debug(F("Updated ")) ;
-        if ( me->flags & TINFO_FLAGS_ADDED)
-          Debug(F("New ")) ;
-      }
+  if (!tinfolabels.empty()) {
+    JSONWriter response;
 
-      Debugln() ;
-*/
-      response += F("{\"na\":\"");
-      response +=  me->name ;
-      response += F("\", \"va\":\"") ;
-      response += me->value;
-      response += F("\", \"ck\":\"") ;
-      if (me->checksum == '"' || me->checksum == '\\' || me->checksum == '/')
-        response += '\\';
-      response += (char) me->checksum;
-      response += F("\", \"fl\":");
-      response += me->flags ;
-      response += '}' ;
-
-    }
-   // Json end
-   response += F("\r\n]");
+    Debug(F("sending..."));
+    response.begin();
+    getTinfoJSONData(response);
+    response.end();
+    Debugln(F("OK!"));
 
   } else {
     Debugln(F("sending 404..."));
     server.send ( 404, "text/plain", "No data" );
   }
-  Debug(F("sending..."));
-  server.send ( 200, "text/json", response );
-  Debugln(F("OK!"));
 }
 
 
@@ -467,89 +634,94 @@ Function: logJSONTable
 Purpose : dump all log values in JSON table format for browser
 Input   : -
 Output  : - 
-Comments: -
+Comments: newest first, ?offset=&limit= to get a page of events,
+          ?since= with X-Log-Cursor of previous answer to get only
+          new ones, X-Log-Reset tells they are all there again
 ====================================================================== */
 void logJSONTable(void)
 {
-  String response = "";
-  bool first = true;
+  JSONWriter response;
 
   // Just to debug where we are
   Debug(F("Serving /log page...\r\n"));
 
-    // Json start
-    response += F("[\r\n");
-
-    if (config.config & CFG_INFO) 
-    {
-
-        if (SPIFFS.exists("/log.txt"))
-        {
-          String temp = "";
-          
-          File f = SPIFFS.open("/log.txt", "r");
-          while (f.available()){
-           
-            String tempwhile = "";
-            String line = f.readStringUntil('\n');
-            tempwhile += ",{\"ev\":\"";
-            tempwhile += line.substring(0,line.length()-1);
-            tempwhile += "\"}\r\n";
-            temp = tempwhile + temp;
-            
-          }
-          f.close();
-
-          response += ( first ? temp.substring(1,temp.length()-1) : temp );
-        }
-        
-        if (SPIFFS.exists("/log.1"))
-        {
-          String temp = "";
-          
-          File f = SPIFFS.open("/log.1", "r");
-          while (f.available()){
-
-            String tempwhile = "";
-            String line = f.readStringUntil('\n');
-            tempwhile += ",{\"ev\":\"";
-            tempwhile += line.substring(0,line.length()-1);
-            tempwhile += "\"}\r\n";
-            temp = tempwhile + temp;
-            
-          }
-          f.close();
-
-          response += ( first ? temp.substring(1,temp.length()-1) : temp );
-        }
-    }
-    else
-    {
-        response += F("{\"ev\":\"");
-        response +=  "Fonctionnalité non activée" ;
-        response += "\"}" ;
+  if (config.config & CFG_INFO) 
+  {
+    uint32_t end = logReadEnd();
+    uint32_t since = 0;
+
+    if (server.hasArg("since")) {
+      since = server.arg("since").toInt();
+      if (!logReadValid(since)) {
+        since = 0;
+        server.sendHeader("X-Log-Reset", "1");
+      }
     }
-    
+    server.sendHeader("X-Log-Cursor", String(end));
+
+    response.begin();
+    logReadJSON(response, since, end, server.arg("offset").toInt(), server.arg("limit").toInt());
+  }
+  else
+  {
+    response.begin();
+    response += F("[\r\n{\"ev\":\"");
+    response +=  "Fonctionnalité non activée" ;
+    response += "\"}]" ;
+  }
 
-   // Json end
-   response += F("]");
-   
   Debug(F("sending..."));
-  server.send ( 200, "text/json", response );
+  response.end();
   Debugln(F("OK!"));
 }
 
 
+/* ======================================================================
+Function: getHistoJSONData 
+Purpose : append a latency histogram row to system data
+Input   : where to render
+          sink name, phase name
+          histogram (HTTP_HISTO_BUCKETS)
+Output  : - 
+Comments: only buckets used, "<4:12" is 12 requests under 4 ms
+====================================================================== */
+static void getHistoJSONData(JSONWriter & response, const char * name, const char * phase, const uint32_t * histo)
+{
+  bool first = true;
+
+  response += "{\"na\":\"";
+  response += name;
+  response += ' ';
+  response += phase;
+  response += " ms\",\"va\":\"";
+  for (uint8_t b = 0; b < HTTP_HISTO_BUCKETS; b++) {
+    if (!histo[b])
+      continue;
+    if (!first)
+      response += ' ';
+    first = false;
+    if (b < HTTP_HISTO_BUCKETS - 1) {
+      response += '<';
+      response += 2UL << b;
+    } else {
+      response += 1UL << b;
+      response += '+';
+    }
+    response += ':';
+    response += histo[b];
+  }
+  response += "\"},\r\n";
+}
+
 /* ======================================================================
 Function: getSysJSONData 
 Purpose : Return JSON string containing system data
-Input   : Response String
+Input   : where to render
 Output  : - 
 Comments: -
 ====================================================================== */
-void getSysJSONData(String & response)
+void getSysJSONData(JSONWriter & response)
 {
-  response = "";
   char buffer[32];
   int32_t adc = ( 1000 * analogRead(A0) / 1024 );
 
@@ -596,6 +768,373 @@ void getSysJSONData(String & response)
   response += buffer ;
   response += "\"},\r\n";
 
+  response += "{\"na\":\"Teleinfo Mode\",\"va\":\"";
+  response += tinfoModeName() ;
+  response += "\"},\r\n";
+
+  response += "{\"na\":\"Teleinfo Erreurs Standard\",\"va\":\"";
+  response += tinfostd.checksumErrors() ;
+  response += "\"},\r\n";
+
+  response += "{\"na\":\"Teleinfo Octets\",\"va\":\"";
+  response += tinfo_rx_bytes ;
+  response += "\"},\r\n";
+
+  response += "{\"na\":\"Teleinfo Max Attente\",\"va\":\"";
+  response += tinfo_rx_max_pending ;
+  response += "\"},\r\n";
+
+  response += "{\"na\":\"Teleinfo Debordements\",\"va\":\"";
+  response += tinfo_rx_overruns ;
+  response += "\"},\r\n";
+
+  response += "{\"na\":\"HTTP OK/Erreurs/Timeouts\",\"va\":\"";
+  response += httpstat.ok ;
+  response += '/';
+  response += httpstat.failed ;
+  response += '/';
+  response += httpstat.timeouts ;
+  response += "\"},\r\n";
+
+  response += "{\"na\":\"HTTP Attente RAM/Max\",\"va\":\"";
+  response += httpPending() ;
+  response += '/';
+  response += httpstat.max_pending ;
+  response += "\"},\r\n";
+
+  response += "{\"na\":\"HTTP Attente Flash/Perdues\",\"va\":\"";
+  response += httpSpooled() ;
+  response += '/';
+  response += httpstat.dropped ;
+  response += "\"},\r\n";
+
+  response += "{\"na\":\"HTTP Plus Ancien\",\"va\":\"";
+  response += httpOldest() ;
+  response += " s\"},\r\n";
+
+  response += "{\"na\":\"HTTP Requete Max\",\"va\":\"";
+  response += httpstat.max_ms ;
+  response += " ms\"},\r\n";
+
+  // Per sink requests sent/avoided and connections
+  for (uint8_t i = 0; i < SINK_HTTP_COUNT; i++) {
+    static const char * const names[SINK_HTTP_COUNT] = { "Emoncms", "Jeedom", "Domoticz", "InfluxDB" };
+
+    response += "{\"na\":\"";
+    response += names[i];
+    response += " Envois/Evites\",\"va\":\"";
+    response += sinkpush[i].sent ;
+    response += '/';
+    response += sinkpush[i].skipped ;
+    response += "\"},\r\n";
+
+    // Keep-alive efficiency
+    response += "{\"na\":\"";
+    response += names[i];
+    response += " Connexions/Requetes/Echecs\",\"va\":\"";
+    response += httpsinkstat[i].connects ;
+    response += '/';
+    response += httpsinkstat[i].requests ;
+    response += '/';
+    response += httpsinkstat[i].failed ;
+    response += "\"},\r\n";
+
+    response += "{\"na\":\"";
+    response += names[i];
+    response += " Requete Moy/Max\",\"va\":\"";
+    response += httpsinkstat[i].requests ? httpsinkstat[i].total_ms / httpsinkstat[i].requests : 0 ;
+    response += '/';
+    response += httpsinkstat[i].max_ms ;
+    response += " ms\"},\r\n";
+
+    // Store and forward
+    response += "{\"na\":\"";
+    response += names[i];
+    response += " Attente/Perdues/Reessai\",\"va\":\"";
+    response += httpSinkPending(i) ;
+    response += '/';
+    response += httpsinkstat[i].dropped ;
+    response += '/';
+    response += httpspool[i].backoff ;
+    response += " s\"},\r\n";
+
+    // Answers and latency, to see which server or phase is slow
+    if (!httpsinkstat[i].requests)
+      continue;
+
+    response += "{\"na\":\"";
+    response += names[i];
+    response += " HTTP 2xx/3xx/4xx/5xx/Autre/Timeout\",\"va\":\"";
+    for (uint8_t c = 2; c <= 5; c++) {
+      response += httpsinkstat[i].status[c] ;
+      response += '/';
+    }
+    response += httpsinkstat[i].status[0] + httpsinkstat[i].status[1] ;
+    response += '/';
+    response += httpsinkstat[i].timeouts ;
+    response += "\"},\r\n";
+
+    response += "{\"na\":\"";
+    response += names[i];
+    response += " Dernier succes/Envoye\",\"va\":\"";
+    if (httpsinkstat[i].ok_ms) {
+      response += (millis() - httpsinkstat[i].ok_ms) / 1000 ;
+      response += " s/";
+    } else {
+      response += "jamais/";
+    }
+    response += formatSize(httpsinkstat[i].bytes) ;
+    response += "\"},\r\n";
+
+    getHistoJSONData(response, names[i], "Connexion", httpsinkstat[i].histo[HTTP_PHASE_CONNECT]);
+    getHistoJSONData(response, names[i], "Envoi",     httpsinkstat[i].histo[HTTP_PHASE_SEND]);
+    getHistoJSONData(response, names[i], "Reponse",   httpsinkstat[i].histo[HTTP_PHASE_RESPONSE]);
+  }
+
+  // Domoticz per device
+  for (uint8_t i = 0; i < HTTP_IDX_COUNT && httpidxstat[i].idx; i++) {
+    response += "{\"na\":\"Domoticz idx ";
+    response += httpidxstat[i].idx ;
+    response += " Requetes/Echecs/Moy/Max\",\"va\":\"";
+    response += httpidxstat[i].requests ;
+    response += '/';
+    response += httpidxstat[i].failed ;
+    response += '/';
+    response += httpidxstat[i].total_ms / httpidxstat[i].requests ;
+    response += '/';
+    response += httpidxstat[i].max_ms ;
+    response += " ms\"},\r\n";
+  }
+
+  // emoncms bulk upload
+  response += "{\"na\":\"Emoncms Bulk Echantillons/Requetes/Perdus\",\"va\":\"";
+  response += emonbulkstat.samples ;
+  response += '/';
+  response += emonbulkstat.requests ;
+  response += '/';
+  response += emonbulkstat.dropped ;
+  response += "\"},\r\n";
+
+  response += "{\"na\":\"Emoncms Bulk Attente/Octets/Pas\",\"va\":\"";
+  response += emonBulkCount() ;
+  response += '/';
+  response += emonBulkUsed() ;
+  response += '/';
+  response += emonbulkstat.step ;
+  response += " s\"},\r\n";
+
+  response += "{\"na\":\"Emoncms Bulk RAM/Requetes\",\"va\":\"";
+  response += emonbulkstat.encoded ;
+  response += '/';
+  response += emonbulkstat.rendered ;
+  response += " o\"},\r\n";
+
+  // InfluxDB batches
+  response += "{\"na\":\"InfluxDB Lignes/Ecritures/Perdues\",\"va\":\"";
+  response += influxstat.lines ;
+  response += '/';
+  response += influxstat.requests ;
+  response += '/';
+  response += influxstat.dropped ;
+  response += "\"},\r\n";
+
+  response += "{\"na\":\"InfluxDB Attente/Octets/Anticipees\",\"va\":\"";
+  response += influxCount() ;
+  response += '/';
+  response += influxUsed() ;
+  response += '/';
+  response += influxstat.early ;
+  response += "\"},\r\n";
+
+  response += "{\"na\":\"InfluxDB Gzip Entree/Sortie/Non compresse\",\"va\":\"";
+  response += gzipstat.in ;
+  response += '/';
+  response += gzipstat.out ;
+  response += '/';
+  response += gzipstat.fallback ;
+  response += "\"},\r\n";
+
+  // Scheduled tasks run time and lateness
+  for (uint8_t i = 0; i < TASK_COUNT; i++) {
+    _schedtask * t = &schedtask[i];
+
+    if (!t->name)
+      continue;
+
+    response += "{\"na\":\"Tache ";
+    response += t->name;
+    response += " Exec Moy/Max\",\"va\":\"";
+    response += t->runs ? t->total_us / t->runs : 0 ;
+    response += '/';
+    response += t->max_us ;
+    response += " us\"},\r\n";
+
+    response += "{\"na\":\"Tache ";
+    response += t->name;
+    response += " Retard Moy/Max\",\"va\":\"";
+    response += t->runs ? t->late_ms / t->runs : 0 ;
+    response += '/';
+    response += t->late_max_ms ;
+    response += " ms\"},\r\n";
+
+    response += "{\"na\":\"Tache ";
+    response += t->name;
+    response += " Depassements/Sautees/Differees\",\"va\":\"";
+    response += t->over ;
+    response += '/';
+    response += t->missed ;
+    response += '/';
+    response += t->deferred ;
+    response += "\"},\r\n";
+  }
+
+  // Prometheus scrapes
+  response += "{\"na\":\"Metrics Scrapes/Octets/Max\",\"va\":\"";
+  response += metricsstat.scrapes ;
+  response += '/';
+  response += metricsstat.bytes ;
+  response += '/';
+  response += metricsstat.max_us / 1000 ;
+  response += " ms\"},\r\n";
+
+  // Frame JSON cache
+  response += "{\"na\":\"JSON Cache Trames/Servies/304/Hors cache\",\"va\":\"";
+  response += jsoncachestat.renders ;
+  response += '/';
+  response += jsoncachestat.hits ;
+  response += '/';
+  response += jsoncachestat.notmod ;
+  response += '/';
+  response += jsoncachestat.misses ;
+  response += "\"},\r\n";
+
+  response += "{\"na\":\"JSON Cache Taille/Max/Debordements/Rendu Max\",\"va\":\"";
+  response += jsoncachestat.size ;
+  response += '/';
+  response += jsoncachestat.max_size ;
+  response += '/';
+  response += jsoncachestat.overflows ;
+  response += '/';
+  response += jsoncachestat.max_us ;
+  response += " us\"},\r\n";
+
+  // Web server connections
+  response += "{\"na\":\"Web Connexions/Max/Acceptees/Refusees/Fermees\",\"va\":\"";
+  response += webconnstat.conns ;
+  response += '/';
+  response += webconnstat.max_conns ;
+  response += '/';
+  response += webconnstat.accepted ;
+  response += '/';
+  response += webconnstat.refused ;
+  response += '/';
+  response += webconnstat.evicted + webconnstat.timeouts ;
+  response += "\"},\r\n";
+
+  response += "{\"na\":\"Web Requetes/Keep-alive/Fichiers/Max\",\"va\":\"";
+  response += webconnstat.requests ;
+  response += '/';
+  response += webconnstat.reused ;
+  response += '/';
+  response += webconnstat.files ;
+  response += '/';
+  response += webconnstat.max_us / 1000 ;
+  response += " ms\"},\r\n";
+
+  // Server-Sent Events subscribers
+  response += "{\"na\":\"Events Clients/Connexions/Refus/Coupes\",\"va\":\"";
+  response += ssestat.clients ;
+  response += '/';
+  response += ssestat.connects ;
+  response += '/';
+  response += ssestat.rejected ;
+  response += '/';
+  response += ssestat.dropped ;
+  response += "\"},\r\n";
+
+  response += "{\"na\":\"Events Envoyes/Sautes/Octets/Max\",\"va\":\"";
+  response += ssestat.events ;
+  response += '/';
+  response += ssestat.skipped ;
+  response += '/';
+  response += ssestat.bytes ;
+  response += '/';
+  response += ssestat.max_us ;
+  response += " us\"},\r\n";
+
+  // SPIFFS web files index
+  response += "{\"na\":\"Fichiers Index/Servis/304/Hors index\",\"va\":\"";
+  response += fileindexstat.files ;
+  if (fileindexstat.full)
+    response += '+';
+  response += '/';
+  response += fileindexstat.hits ;
+  response += '/';
+  response += fileindexstat.notmod ;
+  response += '/';
+  response += fileindexstat.misses ;
+  response += "\"},\r\n";
+
+  // Chunked JSON responses
+  response += "{\"na\":\"JSON Reponses/Chunks/Max\",\"va\":\"";
+  response += jsonwriterstat.responses ;
+  response += '/';
+  response += jsonwriterstat.chunks ;
+  response += '/';
+  response += formatSize(jsonwriterstat.max_bytes) ;
+  response += "\"},\r\n";
+
+  // UDP frame datagrams
+  response += "{\"na\":\"UDP Trames/Envois/Erreurs\",\"va\":\"";
+  response += udpframestat.frames ;
+  response += '/';
+  response += udpframestat.sent ;
+  response += '/';
+  response += udpframestat.errors ;
+  response += "\"},\r\n";
+
+  response += "{\"na\":\"UDP Taille datagramme\",\"va\":\"";
+  response += udpframestat.size ;
+  response += " o\"},\r\n";
+
+  // MQTT session
+  response += "{\"na\":\"MQTT Etat\",\"va\":\"";
+  switch (mqttState()) {
+    case MQTT_OFF:          response += "Inactif";   break;
+    case MQTT_DOWN:         response += "Deconnecte"; break;
+    case MQTT_WAIT_CONNACK: response += "Connexion"; break;
+    case MQTT_UP:           response += "Connecte";  break;
+  }
+  response += "\"},\r\n";
+
+  response += "{\"na\":\"MQTT Envois/Evites\",\"va\":\"";
+  response += sinkpush[SINK_MQTT].sent ;
+  response += '/';
+  response += sinkpush[SINK_MQTT].skipped ;
+  response += "\"},\r\n";
+
+  response += "{\"na\":\"MQTT Connexions/Sessions\",\"va\":\"";
+  response += mqttstat.connects ;
+  response += '/';
+  response += mqttstat.sessions ;
+  response += "\"},\r\n";
+
+  response += "{\"na\":\"MQTT Publies/Acquittes/Renvoyes/Perdus\",\"va\":\"";
+  response += mqttstat.published ;
+  response += '/';
+  response += mqttstat.acked ;
+  response += '/';
+  response += mqttstat.resent ;
+  response += '/';
+  response += mqttstat.dropped ;
+  response += "\"},\r\n";
+
+  response += "{\"na\":\"MQTT En vol/Max\",\"va\":\"";
+  response += mqttInflight() ;
+  response += '/';
+  response += mqttstat.max_inflight ;
+  response += "\"},\r\n";
+
   FSInfo info;
   SPIFFS.info(info);
 
@@ -630,29 +1169,47 @@ Comments: -
 ====================================================================== */
 void sysJSONTable()
 {
-  String response = "";
-  
-  getSysJSONData(response);
+  JSONWriter response;
 
   // Just to debug where we are
   Debug(F("Serving /system page..."));
-  server.send ( 200, "text/json", response );
+  response.begin();
+  getSysJSONData(response);
+  response.end();
   Debugln(F("Ok!"));
 }
 
 
 
+/* ======================================================================
+Function: getPushJSONData
+Purpose : add push on change settings of a sink to config JSON
+Input   : where to render
+          sink form fields prefix (emon, jdom, dmcz)
+          sink push settings
+Output  : - 
+Comments: -
+====================================================================== */
+static void getPushJSONData(JSONWriter & r, const char * prefix, _pushcfg * push)
+{
+  r+=prefix; r+=CFG_FORM_PUSH_MODE;  r+=FPSTR(FP_QCQ); r+=push->mode;       r+= FPSTR(FP_QCNL); 
+  r+=prefix; r+=CFG_FORM_PUSH_HB;    r+=FPSTR(FP_QCQ); r+=push->heartbeat;  r+= FPSTR(FP_QCNL); 
+  r+=prefix; r+=CFG_FORM_PUSH_DBPWR; r+=FPSTR(FP_QCQ); r+=push->db_power;   r+= FPSTR(FP_QCNL); 
+  r+=prefix; r+=CFG_FORM_PUSH_DBCUR; r+=FPSTR(FP_QCQ); r+=push->db_current; r+= FPSTR(FP_QCNL); 
+  r+=prefix; r+=CFG_FORM_PUSH_DBIDX; r+=FPSTR(FP_QCQ); r+=push->db_index;   r+= FPSTR(FP_QCNL); 
+}
+
 /* ======================================================================
 Function: getConfigJSONData 
 Purpose : Return JSON string containing configuration data
-Input   : Response String
+Input   : where to render
 Output  : - 
 Comments: -
 ====================================================================== */
-void getConfJSONData(String & r)
+void getConfJSONData(JSONWriter & r)
 {
   // Json start
-  r = FPSTR(FP_JSON_START); 
+  r += FPSTR(FP_JSON_START); 
 
   r+="\"";
   r+=CFG_FORM_SSID;      r+=FPSTR(FP_QCQ); r+=config.ssid;           r+= FPSTR(FP_QCNL); 
@@ -667,9 +1224,12 @@ void getConfJSONData(String & r)
   r+=CFG_FORM_EMON_KEY;  r+=FPSTR(FP_QCQ); r+=config.emoncms.apikey; r+= FPSTR(FP_QCNL); 
   r+=CFG_FORM_EMON_NODE; r+=FPSTR(FP_QCQ); r+=config.emoncms.node;   r+= FPSTR(FP_QCNL); 
   r+=CFG_FORM_EMON_FREQ; r+=FPSTR(FP_QCQ); r+=config.emoncms.freq;   r+= FPSTR(FP_QCNL); 
+  r+=CFG_FORM_EMON_BULK; r+=FPSTR(FP_QCQ); r+=config.emoncms.bulk;   r+= FPSTR(FP_QCNL); 
+  getPushJSONData(r, "emon", &config.emoncms.push);
   
   r+=CFG_FORM_OTA_AUTH;  r+=FPSTR(FP_QCQ); r+=config.ota_auth;       r+= FPSTR(FP_QCNL); 
   r+=CFG_FORM_OTA_PORT;  r+=FPSTR(FP_QCQ); r+=config.ota_port;       r+= FPSTR(FP_QCNL);
+  r+=CFG_FORM_TIC_MODE;  r+=FPSTR(FP_QCQ); r+=config.tic_mode;       r+= FPSTR(FP_QCNL);
   
   if (config.config & CFG_DEBUG)   { r+=CFG_FORM_CFG_DEBUG;  r+=FPSTR(FP_QCQ); r+= FPSTR(FP_QCNL); }
   if (config.config & CFG_INFO)    { r+=CFG_FORM_CFG_INFO;   r+=FPSTR(FP_QCQ); r+= FPSTR(FP_QCNL); }
@@ -688,12 +1248,45 @@ void getConfJSONData(String & r)
   r+=CFG_FORM_DMCZ_IDX_KWH;  r+=FPSTR(FP_QCQ); r+=config.domoticz.idx_kwh;  r+= FPSTR(FP_QCNL); 
   r+=CFG_FORM_DMCZ_IDX_PCT;  r+=FPSTR(FP_QCQ); r+=config.domoticz.idx_pct;  r+= FPSTR(FP_QCNL); 
   r+=CFG_FORM_DMCZ_FREQ;     r+=FPSTR(FP_QCQ); r+=config.domoticz.freq;     r+= FPSTR(FP_QCNL); 
+  getPushJSONData(r, "dmcz", &config.domoticz.push);
+
+  r+=CFG_FORM_MQTT_HOST;  r+=FPSTR(FP_QCQ); r+=config.mqtt.host;      r+= FPSTR(FP_QCNL); 
+  r+=CFG_FORM_MQTT_PORT;  r+=FPSTR(FP_QCQ); r+=config.mqtt.port;      r+= FPSTR(FP_QCNL); 
+  r+=CFG_FORM_MQTT_USR;   r+=FPSTR(FP_QCQ); r+=config.mqtt.usr;       r+= FPSTR(FP_QCNL); 
+  r+=CFG_FORM_MQTT_PWD;   r+=FPSTR(FP_QCQ); r+=config.mqtt.pwd;       r+= FPSTR(FP_QCNL); 
+  r+=CFG_FORM_MQTT_TOPIC; r+=FPSTR(FP_QCQ); r+=config.mqtt.topic;     r+= FPSTR(FP_QCNL); 
+  r+=CFG_FORM_MQTT_QOS;   r+=FPSTR(FP_QCQ); r+=config.mqtt.qos;       r+= FPSTR(FP_QCNL); 
+  r+=CFG_FORM_MQTT_KA;    r+=FPSTR(FP_QCQ); r+=config.mqtt.keepalive; r+= FPSTR(FP_QCNL); 
+  r+=CFG_FORM_MQTT_FREQ;  r+=FPSTR(FP_QCQ); r+=config.mqtt.freq;      r+= FPSTR(FP_QCNL); 
+  if (config.mqtt.mode & CFG_MQTT_DOMOTICZ) { r+=CFG_FORM_MQTT_DMCZ;   r+=FPSTR(FP_QCQ); r+= FPSTR(FP_QCNL); }
+  if (config.mqtt.mode & CFG_MQTT_FRAME)    { r+=CFG_FORM_MQTT_FRAME;  r+=FPSTR(FP_QCQ); r+= FPSTR(FP_QCNL); }
+  if (config.mqtt.mode & CFG_MQTT_LWT)      { r+=CFG_FORM_MQTT_LWT;    r+=FPSTR(FP_QCQ); r+= FPSTR(FP_QCNL); }
+  if (config.mqtt.mode & CFG_MQTT_RETAIN)   { r+=CFG_FORM_MQTT_RETAIN; r+=FPSTR(FP_QCQ); r+= FPSTR(FP_QCNL); }
+  getPushJSONData(r, "mqtt", &config.mqtt.push);
+  r+=CFG_FORM_INFX_HOST;  r+=FPSTR(FP_QCQ); r+=config.influx.host;    r+= FPSTR(FP_QCNL); 
+  r+=CFG_FORM_INFX_PORT;  r+=FPSTR(FP_QCQ); r+=config.influx.port;    r+= FPSTR(FP_QCNL); 
+  r+=CFG_FORM_INFX_DB;    r+=FPSTR(FP_QCQ); r+=config.influx.db;      r+= FPSTR(FP_QCNL); 
+  r+=CFG_FORM_INFX_USR;   r+=FPSTR(FP_QCQ); r+=config.influx.usr;     r+= FPSTR(FP_QCNL); 
+  r+=CFG_FORM_INFX_PWD;   r+=FPSTR(FP_QCQ); r+=config.influx.pwd;     r+= FPSTR(FP_QCNL); 
+  r+=CFG_FORM_INFX_MEAS;  r+=FPSTR(FP_QCQ); r+=config.influx.measurement; r+= FPSTR(FP_QCNL); 
+  r+=CFG_FORM_INFX_BATCH; r+=FPSTR(FP_QCQ); r+=config.influx.batch;   r+= FPSTR(FP_QCNL); 
+  if (config.influx.gzip) { r+=CFG_FORM_INFX_GZIP; r+=FPSTR(FP_QCQ); r+= FPSTR(FP_QCNL); }
+  r+=CFG_FORM_INFX_FREQ;  r+=FPSTR(FP_QCQ); r+=config.influx.freq;    r+= FPSTR(FP_QCNL); 
+  r+=CFG_FORM_UDP_PORT;   r+=FPSTR(FP_QCQ); r+=config.udp.port;       r+= FPSTR(FP_QCNL); 
+  for (uint8_t i = 0; i < CFG_UDP_RECEIVERS; i++) {
+    r+=CFG_FORM_UDP_IP;  r+=i; r+=FPSTR(FP_QCQ); if (config.udp.rcv[i].ip) r+=IPAddress(config.udp.rcv[i].ip).toString(); r+= FPSTR(FP_QCNL); 
+    r+=CFG_FORM_UDP_DEC; r+=i; r+=FPSTR(FP_QCQ); r+=config.udp.rcv[i].every; r+= FPSTR(FP_QCNL); 
+  }
 
   r+=CFG_FORM_JDOM_HOST; r+=FPSTR(FP_QCQ); r+=config.jeedom.host;   r+= FPSTR(FP_QCNL); 
   r+=CFG_FORM_JDOM_PORT; r+=FPSTR(FP_QCQ); r+=config.jeedom.port;   r+= FPSTR(FP_QCNL); 
   r+=CFG_FORM_JDOM_URL;  r+=FPSTR(FP_QCQ); r+=config.jeedom.url;    r+= FPSTR(FP_QCNL); 
   r+=CFG_FORM_JDOM_KEY;  r+=FPSTR(FP_QCQ); r+=config.jeedom.apikey; r+= FPSTR(FP_QCNL); 
   r+=CFG_FORM_JDOM_ADCO; r+=FPSTR(FP_QCQ); r+=config.jeedom.adco;   r+= FPSTR(FP_QCNL); 
+  r+=CFG_FORM_JDOM_FMT;  r+=FPSTR(FP_QCQ); r+=config.jeedom.format; r+= FPSTR(FP_QCNL); 
+  r+=CFG_FORM_JDOM_FILTER; r+=FPSTR(FP_QCQ); r+=config.jeedom.filter; r+= FPSTR(FP_QCNL); 
+  r+=CFG_FORM_JDOM_LABELS; r+=FPSTR(FP_QCQ); r+=config.jeedom.labels; r+= FPSTR(FP_QCNL); 
+  getPushJSONData(r, "jdom", &config.jeedom.push);
   r+=CFG_FORM_JDOM_FREQ; r+=FPSTR(FP_QCQ); r+=config.jeedom.freq;  
 
   r+= F("\""); 
@@ -711,28 +1304,78 @@ Comments: -
 ====================================================================== */
 void confJSONTable()
 {
-  String response = "";
-  getConfJSONData(response);
+  JSONWriter response;
   // Just to debug where we are
   Debug(F("Serving /config page..."));
-  server.send ( 200, "text/json", response );
+  response.begin();
+  getConfJSONData(response);
+  response.end();
   Debugln(F("Ok!"));
 }
 
+/* ======================================================================
+Function: captureJSONTable 
+Purpose : dump capture/replay state and stages statistics in JSON
+Input   : -
+Output  : - 
+Comments: -
+====================================================================== */
+void captureJSONTable()
+{
+  String response = "";
+  getCaptureJSONData(response);
+  server.send ( 200, "text/json", response );
+}
+
+/* ======================================================================
+Function: handleMetrics 
+Purpose : serve Prometheus scrape
+Input   : -
+Output  : - 
+Comments: chunked, metricsRender() sends the body
+====================================================================== */
+void handleMetrics(void)
+{
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, METRICS_CONTENT_TYPE, "");
+  metricsRender();
+  server.sendContent("");
+}
+
+/* ======================================================================
+Function: handleEvents 
+Purpose : subscribe to frames pushed as Server-Sent Events
+Input   : -
+Output  : - 
+Comments: changed values only, ?full=1 to get whole frame each time
+          connection stays open, see sse.cpp
+====================================================================== */
+void handleEvents(void)
+{
+  WiFiClient client = server.client();
+
+  if (sseSubscribe(client, server.arg("full") != "1")) {
+    server.detach();
+  } else {
+    server.sendHeader("Retry-After", "30");
+    server.send(503, "text/plain", "Too many subscribers");
+  }
+}
+
 /* ======================================================================
 Function: getSpiffsJSONData 
 Purpose : Return JSON string containing list of SPIFFS files
-Input   : Response String
+Input   : where to render
 Output  : - 
 Comments: -
 ====================================================================== */
-void getSpiffsJSONData(String & response)
+void getSpiffsJSONData(JSONWriter & response)
 {
   char buffer[32];
   bool first_item = true;
 
   // Json start
-  response = FPSTR(FP_JSON_START);
+  response += FPSTR(FP_JSON_START);
 
   // Files Array  
   response += F("\"files\":[\r\n");
@@ -785,47 +1428,78 @@ Comments: -
 ====================================================================== */
 void spiffsJSONTable()
 {
-  String response = "";
+  JSONWriter response;
+  response.begin();
   getSpiffsJSONData(response);
-  server.send ( 200, "text/json", response );
+  response.end();
 }
 
 /* ======================================================================
-Function: sendJSON 
+Function: getJSONData 
 Purpose : dump all values in JSON
-Input   : linked list pointer on the concerned data
-          true to dump all values, false for only modified ones
+Input   : where to render
 Output  : - 
 Comments: -
 ====================================================================== */
+void getJSONData(JSONWriter & response)
+{
+  uint32_t number;
+
+  // Json start
+  response += FPSTR(FP_JSON_START);
+  response += F("\"_UPTIME\":");
+  response += seconds;
+
+  // Loop thru the known labels, numbers are already decoded in frame
+  for (uint8_t id = 0; id < LABEL_COUNT; id++) {
+    if (!tinfolabels.has(id))
+      continue;
+
+    response += F(",\"") ;
+    response += TInfoLabels::labelName(id);
+    response += F("\":") ;
+    if (tinfoFrameNumber(id, &number))
+      response += number;
+    else
+      formatNumberJSON(response, (char *) tinfolabels.get(id));
+  }
+
+  // Then unknown ones
+  for (uint8_t i = 0; i < tinfolabels.extraCount(); i++) {
+    response += F(",\"") ;
+    response += tinfolabels.extraName(i);
+    response += F("\":") ;
+    formatNumberJSON(response, (char *) tinfolabels.extraValue(i));
+  }
+  // Json end
+  response += FPSTR(FP_JSON_END) ;
+}
+
+/* ======================================================================
+Function: sendJSON 
+Purpose : dump all values in JSON
+Input   : -
+Output  : - 
+Comments: from frame cache when it is there, else streamed
+          _UPTIME is then the one of last frame
+====================================================================== */
 void sendJSON(void)
 {
-  ValueList * me = tinfo.getList();
-  String response = "";
-  
+  // Rendered at frame reception ?
+  if (jsonCacheSend(JSONCACHE_JSON))
+    return;
+
   // Got at least one ?
-  if (me) {
-    // Json start
-    response += FPSTR(FP_JSON_START);
-    response += F("\"_UPTIME\":");
-    response += seconds;
-
-    // Loop thru the node
-    while (me->next) {
-      // go to next node
-      me = me->next;
-      response += F(",\"") ;
-      response += me->name ;
-      response += F("\":") ;
-      formatNumberJSON(response, me->value);
-    }
-   // Json end
-   response += FPSTR(FP_JSON_END) ;
+  if (!tinfolabels.empty()) {
+    JSONWriter response;
+
+    response.begin();
+    getJSONData(response);
+    response.end();
 
   } else {
     server.send ( 404, "text/plain", "No data" );
   }
-  server.send ( 200, "text/json", response );
 }
 
 
@@ -834,7 +1508,9 @@ Function: wifiScanJSON
 Purpose : scan Wifi Access Point and return JSON code
 Input   : -
 Output  : - 
-Comments: -
+Comments: scan runs in background, an empty list is sent while it's
+          not done, browser asks again. Results are sent once, next
+          request starts a new scan
 ====================================================================== */
 void wifiScanJSON(void)
 {
@@ -844,12 +1520,18 @@ void wifiScanJSON(void)
   // Just to debug where we are
   Debug(F("Serving /wifiscan page..."));
 
-  int n = WiFi.scanNetworks();
+  int n = WiFi.scanComplete();
+
+  // Not started, or results already sent
+  if (n == WIFI_SCAN_FAILED) {
+    WiFi.scanNetworks(true);
+    n = WIFI_SCAN_RUNNING;
+  }
 
   // Json start
   response += F("[\r\n");
 
-  for (uint8_t i = 0; i < n; ++i)
+  for (int i = 0; i < n; ++i)
   {
     int8_t rssi = WiFi.RSSI(i);
     
@@ -875,6 +1557,11 @@ void wifiScanJSON(void)
   // Json end
   response += FPSTR("]\r\n");
 
+  if (n >= 0)
+    WiFi.scanDelete();
+  else
+    server.sendHeader("X-Scan-Running", "1");
+
   Debug(F("sending..."));
   server.send ( 200, "text/json", response );
   Debugln(F("Ok!"));
@@ -933,56 +1620,51 @@ Comments: -
 ====================================================================== */
 void handleNotFound(void) 
 {
-  String response = "";
   boolean found = false;  
 
   // Led on
   LedBluON();
 
-  // try to return SPIFFS file
-  found = handleFileRead(server.uri());
+  // try to return SPIFFS web file
+  found = fileIndexSend(server.uri().c_str());
 
   // Try Teleinfo ETIQUETTE
   if (!found) {
-    // We check for an known label
-    ValueList * me = tinfo.getList();
     const char * uri;
     // convert uri to char * for compare
     uri = server.uri().c_str();
 
     Debugf("handleNotFound(%s)\r\n", uri);
 
-    // Got at least one and consistent URI ?
-    if (me && uri && *uri=='/' && *++uri ) {
-      
-      // Loop thru the linked list of values
-      while (me->next && !found) {
-
-        // go to next node
-        me = me->next;
-
-        //Debugf("compare to '%s' ", me->name);
-        // Do we have this one ?
-        if (strcmp (me->name, uri) == 0 )
-        {
-          // no need to continue
-          found = true;
-
-          // Add to respone
-          response += F("{\"") ;
-          response += me->name ;
-          response += F("\":") ;
-          formatNumberJSON(response, me->value);
-          response += F("}\r\n");
-        }
+    // Consistent URI ?
+    if (uri && *uri=='/' && *++uri ) {
+      // We check for an known label, direct access
+      char * value = (char *) tinfolabels.get(uri);
+      uint32_t number;
+
+      if (value) {
+        JSONWriter response;
+        found = true;
+
+        // send json
+        response.begin();
+        response += F("{\"") ;
+        response += uri ;
+        response += F("\":") ;
+        if (tinfoFrameNumber(TInfoLabels::labelId(uri), &number))
+          response += number;
+        else
+          formatNumberJSON(response, value);
+        response += F("}\r\n");
+        response.end();
       }
     }
-
-    // Got it, send json
-    if (found) 
-      server.send ( 200, "text/json", response );
   }
 
+  // Other SPIFFS file
+  if (!found)
+    found = handleFileFlash(server.uri());
+
   // All trys failed
   if (!found) {
     // send error message in plain text
@@ -29,6 +29,9 @@
 // Web response max size
 #define RESPONSE_BUFFER_SIZE 4096
 
+// Chunked response writer, see jsonwriter.h
+class JSONWriter;
+
 // Exported variables/object instancied in main sketch
 // ===================================================
 extern char response[];
@@ -40,18 +43,25 @@ void handleTest(void);
 void handleRoot(void); 
 void handleFormConfig(void) ;
 void handleNotFound(void);
+void getTinfoJSONData(JSONWriter & r);
 void tinfoJSONTable(void);
-void getSysJSONData(String & r);
+void getSysJSONData(JSONWriter & r);
 void sysJSONTable(void);
 void logJSONTable(void);
-void getConfJSONData(String & r);
+void getConfJSONData(JSONWriter & r);
 void confJSONTable(void);
-void getSpiffsJSONData(String & r);
+void getSpiffsJSONData(JSONWriter & r);
 void spiffsJSONTable(void);
+void formatNumberJSON(JSONWriter & r, char * value);
+void getJSONData(JSONWriter & r);
 void sendJSON(void);
 void wifiScanJSON(void);
 void handleFactoryReset(void);
 void handleReset(void);
 void handleSpiffsOperation(void);
+void handleCaptureOperation(void);
+void captureJSONTable(void);
+void handleMetrics(void);
+void handleEvents(void);
 
 #endif